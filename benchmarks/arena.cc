@@ -0,0 +1,92 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t record_count = 10000;
+constexpr int    repeat_count = 50;
+
+dy_t make_heap_record(int64_t id) noexcept
+{
+    int64_t samples[] = { id, id + 1, id + 2, id + 3 };
+
+    dy_keyval_t fields[] = {
+        { "id", dy_make_i(id) },
+        { "name", dy_make_str("a short record name") },
+        { "samples", dy_make_iarr(samples, 4) },
+        { "score", dy_make_f(id * 0.5) },
+        { "valid", dy_make_b(id % 2 == 0) },
+    };
+
+    return dy_make_map(fields, 5);
+}
+
+dy_t make_arena_record(dy_arena_t arena, int64_t id) noexcept
+{
+    int64_t samples[] = { id, id + 1, id + 2, id + 3 };
+
+    dy_keyval_t fields[] = {
+        { "id", dy_arena_make_i(arena, id) },
+        { "name", dy_arena_make_str(arena, "a short record name") },
+        { "samples", dy_arena_make_iarr(arena, samples, 4) },
+        { "score", dy_arena_make_f(arena, id * 0.5) },
+        { "valid", dy_arena_make_b(arena, id % 2 == 0) },
+    };
+
+    return dy_arena_make_map(arena, fields, 5);
+}
+
+template <typename Fn>
+double measure(Fn&& fn)
+{
+    auto begin = steady_clock::now();
+    for (int i = 0; i < repeat_count; ++i) fn();
+    return duration<double>(steady_clock::now() - begin).count();
+}
+
+void report(char const* name, double seconds) noexcept
+{
+    // every record has 1 map + 5 fields
+    double nodes = 6.0 * record_count * repeat_count;
+    printf("%-8s %8.3f s %10.2f Mnodes/s\n",
+           name,
+           seconds,
+           nodes / seconds / 1e6);
+}
+
+}
+
+int main()
+{
+    vector<dy_t> records(record_count);
+
+    double heap = measure([&] {
+        for (size_t i = 0; i < record_count; ++i)
+            records[i] = make_heap_record(i);
+        dy_dispose(dy_make_arr(records.data(), record_count));
+    });
+
+    dy_arena_t arena = dy_arena_create(0);
+    double     used  = measure([&] {
+        for (size_t i = 0; i < record_count; ++i)
+            records[i] = make_arena_record(arena, i);
+        dy_arena_make_arr(arena, records.data(), record_count);
+        dy_arena_reset(arena);
+    });
+    dy_arena_destroy(arena);
+
+    report("heap", heap);
+    report("arena", used);
+
+    return 0;
+}
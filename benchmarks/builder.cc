@@ -0,0 +1,124 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t record_count = 100000;
+constexpr double min_seconds  = 0.5;
+
+/// <summary>
+/// runs the function until enough time passes
+/// </summary>
+/// <returns>the nanoseconds taken by a record</returns>
+template <typename Fn>
+double measure(Fn&& fn)
+{
+    size_t rounds = 0;
+    auto   begin  = steady_clock::now();
+    double secs   = 0;
+    do
+    {
+        fn();
+        ++rounds;
+        secs = duration<double>(steady_clock::now() - begin).count();
+    } while (secs < min_seconds);
+    return secs * 1e9 / (rounds * record_count);
+}
+
+/// <summary>
+/// builds the records as a decoder reading them would
+/// </summary>
+void build_records(dy_builder_t builder, vector<string> const& users, bool hint)
+{
+    dy_builder_begin_arr(builder, hint ? record_count : 0);
+    for (size_t i = 0; i < record_count; ++i)
+    {
+        dy_builder_begin_map(builder, hint ? 5 : 0);
+        dy_builder_key(builder, "id");
+        dy_builder_push_i(builder, i);
+        dy_builder_key(builder, "user");
+        dy_builder_push_str_len(builder, users[i].data(), users[i].size());
+        dy_builder_key(builder, "score");
+        dy_builder_push_f(builder, i * 0.25);
+        dy_builder_key(builder, "tags");
+        dy_builder_begin_arr(builder, hint ? 2 : 0);
+        dy_builder_push_str(builder, "a");
+        dy_builder_push_str(builder, "b");
+        dy_builder_end(builder);
+        dy_builder_key(builder, "active");
+        dy_builder_push_b(builder, true);
+        dy_builder_end(builder);
+    }
+    dy_builder_end(builder);
+}
+
+/// <summary>
+/// makes the same records by gathering the entries of each array and map
+/// </summary>
+dy_t make_records(vector<string> const& users)
+{
+    vector<dy_t> records;
+    records.reserve(record_count);
+    for (size_t i = 0; i < record_count; ++i)
+    {
+        dy_t tags[] = { dy_make_str("a"), dy_make_str("b") };
+
+        dy_keyval_t pairs[] = {
+            { "id", dy_make_i(i) },
+            { "user", dy_make_str_len(users[i].data(), users[i].size()) },
+            { "score", dy_make_f(i * 0.25) },
+            { "tags", dy_make_arr(tags, 2) },
+            { "active", dy_make_b(true) },
+        };
+        records.push_back(dy_make_map(pairs, 5));
+    }
+    return dy_make_arr(records.data(), records.size());
+}
+
+}
+
+int main()
+{
+    vector<string> users;
+    for (size_t i = 0; i < record_count; ++i)
+        users.push_back("user " + to_string(i));
+
+    double make = measure([&] { dy_dispose(make_records(users)); });
+
+    dy_builder_t builder = dy_builder_create(NULL);
+    double       build   = measure([&] {
+        build_records(builder, users, false);
+        dy_dispose(dy_builder_finish(builder));
+    });
+    double hinted = measure([&] {
+        build_records(builder, users, true);
+        dy_dispose(dy_builder_finish(builder));
+    });
+    dy_builder_destroy(builder);
+
+    dy_arena_t arena = dy_arena_create(0);
+    builder          = dy_builder_create(arena);
+    double in_arena  = measure([&] {
+        build_records(builder, users, true);
+        dy_builder_finish(builder);
+        dy_arena_reset(arena);
+    });
+    dy_builder_destroy(builder);
+    dy_arena_destroy(arena);
+
+    printf("%-28s %10.1f\n", "make, gathered (ns)", make);
+    printf("%-28s %10.1f\n", "builder (ns)", build);
+    printf("%-28s %10.1f\n", "builder, hinted (ns)", hinted);
+    printf("%-28s %10.1f\n", "builder, hinted arena (ns)", in_arena);
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t section_count  = 100;
+constexpr size_t field_count    = 20;
+constexpr size_t consumer_count = 1000;
+
+/// <summary>
+/// makes a config document of 100 sections of 20 fields each
+/// </summary>
+dy_t make_config(dy_arena_t arena) noexcept
+{
+    vector<string> names;
+    for (size_t i = 0; i < field_count; ++i)
+        names.push_back("option_" + to_string(i));
+
+    vector<dy_t> sections;
+    for (size_t s = 0; s < section_count; ++s)
+    {
+        vector<dy_keyval_t> fields;
+        for (size_t i = 0; i < field_count; ++i)
+        {
+            string value = "value " + to_string(s * field_count + i);
+            dy_t   val   = arena ? dy_arena_make_str(arena, value.c_str())
+                                 : dy_make_str(value.c_str());
+            fields.push_back({ names[i].c_str(), val });
+        }
+        sections.push_back(
+            arena ? dy_arena_make_map(arena, fields.data(), field_count)
+                  : dy_make_map(fields.data(), field_count));
+    }
+
+    return arena ? dy_arena_make_arr(arena, sections.data(), section_count)
+                 : dy_make_arr(sections.data(), section_count);
+}
+
+/// <summary>
+/// hands a copy of the document to every consumer and disposes the copies
+/// </summary>
+double fan_out(dy_t doc) noexcept
+{
+    vector<dy_t> copies(consumer_count);
+
+    auto begin = steady_clock::now();
+    for (auto& copy : copies) copy = dy_copy(doc);
+    for (auto copy : copies) dy_dispose(copy);
+    return duration<double, micro>(steady_clock::now() - begin).count()
+           / consumer_count;
+}
+
+}
+
+int main()
+{
+    // copies of arena values are deep copies, which is what every copy used
+    // to be
+    dy_arena_t arena = dy_arena_create(0);
+    double     deep  = fan_out(make_config(arena));
+    dy_arena_destroy(arena);
+
+    dy_t   doc    = make_config(nullptr);
+    double shared = fan_out(doc);
+    dy_dispose(doc);
+
+    printf("%-8s %12.3f us/copy\n", "deep", deep);
+    printf("%-8s %12.3f us/copy\n", "shared", shared);
+
+    return 0;
+}
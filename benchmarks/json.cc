@@ -0,0 +1,201 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Pass the paths of twitter.json, canada.json, citm_catalog.json or any other
+// corpus to measure them. Without arguments, documents of the same flavors are
+// generated: short records full of strings, long arrays of coordinates, and
+// maps of maps keyed by numbers.
+
+namespace
+{
+
+constexpr double min_seconds = 0.5;
+
+struct corpus
+{
+    string name;
+    string json;
+};
+
+string read_file(char const* path)
+{
+    ifstream      in(path, ios::binary);
+    ostringstream out;
+    out << in.rdbuf();
+    return out.str();
+}
+
+string make_tweets(mt19937_64& rng)
+{
+    string json = "{\"statuses\": [";
+    for (int i = 0; i < 2000; ++i)
+    {
+        if (i != 0) json += ",";
+        json += "{\"id\": " + to_string(rng() >> 8)
+                + ", \"text\": \"RT @user: caf\\u00e9 \xe2\x9c\xa8 "
+                  "https:\\/\\/t.co\\/" + to_string(rng() % 100000)
+                + "\", \"user\": {\"name\": \"\xe3\x81\x82\xe3\x81\x84 "
+                + to_string(i) + "\", \"followers_count\": "
+                + to_string(rng() % 10000)
+                + ", \"verified\": false, \"url\": null}, "
+                  "\"retweet_count\": " + to_string(rng() % 100)
+                + ", \"entities\": {\"hashtags\": [], \"urls\": []}}";
+    }
+    return json + "]}";
+}
+
+string make_coordinates(mt19937_64& rng)
+{
+    uniform_real_distribution<double> lon(-141.0, -52.0), lat(41.0, 83.0);
+
+    char   buffer[64];
+    string json = "{\"type\": \"Polygon\", \"coordinates\": [";
+    for (int ring = 0; ring < 50; ++ring)
+    {
+        if (ring != 0) json += ",";
+        json += "[";
+        for (int i = 0; i < 2000; ++i)
+        {
+            snprintf(buffer,
+                     sizeof(buffer),
+                     "%s[%.15g,%.15g]",
+                     i != 0 ? "," : "",
+                     lon(rng),
+                     lat(rng));
+            json += buffer;
+        }
+        json += "]";
+    }
+    return json + "]}";
+}
+
+string make_catalog(mt19937_64& rng)
+{
+    string json = "{\"events\": {";
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (i != 0) json += ",";
+        string id = to_string(138586341 + i);
+        json += "\"" + id + "\": {\"id\": " + id
+                + ", \"name\": \"Concert " + to_string(rng() % 1000)
+                + "\", \"subTopicIds\": [337184, 337193, "
+                + to_string(rng() % 1000000)
+                + "], \"topicIds\": [324846100, 107888604], "
+                  "\"logo\": null, \"subjectCode\": null}";
+    }
+    return json + "}}";
+}
+
+double measure_gbps(string const& json, dy_parse_opts_t const& opts)
+{
+    size_t rounds = 0;
+    auto   begin  = steady_clock::now();
+    double secs   = 0;
+    do
+    {
+        dy_parse_opts_t copy = opts;
+        if (copy.arena != NULL) dy_arena_reset(copy.arena);
+
+        dy_t val = dy_parse_json(json.data(), json.size(), &copy);
+        if (val == NULL)
+        {
+            fprintf(stderr, "error %d at %zu\n", copy.error, copy.error_offset);
+            exit(1);
+        }
+        dy_dispose(val);
+
+        ++rounds;
+        secs = duration<double>(steady_clock::now() - begin).count();
+    } while (secs < min_seconds);
+
+    return json.size() * rounds / secs / 1e9;
+}
+
+bool discard(void* ctx, char const*, size_t len)
+{
+    *static_cast<size_t*>(ctx) += len;
+    return true;
+}
+
+/// <summary>
+/// measures writing the parsed text back in the bytes written per second
+/// </summary>
+double measure_write_gbps(string const& json)
+{
+    dy_t val = dy_parse_json(json.data(), json.size(), NULL);
+
+    size_t bytes = 0;
+    auto   begin = steady_clock::now();
+    double secs  = 0;
+    do
+    {
+        dy_write_json(val, dy_write_default, discard, &bytes);
+        secs = duration<double>(steady_clock::now() - begin).count();
+    } while (secs < min_seconds);
+
+    dy_dispose(val);
+    return bytes / secs / 1e9;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    vector<corpus> corpora;
+    for (int i = 1; i < argc; ++i)
+        corpora.push_back({ argv[i], read_file(argv[i]) });
+
+    if (corpora.empty())
+    {
+        mt19937_64 rng(42);
+        corpora.push_back({ "tweets", make_tweets(rng) });
+        corpora.push_back({ "coordinates", make_coordinates(rng) });
+        corpora.push_back({ "catalog", make_catalog(rng) });
+    }
+
+    dy_arena_t arena = dy_arena_create(0);
+
+    dy_parse_opts_t heap {}, generic {}, in_arena {};
+    generic.generic_arrays = true;
+    in_arena.arena         = arena;
+
+    printf("%-24s %10s %10s %10s %10s %10s\n",
+           "corpus",
+           "size (MB)",
+           "heap",
+           "generic",
+           "arena",
+           "write");
+    printf("%-24s %10s %10s %10s %10s %10s\n",
+           "",
+           "",
+           "(GB/s)",
+           "(GB/s)",
+           "(GB/s)",
+           "(GB/s)");
+
+    for (auto const& corpus : corpora)
+        printf("%-24s %10.2f %10.3f %10.3f %10.3f %10.3f\n",
+               corpus.name.c_str(),
+               corpus.json.size() / 1e6,
+               measure_gbps(corpus.json, heap),
+               measure_gbps(corpus.json, generic),
+               measure_gbps(corpus.json, in_arena),
+               measure_write_gbps(corpus.json));
+
+    dy_arena_destroy(arena);
+    return 0;
+}
@@ -0,0 +1,198 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t element_count = size_t(1) << 20;
+constexpr size_t round_count   = 200;
+
+/// <summary>
+/// keeps the compiler from discarding the results
+/// </summary>
+volatile double sink;
+
+template <typename Fn>
+double measure_gbps(size_t bytes, Fn&& fn)
+{
+    auto begin = steady_clock::now();
+    for (size_t r = 0; r < round_count; ++r) sink = static_cast<double>(fn());
+    double secs = duration<double>(steady_clock::now() - begin).count();
+    return bytes * round_count / secs / 1e9;
+}
+
+void report(char const* name, double naive, double dy)
+{
+    printf("%-16s %12.2f %12.2f %10.2fx\n", name, naive, dy, dy / naive);
+}
+
+}
+
+int main()
+{
+    mt19937_64 rng(42);
+
+    vector<int64_t> ints(element_count);
+    vector<double>  nums(element_count), others(element_count);
+    for (auto& i : ints) i = static_cast<int64_t>(rng() % 2000001) - 1000000;
+    for (auto& f : nums) f = static_cast<double>(rng() % 1000000) / 7;
+    for (auto& f : others) f = static_cast<double>(rng() % 1000000) / 11;
+
+    // a validity mask with runs of valid and invalid rows
+    unique_ptr<bool[]> valid(new bool[element_count]);
+    for (size_t i = 0; i < element_count; ++i) valid[i] = (i / 100) % 4 != 0;
+
+    dy_t iarr  = dy_make_iarr_view(ints.data(), element_count);
+    dy_t farr  = dy_make_farr_view(nums.data(), element_count);
+    dy_t farr2 = dy_make_farr_view(others.data(), element_count);
+    dy_t mask  = dy_make_barr(valid.get(), element_count);
+
+    size_t const ibytes = element_count * sizeof(int64_t);
+    size_t const fbytes = element_count * sizeof(double);
+
+    printf("%-16s %12s %12s %11s\n", "kernel", "naive", "dy", "speedup");
+    printf("%-16s %12s %12s %11s\n", "", "(GB/s)", "(GB/s)", "");
+
+    report("iarr sum",
+           measure_gbps(ibytes,
+                        [&] {
+                            int64_t acc = 0;
+                            for (auto i : ints) acc += i;
+                            return acc;
+                        }),
+           measure_gbps(ibytes, [&] { return dy_iarr_sum(iarr); }));
+
+    report("iarr min",
+           measure_gbps(ibytes,
+                        [&] {
+                            int64_t acc = INT64_MAX;
+                            for (auto i : ints) acc = min(acc, i);
+                            return acc;
+                        }),
+           measure_gbps(ibytes, [&] { return dy_iarr_min(iarr); }));
+
+    report("iarr sum masked",
+           measure_gbps(ibytes,
+                        [&] {
+                            int64_t acc = 0;
+                            for (size_t i = 0; i < element_count; ++i)
+                                if (dy_get_barr_idx(mask, i)) acc += ints[i];
+                            return acc;
+                        }),
+           measure_gbps(ibytes,
+                        [&] { return dy_iarr_sum_masked(iarr, mask); }));
+
+    report("farr sum",
+           measure_gbps(fbytes,
+                        [&] {
+                            // Kahan summation as a consumer would write it
+                            double acc = 0, comp = 0;
+                            for (auto f : nums)
+                            {
+                                double y = f - comp;
+                                double t = acc + y;
+                                comp     = (t - acc) - y;
+                                acc      = t;
+                            }
+                            return acc;
+                        }),
+           measure_gbps(fbytes, [&] { return dy_farr_sum(farr); }));
+
+    report("farr sum masked",
+           measure_gbps(fbytes,
+                        [&] {
+                            double acc = 0, comp = 0;
+                            for (size_t i = 0; i < element_count; ++i)
+                            {
+                                if (!dy_get_barr_idx(mask, i)) continue;
+                                double y = nums[i] - comp;
+                                double t = acc + y;
+                                comp     = (t - acc) - y;
+                                acc      = t;
+                            }
+                            return acc;
+                        }),
+           measure_gbps(fbytes,
+                        [&] { return dy_farr_sum_masked(farr, mask); }));
+
+    report("farr dot",
+           measure_gbps(fbytes * 2,
+                        [&] {
+                            double acc = 0;
+                            for (size_t i = 0; i < element_count; ++i)
+                                acc += nums[i] * others[i];
+                            return acc;
+                        }),
+           measure_gbps(fbytes * 2, [&] { return dy_farr_dot(farr, farr2); }));
+
+    report("iarr prefix sum",
+           measure_gbps(ibytes,
+                        [&] {
+                            vector<int64_t> out(element_count);
+                            int64_t         acc = 0;
+                            for (size_t i = 0; i < element_count; ++i)
+                                out[i] = acc += ints[i];
+                            return out.back();
+                        }),
+           measure_gbps(ibytes, [&] {
+               dy_t    sums = dy_iarr_prefix_sum(iarr);
+               int64_t last = dy_get_iarr_idx(sums, element_count - 1);
+               dy_dispose(sums);
+               return last;
+           }));
+
+    vector<int16_t> samples(element_count);
+    for (auto& s : samples) s = static_cast<int16_t>(rng());
+    dy_t i16 = dy_make_i16arr_view(samples.data(), element_count);
+
+    report("i16 to f64",
+           measure_gbps(fbytes,
+                        [&] {
+                            vector<double> out(element_count);
+                            for (size_t i = 0; i < element_count; ++i)
+                                out[i] = samples[i];
+                            return out.back();
+                        }),
+           measure_gbps(fbytes, [&] {
+               dy_t   out  = dy_convert_arr(i16, dy_type_farr);
+               double last = dy_get_farr_idx(out, element_count - 1);
+               dy_dispose(out);
+               return last;
+           }));
+
+    report("f64 to i16",
+           measure_gbps(fbytes,
+                        [&] {
+                            // clamps as dy_convert_arr does
+                            vector<int16_t> out(element_count);
+                            for (size_t i = 0; i < element_count; ++i)
+                                out[i] = static_cast<int16_t>(
+                                    clamp(nums[i], -32768.0, 32767.0));
+                            return out.back();
+                        }),
+           measure_gbps(fbytes, [&] {
+               dy_t    out  = dy_convert_arr(farr, dy_type_i16arr);
+               int16_t last = dy_get_i16arr_idx(out, element_count - 1);
+               dy_dispose(out);
+               return last;
+           }));
+
+    dy_dispose(i16);
+    dy_dispose(iarr);
+    dy_dispose(farr);
+    dy_dispose(farr2);
+    dy_dispose(mask);
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include "sink.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr double min_seconds = 0.5;
+
+/// <summary>
+/// runs the function until enough time passes
+/// </summary>
+/// <returns>the number of the runs per second</returns>
+template <typename Fn>
+double measure_rate(Fn&& fn)
+{
+    size_t rounds = 0;
+    auto   begin  = steady_clock::now();
+    double secs   = 0;
+    do
+    {
+        fn();
+        ++rounds;
+        secs = duration<double>(steady_clock::now() - begin).count();
+    } while (secs < min_seconds);
+    return rounds / secs;
+}
+
+/// <summary>
+/// makes a response holding a few fields and many records with hundreds of
+/// fields each
+/// </summary>
+string make_response(mt19937_64& rng)
+{
+    string json = "{\"status\": \"ok\", \"count\": 2000, \"records\": [";
+    for (int i = 0; i < 2000; ++i)
+    {
+        if (i != 0) json += ",";
+        json += "{\"id\": " + to_string(rng() >> 16);
+        for (int j = 0; j < 100; ++j)
+            json += ", \"field_" + to_string(j) + "\": \"value "
+                    + to_string(rng() % 1000) + "\"";
+        json += ", \"scores\": [1, 2, 3], \"owner\": {\"name\": \"user "
+                + to_string(i) + "\"}}";
+    }
+    return json + "], \"next\": \"cursor\"}";
+}
+
+/// <summary>
+/// reads the fields a handler typically needs
+/// </summary>
+int64_t read_fields(dy_t doc)
+{
+    int64_t sum   = dy_get_i(dy_get_map_key(doc, "count").val);
+    dy_t    first = dy_get_arr_idx(dy_get_map_key(doc, "records").val, 0);
+    sum += dy_get_i(dy_get_map_key(first, "id").val);
+    sum += dy_get_str_len(dy_get_map_key(doc, "next").val);
+    sum += dy_get_str_len(dy_get_map_key(doc, "status").val);
+    return sum;
+}
+
+}
+
+int main()
+{
+    mt19937_64 rng(42);
+    string     json = make_response(rng);
+
+    dy_parse_opts_t lazy {};
+    lazy.lazy = true;
+
+    int64_t sum   = 0;
+    double  eager = measure_rate([&] {
+        dy_t doc = dy_parse_json(json.data(), json.size(), NULL);
+        sum += read_fields(doc);
+        dy_dispose(doc);
+    });
+    double partial = measure_rate([&] {
+        dy_t doc = dy_parse_json(json.data(), json.size(), &lazy);
+        sum += read_fields(doc);
+        dy_dispose(doc);
+    });
+    double full = measure_rate([&] {
+        dy_t   doc = dy_parse_json(json.data(), json.size(), &lazy);
+        string out;
+        dy_write_json(doc, dy_write_default, append, &out);
+        sum += out.size();
+        dy_dispose(doc);
+    });
+    if (sum == 0) printf("unreachable\n");
+
+    printf("%-28s %10.2f\n", "json (MB)", json.size() / 1e6);
+    printf("%-28s %10.3f\n", "eager, 4 fields (ms)", 1e3 / eager);
+    printf("%-28s %10.3f\n", "lazy, 4 fields (ms)", 1e3 / partial);
+    printf("%-28s %10.3f\n", "lazy, every field (ms)", 1e3 / full);
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t operation_count = size_t(1) << 22;
+
+/// <summary>
+/// keeps the compiler from discarding the results
+/// </summary>
+volatile uintptr_t sink;
+
+template <typename Fn>
+double measure_ns(size_t ops, Fn&& fn)
+{
+    auto begin = steady_clock::now();
+    fn();
+    return duration<double, nano>(steady_clock::now() - begin).count() / ops;
+}
+
+void run(size_t len) noexcept
+{
+    vector<string> keys;
+    keys.reserve(len);
+    for (size_t i = 0; i < len; ++i) keys.push_back("field_" + to_string(i));
+
+    vector<dy_keyval_t> pairs;
+    pairs.reserve(len);
+    for (size_t i = 0; i < len; ++i)
+        pairs.push_back({ keys[i].c_str(), dy_make_i(i) });
+
+    vector<dy_interned_keyval_t> interned;
+    interned.reserve(len);
+    for (size_t i = 0; i < len; ++i)
+    {
+        auto const& key = keys[i];
+        interned.push_back({ dy_intern_key(key.c_str(), key.size()),
+                             pairs[i].val });
+    }
+
+    dy_t dy          = dy_make_map(pairs.data(), len);
+    dy_t dy_interned = dy_make_map_interned(interned.data(), len);
+
+    unordered_map<string, dy_t> std_map;
+    for (auto const& pair : pairs) std_map.emplace(pair.key, pair.val);
+
+    // looks the keys up in a random order
+    vector<uint32_t> order;
+    order.reserve(operation_count);
+    mt19937_64 rng(len);
+    for (size_t i = 0; i < operation_count; ++i) order.push_back(rng() % len);
+
+    // hashes the keys ahead of time as a field extractor would
+    vector<uint64_t> hashes;
+    hashes.reserve(len);
+    for (auto const& key : keys)
+        hashes.push_back(dy_hash_key(key.c_str(), key.size()));
+
+    double dy_lookup = measure_ns(order.size(), [&] {
+        uintptr_t acc = 0;
+        for (auto i : order)
+            acc += (uintptr_t)dy_get_map_key(dy, keys[i].c_str()).val;
+        sink = acc;
+    });
+
+    double dy_hashed = measure_ns(order.size(), [&] {
+        uintptr_t acc = 0;
+        for (auto i : order)
+        {
+            auto const& key = keys[i];
+            acc += (uintptr_t)dy_get_map_key_hashed(
+                       dy, key.c_str(), key.size(), hashes[i])
+                       .val;
+        }
+        sink = acc;
+    });
+
+    double dy_interned_lookup = measure_ns(order.size(), [&] {
+        uintptr_t acc = 0;
+        for (auto i : order)
+            acc += (uintptr_t)dy_get_map_key_interned(dy_interned,
+                                                      interned[i].key)
+                       .val;
+        sink = acc;
+    });
+
+    double std_lookup = measure_ns(order.size(), [&] {
+        uintptr_t acc = 0;
+        for (auto i : order) acc += (uintptr_t)std_map.find(keys[i])->second;
+        sink = acc;
+    });
+
+    size_t rounds = max<size_t>(1, operation_count / len);
+
+    double dy_iter = measure_ns(rounds * len, [&] {
+        uintptr_t acc = 0;
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            dy_iter_t iter = dy_make_map_iter(dy);
+            for (dy_keyval_t kv = dy_get_map_iter(dy, iter); kv.key != nullptr;
+                 kv             = dy_get_map_iter(dy, iter))
+                acc += (uintptr_t)kv.val;
+            dy_dispose_map_iter(iter);
+        }
+        sink = acc;
+    });
+
+    double std_iter = measure_ns(rounds * len, [&] {
+        uintptr_t acc = 0;
+        for (size_t r = 0; r < rounds; ++r)
+            for (auto const& [key, val] : std_map) acc += (uintptr_t)val;
+        sink = acc;
+    });
+
+    printf("%8zu %12.2f %12.2f %12.2f %12.2f %12.2f %12.2f\n",
+           len,
+           dy_lookup,
+           dy_hashed,
+           dy_interned_lookup,
+           std_lookup,
+           dy_iter,
+           std_iter);
+
+    dy_dispose(dy);
+    dy_dispose_self(dy_interned);
+}
+
+}
+
+int main()
+{
+    printf("%8s %12s %12s %12s %12s %12s %12s\n",
+           "size",
+           "dy find",
+           "dy hashed",
+           "dy interned",
+           "std find",
+           "dy iter",
+           "std iter");
+    printf("%8s %12s %12s %12s %12s %12s %12s\n",
+           "",
+           "(ns)",
+           "(ns)",
+           "(ns)",
+           "(ns)",
+           "(ns)",
+           "(ns)");
+
+    for (size_t len = 4; len <= (size_t(1) << 20); len *= 4) run(len);
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include "sink.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t record_count = 200000;
+constexpr size_t lookups      = 1000000;
+
+bool write_file(void* ctx, char const* data, size_t len)
+{
+    return fwrite(data, 1, len, static_cast<FILE*>(ctx)) == len;
+}
+
+double seconds_since(steady_clock::time_point begin)
+{
+    return duration<double>(steady_clock::now() - begin).count();
+}
+
+/// <summary>
+/// makes records full of short strings and small integers
+/// </summary>
+dy_t make_records(mt19937_64& rng)
+{
+    string json = "[";
+    for (size_t i = 0; i < record_count; ++i)
+    {
+        if (i != 0) json += ",";
+        json += "{\"id\": " + to_string(rng() >> 16) + ", \"user\": \"user "
+                + to_string(i) + "\", \"score\": " + to_string(rng() % 1000)
+                + ", \"tags\": [\"a\", \"b\"], \"active\": true}";
+    }
+    json += "]";
+    return dy_parse_json(json.data(), json.size(), NULL);
+}
+
+/// <summary>
+/// reads the scores of random records
+/// </summary>
+/// <returns>the nanoseconds taken by a lookup</returns>
+double measure_lookups(dy_t records, vector<size_t> const& order)
+{
+    auto    begin = steady_clock::now();
+    int64_t sum   = 0;
+    for (size_t idx : order)
+        sum += dy_get_i(
+            dy_get_map_key(dy_get_arr_idx(records, idx), "score").val);
+
+    double secs = seconds_since(begin);
+    if (sum < 0) printf("unreachable\n");
+    return secs * 1e9 / order.size();
+}
+
+}
+
+int main()
+{
+    mt19937_64 rng(42);
+    dy_t       records = make_records(rng);
+
+    string json;
+    dy_write_json(records, dy_write_default, append, &json);
+
+    string path = "dy_benchmark_mapped.dym";
+    auto   begin = steady_clock::now();
+    FILE*  file  = fopen(path.c_str(), "wb");
+    if (file == NULL || !dy_write_mapped(records, write_file, file)) return 1;
+    fclose(file);
+    double write = seconds_since(begin);
+
+    begin              = steady_clock::now();
+    dy_mapped_t mapped = dy_open_mapped(path.c_str());
+    double      open   = seconds_since(begin);
+    if (mapped == NULL) return 1;
+
+    begin       = steady_clock::now();
+    dy_t parsed = dy_parse_json(json.data(), json.size(), NULL);
+    double parse = seconds_since(begin);
+
+    vector<size_t> order(lookups);
+    for (auto& idx : order) idx = rng() % record_count;
+
+    dy_t   root = dy_get_mapped_root(mapped);
+    double cold = measure_lookups(root, order);
+    double warm = measure_lookups(root, order);
+    double heap = measure_lookups(parsed, order);
+
+    printf("%-24s %10.2f\n", "json (MB)", json.size() / 1e6);
+    printf("%-24s %10.2f\n", "write mapped (ms)", write * 1e3);
+    printf("%-24s %10.3f\n", "open mapped (ms)", open * 1e3);
+    printf("%-24s %10.2f\n", "parse json (ms)", parse * 1e3);
+    printf("%-24s %10.1f\n", "lookup, first (ns)", cold);
+    printf("%-24s %10.1f\n", "lookup, mapped (ns)", warm);
+    printf("%-24s %10.1f\n", "lookup, parsed (ns)", heap);
+
+    dy_close_mapped(mapped);
+    remove(path.c_str());
+    dy_dispose(parsed);
+    dy_dispose(records);
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include "sink.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr double min_seconds = 0.5;
+
+/// <summary>
+/// runs the function until enough time passes
+/// </summary>
+/// <returns>the number of the runs per second</returns>
+template <typename Fn>
+double measure_rate(Fn&& fn)
+{
+    size_t rounds = 0;
+    auto   begin  = steady_clock::now();
+    double secs   = 0;
+    do
+    {
+        fn();
+        ++rounds;
+        secs = duration<double>(steady_clock::now() - begin).count();
+    } while (secs < min_seconds);
+    return rounds / secs;
+}
+
+/// <summary>
+/// makes records full of short strings and small integers
+/// </summary>
+dy_t make_records(mt19937_64& rng)
+{
+    string json = "[";
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (i != 0) json += ",";
+        json += "{\"id\": " + to_string(rng() >> 16) + ", \"user\": \"user "
+                + to_string(i) + "\", \"score\": " + to_string(rng() % 1000)
+                + ".25, \"tags\": [\"a\", \"b\"], \"active\": true}";
+    }
+    json += "]";
+    return dy_parse_json(json.data(), json.size(), NULL);
+}
+
+/// <summary>
+/// makes a map of long typed arrays, as in telemetry
+/// </summary>
+dy_t make_series(mt19937_64& rng)
+{
+    constexpr size_t len = 1 << 18;
+
+    vector<int64_t> stamps(len);
+    vector<double>  values(len);
+    for (size_t i = 0; i < len; ++i)
+    {
+        stamps[i] = 1600000000000 + static_cast<int64_t>(i) * 1000;
+        values[i] = static_cast<double>(rng() % 1000000) / 7;
+    }
+
+    dy_keyval_t pairs[] = {
+        { "stamps", dy_make_iarr(stamps.data(), len) },
+        { "values", dy_make_farr(values.data(), len) },
+    };
+    return dy_make_map(pairs, 2);
+}
+
+void report(char const* name, dy_t val)
+{
+    string packed, json;
+    dy_encode_msgpack(val, append, &packed);
+    dy_write_json(val, dy_write_default, append, &json);
+
+    double encode = measure_rate([&] {
+        string out;
+        out.reserve(packed.size());
+        dy_encode_msgpack(val, append, &out);
+    });
+    double decode = measure_rate([&] {
+        dy_dispose(dy_decode_msgpack(packed.data(), packed.size(), NULL));
+    });
+    double write = measure_rate([&] {
+        string out;
+        out.reserve(json.size());
+        dy_write_json(val, dy_write_default, append, &out);
+    });
+    double parse = measure_rate(
+        [&] { dy_dispose(dy_parse_json(json.data(), json.size(), NULL)); });
+
+    // the rates are in the bytes of the encodings
+    printf("%-12s %10.2f %10.2f %10.3f %10.3f %10.3f %10.3f\n",
+           name,
+           packed.size() / 1e6,
+           json.size() / 1e6,
+           encode * packed.size() / 1e9,
+           decode * packed.size() / 1e9,
+           write * json.size() / 1e9,
+           parse * json.size() / 1e9);
+}
+
+}
+
+int main()
+{
+    mt19937_64 rng(42);
+
+    dy_t records = make_records(rng);
+    dy_t series  = make_series(rng);
+
+    printf("%-12s %10s %10s %10s %10s %10s %10s\n",
+           "document",
+           "msgpack",
+           "json",
+           "encode",
+           "decode",
+           "write",
+           "parse");
+    printf("%-12s %10s %10s %10s %10s %10s %10s\n",
+           "",
+           "(MB)",
+           "(MB)",
+           "(GB/s)",
+           "(GB/s)",
+           "(GB/s)",
+           "(GB/s)");
+
+    report("records", records);
+    report("series", series);
+
+    dy_dispose(records);
+    dy_dispose(series);
+    return 0;
+}
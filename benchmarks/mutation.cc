@@ -0,0 +1,93 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t arr_len = 1000000;
+constexpr size_t map_len = 100000;
+
+/// <summary>
+/// runs the function once
+/// </summary>
+/// <returns>the nanoseconds taken per entry</returns>
+template <typename Fn>
+double measure(size_t len, Fn&& fn)
+{
+    auto begin = steady_clock::now();
+    fn();
+    return duration<double>(steady_clock::now() - begin).count() * 1e9 / len;
+}
+
+}
+
+int main()
+{
+    vector<string> keys;
+    for (size_t i = 0; i < map_len; ++i) keys.push_back("key_" + to_string(i));
+
+    double push = measure(arr_len, [] {
+        dy_t arr = dy_make_arr(NULL, 0);
+        for (size_t i = 0; i < arr_len; ++i)
+            arr = dy_arr_push(arr, dy_make_i(i));
+        dy_dispose(arr);
+    });
+
+    // without mutation, entries are gathered first and the array made at once
+    double gather = measure(arr_len, [] {
+        vector<dy_t> elems;
+        for (size_t i = 0; i < arr_len; ++i) elems.push_back(dy_make_i(i));
+        dy_dispose(dy_make_arr(elems.data(), elems.size()));
+    });
+
+    double ipush = measure(arr_len, [] {
+        dy_t iarr = dy_make_iarr(NULL, 0);
+        for (size_t i = 0; i < arr_len; ++i) iarr = dy_iarr_push(iarr, i);
+        dy_dispose(iarr);
+    });
+
+    double set = measure(map_len, [&] {
+        dy_t map = dy_make_map(NULL, 0);
+        for (size_t i = 0; i < map_len; ++i)
+            map = dy_map_set(map, keys[i].c_str(), dy_make_i(i));
+        dy_dispose(map);
+    });
+
+    double make = measure(map_len, [&] {
+        vector<dy_keyval_t> pairs;
+        for (size_t i = 0; i < map_len; ++i)
+            pairs.push_back({ keys[i].c_str(), dy_make_i(i) });
+        dy_dispose(dy_make_map(pairs.data(), pairs.size()));
+    });
+
+    // rebuilding the map for every key is quadratic, so fewer keys are set
+    constexpr size_t rebuild_len = 2000;
+    double           rebuild     = measure(rebuild_len, [&] {
+        vector<dy_keyval_t> pairs;
+        dy_t                map = dy_make_map(NULL, 0);
+        for (size_t i = 0; i < rebuild_len; ++i)
+        {
+            pairs.push_back({ keys[i].c_str(), dy_make_i(i) });
+            dy_dispose(map);
+            map = dy_make_map(pairs.data(), pairs.size());
+        }
+        dy_dispose(map);
+    });
+
+    printf("%-28s %10.1f\n", "arr push (ns)", push);
+    printf("%-28s %10.1f\n", "arr gather and make (ns)", gather);
+    printf("%-28s %10.1f\n", "iarr push (ns)", ipush);
+    printf("%-28s %10.1f\n", "map set (ns)", set);
+    printf("%-28s %10.1f\n", "map make (ns)", make);
+    printf("%-28s %10.1f\n", "map rebuild, 2000 keys (ns)", rebuild);
+    return 0;
+}
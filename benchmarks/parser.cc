@@ -0,0 +1,131 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t record_count = 200000;
+constexpr size_t chunk_size   = 64 * 1024;
+
+double seconds_since(steady_clock::time_point begin)
+{
+    return duration<double>(steady_clock::now() - begin).count();
+}
+
+/// <summary>
+/// makes a document holding records full of short strings and small integers
+/// </summary>
+string make_document(mt19937_64& rng)
+{
+    string json = "{\"version\": 1, \"records\": [";
+    for (size_t i = 0; i < record_count; ++i)
+    {
+        if (i != 0) json += ",";
+        json += "{\"id\": " + to_string(rng() >> 16) + ", \"user\": \"user "
+                + to_string(i) + "\", \"score\": " + to_string(rng() % 1000)
+                + ", \"tags\": [\"a\", \"b\"], \"active\": true}";
+    }
+    json += "]}";
+    return json;
+}
+
+/// <summary>
+/// sums the scores of the records handed out, recycling the arena
+/// </summary>
+struct summer
+{
+    dy_arena_t arena;
+    int64_t    sum   = 0;
+    size_t     count = 0;
+    size_t     peak  = 0;
+
+    static bool receive(void* ctx, dy_t val)
+    {
+        auto self = static_cast<summer*>(ctx);
+        self->sum += dy_get_i(dy_get_map_key(val, "score").val);
+        ++self->count;
+
+        if (self->arena != NULL)
+        {
+            self->peak = max(self->peak, dy_arena_capacity(self->arena));
+            dy_arena_reset(self->arena);
+        }
+        else
+            dy_dispose(val);
+        return true;
+    }
+};
+
+/// <summary>
+/// feeds the text in chunks to a parser for the records
+/// </summary>
+/// <returns>the seconds taken</returns>
+double stream(string const& json, summer& out)
+{
+    dy_parse_opts_t opts {};
+    opts.arena = out.arena;
+
+    auto        begin  = steady_clock::now();
+    dy_parser_t parser
+        = dy_parser_create("/records", &opts, summer::receive, &out);
+    for (size_t i = 0; i < json.size(); i += chunk_size)
+    {
+        size_t len = min(chunk_size, json.size() - i);
+        dy_parser_feed(parser, json.data() + i, len);
+    }
+    dy_parser_finish(parser);
+    dy_parser_destroy(parser);
+    return seconds_since(begin);
+}
+
+}
+
+int main()
+{
+    mt19937_64 rng(42);
+    string     json = make_document(rng);
+
+    auto    begin   = steady_clock::now();
+    dy_t    doc     = dy_parse_json(json.data(), json.size(), NULL);
+    dy_t    records = dy_get_map_key(doc, "records").val;
+    int64_t sum     = 0;
+    for (size_t i = 0; i < dy_get_arr_len(records); ++i)
+    {
+        dy_t record = dy_get_arr_idx(records, i);
+        sum += dy_get_i(dy_get_map_key(record, "score").val);
+    }
+    dy_dispose(doc);
+    double whole = seconds_since(begin);
+
+    summer heap { NULL };
+    double streamed = stream(json, heap);
+
+    dy_arena_t arena = dy_arena_create(0);
+    summer     recycled { arena };
+    double arena_streamed = stream(json, recycled);
+
+    if (heap.sum != sum || recycled.sum != sum || heap.count != record_count)
+        return 1;
+
+    printf("%-28s %10.2f\n", "json (MB)", json.size() / 1e6);
+    printf("%-28s %10.3f\n", "parse whole (GB/s)", json.size() / whole / 1e9);
+    printf("%-28s %10.3f\n",
+           "stream, heap (GB/s)",
+           json.size() / streamed / 1e9);
+    printf("%-28s %10.3f\n",
+           "stream, arena (GB/s)",
+           json.size() / arena_streamed / 1e9);
+    printf("%-28s %10.1f\n", "arena held, peak (KB)", recycled.peak / 1e3);
+
+    dy_arena_destroy(arena);
+    return 0;
+}
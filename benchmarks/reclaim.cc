@@ -0,0 +1,98 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t record_count   = 1000;
+constexpr size_t response_count = 2000;
+
+/// <summary>
+/// makes a response of 1000 records in the arena, which is copied to the heap
+/// for each request
+/// </summary>
+dy_t make_response(dy_arena_t arena) noexcept
+{
+    dy_builder_t builder = dy_builder_create(arena);
+    dy_builder_begin_arr(builder, record_count);
+    for (size_t i = 0; i < record_count; ++i)
+    {
+        string user = "user " + to_string(i);
+
+        dy_builder_begin_map(builder, 4);
+        dy_builder_key(builder, "id");
+        dy_builder_push_i(builder, i << 40);
+        dy_builder_key(builder, "user");
+        dy_builder_push_str(builder, user.c_str());
+        dy_builder_key(builder, "score");
+        dy_builder_push_f(builder, i * 0.25);
+        dy_builder_key(builder, "tags");
+        dy_builder_begin_arr(builder, 2);
+        dy_builder_push_str(builder, "a");
+        dy_builder_push_str(builder, "b");
+        dy_builder_end(builder);
+        dy_builder_end(builder);
+    }
+    dy_builder_end(builder);
+
+    dy_t val = dy_builder_finish(builder);
+    dy_builder_destroy(builder);
+    return val;
+}
+
+/// <summary>
+/// drops a copy of the response after each request
+/// </summary>
+/// <returns>the microseconds the caller spent in each call</returns>
+template <typename Fn>
+vector<double> measure(dy_t response, Fn&& dispose)
+{
+    vector<double> times;
+    for (size_t i = 0; i < response_count; ++i)
+    {
+        dy_t copy = dy_copy(response);
+
+        auto begin = steady_clock::now();
+        dispose(copy);
+        times.push_back(
+            duration<double, micro>(steady_clock::now() - begin).count());
+    }
+
+    sort(times.begin(), times.end());
+    return times;
+}
+
+void print(char const* name, vector<double> const& times)
+{
+    printf("%-22s p50 %10.2f us  p99 %10.2f us\n",
+           name,
+           times[times.size() / 2],
+           times[times.size() * 99 / 100]);
+}
+
+}
+
+int main()
+{
+    dy_arena_t arena    = dy_arena_create(0);
+    dy_t       response = make_response(arena);
+
+    auto inline_times   = measure(response, dy_dispose);
+    auto deferred_times = measure(response, dy_dispose_deferred);
+    dy_reclaim_flush();
+    dy_arena_destroy(arena);
+
+    print("dy_dispose", inline_times);
+    print("dy_dispose_deferred", deferred_times);
+    return 0;
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t map_count = 1000000;
+constexpr size_t key_count = 8;
+
+/// <summary>
+/// keeps the compiler from discarding the results
+/// </summary>
+volatile size_t sink;
+
+/// <summary>
+/// runs the function once
+/// </summary>
+/// <returns>the nanoseconds taken by an entry</returns>
+template <typename Fn>
+double measure(Fn&& fn)
+{
+    auto begin = steady_clock::now();
+    fn();
+    return duration<double, nano>(steady_clock::now() - begin).count()
+           / (map_count * key_count);
+}
+
+/// <summary>
+/// makes small maps with the same keys, whose string values are allocated in
+/// a random order so that reading them misses the cache as in a long-running
+/// process
+/// </summary>
+vector<dy_t> make_maps()
+{
+    vector<dy_t> values(map_count * key_count);
+    vector<size_t> order(values.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    shuffle(order.begin(), order.end(), mt19937_64(0));
+    for (auto i : order) values[i] = dy_make_str("a value of the map");
+
+    char const* keys[key_count] = { "id",   "user", "name", "mail",
+                                    "city", "zip",  "role", "note" };
+
+    vector<dy_t> maps;
+    for (size_t m = 0; m < map_count; ++m)
+    {
+        dy_keyval_t pairs[key_count];
+        for (size_t k = 0; k < key_count; ++k)
+            pairs[k] = { keys[k], values[m * key_count + k] };
+        maps.push_back(dy_make_map(pairs, key_count));
+    }
+    return maps;
+}
+
+bool add_len(void* ctx, dy_keyval_t keyval)
+{
+    *static_cast<size_t*>(ctx) += dy_get_str_len(keyval.val);
+    return true;
+}
+
+}
+
+int main()
+{
+    vector<dy_t> maps = make_maps();
+
+    double heap_iter = measure([&] {
+        size_t acc = 0;
+        for (auto map : maps)
+        {
+            dy_iter_t iter = dy_make_map_iter(map);
+            for (dy_keyval_t kv = dy_get_map_iter(map, iter); kv.key != nullptr;
+                 kv             = dy_get_map_iter(map, iter))
+                acc += dy_get_str_len(kv.val);
+            dy_dispose_map_iter(iter);
+        }
+        sink = acc;
+    });
+
+    double stack_iter = measure([&] {
+        size_t acc = 0;
+        for (auto map : maps)
+        {
+            dy_iter_state_t state;
+            dy_init_map_iter(map, &state);
+            for (dy_keyval_t kv = dy_get_map_iter(map, &state);
+                 kv.key != nullptr;
+                 kv = dy_get_map_iter(map, &state))
+                acc += dy_get_str_len(kv.val);
+        }
+        sink = acc;
+    });
+
+    double foreach = measure([&] {
+        size_t acc = 0;
+        for (auto map : maps) dy_map_foreach(map, add_len, &acc);
+        sink = acc;
+    });
+
+    double exported = measure([&] {
+        size_t      acc = 0;
+        dy_keyval_t pairs[key_count];
+        for (auto map : maps)
+        {
+            size_t len = dy_map_export(map, pairs, key_count);
+            for (size_t i = 0; i < len; ++i)
+                acc += dy_get_str_len(pairs[i].val);
+        }
+        sink = acc;
+    });
+
+    for (auto map : maps) dy_dispose(map);
+
+    printf("%-28s %10.2f ns/entry\n", "dy_make_map_iter", heap_iter);
+    printf("%-28s %10.2f ns/entry\n", "dy_init_map_iter", stack_iter);
+    printf("%-28s %10.2f ns/entry\n", "dy_map_foreach", foreach);
+    printf("%-28s %10.2f ns/entry\n", "dy_map_export", exported);
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr size_t fanout = 10;
+constexpr size_t depth  = 7;
+
+/// <summary>
+/// builds arrays with the fanout down to the depth, whose leaves are strings,
+/// making 11.1M values of which 10M are leaves
+/// </summary>
+void build_tree(dy_builder_t builder, size_t level) noexcept
+{
+    if (level == depth)
+    {
+        dy_builder_push_str(builder, "a leaf of the tree");
+        return;
+    }
+
+    dy_builder_begin_arr(builder, fanout);
+    for (size_t i = 0; i < fanout; ++i) build_tree(builder, level + 1);
+    dy_builder_end(builder);
+}
+
+/// <summary>
+/// runs the function once
+/// </summary>
+/// <returns>the milliseconds taken</returns>
+template <typename Fn>
+double measure(Fn&& fn)
+{
+    auto begin = steady_clock::now();
+    fn();
+    return duration<double, milli>(steady_clock::now() - begin).count();
+}
+
+}
+
+int main()
+{
+    dy_arena_t   arena   = dy_arena_create(0);
+    dy_builder_t builder = dy_builder_create(arena);
+    build_tree(builder, 0);
+    dy_t tree = dy_builder_finish(builder);
+    dy_builder_destroy(builder);
+
+    // copies of arena values are deep copies, and disposing them walks the
+    // whole tree as well. The first round warms up the heap.
+    dy_dispose(dy_copy(tree));
+
+    dy_t   copy           = nullptr;
+    double serial_copy    = measure([&] { copy = dy_copy(tree); });
+    double serial_dispose = measure([&] { dy_dispose(copy); });
+
+    double parallel_copy    = measure([&] { copy = dy_copy_parallel(tree); });
+    double parallel_dispose = measure([&] { dy_dispose_parallel(copy); });
+    dy_arena_destroy(arena);
+
+    printf("%u hardware threads\n", thread::hardware_concurrency());
+    printf("%-22s %10.1f ms\n", "dy_copy", serial_copy);
+    printf("%-22s %10.1f ms\n", "dy_copy_parallel", parallel_copy);
+    printf("%-22s %10.1f ms\n", "dy_dispose", serial_dispose);
+    printf("%-22s %10.1f ms\n", "dy_dispose_parallel", parallel_dispose);
+    return 0;
+}
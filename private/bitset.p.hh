@@ -0,0 +1,269 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#ifndef DY_BITSET_P_HH
+#define DY_BITSET_P_HH
+
+#include <buffer.p.hh>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <utility>
+
+namespace dy
+{
+
+/// <summary>
+/// a fixed-size array of bits packed into 64-bit words. The bit at index
+/// <c>i</c> is the bit <c>i % 64</c> of the word <c>i / 64</c>, counting from
+/// the least significant bit, and the bits after the last one are zero.
+/// </summary>
+class bitset
+{
+  public:
+    using value_type = bool;
+
+    static constexpr size_t word_bits = 64;
+
+    /// <summary>
+    /// returns the number of the words holding the bits
+    /// </summary>
+    static constexpr size_t word_count(size_t len) noexcept
+    {
+        return (len + word_bits - 1) / word_bits;
+    }
+
+    /// <summary>
+    /// packs the booleans
+    /// </summary>
+    bitset(bool const*                first,
+           bool const*                last,
+           std::pmr::memory_resource* res) :
+        bitset(static_cast<size_t>(last - first), res)
+    {
+        pack(first, size_, words_.data());
+    }
+
+    /// <summary>
+    /// sets every bit to the value
+    /// </summary>
+    bitset(size_t len, bool value, std::pmr::memory_resource* res) :
+        bitset(len, res)
+    {
+        std::memset(words_.data(), value ? 0xff : 0, words_.size() * 8);
+        clear_tail();
+    }
+
+    /// <summary>
+    /// copies the bits packed into bytes, in which the bit at index <c>i</c>
+    /// is the bit <c>i % 8</c> of the byte <c>i / 8</c>. The bits after the
+    /// last one are ignored.
+    /// </summary>
+    bitset(uint8_t const*             bytes,
+           size_t                     len,
+           std::pmr::memory_resource* res) :
+        bitset(len, res)
+    {
+        size_t count = (len + 7) / 8;
+        if constexpr (std::endian::native == std::endian::little)
+            std::memcpy(words_.data(), bytes, count);
+        else
+            for (size_t i = 0; i < count; ++i)
+                words_[i / 8] |= uint64_t(bytes[i]) << (i % 8 * 8);
+        clear_tail();
+    }
+
+    /// <summary>
+    /// copies the words. The bits after the last one must be zero.
+    /// </summary>
+    bitset(uint64_t const*            words,
+           size_t                     len,
+           std::pmr::memory_resource* res) :
+        words_ { words, words + word_count(len), res },
+        size_ { len }
+    {
+        clear_tail();
+    }
+
+    /// <summary>
+    /// takes the words. The bits after the last one must be zero.
+    /// </summary>
+    bitset(buffer<uint64_t>&& words, size_t len) noexcept :
+        words_ { std::move(words) },
+        size_ { len }
+    {}
+
+    /// <summary>
+    /// copies the bits of the other bitset
+    /// </summary>
+    bitset(bitset const& other, std::pmr::memory_resource* res) :
+        words_ { other.words_, res },
+        size_ { other.size_ }
+    {}
+
+    bitset(bitset&& other) noexcept = default;
+
+    bitset(bitset const&) = delete;
+
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    uint64_t const* words() const noexcept
+    {
+        return words_.data();
+    }
+
+    bool operator[](size_t idx) const noexcept
+    {
+        return (words_[idx / word_bits] >> (idx % word_bits)) & 1;
+    }
+
+    /// <summary>
+    /// unpacks the bits into booleans
+    /// </summary>
+    /// <param name="first">the index of the first bit</param>
+    /// <param name="len">the number of the bits</param>
+    /// <param name="out">the booleans</param>
+    void unpack(size_t first, size_t len, bool* out) const noexcept
+    {
+        size_t idx = first, last = first + len;
+
+        // unpacks 8 bits at a time from the byte-aligned ones
+        for (; idx % 8 != 0 && idx < last; ++idx) *out++ = (*this)[idx];
+        for (; idx + 8 <= last; idx += 8, out += 8)
+            unpack_byte(words_[idx / word_bits] >> (idx % word_bits), out);
+        for (; idx < last; ++idx) *out++ = (*this)[idx];
+    }
+
+    /// <summary>
+    /// returns the number of the set bits
+    /// </summary>
+    size_t popcount() const noexcept
+    {
+        size_t count = 0;
+        for (uint64_t word : words_) count += std::popcount(word);
+        return count;
+    }
+
+    /// <summary>
+    /// returns the index of the first set bit at or after the index, or the
+    /// size of the bitset if there is none
+    /// </summary>
+    size_t find_first(size_t first) const noexcept
+    {
+        if (first >= size_) return size_;
+
+        size_t   idx  = first / word_bits;
+        uint64_t word = words_[idx] & (~uint64_t(0) << (first % word_bits));
+        for (size_t count = words_.size(); word == 0;)
+        {
+            if (++idx == count) return size_;
+            word = words_[idx];
+        }
+        return idx * word_bits + std::countr_zero(word);
+    }
+
+    /// <summary>
+    /// combines the words of the bitsets of the same size
+    /// </summary>
+    /// <param name="lhs">the first bitset</param>
+    /// <param name="rhs">the second bitset</param>
+    /// <param name="op">the function combining two words</param>
+    /// <param name="res">the memory resource</param>
+    /// <returns>a new bitset</returns>
+    template <typename Op>
+    static bitset combine(bitset const&              lhs,
+                          bitset const&              rhs,
+                          Op                         op,
+                          std::pmr::memory_resource* res)
+    {
+        bitset          result(lhs.size_, res);
+        uint64_t*       out = result.words_.data();
+        uint64_t const* a   = lhs.words_.data();
+        uint64_t const* b   = rhs.words_.data();
+        for (size_t i = 0, count = result.words_.size(); i < count; ++i)
+            out[i] = op(a[i], b[i]);
+        return result;
+    }
+
+  private:
+    buffer<uint64_t> words_;
+    size_t           size_;
+
+    /// <summary>
+    /// allocates the words, which are cleared
+    /// </summary>
+    bitset(size_t len, std::pmr::memory_resource* res) :
+        words_ { word_count(len), 0, res },
+        size_ { len }
+    {}
+
+    /// <summary>
+    /// clears the bits after the last one
+    /// </summary>
+    void clear_tail() noexcept
+    {
+        if (size_ % word_bits != 0)
+            words_[size_ / word_bits] &= ~(~uint64_t(0) << (size_ % word_bits));
+    }
+
+    /// <summary>
+    /// packs the booleans into the words. The bits after the last one are
+    /// cleared.
+    /// </summary>
+    static void pack(bool const* in, size_t len, uint64_t* words) noexcept
+    {
+        for (size_t w = 0, count = word_count(len); w < count; ++w)
+        {
+            size_t   first = w * word_bits;
+            size_t   n     = std::min(word_bits, len - first);
+            uint64_t word  = 0;
+
+            size_t i = 0;
+            if constexpr (std::endian::native == std::endian::little)
+            {
+                // gathers the lowest bits of 8 bytes into one byte
+                for (; i + 8 <= n; i += 8)
+                {
+                    uint64_t bytes;
+                    std::memcpy(&bytes, in + first + i, 8);
+                    word |= ((bytes * UINT64_C(0x0102040810204080)) >> 56) << i;
+                }
+            }
+            for (; i < n; ++i) word |= uint64_t(in[first + i]) << i;
+
+            words[w] = word;
+        }
+    }
+
+    /// <summary>
+    /// unpacks the lowest 8 bits into booleans
+    /// </summary>
+    static void unpack_byte(uint64_t bits, bool* out) noexcept
+    {
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            // spreads the byte, keeps the bit i in the byte i, and moves any
+            // set bit to the lowest one of the byte
+            uint64_t bytes = (bits & 0xff) * UINT64_C(0x0101010101010101);
+            bytes &= UINT64_C(0x8040201008040201);
+            bytes = ((bytes + UINT64_C(0x7f7f7f7f7f7f7f7f))
+                     & UINT64_C(0x8080808080808080))
+                    >> 7;
+            std::memcpy(out, &bytes, 8);
+        }
+        else
+        {
+            for (int i = 0; i < 8; ++i) out[i] = (bits >> i) & 1;
+        }
+    }
+};
+
+}
+
+#endif
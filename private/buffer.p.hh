@@ -0,0 +1,254 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#ifndef DY_BUFFER_P_HH
+#define DY_BUFFER_P_HH
+
+#include <dy.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace dy
+{
+
+/// <summary>
+/// an array of trivially copyable elements. The elements are either
+/// allocated from a memory resource or adopted from the caller, in which case
+/// the buffer frees them with the function given by the caller. Buffers of
+/// characters are always followed by a NUL terminator, which is not counted in
+/// the size.
+/// </summary>
+/// <typeparam name="T">the type of the elements</typeparam>
+template <typename T>
+class buffer
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+  public:
+    using value_type = T;
+
+    /// <summary>
+    /// the number of the elements allocated after the last one
+    /// </summary>
+    static constexpr size_t terminator = std::is_same_v<T, char> ? 1 : 0;
+
+    /// <summary>
+    /// copies the elements
+    /// </summary>
+    buffer(T const* first, T const* last, std::pmr::memory_resource* res) :
+        buffer(static_cast<size_t>(last - first), res)
+    {
+        std::copy(first, last, data_);
+    }
+
+    /// <summary>
+    /// allocates the elements from the memory resource, which are left
+    /// uninitialized
+    /// </summary>
+    buffer(size_t len, std::pmr::memory_resource* res) :
+        data_ { static_cast<T*>(
+            res->allocate((len + terminator) * sizeof(T), alignof(T))) },
+        size_ { len },
+        capacity_ { len },
+        res_ { res },
+        free_fn_ { nullptr },
+        ctx_ { nullptr }
+    {
+        if constexpr (terminator != 0) data_[len] = T {};
+    }
+
+    /// <summary>
+    /// fills the buffer with the value
+    /// </summary>
+    buffer(size_t len, T const& value, std::pmr::memory_resource* res) :
+        buffer(len, res)
+    {
+        std::fill_n(data_, len, value);
+    }
+
+    /// <summary>
+    /// copies the elements of the other buffer
+    /// </summary>
+    buffer(buffer const& other, std::pmr::memory_resource* res) :
+        buffer(other.begin(), other.end(), res)
+    {}
+
+    /// <summary>
+    /// adopts the elements, which are freed with the function when the buffer
+    /// is destroyed
+    /// </summary>
+    /// <param name="ptr">the elements, followed by a terminator if any</param>
+    /// <param name="len">the number of the elements</param>
+    /// <param name="free_fn">the function called with the elements and the
+    /// context, or <c>NULL</c> not to free them</param>
+    /// <param name="ctx">the context passed to the function</param>
+    buffer(T* ptr, size_t len, dy_free_fn_t free_fn, void* ctx) noexcept :
+        data_ { ptr },
+        size_ { len },
+        capacity_ { len },
+        res_ { nullptr },
+        free_fn_ { free_fn },
+        ctx_ { ctx }
+    {}
+
+    buffer(buffer&& other) noexcept :
+        data_ { std::exchange(other.data_, nullptr) },
+        size_ { std::exchange(other.size_, 0) },
+        capacity_ { std::exchange(other.capacity_, 0) },
+        res_ { std::exchange(other.res_, nullptr) },
+        free_fn_ { std::exchange(other.free_fn_, nullptr) },
+        ctx_ { std::exchange(other.ctx_, nullptr) }
+    {}
+
+    buffer(buffer const&) = delete;
+
+    ~buffer() noexcept
+    {
+        deallocate();
+    }
+
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    T* data() noexcept
+    {
+        return data_;
+    }
+
+    T const* data() const noexcept
+    {
+        return data_;
+    }
+
+    T* begin() noexcept
+    {
+        return data_;
+    }
+
+    T* end() noexcept
+    {
+        return data_ + size_;
+    }
+
+    T const* begin() const noexcept
+    {
+        return data_;
+    }
+
+    T const* end() const noexcept
+    {
+        return data_ + size_;
+    }
+
+    T& operator[](size_t idx) noexcept
+    {
+        return data_[idx];
+    }
+
+    T const& operator[](size_t idx) const noexcept
+    {
+        return data_[idx];
+    }
+
+    /// <summary>
+    /// returns whether the elements are allocated from the memory resource
+    /// </summary>
+    bool owned_by(std::pmr::memory_resource* res) const noexcept
+    {
+        return res_ == res;
+    }
+
+    /// <summary>
+    /// makes room for the elements, which are reallocated from the memory
+    /// resource unless they are allocated from it with enough room
+    /// </summary>
+    /// <param name="len">the number of the elements</param>
+    void reserve(size_t len, std::pmr::memory_resource* res)
+    {
+        if (res_ == res && capacity_ >= len) return;
+
+        len     = std::max(len, size_);
+        T* data = static_cast<T*>(
+            res->allocate((len + terminator) * sizeof(T), alignof(T)));
+        if (size_ + terminator != 0)
+            std::copy_n(data_, size_ + terminator, data);
+
+        deallocate();
+        data_     = data;
+        capacity_ = len;
+        res_      = res;
+        free_fn_  = nullptr;
+        ctx_      = nullptr;
+    }
+
+    /// <summary>
+    /// appends the elements, growing the buffer geometrically
+    /// </summary>
+    /// <param name="ptr">the elements, which are not in the buffer</param>
+    /// <param name="len">the number of the elements</param>
+    void append(T const* ptr, size_t len, std::pmr::memory_resource* res)
+    {
+        if (res_ != res || capacity_ - size_ < len)
+            reserve(std::max(size_ + len, capacity_ * 2), res);
+
+        std::copy_n(ptr, len, data_ + size_);
+        size_ += len;
+        if constexpr (terminator != 0) data_[size_] = T {};
+    }
+
+    /// <summary>
+    /// hands the elements out, leaving the buffer empty
+    /// </summary>
+    /// <param name="free_fn">set to the function which frees the elements, or
+    /// <c>NULL</c> if they need not be freed</param>
+    /// <param name="ctx">set to the context passed to the function</param>
+    /// <param name="res_free_fn">the function which frees the elements
+    /// allocated from the memory resource, which is given the resource as the
+    /// context</param>
+    /// <returns>the elements</returns>
+    T* release(dy_free_fn_t* free_fn,
+               void**        ctx,
+               dy_free_fn_t  res_free_fn) noexcept
+    {
+        *free_fn = res_ != nullptr ? res_free_fn : free_fn_;
+        *ctx     = res_ != nullptr ? static_cast<void*>(res_) : ctx_;
+
+        res_      = nullptr;
+        free_fn_  = nullptr;
+        ctx_      = nullptr;
+        size_     = 0;
+        capacity_ = 0;
+        return std::exchange(data_, nullptr);
+    }
+
+  private:
+    T*     data_;
+    size_t size_;
+
+    /// <summary>
+    /// the number of the elements allocated, not counting the terminator
+    /// </summary>
+    size_t                     capacity_;
+    std::pmr::memory_resource* res_;
+    dy_free_fn_t               free_fn_;
+    void*                      ctx_;
+
+    void deallocate() noexcept
+    {
+        if (res_ != nullptr)
+            res_->deallocate(
+                data_, (capacity_ + terminator) * sizeof(T), alignof(T));
+        else if (free_fn_ != nullptr)
+            free_fn_(data_, ctx_);
+    }
+};
+
+}
+
+#endif
@@ -1,26 +1,265 @@
 // Copyright (c) 2020 Stella Authors. All rights reserved.
 
+#ifndef DY_P_HH
+#define DY_P_HH
+
 #include <dy.h>
 
+#include <atomic>
+#include <bit>
+#include <bitset.p.hh>
+#include <buffer.p.hh>
 #include <cstddef>
+#include <cstdint>
+#include <lazy.p.hh>
+#include <map.p.hh>
+#include <mapped.p.hh>
+#include <memory_resource>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
+namespace dy
+{
+
+/// <summary>
+/// flags stored in every value instance
+/// </summary>
+enum node_flag : uint8_t
+{
+    /// <summary>
+    /// the instance and its internal data live in an arena and must not be
+    /// deallocated one by one
+    /// </summary>
+    flag_arena = 1 << 0,
+
+    /// <summary>
+    /// the internal data references memory owned elsewhere, which is neither
+    /// modified nor freed
+    /// </summary>
+    flag_view = 1 << 1,
+
+    /// <summary>
+    /// the generic array or map reads its entries from a mapped file through
+    /// <c>dy::mapped_ref</c>. Always set with <c>flag_arena</c>.
+    /// </summary>
+    flag_mapped = 1 << 2,
+
+    /// <summary>
+    /// the generic array or map is parsed from its JSON text on the first
+    /// read through <c>dy::lazy_ref</c>. Never set with <c>flag_arena</c>.
+    /// </summary>
+    flag_lazy = 1 << 3,
+};
+
+/// <summary>
+/// returns the memory resource used by the values not created in an arena.
+/// Memory is obtained with <c>malloc</c> and returned with <c>free</c>.
+/// </summary>
+/// <returns>the heap memory resource</returns>
+std::pmr::memory_resource* heap() noexcept;
+
+/// <summary>
+/// releases a reference to the value without deallocating it
+/// </summary>
+/// <returns><c>true</c> if it was the last one and the value is to be passed
+/// to <c>dy::free_tree</c>, <c>false</c> otherwise</returns>
+bool drop_ref(dy_t val) noexcept;
+
+/// <summary>
+/// deallocates the value whose last reference was released, releasing the
+/// values in it. The arrays and maps are followed with a stack on the heap, so
+/// deep trees do not overflow the stack of the thread.
+/// </summary>
+/// <param name="val">the instance on the heap</param>
+void free_tree(dy_t val) noexcept;
+
+/// <summary>
+/// makes a boolean array or an array of numbers from the bytes of its entries
+/// in little-endian order, which need not be aligned. The entries of boolean
+/// arrays are packed into the bytes from the least significant bit.
+/// </summary>
+/// <param name="res">the heap or an arena</param>
+/// <param name="type">the type of the array</param>
+/// <param name="bytes">the bytes to copy</param>
+/// <param name="len">the number of the entries</param>
+/// <returns>a new value instance</returns>
+dy_t make_packed(std::pmr::memory_resource* res,
+                 dy_type_t                  type,
+                 void const*                bytes,
+                 size_t                     len) noexcept;
+
+// Values which do not need a value instance are encoded in the handle. Value
+// instances are at least 8-byte aligned, so handles with any of the lowest 3
+// bits set never point to one. On 64-bit targets, integers which fit in 48 bits
+// and every double-precision number are NaN-boxed as well:
+//
+//   0000:pppp:pppp:pppp  a pointer to a value instance, or a special value
+//   0001:xxxx:xxxx:xxxx  a double-precision number, offset by 2^48
+//     ...
+//   fff1:xxxx:xxxx:xxxx
+//   ffff:iiii:iiii:iiii  a 48-bit signed integer
+//
+// This requires user space pointers to fit in 48 bits, which holds for every
+// supported 64-bit platform.
+
+#if UINTPTR_MAX == UINT64_MAX
+#    define DY_NANBOX 1
+#else
+#    define DY_NANBOX 0
+#endif
+
+constexpr uintptr_t imm_null  = 0x1;
+constexpr uintptr_t imm_false = 0x2;
+constexpr uintptr_t imm_true  = 0x3;
+
+#if DY_NANBOX
+constexpr uint64_t imm_double_offset = uint64_t(1) << 48;
+constexpr uint64_t imm_int_tag       = uint64_t(0xffff) << 48;
+constexpr int64_t  imm_int_min       = -(int64_t(1) << 47);
+constexpr int64_t  imm_int_max       = (int64_t(1) << 47) - 1;
+#endif
+
+/// <summary>
+/// returns the bits of the handle
+/// </summary>
+inline uintptr_t bits(dy_t val) noexcept
+{
+    return reinterpret_cast<uintptr_t>(val);
+}
+
+/// <summary>
+/// makes a handle from the bits
+/// </summary>
+inline dy_t handle(uintptr_t bits) noexcept
+{
+    return reinterpret_cast<dy_t>(bits);
+}
+
+/// <summary>
+/// checks whether the handle points to a value instance
+/// </summary>
+/// <param name="val">the handle, which must not be <c>NULL</c></param>
+/// <returns><c>true</c> if it does, <c>false</c> if the value is encoded in
+/// the handle</returns>
+inline bool is_node(dy_t val) noexcept
+{
+#if DY_NANBOX
+    return (bits(val) & (imm_int_tag | 0x7)) == 0;
+#else
+    return (bits(val) & 0x7) == 0;
+#endif
+}
+
+/// <summary>
+/// returns the type of a value encoded in the handle
+/// </summary>
+/// <param name="val">the handle, for which <c>is_node</c> is false</param>
+/// <returns>the type of the value</returns>
+inline dy_type_t imm_type(dy_t val) noexcept
+{
+    uintptr_t b = bits(val);
+    if (b == imm_null) return dy_type_null;
+    if (b == imm_false || b == imm_true) return dy_type_b;
+#if DY_NANBOX
+    if ((b & imm_int_tag) == imm_int_tag) return dy_type_i;
+#endif
+    return dy_type_f;
+}
+
+/// <summary>
+/// encodes a boolean value in a handle
+/// </summary>
+inline dy_t imm_b(bool b) noexcept
+{
+    return handle(b ? imm_true : imm_false);
+}
+
+/// <summary>
+/// encodes an integer in a handle
+/// </summary>
+/// <returns>the handle, or <c>nullptr</c> if the integer does not fit</returns>
+inline dy_t imm_i(int64_t i) noexcept
+{
+#if DY_NANBOX
+    if (i < imm_int_min || imm_int_max < i) return nullptr;
+    return handle((static_cast<uint64_t>(i) & ~imm_int_tag) | imm_int_tag);
+#else
+    return nullptr;
+#endif
+}
+
+/// <summary>
+/// encodes a double-precision number in a handle. Every NaN is replaced with
+/// the canonical quiet NaN.
+/// </summary>
+/// <returns>the handle, or <c>nullptr</c> if the number does not fit</returns>
+inline dy_t imm_f(double f) noexcept
+{
+#if DY_NANBOX
+    uint64_t b = f == f ? std::bit_cast<uint64_t>(f)
+                        : UINT64_C(0x7ff8000000000000);
+    return handle(b + imm_double_offset);
+#else
+    return nullptr;
+#endif
+}
+
+/// <summary>
+/// decodes a boolean value from a handle
+/// </summary>
+inline bool imm_get_b(dy_t val) noexcept
+{
+    return bits(val) == imm_true;
+}
+
+/// <summary>
+/// decodes an integer from a handle
+/// </summary>
+inline int64_t imm_get_i(dy_t val) noexcept
+{
+#if DY_NANBOX
+    // sign-extends the lower 48 bits
+    return static_cast<int64_t>(bits(val) << 16) >> 16;
+#else
+    return 0;
+#endif
+}
+
+/// <summary>
+/// decodes a double-precision number from a handle
+/// </summary>
+inline double imm_get_f(dy_t val) noexcept
+{
+#if DY_NANBOX
+    return std::bit_cast<double>(bits(val) - imm_double_offset);
+#else
+    return 0;
+#endif
+}
+
+}
+
 typedef union _dy_data_t
 {
   public:
-    std::nullptr_t                        null;
-    bool                                  b;
-    int64_t                               i;
-    double                                f;
-    std::string                           str;
-    std::vector<bool>                     barr;
-    std::vector<uint8_t>                  bytes;
-    std::vector<int64_t>                  iarr;
-    std::vector<double>                   farr;
-    std::vector<dy_t>                     arr;
-    std::unordered_map<std::string, dy_t> map;
+    std::nullptr_t          null;
+    bool                    b;
+    int64_t                 i;
+    double                  f;
+    dy::buffer<char>        str;
+    dy::bitset              barr;
+    dy::buffer<uint8_t>     bytes;
+    dy::buffer<int64_t>     iarr;
+    dy::buffer<double>      farr;
+    std::pmr::vector<dy_t>  arr;
+    dy::map                 map;
+    dy::buffer<int8_t>      i8arr;
+    dy::buffer<int16_t>     i16arr;
+    dy::buffer<int32_t>     i32arr;
+    dy::buffer<uint32_t>    u32arr;
+    dy::buffer<float>       f32arr;
+    dy::mapped_ref          mapped;
+    dy::lazy_ref            lazy;
     ~_dy_data_t() {}
 } dy_data_t;
 
@@ -28,9 +267,23 @@ struct _dy_val_t
 {
   public:
     /// <summary>
-    /// The type of the value
+    /// The type of the value. Packed with the flags so that the reference count
+    /// fits in the same 8 bytes.
+    /// </summary>
+    dy_type_t type : 8;
+
+    /// <summary>
+    /// The combination of <c>dy::node_flag</c>s
     /// </summary>
-    dy_type_t type;
+    uint8_t flags;
+
+    /// <summary>
+    /// The number of the references to the value on the heap. Values are
+    /// immutable while shared, so copying one only adds a reference, and
+    /// a mutation must copy the value first unless this is one. Not counted
+    /// for values in arenas.
+    /// </summary>
+    std::atomic<uint32_t> refs { 1 };
 
     /// <summary>
     /// The data of the value
@@ -39,6 +292,8 @@ struct _dy_val_t
 
     ~_dy_val_t() DY_NOEXCEPT
     {
+        if (flags & dy::flag_lazy) return;
+
         switch (type)
         {
         default:
@@ -46,18 +301,84 @@ struct _dy_val_t
         case dy_type_b:
         case dy_type_i:
         case dy_type_f: break;
-        case dy_type_str: data.str.~basic_string(); break;
-        case dy_type_bytes: data.bytes.~vector(); break;
-        case dy_type_barr: data.barr.~vector(); break;
-        case dy_type_iarr: data.iarr.~vector(); break;
-        case dy_type_farr: data.farr.~vector(); break;
+        case dy_type_str: data.str.~buffer(); break;
+        case dy_type_bytes: data.bytes.~buffer(); break;
+        case dy_type_barr: data.barr.~bitset(); break;
+        case dy_type_iarr: data.iarr.~buffer(); break;
+        case dy_type_farr: data.farr.~buffer(); break;
         case dy_type_arr: data.arr.~vector(); break;
-        case dy_type_map: data.map.~unordered_map(); break;
+        case dy_type_map: data.map.~map(); break;
+        case dy_type_i8arr: data.i8arr.~buffer(); break;
+        case dy_type_i16arr: data.i16arr.~buffer(); break;
+        case dy_type_i32arr: data.i32arr.~buffer(); break;
+        case dy_type_u32arr: data.u32arr.~buffer(); break;
+        case dy_type_f32arr: data.f32arr.~buffer(); break;
         }
     }
 };
 
-struct _dy_iter_t
+struct _dy_arena_t : public std::pmr::memory_resource
 {
-    std::unordered_map<std::string, dy_t>::iterator it;
-};
\ No newline at end of file
+  public:
+    /// <summary>
+    /// header of a block obtained from the heap
+    /// </summary>
+    struct block
+    {
+        block* next;
+        size_t size;
+    };
+
+    /// <summary>
+    /// the size of the blocks allocated when the current one is exhausted
+    /// </summary>
+    size_t block_size;
+
+    /// <summary>
+    /// the first block. Blocks are kept in allocation order.
+    /// </summary>
+    block* head;
+
+    /// <summary>
+    /// the block bump allocations are served from
+    /// </summary>
+    block* current;
+
+    /// <summary>
+    /// the first free byte of the current block
+    /// </summary>
+    char* cur;
+
+    /// <summary>
+    /// the end of the current block
+    /// </summary>
+    char* end;
+
+    explicit _dy_arena_t(size_t block_size) noexcept;
+
+    _dy_arena_t(_dy_arena_t const&) = delete;
+
+    ~_dy_arena_t() noexcept;
+
+    /// <summary>
+    /// makes every block available again. Blocks larger than
+    /// <c>block_size</c> are returned to the heap.
+    /// </summary>
+    void reset() noexcept;
+
+  protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(memory_resource const& other) const noexcept override;
+
+  private:
+    /// <summary>
+    /// moves to the next block which can hold the request, allocating one if
+    /// needed
+    /// </summary>
+    void next_block(size_t bytes, size_t alignment) noexcept;
+};
+
+#endif
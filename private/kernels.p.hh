@@ -0,0 +1,123 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#ifndef DY_KERNELS_P_HH
+#define DY_KERNELS_P_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace dy
+{
+
+/// <summary>
+/// the types of the entries of the arrays of numbers
+/// </summary>
+enum elem_type : uint8_t
+{
+    elem_u8,
+    elem_i8,
+    elem_i16,
+    elem_i32,
+    elem_u32,
+    elem_i64,
+    elem_f32,
+    elem_f64,
+    elem_type_count,
+};
+
+/// <summary>
+/// converts the entries of an array of numbers to another type
+/// </summary>
+using convert_fn = void (*)(void const* ptr, void* out, size_t len);
+
+/// <summary>
+/// the conversions indexed by the source and the destination types
+/// </summary>
+using convert_table
+    = std::array<std::array<convert_fn, elem_type_count>, elem_type_count>;
+
+/// <summary>
+/// the reduction, scan and conversion kernels over arrays of numbers, and the
+/// scanner of JSON text. Masks are packed as in <c>dy::bitset</c>. Every
+/// implementation visits the elements in the same order, so the results do not
+/// depend on the instruction set.
+/// </summary>
+struct kernel_table
+{
+    /// <summary>
+    /// the name of the instruction set the kernels are compiled for
+    /// </summary>
+    char const* name;
+
+    int64_t (*iarr_sum)(int64_t const* ptr, size_t len);
+    int64_t (*iarr_min)(int64_t const* ptr, size_t len);
+    int64_t (*iarr_max)(int64_t const* ptr, size_t len);
+
+    int64_t (*iarr_sum_masked)(int64_t const*  ptr,
+                               uint64_t const* mask,
+                               size_t          len);
+    int64_t (*iarr_min_masked)(int64_t const*  ptr,
+                               uint64_t const* mask,
+                               size_t          len);
+    int64_t (*iarr_max_masked)(int64_t const*  ptr,
+                               uint64_t const* mask,
+                               size_t          len);
+
+    void (*iarr_prefix_sum)(int64_t const* ptr, int64_t* out, size_t len);
+
+    double (*farr_sum)(double const* ptr, size_t len);
+    double (*farr_sum_masked)(double const*   ptr,
+                              uint64_t const* mask,
+                              size_t          len);
+
+    double (*farr_dot)(double const* lhs, double const* rhs, size_t len);
+    double (*farr_dot_masked)(double const*   lhs,
+                              double const*   rhs,
+                              uint64_t const* mask,
+                              size_t          len);
+
+    void (*farr_prefix_sum)(double const* ptr, double* out, size_t len);
+
+    convert_table convert;
+
+    /// <summary>
+    /// finds the structural characters of JSON text, which are the brackets,
+    /// braces, colons and commas outside strings, the quotes opening strings,
+    /// and the first characters of the other values
+    /// </summary>
+    /// <param name="ptr">the text</param>
+    /// <param name="len">
+    /// the length of the text, which is less than 4 GiB
+    /// </param>
+    /// <param name="out">the offsets of the characters, which has room for
+    /// <c>len</c> entries</param>
+    /// <param name="ascii_len">set to the length of the prefix of the text
+    /// without non-ASCII characters, rounded down to a multiple of 64</param>
+    /// <returns>the number of the offsets</returns>
+    size_t (*json_index)(char const* ptr,
+                         size_t      len,
+                         uint32_t*   out,
+                         size_t*     ascii_len);
+
+    /// <summary>
+    /// finds the first character which must be escaped in JSON strings, which
+    /// are the quotes, the backslashes and the control characters
+    /// </summary>
+    /// <param name="ptr">the characters</param>
+    /// <param name="len">the number of the characters</param>
+    /// <returns>the offset of the character, or <c>len</c> if there is
+    /// none</returns>
+    size_t (*json_escape_len)(char const* ptr, size_t len);
+};
+
+/// <summary>
+/// returns the kernels for the best instruction set the processor supports,
+/// which is detected on the first call
+/// </summary>
+/// <returns>the kernels</returns>
+kernel_table const& kernels() noexcept;
+
+}
+
+#endif
@@ -0,0 +1,36 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#ifndef DY_KEY_P_HH
+#define DY_KEY_P_HH
+
+#include <dy.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// an interned key. Interned keys are never freed, so the pointer to the
+/// characters is valid until the process exits.
+/// </summary>
+struct _dy_key_t
+{
+    /// <summary>
+    /// the result of <c>dy::hash_bytes</c> on the key
+    /// </summary>
+    uint64_t hash;
+
+    /// <summary>
+    /// the length of the key
+    /// </summary>
+    uint32_t len;
+
+    /// <summary>
+    /// returns the NUL-terminated key following the header
+    /// </summary>
+    char const* data() const noexcept
+    {
+        return reinterpret_cast<char const*>(this + 1);
+    }
+};
+
+#endif
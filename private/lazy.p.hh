@@ -0,0 +1,60 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#ifndef DY_LAZY_P_HH
+#define DY_LAZY_P_HH
+
+#include <dy.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// a document parsed lazily, holding the text and its structural index
+/// </summary>
+struct _dy_lazy_t;
+
+namespace dy
+{
+
+/// <summary>
+/// the internal data of the generic arrays and maps parsed lazily, which
+/// reference their text instead of holding their entries
+/// </summary>
+struct lazy_ref
+{
+    /// <summary>
+    /// the document the text is in, which is retained by every instance
+    /// </summary>
+    _dy_lazy_t* doc;
+
+    /// <summary>
+    /// the position of the opening bracket in the structural index
+    /// </summary>
+    size_t pos;
+
+    /// <summary>
+    /// the generic array or map on the heap holding the entries, which is
+    /// made on the first read. Its arrays and maps are lazy in turn.
+    /// </summary>
+    std::atomic<dy_t> level;
+};
+
+/// <summary>
+/// returns the generic array or map holding the entries of the lazy one,
+/// parsing them if not parsed yet
+/// </summary>
+/// <returns>the instance, which lives as long as <c>val</c></returns>
+dy_t lazy_level(dy_t val) noexcept;
+
+/// <summary>
+/// releases the document of the lazy array or map, before its instance is
+/// deallocated
+/// </summary>
+/// <returns>the instance holding the entries, whose reference is handed to the
+/// caller, or <c>nullptr</c> if not parsed</returns>
+dy_t lazy_release(dy_t val) noexcept;
+
+}
+
+#endif
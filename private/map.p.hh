@@ -0,0 +1,576 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#ifndef DY_MAP_P_HH
+#define DY_MAP_P_HH
+
+#include <dy.h>
+#include <key.p.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <cstring>
+#include <memory_resource>
+
+#if defined(__SSE2__) || defined(_M_X64)                                      \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define DY_SSE2 1
+#    include <emmintrin.h>
+#else
+#    define DY_SSE2 0
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#endif
+
+namespace dy
+{
+
+/// <summary>
+/// multiplies two numbers and folds the 128-bit product
+/// </summary>
+inline uint64_t hash_mix(uint64_t a, uint64_t b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t hi;
+    uint64_t lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#else
+    uint64_t ha = a >> 32, la = static_cast<uint32_t>(a);
+    uint64_t hb = b >> 32, lb = static_cast<uint32_t>(b);
+    uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    uint64_t mid = (ll >> 32) + static_cast<uint32_t>(hl)
+                   + static_cast<uint32_t>(lh);
+    uint64_t lo = (mid << 32) | static_cast<uint32_t>(ll);
+    uint64_t hi = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+    return lo ^ hi;
+#endif
+}
+
+/// <summary>
+/// reads 8 bytes in the native byte order
+/// </summary>
+inline uint64_t hash_read8(char const* p) noexcept
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+/// <summary>
+/// reads 4 bytes in the native byte order
+/// </summary>
+inline uint64_t hash_read4(char const* p) noexcept
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+/// <summary>
+/// hashes the bytes. Based on wyhash, which is released into the public
+/// domain.
+/// </summary>
+/// <param name="data">the pointer to the bytes</param>
+/// <param name="len">the number of the bytes</param>
+/// <returns>the hash</returns>
+inline uint64_t hash_bytes(void const* data, size_t len) noexcept
+{
+    constexpr uint64_t s0 = UINT64_C(0xa0761d6478bd642f);
+    constexpr uint64_t s1 = UINT64_C(0xe7037ed1a0b428db);
+
+    auto     p    = static_cast<char const*>(data);
+    uint64_t seed = s0;
+    uint64_t a, b;
+
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            size_t q = (len >> 3) << 2;
+            a        = (hash_read4(p) << 32) | hash_read4(p + q);
+            b = (hash_read4(p + len - 4) << 32) | hash_read4(p + len - 4 - q);
+        }
+        else if (len > 0)
+        {
+            auto u = reinterpret_cast<unsigned char const*>(p);
+            a = (uint64_t(u[0]) << 16) | (uint64_t(u[len >> 1]) << 8)
+                | u[len - 1];
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else
+    {
+        size_t i = len;
+        for (; i > 16; i -= 16, p += 16)
+            seed = hash_mix(hash_read8(p) ^ s1, hash_read8(p + 8) ^ seed);
+        a = hash_read8(p + i - 16);
+        b = hash_read8(p + i - 8);
+    }
+
+    return hash_mix(s1 ^ len, hash_mix(a ^ s1, b ^ seed));
+}
+
+/// <summary>
+/// folds a hash into the 32 bits stored in the entries of a map
+/// </summary>
+inline uint32_t fold_hash(uint64_t hash) noexcept
+{
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+/// <summary>
+/// returns the first 8 bytes of the key. Shorter keys are packed with
+/// overlapping reads instead, so that keys of the same length have the same
+/// prefix only if they are equal.
+/// </summary>
+inline uint64_t key_prefix(char const* key, size_t len) noexcept
+{
+    if (len >= 8) return hash_read8(key);
+    if (len >= 4) return hash_read4(key) | (hash_read4(key + len - 4) << 32);
+    if (len == 0) return 0;
+
+    auto u = reinterpret_cast<unsigned char const*>(key);
+    return (uint64_t(u[0]) << 16) | (uint64_t(u[len >> 1]) << 8) | u[len - 1];
+}
+
+}
+
+/// <summary>
+/// an ordered set of keys shared by the maps having the same keys. Keys are
+/// kept in a dense array in insertion order. Shapes with at most
+/// <c>small_max</c> keys have no index and are looked up by matching a group
+/// of 7-bit tags derived from the lengths and the prefixes of the keys, so
+/// their keys are never hashed. Larger shapes have a SwissTable-style index of
+/// control bytes and key indices, which is probed one group of control bytes
+/// at a time. Keys are copied to chunks owned by the shape, the first of which
+/// is sized to hold every key given at construction. Interned keys are not
+/// copied, and while every key of the shape is interned, interned keys are
+/// compared by their addresses. A shape is immutable once it is shared.
+/// </summary>
+struct _dy_shape_t
+{
+  public:
+    /// <summary>
+    /// a key
+    /// </summary>
+    struct entry
+    {
+        /// <summary>
+        /// the result of <c>dy::key_prefix</c>
+        /// </summary>
+        uint64_t prefix;
+
+        /// <summary>
+        /// the length of the key
+        /// </summary>
+        uint32_t len;
+
+        /// <summary>
+        /// the folded hash of the key. Not computed while the shape is small
+        /// unless every key is interned.
+        /// </summary>
+        uint32_t hash;
+
+        /// <summary>
+        /// the NUL-terminated key
+        /// </summary>
+        char const* key;
+    };
+
+    /// <summary>
+    /// the number of control bytes probed at once
+    /// </summary>
+    static constexpr size_t group_width = 16;
+
+    /// <summary>
+    /// the largest number of keys of a shape without an index
+    /// </summary>
+    static constexpr size_t small_max = 16;
+
+    static_assert(small_max == group_width);
+
+    /// <summary>
+    /// the result of <c>find</c> if not found
+    /// </summary>
+    static constexpr size_t npos = SIZE_MAX;
+
+    /// <summary>
+    /// makes an empty shape in the memory resource with a single reference
+    /// </summary>
+    static _dy_shape_t* create(std::pmr::memory_resource* res) noexcept;
+
+    /// <summary>
+    /// makes a copy of the other shape in the memory resource with a single
+    /// reference
+    /// </summary>
+    static _dy_shape_t* create(_dy_shape_t const&         other,
+                               std::pmr::memory_resource* res) noexcept;
+
+    _dy_shape_t(_dy_shape_t const&) = delete;
+
+    /// <summary>
+    /// returns the memory resource the shape is allocated from
+    /// </summary>
+    std::pmr::memory_resource* resource() const noexcept
+    {
+        return res_;
+    }
+
+    /// <summary>
+    /// adds a reference to a shape on the heap
+    /// </summary>
+    void retain() noexcept
+    {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// removes a reference to a shape on the heap, destroying it when no
+    /// reference is left
+    /// </summary>
+    void release() noexcept;
+
+    /// <summary>
+    /// checks whether the shape may be referenced by anything else, in which
+    /// case it must not be modified
+    /// </summary>
+    bool shared() const noexcept
+    {
+        return refs_.load(std::memory_order_acquire) != 1;
+    }
+
+    /// <summary>
+    /// returns the number of the keys
+    /// </summary>
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    entry const* begin() const noexcept
+    {
+        return entries_;
+    }
+
+    entry const* end() const noexcept
+    {
+        return entries_ + size_;
+    }
+
+    /// <summary>
+    /// makes room for the keys without reallocating
+    /// </summary>
+    /// <param name="len">the number of the keys</param>
+    /// <param name="key_bytes">the total length of the keys to be added,
+    /// including the NUL terminators</param>
+    void reserve(size_t len, size_t key_bytes = 0) noexcept;
+
+    /// <summary>
+    /// adds a key if not added yet
+    /// </summary>
+    /// <returns><c>true</c> if added, <c>false</c> if the key exists</returns>
+    bool insert(char const* key, size_t len) noexcept;
+
+    /// <summary>
+    /// adds a key if not added yet
+    /// </summary>
+    /// <param name="hash">the result of <c>dy::hash_bytes</c> on the
+    /// key</param>
+    /// <returns><c>true</c> if added, <c>false</c> if the key exists</returns>
+    bool insert(char const* key, size_t len, uint64_t hash) noexcept;
+
+    /// <summary>
+    /// adds an interned key if not added yet
+    /// </summary>
+    /// <returns><c>true</c> if added, <c>false</c> if the key exists</returns>
+    bool insert(dy_key_t key) noexcept;
+
+    /// <summary>
+    /// removes the key at the index, moving the following keys forward. The
+    /// characters of the key are kept until the shape is destroyed.
+    /// </summary>
+    void erase(size_t idx) noexcept;
+
+    /// <summary>
+    /// finds the given key
+    /// </summary>
+    /// <returns>the index of the key, or <c>npos</c> if not found</returns>
+    size_t find(char const* key, size_t len) const noexcept;
+
+    /// <summary>
+    /// finds the given key
+    /// </summary>
+    /// <param name="hash">the result of <c>dy::hash_bytes</c> on the
+    /// key</param>
+    /// <returns>the index of the key, or <c>npos</c> if not found</returns>
+    size_t find(char const* key, size_t len, uint64_t hash) const noexcept;
+
+    /// <summary>
+    /// finds the interned key
+    /// </summary>
+    /// <returns>the index of the key, or <c>npos</c> if not found</returns>
+    size_t find(dy_key_t key) const noexcept;
+
+  private:
+    struct key_chunk
+    {
+        key_chunk* next;
+        size_t     size;
+    };
+
+    std::pmr::memory_resource* res_;
+
+    /// <summary>
+    /// the number of the references, which is not counted for the shapes in
+    /// arenas
+    /// </summary>
+    std::atomic<uint32_t> refs_;
+
+    uint32_t size_;
+
+    /// <summary>
+    /// the keys, preceded by <c>small_max</c> tags used while the shape has
+    /// no index
+    /// </summary>
+    entry*   entries_;
+    uint32_t entries_cap_;
+
+    /// <summary>
+    /// whether every key is interned. The hashes of interned keys are known,
+    /// so they are stored even while the shape is small, and the tags are
+    /// taken from the hashes.
+    /// </summary>
+    bool interned_;
+
+    /// <summary>
+    /// <c>capacity_ + group_width</c> control bytes. The first group is
+    /// mirrored after the last byte so that every group can be loaded at once.
+    /// </summary>
+    int8_t* ctrl_;
+
+    /// <summary>
+    /// the key indices of the full control bytes
+    /// </summary>
+    uint32_t* slots_;
+
+    /// <summary>
+    /// the number of the slots, which is a power of two, or zero if the shape
+    /// has no index
+    /// </summary>
+    size_t capacity_;
+
+    key_chunk* chunks_;
+    char*      key_cur_;
+    char*      key_end_;
+
+    explicit _dy_shape_t(std::pmr::memory_resource* res) noexcept;
+
+    ~_dy_shape_t() noexcept;
+
+    int8_t* tags() const noexcept
+    {
+        return reinterpret_cast<int8_t*>(entries_) - small_max;
+    }
+
+    char const* store_key(char const* key, size_t len) noexcept;
+
+    void clear_interned() noexcept;
+
+    template <typename Eq>
+    size_t scan(int8_t tag, Eq eq) const noexcept;
+
+    template <typename Eq>
+    size_t probe(uint32_t hash, Eq eq) const noexcept;
+
+    /// <summary>
+    /// adds a key which is stored already
+    /// </summary>
+    void append(char const* key, size_t len, uint32_t hash) noexcept;
+
+    void grow_entries(size_t len) noexcept;
+
+    void rehash(size_t capacity) noexcept;
+
+    void insert_slot(uint32_t hash, uint32_t idx) noexcept;
+};
+
+namespace dy
+{
+
+using shape = _dy_shape_t;
+
+/// <summary>
+/// a generic map, which is a shape and the values of its keys in the same
+/// order. Maps on the heap hold a reference to their shapes, so maps having
+/// the same keys share a shape and only own their values.
+/// </summary>
+class map
+{
+  public:
+    /// <summary>
+    /// takes a reference to the shape and the values, which are allocated from
+    /// the memory resource and as many as the keys of the shape
+    /// </summary>
+    map(dy::shape*                 shape,
+        dy_t*                      values,
+        std::pmr::memory_resource* res) noexcept;
+
+    /// <summary>
+    /// shares the shape of the other map if possible, or copies it otherwise.
+    /// The values are shared with the other map.
+    /// </summary>
+    map(map const& other, std::pmr::memory_resource* res) noexcept;
+
+    map(map&& other) noexcept;
+
+    map(map const&) = delete;
+
+    ~map() noexcept;
+
+    /// <summary>
+    /// returns the number of the entries
+    /// </summary>
+    size_t size() const noexcept
+    {
+        return shape_->size();
+    }
+
+    dy::shape const* shape() const noexcept
+    {
+        return shape_;
+    }
+
+    dy::shape* shape() noexcept
+    {
+        return shape_;
+    }
+
+    /// <summary>
+    /// returns the key at the index
+    /// </summary>
+    char const* key(size_t idx) const noexcept
+    {
+        return shape_->begin()[idx].key;
+    }
+
+    dy_t* begin() noexcept
+    {
+        return values_;
+    }
+
+    dy_t* end() noexcept
+    {
+        return values_ + size();
+    }
+
+    dy_t const* begin() const noexcept
+    {
+        return values_;
+    }
+
+    dy_t const* end() const noexcept
+    {
+        return values_ + size();
+    }
+
+    /// <summary>
+    /// makes room for more entries without reallocating
+    /// </summary>
+    /// <param name="len">the number of the entries to be added</param>
+    void reserve(size_t len) noexcept;
+
+    /// <summary>
+    /// sets the value of the key, adding the key after the others if not
+    /// found
+    /// </summary>
+    /// <returns>the previous value of the key, or <c>nullptr</c> if the key is
+    /// added</returns>
+    dy_t set(char const* key, size_t len, dy_t val) noexcept;
+
+    /// <summary>
+    /// removes the key, keeping the order of the others
+    /// </summary>
+    /// <returns>the value of the key, or <c>nullptr</c> if not found</returns>
+    dy_t erase(char const* key, size_t len) noexcept;
+
+    /// <summary>
+    /// adds the key after the others unless found
+    /// </summary>
+    /// <returns><c>true</c> if added, <c>false</c> if the key exists</returns>
+    bool add(char const* key, size_t len, dy_t val) noexcept;
+
+    /// <summary>
+    /// replaces the shape with a copy of its first keys. The values of the
+    /// other keys are dropped without being disposed.
+    /// </summary>
+    /// <param name="len">the number of the keys to keep</param>
+    void truncate(size_t len) noexcept;
+
+    /// <summary>
+    /// replaces the shape with the one recently used by the current thread for
+    /// the same keys, or remembers the shape for the next maps if not found.
+    /// Only for maps on the heap.
+    /// </summary>
+    void share_shape() noexcept;
+
+  private:
+    dy::shape*                 shape_;
+    dy_t*                      values_;
+    std::pmr::memory_resource* res_;
+
+    /// <summary>
+    /// the number of the values allocated
+    /// </summary>
+    size_t capacity_;
+
+    /// <summary>
+    /// copies the shape unless only this map references it
+    /// </summary>
+    void own_shape() noexcept;
+
+    /// <summary>
+    /// makes room for more values, growing them geometrically
+    /// </summary>
+    void grow(size_t len) noexcept;
+};
+
+/// <summary>
+/// finds a shape with the given keys in the same order among the shapes
+/// recently used by the current thread
+/// </summary>
+/// <returns>the shape with a new reference, or <c>nullptr</c> if not
+/// found</returns>
+shape* find_cached_shape(dy_keyval_t const* ptr, size_t len) noexcept;
+
+/// <summary>
+/// finds a shape with the given interned keys in the same order among the
+/// shapes recently used by the current thread
+/// </summary>
+/// <returns>the shape with a new reference, or <c>nullptr</c> if not
+/// found</returns>
+shape* find_cached_shape(dy_interned_keyval_t const* ptr, size_t len) noexcept;
+
+/// <summary>
+/// finds a shape with the same keys as the given one in the same order among
+/// the shapes recently used by the current thread
+/// </summary>
+/// <returns>the shape with a new reference, or <c>nullptr</c> if not
+/// found</returns>
+shape* find_cached_shape(shape const& other) noexcept;
+
+/// <summary>
+/// remembers a shape on the heap for <c>find_cached_shape</c> on the current
+/// thread
+/// </summary>
+void cache_shape(shape* shape) noexcept;
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#ifndef DY_MAPPED_P_HH
+#define DY_MAPPED_P_HH
+
+#include <dy.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace dy
+{
+
+/// <summary>
+/// the internal data of the generic arrays and maps read from a mapped file,
+/// which reference their records instead of holding their entries
+/// </summary>
+struct mapped_ref
+{
+    /// <summary>
+    /// the file the record is in
+    /// </summary>
+    _dy_mapped_t* owner;
+
+    /// <summary>
+    /// the record of the array or the map
+    /// </summary>
+    uint64_t const* record;
+
+    /// <summary>
+    /// the entries of the array, which are made on the first call to
+    /// <c>dy_get_arr_data</c>
+    /// </summary>
+    std::atomic<dy_t const*> elems;
+};
+
+/// <summary>
+/// returns the number of the entries of the mapped array or map
+/// </summary>
+size_t mapped_len(dy_t val) noexcept;
+
+/// <summary>
+/// returns the entry at the index of the mapped array
+/// </summary>
+dy_t mapped_idx(dy_t val, size_t idx) noexcept;
+
+/// <summary>
+/// returns the entries of the mapped array, making a value instance for each
+/// of them that is not made yet
+/// </summary>
+dy_t const* mapped_data(dy_t val) noexcept;
+
+/// <summary>
+/// returns the key-value pair at the index of the mapped map
+/// </summary>
+/// <param name="idx">the index, or <c>dy::shape::npos</c></param>
+/// <returns>the key-value pair, whose fields are <c>nullptr</c> if the index
+/// is <c>dy::shape::npos</c></returns>
+dy_keyval_t mapped_keyval(dy_t val, size_t idx) noexcept;
+
+/// <summary>
+/// finds the key in the mapped map
+/// </summary>
+/// <returns>the index of the key, or <c>dy::shape::npos</c> if not
+/// found</returns>
+size_t mapped_find(dy_t val, char const* key, size_t len) noexcept;
+
+/// <summary>
+/// finds the key in the index of the mapped map
+/// </summary>
+/// <param name="hash">the result of <c>dy::hash_bytes</c> on the key</param>
+/// <returns>the index of the key, or <c>dy::shape::npos</c> if not
+/// found</returns>
+size_t mapped_find(dy_t        val,
+                   char const* key,
+                   size_t      len,
+                   uint64_t    hash) noexcept;
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#ifndef DY_POOL_P_HH
+#define DY_POOL_P_HH
+
+#include <cstddef>
+#include <type_traits>
+
+namespace dy
+{
+
+/// <summary>
+/// the function run for each index by <c>dy::parallel_for</c>
+/// </summary>
+using index_fn_t = void (*)(void* ctx, size_t idx) noexcept;
+
+/// <summary>
+/// returns the number of the threads running the tasks of
+/// <c>dy::parallel_for</c>, including the calling thread
+/// </summary>
+size_t pool_size() noexcept;
+
+/// <summary>
+/// runs the function for each index on the threads of the pool shared by the
+/// process and on the calling thread, and returns when every run has
+/// finished. The indices are handed out as ranges, which the threads split in
+/// halves as they take them, and idle threads steal the halves the others
+/// have not taken yet.
+/// </summary>
+/// <param name="len">the number of the indices</param>
+/// <param name="fn">the function, which must be safe to run
+/// concurrently</param>
+/// <param name="ctx">the context passed to <c>fn</c></param>
+void parallel_for(size_t len, index_fn_t fn, void* ctx) noexcept;
+
+/// <summary>
+/// runs the function object for each index as
+/// <c>dy::parallel_for(size_t, index_fn_t, void*)</c> does
+/// </summary>
+template <typename Fn>
+void parallel_for(size_t len, Fn&& fn) noexcept
+{
+    using fn_type = std::remove_reference_t<Fn>;
+
+    index_fn_t thunk = [](void* ctx, size_t idx) noexcept {
+        (*static_cast<fn_type*>(ctx))(idx);
+    };
+    parallel_for(len, thunk, const_cast<void*>(static_cast<void const*>(&fn)));
+}
+
+}
+
+#endif
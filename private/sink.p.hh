@@ -0,0 +1,135 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#ifndef DY_SINK_P_HH
+#define DY_SINK_P_HH
+
+#include <dy.h>
+
+#include <cstddef>
+#include <cstring>
+
+namespace dy
+{
+
+/// <summary>
+/// collects the output of a writer and hands it to a <c>dy_write_fn_t</c> in
+/// chunks. Writers reserve room in the chunk and write into it directly, so
+/// that nothing is formatted twice.
+/// </summary>
+class sink
+{
+  public:
+    /// <summary>
+    /// the size of the chunks
+    /// </summary>
+    static constexpr size_t capacity = 8192;
+
+    sink(dy_write_fn_t write_fn, void* ctx) noexcept :
+        write_fn_ { write_fn },
+        ctx_ { ctx }
+    {}
+
+    sink(sink const&) = delete;
+
+    /// <summary>
+    /// checks whether the output is still accepted. The chunks are dropped
+    /// once the function stops writing or the writer gives up.
+    /// </summary>
+    bool ok() const noexcept
+    {
+        return ok_;
+    }
+
+    /// <summary>
+    /// drops the rest of the output
+    /// </summary>
+    void stop() noexcept
+    {
+        ok_ = false;
+    }
+
+    /// <summary>
+    /// hands the collected output to the function
+    /// </summary>
+    void flush() noexcept
+    {
+        if (ok_ && used_ != 0) ok_ = write_fn_(ctx_, chunk_, used_);
+        used_ = 0;
+    }
+
+    /// <summary>
+    /// returns the room for at least <c>len</c> bytes, which is at most the
+    /// capacity. Call <c>commit</c> with the end of the bytes written.
+    /// </summary>
+    char* reserve(size_t len) noexcept
+    {
+        if (capacity - used_ < len) flush();
+        return chunk_ + used_;
+    }
+
+    void commit(char* end) noexcept
+    {
+        used_ = static_cast<size_t>(end - chunk_);
+    }
+
+    void put(char c) noexcept
+    {
+        *reserve(1) = c;
+        ++used_;
+    }
+
+    void append(void const* data, size_t len) noexcept
+    {
+        if (capacity - used_ < len)
+        {
+            flush();
+
+            // hands long runs out without copying them
+            if (len >= capacity)
+            {
+                if (ok_)
+                    ok_ = write_fn_(ctx_, static_cast<char const*>(data), len);
+                return;
+            }
+        }
+        std::memcpy(chunk_ + used_, data, len);
+        used_ += len;
+    }
+
+  private:
+    dy_write_fn_t write_fn_;
+    void*         ctx_;
+    bool          ok_   = true;
+    size_t        used_ = 0;
+    char          chunk_[capacity];
+};
+
+/// <summary>
+/// the context of <c>write_to_buffer</c>
+/// </summary>
+struct buffer_sink
+{
+    char*  buf;
+    size_t cap;
+    size_t len;
+};
+
+/// <summary>
+/// copies the chunk into the buffer as far as it fits, counting the whole
+/// length. Used as the <c>dy_write_fn_t</c> of the functions writing into a
+/// buffer.
+/// </summary>
+inline bool write_to_buffer(void* ctx, char const* data, size_t len) noexcept
+{
+    auto& sink = *static_cast<buffer_sink*>(ctx);
+    if (sink.len < sink.cap)
+        std::memcpy(sink.buf + sink.len,
+                    data,
+                    len < sink.cap - sink.len ? len : sink.cap - sink.len);
+    sink.len += len;
+    return true;
+}
+
+}
+
+#endif
@@ -45,6 +45,26 @@
 #define DY_DEF_GET_IDX(f, ty)                                                  \
     DY_PUBLIC(ty) dy_get_##f##_idx(dy_t val, size_t idx) DY_NOEXCEPT
 
+#define DY_DEF_ARENA_MAKE(f, ty)                                               \
+    DY_PUBLIC(dy_t) dy_arena_make_##f(dy_arena_t arena, ty f) DY_NOEXCEPT
+
+#define DY_DEF_ARENA_MAKE_LEN(f, ty)                                           \
+    DY_PUBLIC(dy_t)                                                            \
+    dy_arena_make_##f(dy_arena_t arena, ty const* f, size_t len) DY_NOEXCEPT
+
+#define DY_DEF_ADOPT(f, ty)                                                    \
+    DY_PUBLIC(dy_t)                                                            \
+    dy_adopt_##f(ty* f, size_t len, dy_free_fn_t free_fn, void* ctx)           \
+        DY_NOEXCEPT
+
+#define DY_DEF_MAKE_VIEW(f, ty)                                                \
+    DY_PUBLIC(dy_t) dy_make_##f##_view(ty const* f, size_t len) DY_NOEXCEPT
+
+#define DY_DEF_RELEASE_DATA(f, ty)                                             \
+    DY_PUBLIC(ty*)                                                             \
+    dy_release_##f##_data(dy_t val, dy_free_fn_t* free_fn, void** ctx)         \
+        DY_NOEXCEPT
+
 /// <summary>
 /// indicates the type of the value
 /// </summary>
@@ -104,13 +124,70 @@ typedef enum _dy_type_t
     /// generic map
     /// </summary>
     dy_type_map,
+
+    /// <summary>
+    /// 8-bit integer array
+    /// </summary>
+    dy_type_i8arr,
+
+    /// <summary>
+    /// 16-bit integer array
+    /// </summary>
+    dy_type_i16arr,
+
+    /// <summary>
+    /// 32-bit integer array
+    /// </summary>
+    dy_type_i32arr,
+
+    /// <summary>
+    /// 32-bit unsigned integer array
+    /// </summary>
+    dy_type_u32arr,
+
+    /// <summary>
+    /// single-precision floating-point number array
+    /// </summary>
+    dy_type_f32arr,
 } dy_type_t;
 
 /// <summary>
-/// indicates a value
+/// indicates how generic arrays of integers are compacted
+/// </summary>
+typedef enum _dy_compact_flag_t
+{
+    /// <summary>
+    /// integers become an integer array
+    /// </summary>
+    dy_compact_default = 0,
+
+    /// <summary>
+    /// integers from 0 to 255 become a byte array
+    /// </summary>
+    dy_compact_bytes = 1 << 0,
+
+    /// <summary>
+    /// integers become the narrowest integer array holding them all
+    /// </summary>
+    dy_compact_narrow = 1 << 1,
+} dy_compact_flag_t;
+
+/// <summary>
+/// indicates a value. Null and boolean values, integers which fit in 48 bits
+/// and double-precision numbers are encoded in the handle itself on 64-bit
+/// targets, so making, copying and disposing them never touches the heap and
+/// copies of them compare equal.
 /// </summary>
 typedef struct _dy_val_t* dy_t;
 
+/// <summary>
+/// indicates a function freeing a buffer adopted by a value or released from
+/// a value
+/// </summary>
+/// <param name="ptr">the buffer</param>
+/// <param name="ctx">the context given with the function</param>
+typedef void (*dy_free_fn_t)(void* ptr, void* ctx);
+
 /// <summary>
 /// indicates a key-value pair
 /// </summary>
@@ -127,11 +204,72 @@ typedef struct _dy_keyval_t
     dy_t val;
 } dy_keyval_t;
 
+/// <summary>
+/// indicates an interned key. Interning the same characters always returns the
+/// same handle, which stays valid until the process exits.
+/// </summary>
+typedef struct _dy_key_t const* dy_key_t;
+
+/// <summary>
+/// indicates a key-value pair with an interned key
+/// </summary>
+typedef struct _dy_interned_keyval_t
+{
+    /// <summary>
+    /// the key
+    /// </summary>
+    dy_key_t key;
+
+    /// <summary>
+    /// the value
+    /// </summary>
+    dy_t val;
+} dy_interned_keyval_t;
+
+/// <summary>
+/// indicates a shape, which is an ordered set of keys shared by the generic
+/// maps having the same keys
+/// </summary>
+typedef struct _dy_shape_t* dy_shape_t;
+
+/// <summary>
+/// indicates the state of an iterator of a generic map. The caller may own it,
+/// on the stack for example, and pass its address as a <c>dy_iter_t</c> after
+/// <c>dy_init_map_iter</c>, so that iterating allocates nothing.
+/// </summary>
+typedef struct _dy_iter_t
+{
+    /// <summary>
+    /// the index of the next entry
+    /// </summary>
+    size_t idx;
+} dy_iter_state_t;
+
 /// <summary>
 /// indicates an iterator of a generic map
 /// </summary>
 typedef struct _dy_iter_t* dy_iter_t;
 
+/// <summary>
+/// indicates an arena which values can be allocated from
+/// </summary>
+typedef struct _dy_arena_t* dy_arena_t;
+
+/// <summary>
+/// indicates a file of values mapped into memory
+/// </summary>
+typedef struct _dy_mapped_t* dy_mapped_t;
+
+/// <summary>
+/// indicates an incremental JSON parser
+/// </summary>
+typedef struct _dy_parser_t* dy_parser_t;
+
+/// <summary>
+/// indicates a builder of nested values
+/// </summary>
+typedef struct _dy_builder_t* dy_builder_t;
+
 /// <summary>
 /// returns the type of the value
 /// </summary>
@@ -140,24 +278,184 @@ typedef struct _dy_iter_t* dy_iter_t;
 DY_PUBLIC(dy_type_t) dy_get_type(dy_t val) DY_NOEXCEPT;
 
 /// <summary>
-/// deepcopies the value
+/// copies the value. Values are immutable while shared, so a value on the heap
+/// is not copied but gets another reference in constant time, so a copy of a
+/// view references the same memory. A value in an arena is copied to the heap.
 /// </summary>
 /// <param name="val">the value to copy</param>
-/// <returns>newly created value instance</returns>
+/// <returns>the value instance to be disposed separately</returns>
 DY_PUBLIC(dy_t) dy_copy(dy_t val) DY_NOEXCEPT;
 
 /// <summary>
-/// deallocates the memory holding the instance and the internal data
+/// copies the value as <c>dy_copy</c> does, splitting a large tree in an arena
+/// into subtrees copied on the threads of a pool shared by the process. Values
+/// on the heap only get another reference, so only values in arenas and
+/// mapped files are worth copying this way.
+/// </summary>
+/// <param name="val">the value to copy</param>
+/// <returns>the value instance to be disposed separately</returns>
+DY_PUBLIC(dy_t) dy_copy_parallel(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// releases a reference to the value. The memory holding the instance and the
+/// internal data is deallocated with the last reference, releasing the values
+/// in it. Nested values are released without recursion, so the depth of the
+/// tree is bounded only by the memory.
 /// </summary>
 /// <param name="val">the instance</param>
 DY_PUBLIC(void) dy_dispose(dy_t val) DY_NOEXCEPT;
 
 /// <summary>
-/// deallocates the memory holding the instance but not the internal data.
+/// releases a reference to the value as <c>dy_dispose</c> does. With the last
+/// reference, a large tree is split into subtrees released on the threads of
+/// a pool shared by the process.
+/// </summary>
+/// <param name="val">the instance</param>
+DY_PUBLIC(void) dy_dispose_parallel(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// releases a reference to the value. The memory holding the instance is
+/// deallocated with the last reference, but the values in it are not
+/// released.
 /// </summary>
 /// <param name="val">the instance</param>
 DY_PUBLIC(void) dy_dispose_self(dy_t val) DY_NOEXCEPT;
 
+/// <summary>
+/// adds a reference to the value, which is safe to call from multiple threads.
+/// Does nothing on values in arenas.
+/// </summary>
+/// <param name="val">the instance</param>
+/// <returns>the same instance</returns>
+DY_PUBLIC(dy_t) dy_retain(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// releases a reference to the value, which is the same as
+/// <c>dy_dispose</c>
+/// </summary>
+/// <param name="val">the instance</param>
+DY_PUBLIC(void) dy_release(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// checks whether the value is a view made with <c>dy_make_*_view</c>
+/// functions, which references memory owned elsewhere
+/// </summary>
+/// <param name="val">the value</param>
+/// <returns><c>true</c> if it is, <c>false</c> otherwise</returns>
+DY_PUBLIC(bool) dy_is_view(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// makes a value which does not reference memory owned elsewhere. Views in the
+/// value, including the ones nested in arrays and maps, are copied to the heap,
+/// and the rest is shared as with <c>dy_copy</c>.
+/// </summary>
+/// <param name="val">the value to materialize, which is left as is</param>
+/// <returns>the value instance to be disposed separately</returns>
+DY_PUBLIC(dy_t) dy_materialize(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// replaces the generic arrays in the value whose entries are all booleans,
+/// all integers or all double-precision numbers with boolean, integer or
+/// double-precision number arrays, including the ones nested in arrays and
+/// maps. Arrays and maps which are not shared are compacted in place, and the
+/// rest is copied. Empty arrays are left as is.
+/// </summary>
+/// <param name="val">the value to compact, which is consumed</param>
+/// <param name="flags">the combination of <c>dy_compact_flag_t</c>s</param>
+/// <param name="saved">increased by the number of the bytes the compacted
+/// arrays take less than the generic ones, or <c>NULL</c></param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t)
+dy_compact(dy_t val, uint32_t flags, size_t* saved) DY_NOEXCEPT;
+
+// --------------------------------- arena  --------------------------------- //
+
+/// <summary>
+/// makes an arena. Values made with <c>dy_arena_make_*</c> functions and their
+/// internal data are bump-allocated from large blocks owned by the arena and
+/// released all at once by <c>dy_arena_reset</c> or <c>dy_arena_destroy</c>.
+/// <c>dy_dispose</c> and <c>dy_dispose_self</c> do nothing on such values, and
+/// <c>dy_copy</c> makes a copy which does not belong to the arena. Arena values
+/// must only contain values from the same arena. An arena is not thread-safe.
+/// </summary>
+/// <param name="block_size">the size of the blocks in bytes, or 0 for the
+/// default size</param>
+/// <returns>a new arena instance, or <c>NULL</c> on failure</returns>
+DY_PUBLIC(dy_arena_t) dy_arena_create(size_t block_size) DY_NOEXCEPT;
+
+/// <summary>
+/// invalidates every value made from the arena and makes its memory available
+/// for new values
+/// </summary>
+/// <param name="arena">the arena instance</param>
+DY_PUBLIC(void) dy_arena_reset(dy_arena_t arena) DY_NOEXCEPT;
+
+/// <summary>
+/// deallocates the arena and every value made from it
+/// </summary>
+/// <param name="arena">the arena instance</param>
+DY_PUBLIC(void) dy_arena_destroy(dy_arena_t arena) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the number of bytes the arena has obtained from the heap
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <returns>the total size of the blocks</returns>
+DY_PUBLIC(size_t) dy_arena_capacity(dy_arena_t arena) DY_NOEXCEPT;
+
+// -------------------------------- reclaim  -------------------------------- //
+
+// Disposing a large tree takes time proportional to its size on the thread
+// releasing the last reference. dy_dispose_deferred hands such a tree to a
+// reclaimer thread instead, through a queue which takes a constant number of
+// atomic operations and never blocks the caller. The reclaimers start with the
+// first value deferred and run until the process exits.
+
+/// <summary>
+/// indicates the options of the reclaimers. Zero-initialize it and set the
+/// fields to change.
+/// </summary>
+typedef struct _dy_reclaim_opts_t
+{
+    /// <summary>
+    /// the number of the reclaimer threads, or 0 for 1. Each thread deferring
+    /// values hands them to one of the reclaimers.
+    /// </summary>
+    size_t threads;
+
+    /// <summary>
+    /// the number of the values queued before a reclaimer wakes up to dispose
+    /// them, or 0 for 1. Larger batches wake the reclaimers less often, but
+    /// the values wait longer, up to the next call to
+    /// <c>dy_reclaim_flush</c>.
+    /// </summary>
+    size_t batch;
+} dy_reclaim_opts_t;
+
+/// <summary>
+/// releases a reference to the value as <c>dy_dispose</c> does, but hands an
+/// array or a map losing its last reference to a reclaimer thread, which
+/// deallocates it and releases the values in it later
+/// </summary>
+/// <param name="val">the instance</param>
+DY_PUBLIC(void) dy_dispose_deferred(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// sets the options of the reclaimers, which is only possible before the first
+/// value is deferred
+/// </summary>
+/// <param name="opts">the options</param>
+/// <returns><c>true</c> if set, <c>false</c> if the reclaimers have already
+/// started</returns>
+DY_PUBLIC(bool)
+dy_reclaim_configure(dy_reclaim_opts_t const* opts) DY_NOEXCEPT;
+
+/// <summary>
+/// waits until the values deferred before the call are disposed
+/// </summary>
+DY_PUBLIC(void) dy_reclaim_flush(void) DY_NOEXCEPT;
+
 // ---------------------------------- null ---------------------------------- //
 
 /// <summary>
@@ -166,6 +464,13 @@ DY_PUBLIC(void) dy_dispose_self(dy_t val) DY_NOEXCEPT;
 /// <returns>a new value instance</returns>
 DY_PUBLIC(dy_t) dy_make_null() DY_NOEXCEPT;
 
+/// <summary>
+/// makes a null value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t) dy_arena_make_null(dy_arena_t arena) DY_NOEXCEPT;
+
 // ----------------------------------- b  ----------------------------------- //
 
 /// <summary>
@@ -175,6 +480,14 @@ DY_PUBLIC(dy_t) dy_make_null() DY_NOEXCEPT;
 /// <returns>a new value instance</returns>
 DY_DEF_MAKE(b, bool);
 
+/// <summary>
+/// makes a boolean value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="b">internal data</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE(b, bool);
+
 /// <summary>
 /// checks if the value is boolean and returns the internal data
 /// </summary>
@@ -191,6 +504,14 @@ DY_DEF_GET(b, bool);
 /// <returns>a new value instance</returns>
 DY_DEF_MAKE(i, int64_t);
 
+/// <summary>
+/// makes an integer value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="i">internal data</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE(i, int64_t);
+
 /// <summary>
 /// checks if the value is an integer and returns the internal data
 /// </summary>
@@ -207,6 +528,14 @@ DY_DEF_GET(i, int64_t);
 /// <returns>a new value instance</returns>
 DY_DEF_MAKE(f, double);
 
+/// <summary>
+/// makes a double-precision number value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="f">internal data</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE(f, double);
+
 /// <summary>
 /// checks if the value is a double-precision number value and returns the
 /// internal data
@@ -225,6 +554,57 @@ DY_DEF_GET(f, double);
 /// <returns>a new value instance</returns>
 DY_DEF_MAKE(str, char const*);
 
+/// <summary>
+/// makes a string value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="str">a pointer to the string to copy</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE(str, char const*);
+
+/// <summary>
+/// makes a string value from the characters, which may contain NUL characters
+/// </summary>
+/// <param name="str">a pointer to the characters to copy</param>
+/// <param name="len">the number of the characters</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t) dy_make_str_len(char const* str, size_t len) DY_NOEXCEPT;
+
+/// <summary>
+/// makes a string value from the characters in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="str">a pointer to the characters to copy</param>
+/// <param name="len">the number of the characters</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t)
+dy_arena_make_str_len(dy_arena_t arena, char const* str, size_t len)
+    DY_NOEXCEPT;
+
+/// <summary>
+/// makes a string value taking the ownership of the buffer without copying
+/// it. The string must be followed by a NUL terminator
+/// </summary>
+/// <param name="str">the buffer, followed by a NUL terminator</param>
+/// <param name="len">the length of the string</param>
+/// <param name="free_fn">the function freeing the buffer when the value is
+/// deallocated, or <c>NULL</c> if the buffer outlives the value</param>
+/// <param name="ctx">the context passed to <c>free_fn</c></param>
+/// <returns>a new value instance</returns>
+DY_DEF_ADOPT(str, char);
+
+/// <summary>
+/// makes a string value referencing the memory without copying it. The memory
+/// is neither modified nor freed by the value and must outlive it and its
+/// copies.
+/// </summary>
+/// <param name="str">the string, which need not be followed by a NUL
+/// terminator. <c>dy_get_str_data</c> of the view is not terminated either.
+/// </param>
+/// <param name="len">the length of the string</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_VIEW(str, char);
+
 /// <summary>
 /// returns the length of the string in the internal data
 /// </summary>
@@ -239,6 +619,18 @@ DY_DEF_GET_LEN(str);
 /// <returns>the pointer to the string</returns>
 DY_DEF_GET_DATA(str, char);
 
+/// <summary>
+/// hands the buffer of the string out of the value, which is left empty and
+/// must only be disposed afterwards. The buffer is not copied unless the value
+/// is shared, a view, or in an arena. Get the length first.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="free_fn">set to the function freeing the buffer, or
+/// <c>NULL</c> if the buffer need not be freed</param>
+/// <param name="ctx">set to the context to pass to <c>free_fn</c></param>
+/// <returns>the buffer</returns>
+DY_DEF_RELEASE_DATA(str, char);
+
 // ---------------------------------- barr ---------------------------------- //
 
 /// <summary>
@@ -249,6 +641,25 @@ DY_DEF_GET_DATA(str, char);
 /// <returns>a new value instance</returns>
 DY_DEF_MAKE_LEN(barr, bool);
 
+/// <summary>
+/// makes a boolean array value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="barr">a pointer to the boolean array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(barr, bool);
+
+/// <summary>
+/// makes a boolean array value from packed words in the layout described in
+/// <c>dy_get_barr_words</c>
+/// </summary>
+/// <param name="words">a pointer to the words to copy</param>
+/// <param name="len">the length of the array in bits</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t)
+dy_make_barr_words(uint64_t const* words, size_t len) DY_NOEXCEPT;
+
 /// <summary>
 /// returns the length of the boolean array in the internal data
 /// </summary>
@@ -265,6 +676,69 @@ DY_DEF_GET_LEN(barr);
 /// <returns>the value of the entry</returns>
 DY_DEF_GET_IDX(barr, bool);
 
+/// <summary>
+/// returns the packed words of the boolean array in the internal data. The
+/// entry at index <c>i</c> is the bit <c>i % 64</c> of the word <c>i / 64</c>,
+/// counting from the least significant bit. There are <c>(len + 63) / 64</c>
+/// words, and the bits after the last entry are zero.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the pointer to the words</returns>
+DY_PUBLIC(uint64_t const*) dy_get_barr_words(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// unpacks a range of the boolean array in the internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="first">the index of the first entry</param>
+/// <param name="len">the number of the entries</param>
+/// <param name="out">the array receiving <c>len</c> entries</param>
+DY_PUBLIC(void)
+dy_get_barr_range(dy_t val, size_t first, size_t len, bool* out) DY_NOEXCEPT;
+
+/// <summary>
+/// counts the entries which are <c>true</c> in the boolean array
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the number of the entries</returns>
+DY_PUBLIC(size_t) dy_barr_popcount(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// finds the first entry which is <c>true</c> in the boolean array
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="first">the index to start from</param>
+/// <returns>the index of the entry, or the length of the array if there is
+/// none</returns>
+DY_PUBLIC(size_t) dy_barr_find_first(dy_t val, size_t first) DY_NOEXCEPT;
+
+/// <summary>
+/// makes a boolean array value holding the conjunction of the entries of two
+/// boolean arrays of the same length
+/// </summary>
+/// <param name="lhs">the first boolean array</param>
+/// <param name="rhs">the second boolean array</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t) dy_barr_and(dy_t lhs, dy_t rhs) DY_NOEXCEPT;
+
+/// <summary>
+/// makes a boolean array value holding the disjunction of the entries of two
+/// boolean arrays of the same length
+/// </summary>
+/// <param name="lhs">the first boolean array</param>
+/// <param name="rhs">the second boolean array</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t) dy_barr_or(dy_t lhs, dy_t rhs) DY_NOEXCEPT;
+
+/// <summary>
+/// makes a boolean array value holding the exclusive disjunction of the
+/// entries of two boolean arrays of the same length
+/// </summary>
+/// <param name="lhs">the first boolean array</param>
+/// <param name="rhs">the second boolean array</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t) dy_barr_xor(dy_t lhs, dy_t rhs) DY_NOEXCEPT;
+
 // --------------------------------- bytes  --------------------------------- //
 
 /// <summary>
@@ -275,6 +749,37 @@ DY_DEF_GET_IDX(barr, bool);
 /// <returns>a new value instance</returns>
 DY_DEF_MAKE_LEN(bytes, uint8_t);
 
+/// <summary>
+/// makes a byte array value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="bytes">a pointer to the byte array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(bytes, uint8_t);
+
+/// <summary>
+/// makes a byte array value taking the ownership of the buffer without copying
+/// it
+/// </summary>
+/// <param name="bytes">the buffer</param>
+/// <param name="len">the number of the bytes</param>
+/// <param name="free_fn">the function freeing the buffer when the value is
+/// deallocated, or <c>NULL</c> if the buffer outlives the value</param>
+/// <param name="ctx">the context passed to <c>free_fn</c></param>
+/// <returns>a new value instance</returns>
+DY_DEF_ADOPT(bytes, uint8_t);
+
+/// <summary>
+/// makes a byte array value referencing the memory without copying it. The
+/// memory is neither modified nor freed by the value and must outlive it and
+/// its copies.
+/// </summary>
+/// <param name="bytes">the bytes</param>
+/// <param name="len">the number of the bytes</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_VIEW(bytes, uint8_t);
+
 /// <summary>
 /// returns the length of the byte array in the internal data
 /// </summary>
@@ -289,6 +794,18 @@ DY_DEF_GET_LEN(bytes);
 /// <returns>the pointer to the byte array</returns>
 DY_DEF_GET_DATA(bytes, uint8_t);
 
+/// <summary>
+/// hands the buffer of the byte array out of the value, which is left empty and
+/// must only be disposed afterwards. The buffer is not copied unless the value
+/// is shared, a view, or in an arena. Get the length first.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="free_fn">set to the function freeing the buffer, or
+/// <c>NULL</c> if the buffer need not be freed</param>
+/// <param name="ctx">set to the context to pass to <c>free_fn</c></param>
+/// <returns>the buffer</returns>
+DY_DEF_RELEASE_DATA(bytes, uint8_t);
+
 /// <summary>
 /// returns the value of a entry at the given index of the byte array in the
 /// internal data
@@ -298,6 +815,18 @@ DY_DEF_GET_DATA(bytes, uint8_t);
 /// <returns>the value of the entry</returns>
 DY_DEF_GET_IDX(bytes, uint8_t);
 
+/// <summary>
+/// appends the bytes to the byte array as described in <c>dy_arr_push</c>
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="ptr">the bytes to append, which must not be in the
+/// value</param>
+/// <param name="len">the number of the bytes</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t)
+dy_bytes_append(dy_t val, uint8_t const* ptr, size_t len) DY_NOEXCEPT;
+
 // ---------------------------------- iarr ---------------------------------- //
 
 /// <summary>
@@ -308,6 +837,37 @@ DY_DEF_GET_IDX(bytes, uint8_t);
 /// <returns>a new value instance</returns>
 DY_DEF_MAKE_LEN(iarr, int64_t);
 
+/// <summary>
+/// makes an integer array value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="iarr">a pointer to the integer array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(iarr, int64_t);
+
+/// <summary>
+/// makes an integer array value taking the ownership of the buffer without
+/// copying it
+/// </summary>
+/// <param name="iarr">the buffer</param>
+/// <param name="len">the length of the array</param>
+/// <param name="free_fn">the function freeing the buffer when the value is
+/// deallocated, or <c>NULL</c> if the buffer outlives the value</param>
+/// <param name="ctx">the context passed to <c>free_fn</c></param>
+/// <returns>a new value instance</returns>
+DY_DEF_ADOPT(iarr, int64_t);
+
+/// <summary>
+/// makes a integer array value referencing the memory without copying it. The
+/// memory is neither modified nor freed by the value and must outlive it and
+/// its copies.
+/// </summary>
+/// <param name="iarr">the integers</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_VIEW(iarr, int64_t);
+
 /// <summary>
 /// returns the length of the integer array in the internal data
 /// </summary>
@@ -322,6 +882,18 @@ DY_DEF_GET_LEN(iarr);
 /// <returns>the pointer to the integer array</returns>
 DY_DEF_GET_DATA(iarr, int64_t);
 
+/// <summary>
+/// hands the buffer of the integer array out of the value, which is left empty
+/// and must only be disposed afterwards. The buffer is not copied unless the
+/// value is shared, a view, or in an arena. Get the length first.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="free_fn">set to the function freeing the buffer, or
+/// <c>NULL</c> if the buffer need not be freed</param>
+/// <param name="ctx">set to the context to pass to <c>free_fn</c></param>
+/// <returns>the buffer</returns>
+DY_DEF_RELEASE_DATA(iarr, int64_t);
+
 /// <summary>
 /// returns the value of a entry at the given index of the integer array in the
 /// internal data
@@ -331,8 +903,72 @@ DY_DEF_GET_DATA(iarr, int64_t);
 /// <returns>the value of the entry</returns>
 DY_DEF_GET_IDX(iarr, int64_t);
 
-// ---------------------------------- farr ---------------------------------- //
-
+/// <summary>
+/// appends the integer to the integer array as described in
+/// <c>dy_arr_push</c>
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="elem">the integer to append</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t) dy_iarr_push(dy_t val, int64_t elem) DY_NOEXCEPT;
+
+/// <summary>
+/// adds up the integer array. Wraps around on overflow.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the sum</returns>
+DY_PUBLIC(int64_t) dy_iarr_sum(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// finds the smallest entry of the integer array
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the smallest entry, or <c>INT64_MAX</c> if empty</returns>
+DY_PUBLIC(int64_t) dy_iarr_min(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// finds the largest entry of the integer array
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the largest entry, or <c>INT64_MIN</c> if empty</returns>
+DY_PUBLIC(int64_t) dy_iarr_max(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// adds up the entries of the integer array which are valid in the mask. Wraps
+/// around on overflow.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="mask">the boolean array of the same length</param>
+/// <returns>the sum</returns>
+DY_PUBLIC(int64_t) dy_iarr_sum_masked(dy_t val, dy_t mask) DY_NOEXCEPT;
+
+/// <summary>
+/// finds the smallest entry of the integer array which is valid in the mask
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="mask">the boolean array of the same length</param>
+/// <returns>the smallest entry, or <c>INT64_MAX</c> if there is none</returns>
+DY_PUBLIC(int64_t) dy_iarr_min_masked(dy_t val, dy_t mask) DY_NOEXCEPT;
+
+/// <summary>
+/// finds the largest entry of the integer array which is valid in the mask
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="mask">the boolean array of the same length</param>
+/// <returns>the largest entry, or <c>INT64_MIN</c> if there is none</returns>
+DY_PUBLIC(int64_t) dy_iarr_max_masked(dy_t val, dy_t mask) DY_NOEXCEPT;
+
+/// <summary>
+/// makes an integer array value holding the inclusive prefix sums of the
+/// integer array. Wraps around on overflow.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t) dy_iarr_prefix_sum(dy_t val) DY_NOEXCEPT;
+
+// ---------------------------------- farr ---------------------------------- //
+
 /// <summary>
 /// makes an double-precision number array value
 /// </summary>
@@ -341,6 +977,38 @@ DY_DEF_GET_IDX(iarr, int64_t);
 /// new value instance</returns>
 DY_DEF_MAKE_LEN(farr, double);
 
+/// <summary>
+/// makes a double-precision number array value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="farr">a pointer to the double-precision number array to
+/// copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(farr, double);
+
+/// <summary>
+/// makes a double-precision number array value taking the ownership of the
+/// buffer without copying it
+/// </summary>
+/// <param name="farr">the buffer</param>
+/// <param name="len">the length of the array</param>
+/// <param name="free_fn">the function freeing the buffer when the value is
+/// deallocated, or <c>NULL</c> if the buffer outlives the value</param>
+/// <param name="ctx">the context passed to <c>free_fn</c></param>
+/// <returns>a new value instance</returns>
+DY_DEF_ADOPT(farr, double);
+
+/// <summary>
+/// makes a double-precision number array value referencing the memory without
+/// copying it. The memory is neither modified nor freed by the value and must
+/// outlive it and its copies.
+/// </summary>
+/// <param name="farr">the numbers</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_VIEW(farr, double);
+
 /// <summary>
 /// returns the length of the double-precision number array in the internal data
 /// </summary>
@@ -356,6 +1024,19 @@ DY_DEF_GET_LEN(farr);
 /// <returns>the pointer to the double-precision number array</returns>
 DY_DEF_GET_DATA(farr, double);
 
+/// <summary>
+/// hands the buffer of the double-precision number array out of the value,
+/// which is left empty and must only be disposed afterwards. The buffer is not
+/// copied unless the value is shared, a view, or in an arena. Get the length
+/// first.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="free_fn">set to the function freeing the buffer, or
+/// <c>NULL</c> if the buffer need not be freed</param>
+/// <param name="ctx">set to the context to pass to <c>free_fn</c></param>
+/// <returns>the buffer</returns>
+DY_DEF_RELEASE_DATA(farr, double);
+
 /// <summary>
 /// returns the value of a entry at the given index of the double-precision
 /// number array in the internal data
@@ -365,85 +1046,1426 @@ DY_DEF_GET_DATA(farr, double);
 /// <returns>the value of the entry</returns>
 DY_DEF_GET_IDX(farr, double);
 
-// ---------------------------------- arr  ---------------------------------- //
+/// <summary>
+/// appends the number to the double-precision number array as described in
+/// <c>dy_arr_push</c>
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="elem">the number to append</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t) dy_farr_push(dy_t val, double elem) DY_NOEXCEPT;
 
 /// <summary>
-/// makes a generic array value
+/// adds up the double-precision number array with compensated summation,
+/// which keeps the error close to that of a single rounding. The entries are
+/// added in the same order on every processor.
 /// </summary>
-/// <param name="arr">a pointer to the generic array to copy</param>
+/// <param name="val">the value instance</param>
+/// <returns>the sum</returns>
+DY_PUBLIC(double) dy_farr_sum(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// adds up the entries of the double-precision number array which are valid in
+/// the mask with compensated summation
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="mask">the boolean array of the same length</param>
+/// <returns>the sum</returns>
+DY_PUBLIC(double) dy_farr_sum_masked(dy_t val, dy_t mask) DY_NOEXCEPT;
+
+/// <summary>
+/// computes the dot product of two double-precision number arrays of the same
+/// length. The products are added in the same order on every processor.
+/// </summary>
+/// <param name="lhs">the first array</param>
+/// <param name="rhs">the second array</param>
+/// <returns>the dot product</returns>
+DY_PUBLIC(double) dy_farr_dot(dy_t lhs, dy_t rhs) DY_NOEXCEPT;
+
+/// <summary>
+/// computes the dot product of the entries of two double-precision number
+/// arrays which are valid in the mask
+/// </summary>
+/// <param name="lhs">the first array</param>
+/// <param name="rhs">the second array of the same length</param>
+/// <param name="mask">the boolean array of the same length</param>
+/// <returns>the dot product</returns>
+DY_PUBLIC(double)
+dy_farr_dot_masked(dy_t lhs, dy_t rhs, dy_t mask) DY_NOEXCEPT;
+
+/// <summary>
+/// makes a double-precision number array value holding the inclusive prefix
+/// sums of the double-precision number array
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t) dy_farr_prefix_sum(dy_t val) DY_NOEXCEPT;
+
+// --------------------------------- i8arr  --------------------------------- //
+
+/// <summary>
+/// makes an 8-bit integer array value
+/// </summary>
+/// <param name="i8arr">a pointer to the 8-bit integer array to copy</param>
 /// <param name="len">the length of the array</param>
 /// <returns>a new value instance</returns>
-DY_DEF_MAKE_LEN(arr, dy_t);
+DY_DEF_MAKE_LEN(i8arr, int8_t);
 
 /// <summary>
-/// returns the length of the generic array in the internal data
+/// makes an 8-bit integer array value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="i8arr">a pointer to the 8-bit integer array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(i8arr, int8_t);
+
+/// <summary>
+/// makes an 8-bit integer array value taking the ownership of the buffer
+/// without copying it
+/// </summary>
+/// <param name="i8arr">the buffer</param>
+/// <param name="len">the length of the array</param>
+/// <param name="free_fn">the function freeing the buffer when the value is
+/// deallocated, or <c>NULL</c> if the buffer outlives the value</param>
+/// <param name="ctx">the context passed to <c>free_fn</c></param>
+/// <returns>a new value instance</returns>
+DY_DEF_ADOPT(i8arr, int8_t);
+
+/// <summary>
+/// makes an 8-bit integer array value referencing the memory without copying
+/// it. The memory is neither modified nor freed by the value and must outlive
+/// it and its copies.
+/// </summary>
+/// <param name="i8arr">the entries</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_VIEW(i8arr, int8_t);
+
+/// <summary>
+/// returns the length of the 8-bit integer array in the internal data
 /// </summary>
 /// <param name="val">the value instance</param>
-/// <returns>the length of the generic array</returns>
-DY_DEF_GET_LEN(arr);
+/// <returns>the length of the 8-bit integer array</returns>
+DY_DEF_GET_LEN(i8arr);
 
 /// <summary>
-/// returns the pointer to the generic array in the internal
-/// data
+/// returns the pointer to the 8-bit integer array in the internal data
 /// </summary>
 /// <param name="val">the value instance</param>
-/// <returns>the pointer to the generic array</returns>
-DY_DEF_GET_DATA(arr, dy_t);
+/// <returns>the pointer to the 8-bit integer array</returns>
+DY_DEF_GET_DATA(i8arr, int8_t);
 
 /// <summary>
-/// returns the value of a entry at the given index of the generic array in the
-/// internal data
+/// hands the buffer of the 8-bit integer array out of the value, which is left
+/// empty and must only be disposed afterwards. The buffer is not copied unless
+/// the value is shared, a view, or in an arena. Get the length first.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="free_fn">set to the function freeing the buffer, or
+/// <c>NULL</c> if the buffer need not be freed</param>
+/// <param name="ctx">set to the context to pass to <c>free_fn</c></param>
+/// <returns>the buffer</returns>
+DY_DEF_RELEASE_DATA(i8arr, int8_t);
+
+/// <summary>
+/// returns the value of a entry at the given index of the 8-bit integer array
+/// in the internal data
 /// </summary>
 /// <param name="val">the value instance</param>
 /// <param name="idx">the index of the entry</param>
 /// <returns>the value of the entry</returns>
-DY_DEF_GET_IDX(arr, dy_t);
+DY_DEF_GET_IDX(i8arr, int8_t);
 
-// ---------------------------------- map  ---------------------------------- //
+// --------------------------------- i16arr --------------------------------- //
 
 /// <summary>
-/// makes a generic map
+/// makes a 16-bit integer array value
 /// </summary>
-/// <param name="map">a pointer to the key-value pair array to copy</param>
+/// <param name="i16arr">a pointer to the 16-bit integer array to copy</param>
 /// <param name="len">the length of the array</param>
-/// <returns></returns>
-DY_DEF_MAKE_LEN(map, dy_keyval_t);
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_LEN(i16arr, int16_t);
 
 /// <summary>
-/// returns the length of the generic map in the internal data
+/// makes a 16-bit integer array value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="i16arr">a pointer to the 16-bit integer array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(i16arr, int16_t);
+
+/// <summary>
+/// makes a 16-bit integer array value taking the ownership of the buffer
+/// without copying it
+/// </summary>
+/// <param name="i16arr">the buffer</param>
+/// <param name="len">the length of the array</param>
+/// <param name="free_fn">the function freeing the buffer when the value is
+/// deallocated, or <c>NULL</c> if the buffer outlives the value</param>
+/// <param name="ctx">the context passed to <c>free_fn</c></param>
+/// <returns>a new value instance</returns>
+DY_DEF_ADOPT(i16arr, int16_t);
+
+/// <summary>
+/// makes a 16-bit integer array value referencing the memory without copying
+/// it. The memory is neither modified nor freed by the value and must outlive
+/// it and its copies.
+/// </summary>
+/// <param name="i16arr">the entries</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_VIEW(i16arr, int16_t);
+
+/// <summary>
+/// returns the length of the 16-bit integer array in the internal data
 /// </summary>
 /// <param name="val">the value instance</param>
-/// <returns>the length of the generic map</returns>
-DY_DEF_GET_LEN(map);
+/// <returns>the length of the 16-bit integer array</returns>
+DY_DEF_GET_LEN(i16arr);
 
 /// <summary>
-/// makes an iterator of the generic map in the internal data
+/// returns the pointer to the 16-bit integer array in the internal data
 /// </summary>
 /// <param name="val">the value instance</param>
-/// <returns>a new iterator instance</returns>
-DY_PUBLIC(dy_iter_t) dy_make_map_iter(dy_t val) DY_NOEXCEPT;
+/// <returns>the pointer to the 16-bit integer array</returns>
+DY_DEF_GET_DATA(i16arr, int16_t);
 
 /// <summary>
-/// returns the data pointed by the given iterator
+/// hands the buffer of the 16-bit integer array out of the value, which is left
+/// empty and must only be disposed afterwards. The buffer is not copied unless
+/// the value is shared, a view, or in an arena. Get the length first.
 /// </summary>
 /// <param name="val">the value instance</param>
-/// <param name="iter">the iterator instance</param>
-/// <param name="keyval">the pointer to copy value</param>
-/// <returns>the key-value pair pointed</returns>
-DY_PUBLIC(dy_keyval_t) dy_get_map_iter(dy_t val, dy_iter_t iter) DY_NOEXCEPT;
+/// <param name="free_fn">set to the function freeing the buffer, or
+/// <c>NULL</c> if the buffer need not be freed</param>
+/// <param name="ctx">set to the context to pass to <c>free_fn</c></param>
+/// <returns>the buffer</returns>
+DY_DEF_RELEASE_DATA(i16arr, int16_t);
 
 /// <summary>
-/// deallocates the memory holding the iterator instance
+/// returns the value of a entry at the given index of the 16-bit integer array
+/// in the internal data
 /// </summary>
-/// <param name="iter">the iterator</param>
-DY_PUBLIC(void) dy_dispose_map_iter(dy_iter_t iter) DY_NOEXCEPT;
+/// <param name="val">the value instance</param>
+/// <param name="idx">the index of the entry</param>
+/// <returns>the value of the entry</returns>
+DY_DEF_GET_IDX(i16arr, int16_t);
+
+// --------------------------------- i32arr --------------------------------- //
 
 /// <summary>
-/// returns the data with the given key
+/// makes a 32-bit integer array value
+/// </summary>
+/// <param name="i32arr">a pointer to the 32-bit integer array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_LEN(i32arr, int32_t);
+
+/// <summary>
+/// makes a 32-bit integer array value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="i32arr">a pointer to the 32-bit integer array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(i32arr, int32_t);
+
+/// <summary>
+/// makes a 32-bit integer array value taking the ownership of the buffer
+/// without copying it
+/// </summary>
+/// <param name="i32arr">the buffer</param>
+/// <param name="len">the length of the array</param>
+/// <param name="free_fn">the function freeing the buffer when the value is
+/// deallocated, or <c>NULL</c> if the buffer outlives the value</param>
+/// <param name="ctx">the context passed to <c>free_fn</c></param>
+/// <returns>a new value instance</returns>
+DY_DEF_ADOPT(i32arr, int32_t);
+
+/// <summary>
+/// makes a 32-bit integer array value referencing the memory without copying
+/// it. The memory is neither modified nor freed by the value and must outlive
+/// it and its copies.
+/// </summary>
+/// <param name="i32arr">the entries</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_VIEW(i32arr, int32_t);
+
+/// <summary>
+/// returns the length of the 32-bit integer array in the internal data
 /// </summary>
 /// <param name="val">the value instance</param>
-/// <param name="key">the key</param>
-/// <returns>the key-value pair with the given key</returns>
-DY_PUBLIC(dy_keyval_t) dy_get_map_key(dy_t val, char const* key) DY_NOEXCEPT;
+/// <returns>the length of the 32-bit integer array</returns>
+DY_DEF_GET_LEN(i32arr);
+
+/// <summary>
+/// returns the pointer to the 32-bit integer array in the internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the pointer to the 32-bit integer array</returns>
+DY_DEF_GET_DATA(i32arr, int32_t);
+
+/// <summary>
+/// hands the buffer of the 32-bit integer array out of the value, which is left
+/// empty and must only be disposed afterwards. The buffer is not copied unless
+/// the value is shared, a view, or in an arena. Get the length first.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="free_fn">set to the function freeing the buffer, or
+/// <c>NULL</c> if the buffer need not be freed</param>
+/// <param name="ctx">set to the context to pass to <c>free_fn</c></param>
+/// <returns>the buffer</returns>
+DY_DEF_RELEASE_DATA(i32arr, int32_t);
+
+/// <summary>
+/// returns the value of a entry at the given index of the 32-bit integer array
+/// in the internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="idx">the index of the entry</param>
+/// <returns>the value of the entry</returns>
+DY_DEF_GET_IDX(i32arr, int32_t);
+
+// --------------------------------- u32arr --------------------------------- //
+
+/// <summary>
+/// makes a 32-bit unsigned integer array value
+/// </summary>
+/// <param name="u32arr">a pointer to the 32-bit unsigned integer array to
+/// copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_LEN(u32arr, uint32_t);
+
+/// <summary>
+/// makes a 32-bit unsigned integer array value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="u32arr">a pointer to the 32-bit unsigned integer array to
+/// copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(u32arr, uint32_t);
+
+/// <summary>
+/// makes a 32-bit unsigned integer array value taking the ownership of the
+/// buffer without copying it
+/// </summary>
+/// <param name="u32arr">the buffer</param>
+/// <param name="len">the length of the array</param>
+/// <param name="free_fn">the function freeing the buffer when the value is
+/// deallocated, or <c>NULL</c> if the buffer outlives the value</param>
+/// <param name="ctx">the context passed to <c>free_fn</c></param>
+/// <returns>a new value instance</returns>
+DY_DEF_ADOPT(u32arr, uint32_t);
+
+/// <summary>
+/// makes a 32-bit unsigned integer array value referencing the memory without
+/// copying it. The memory is neither modified nor freed by the value and must
+/// outlive it and its copies.
+/// </summary>
+/// <param name="u32arr">the entries</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_VIEW(u32arr, uint32_t);
+
+/// <summary>
+/// returns the length of the 32-bit unsigned integer array in the internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the length of the 32-bit unsigned integer array</returns>
+DY_DEF_GET_LEN(u32arr);
+
+/// <summary>
+/// returns the pointer to the 32-bit unsigned integer array in the internal
+/// data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the pointer to the 32-bit unsigned integer array</returns>
+DY_DEF_GET_DATA(u32arr, uint32_t);
+
+/// <summary>
+/// hands the buffer of the 32-bit unsigned integer array out of the value,
+/// which is left empty and must only be disposed afterwards. The buffer is not
+/// copied unless the value is shared, a view, or in an arena. Get the length
+/// first.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="free_fn">set to the function freeing the buffer, or
+/// <c>NULL</c> if the buffer need not be freed</param>
+/// <param name="ctx">set to the context to pass to <c>free_fn</c></param>
+/// <returns>the buffer</returns>
+DY_DEF_RELEASE_DATA(u32arr, uint32_t);
+
+/// <summary>
+/// returns the value of a entry at the given index of the 32-bit unsigned
+/// integer array in the internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="idx">the index of the entry</param>
+/// <returns>the value of the entry</returns>
+DY_DEF_GET_IDX(u32arr, uint32_t);
+
+// --------------------------------- f32arr --------------------------------- //
+
+/// <summary>
+/// makes a single-precision number array value
+/// </summary>
+/// <param name="f32arr">a pointer to the single-precision number array to
+/// copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_LEN(f32arr, float);
+
+/// <summary>
+/// makes a single-precision number array value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="f32arr">a pointer to the single-precision number array to
+/// copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(f32arr, float);
+
+/// <summary>
+/// makes a single-precision number array value taking the ownership of the
+/// buffer without copying it
+/// </summary>
+/// <param name="f32arr">the buffer</param>
+/// <param name="len">the length of the array</param>
+/// <param name="free_fn">the function freeing the buffer when the value is
+/// deallocated, or <c>NULL</c> if the buffer outlives the value</param>
+/// <param name="ctx">the context passed to <c>free_fn</c></param>
+/// <returns>a new value instance</returns>
+DY_DEF_ADOPT(f32arr, float);
+
+/// <summary>
+/// makes a single-precision number array value referencing the memory without
+/// copying it. The memory is neither modified nor freed by the value and must
+/// outlive it and its copies.
+/// </summary>
+/// <param name="f32arr">the entries</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_VIEW(f32arr, float);
+
+/// <summary>
+/// returns the length of the single-precision number array in the internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the length of the single-precision number array</returns>
+DY_DEF_GET_LEN(f32arr);
+
+/// <summary>
+/// returns the pointer to the single-precision number array in the internal
+/// data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the pointer to the single-precision number array</returns>
+DY_DEF_GET_DATA(f32arr, float);
+
+/// <summary>
+/// hands the buffer of the single-precision number array out of the value,
+/// which is left empty and must only be disposed afterwards. The buffer is not
+/// copied unless the value is shared, a view, or in an arena. Get the length
+/// first.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="free_fn">set to the function freeing the buffer, or
+/// <c>NULL</c> if the buffer need not be freed</param>
+/// <param name="ctx">set to the context to pass to <c>free_fn</c></param>
+/// <returns>the buffer</returns>
+DY_DEF_RELEASE_DATA(f32arr, float);
+
+/// <summary>
+/// returns the value of a entry at the given index of the single-precision
+/// number array in the internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="idx">the index of the entry</param>
+/// <returns>the value of the entry</returns>
+DY_DEF_GET_IDX(f32arr, float);
+
+// ------------------------------- conversion ------------------------------- //
+
+/// <summary>
+/// checks whether the type is an array of numbers, which is one of
+/// <c>dy_type_bytes</c>, <c>dy_type_iarr</c>, <c>dy_type_farr</c>,
+/// <c>dy_type_i8arr</c>, <c>dy_type_i16arr</c>, <c>dy_type_i32arr</c>,
+/// <c>dy_type_u32arr</c> and <c>dy_type_f32arr</c>
+/// </summary>
+/// <param name="type">the type</param>
+/// <returns><c>true</c> if it is, <c>false</c> otherwise</returns>
+DY_PUBLIC(bool) dy_is_numeric_arr_type(dy_type_t type) DY_NOEXCEPT;
+
+/// <summary>
+/// makes an array value of another numeric type holding the entries of the
+/// array converted one by one. Integers out of the range of the new type are
+/// clamped to it. Floating-point numbers are rounded toward zero and clamped
+/// when converted to integers, and NaN becomes zero. Integers converted to
+/// floating-point numbers and double-precision numbers converted to
+/// single-precision ones are rounded to the nearest representable number, and
+/// numbers out of the range become infinities.
+/// </summary>
+/// <param name="val">the array of numbers</param>
+/// <param name="type">the type of the new array, for which
+/// <c>dy_is_numeric_arr_type</c> is true</param>
+/// <returns>a new value instance, or a copy of <c>val</c> if it already has
+/// the type</returns>
+DY_PUBLIC(dy_t) dy_convert_arr(dy_t val, dy_type_t type) DY_NOEXCEPT;
+
+// ---------------------------------- arr  ---------------------------------- //
+
+/// <summary>
+/// makes a generic array value
+/// </summary>
+/// <param name="arr">a pointer to the generic array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_MAKE_LEN(arr, dy_t);
+
+/// <summary>
+/// makes a generic array value in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="arr">a pointer to the generic array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(arr, dy_t);
+
+/// <summary>
+/// makes a generic array value, or a typed array if the entries are all
+/// booleans, all integers or all double-precision numbers as in
+/// <c>dy_compact</c>. The entries themselves are not compacted.
+/// </summary>
+/// <param name="arr">a pointer to the generic array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <param name="flags">the combination of <c>dy_compact_flag_t</c>s</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t)
+dy_make_arr_compact(dy_t const* arr, size_t len, uint32_t flags) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the length of the generic array in the internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the length of the generic array</returns>
+DY_DEF_GET_LEN(arr);
+
+/// <summary>
+/// returns the pointer to the generic array in the internal
+/// data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the pointer to the generic array</returns>
+DY_DEF_GET_DATA(arr, dy_t);
+
+/// <summary>
+/// returns the value of a entry at the given index of the generic array in the
+/// internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="idx">the index of the entry</param>
+/// <returns>the value of the entry</returns>
+DY_DEF_GET_IDX(arr, dy_t);
+
+// The functions below change arrays and maps in place. They consume the value
+// and return the instance to use from then on, which is the value itself if it
+// is the only reference to it and owns its entries. Otherwise, that is, if the
+// value is shared, a view, in an arena, read from a mapped file or parsed
+// lazily, the value is copied to the heap first and the copy is changed, so
+// that the other references see no change.
+
+/// <summary>
+/// appends the entry to the generic array. The array grows geometrically, so
+/// that pushing n entries one by one takes O(n) time.
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="elem">the entry to append, which is consumed</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t) dy_arr_push(dy_t val, dy_t elem) DY_NOEXCEPT;
+
+/// <summary>
+/// removes the last entry of the generic array, which must not be empty
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="elem">set to the removed entry to be disposed separately, or
+/// <c>NULL</c> to dispose it</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t) dy_arr_pop(dy_t val, dy_t* elem) DY_NOEXCEPT;
+
+/// <summary>
+/// inserts the entry at the index of the generic array, moving the entries
+/// after it
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="idx">the index, which is at most the length of the
+/// array</param>
+/// <param name="elem">the entry to insert, which is consumed</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t) dy_arr_insert(dy_t val, size_t idx, dy_t elem) DY_NOEXCEPT;
+
+/// <summary>
+/// disposes the entry at the index of the generic array and removes it, moving
+/// the entries after it
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="idx">the index of the entry</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t) dy_arr_erase(dy_t val, size_t idx) DY_NOEXCEPT;
+
+/// <summary>
+/// makes room in the generic array for the entries to be appended
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="len">the number of the entries to be appended</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t) dy_arr_reserve(dy_t val, size_t len) DY_NOEXCEPT;
+
+// ---------------------------------- key  ---------------------------------- //
+
+/// <summary>
+/// returns the interned key with the given characters, interning them if not
+/// interned yet. Safe to call from multiple threads.
+/// </summary>
+/// <param name="key">the pointer to the characters</param>
+/// <param name="len">the number of the characters</param>
+/// <returns>the interned key</returns>
+DY_PUBLIC(dy_key_t) dy_intern_key(char const* key, size_t len) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the NUL-terminated characters of the interned key
+/// </summary>
+/// <param name="key">the interned key</param>
+/// <returns>the characters</returns>
+DY_PUBLIC(char const*) dy_get_key_data(dy_key_t key) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the length of the interned key
+/// </summary>
+/// <param name="key">the interned key</param>
+/// <returns>the length</returns>
+DY_PUBLIC(size_t) dy_get_key_len(dy_key_t key) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the hash of the interned key, which is equal to the result of
+/// <c>dy_hash_key</c> on the characters
+/// </summary>
+/// <param name="key">the interned key</param>
+/// <returns>the hash</returns>
+DY_PUBLIC(uint64_t) dy_get_key_hash(dy_key_t key) DY_NOEXCEPT;
+
+// --------------------------------- shape  --------------------------------- //
+
+/// <summary>
+/// makes a shape with the keys in the given order. Maps made with
+/// <c>dy_make_map_with_shape</c> share the shape and only store their values.
+/// <c>dy_make_map</c> also shares the shapes recently made by the same thread
+/// for the same keys in the same order, including this one.
+/// </summary>
+/// <param name="keys">a pointer to the NUL-terminated keys to copy. Keys
+/// given more than once are added once.</param>
+/// <param name="len">the number of the keys</param>
+/// <returns>a new shape instance</returns>
+DY_PUBLIC(dy_shape_t)
+dy_make_shape(char const* const* keys, size_t len) DY_NOEXCEPT;
+
+/// <summary>
+/// releases the shape. The shape is deallocated once no map on the heap
+/// holds it.
+/// </summary>
+/// <param name="shape">the shape</param>
+DY_PUBLIC(void) dy_dispose_shape(dy_shape_t shape) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the number of the keys of the shape
+/// </summary>
+/// <param name="shape">the shape</param>
+/// <returns>the number of the keys</returns>
+DY_PUBLIC(size_t) dy_get_shape_len(dy_shape_t shape) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the key at the index of the shape
+/// </summary>
+/// <param name="shape">the shape</param>
+/// <param name="idx">the index</param>
+/// <returns>the NUL-terminated key</returns>
+DY_PUBLIC(char const*)
+dy_get_shape_key(dy_shape_t shape, size_t idx) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the index of the key in the shape. The index of a key is the same
+/// in every map with the shape, so it can be looked up once per shape and
+/// passed to <c>dy_get_map_idx</c>.
+/// </summary>
+/// <param name="shape">the shape</param>
+/// <param name="key">the pointer to the key</param>
+/// <param name="len">the length of the key</param>
+/// <returns>the index, or <c>SIZE_MAX</c> if not found</returns>
+DY_PUBLIC(size_t)
+dy_find_shape_key(dy_shape_t shape, char const* key, size_t len) DY_NOEXCEPT;
+
+// ---------------------------------- map  ---------------------------------- //
+
+/// <summary>
+/// makes a generic map
+/// </summary>
+/// <param name="map">a pointer to the key-value pair array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns></returns>
+DY_DEF_MAKE_LEN(map, dy_keyval_t);
+
+/// <summary>
+/// makes a generic map in the arena
+/// </summary>
+/// <param name="arena">the arena instance</param>
+/// <param name="map">a pointer to the key-value pair array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_DEF_ARENA_MAKE_LEN(map, dy_keyval_t);
+
+/// <summary>
+/// makes a generic map with interned keys. The keys are shared with every
+/// other map holding them instead of being copied, and while every key of the
+/// map is interned, looking up interned keys compares addresses only.
+/// </summary>
+/// <param name="map">a pointer to the key-value pair array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t)
+dy_make_map_interned(dy_interned_keyval_t const* map, size_t len) DY_NOEXCEPT;
+
+/// <summary>
+/// makes a generic map with interned keys in the arena
+/// </summary>
+/// <param name="arena">the arena</param>
+/// <param name="map">a pointer to the key-value pair array to copy</param>
+/// <param name="len">the length of the array</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t)
+dy_arena_make_map_interned(dy_arena_t                  arena,
+                           dy_interned_keyval_t const* map,
+                           size_t                      len) DY_NOEXCEPT;
+
+/// <summary>
+/// makes a generic map with the shape, holding a reference to the shape
+/// </summary>
+/// <param name="shape">the shape</param>
+/// <param name="map">a pointer to the values of the keys of the shape in the
+/// same order</param>
+/// <param name="len">the number of the values, which is equal to the number of
+/// the keys of the shape</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t)
+dy_make_map_with_shape(dy_shape_t  shape,
+                       dy_t const* map,
+                       size_t      len) DY_NOEXCEPT;
+
+/// <summary>
+/// makes a generic map with the shape in the arena. The map does not hold a
+/// reference to the shape, so the shape must not be released before the arena
+/// is reset or destroyed.
+/// </summary>
+/// <param name="arena">the arena</param>
+/// <param name="shape">the shape</param>
+/// <param name="map">a pointer to the values of the keys of the shape in the
+/// same order</param>
+/// <param name="len">the number of the values, which is equal to the number of
+/// the keys of the shape</param>
+/// <returns>a new value instance</returns>
+DY_PUBLIC(dy_t)
+dy_arena_make_map_with_shape(dy_arena_t  arena,
+                             dy_shape_t  shape,
+                             dy_t const* map,
+                             size_t      len) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the length of the generic map in the internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the length of the generic map</returns>
+DY_DEF_GET_LEN(map);
+
+/// <summary>
+/// returns the shape of the generic map, which is valid while the map is.
+/// Maps read from mapped files have no shape.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>the shape, or <c>NULL</c> if the map is read from a mapped
+/// file</returns>
+DY_PUBLIC(dy_shape_t) dy_get_map_shape(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the data at the index of the generic map. Entries are kept in the
+/// order their keys were first given.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="idx">the index</param>
+/// <returns>the key-value pair at the index</returns>
+DY_PUBLIC(dy_keyval_t) dy_get_map_idx(dy_t val, size_t idx) DY_NOEXCEPT;
+
+/// <summary>
+/// makes an iterator of the generic map in the internal data
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <returns>a new iterator instance</returns>
+DY_PUBLIC(dy_iter_t) dy_make_map_iter(dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// initializes an iterator of the generic map in memory owned by the caller,
+/// which needs no <c>dy_dispose_map_iter</c>
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="iter">the iterator state to initialize</param>
+DY_PUBLIC(void) dy_init_map_iter(dy_t val, dy_iter_t iter) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the data pointed by the given iterator
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="iter">the iterator instance</param>
+/// <param name="keyval">the pointer to copy value</param>
+/// <returns>the key-value pair pointed</returns>
+DY_PUBLIC(dy_keyval_t) dy_get_map_iter(dy_t val, dy_iter_t iter) DY_NOEXCEPT;
+
+/// <summary>
+/// deallocates the memory holding the iterator instance
+/// </summary>
+/// <param name="iter">the iterator</param>
+DY_PUBLIC(void) dy_dispose_map_iter(dy_iter_t iter) DY_NOEXCEPT;
+
+/// <summary>
+/// indicates a function receiving the entries of a generic map
+/// </summary>
+/// <param name="ctx">the context given with the function</param>
+/// <param name="keyval">the key-value pair, which lives as long as the
+/// map</param>
+/// <returns><c>true</c> to continue, <c>false</c> to stop</returns>
+typedef bool (*dy_map_fn_t)(void* ctx, dy_keyval_t keyval);
+
+/// <summary>
+/// calls the function on each entry of the generic map in order. The function
+/// must not change the map.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="fn">the function</param>
+/// <param name="ctx">the context passed to the function</param>
+/// <returns><c>true</c> if every entry is visited, <c>false</c> if the
+/// function stopped</returns>
+DY_PUBLIC(bool)
+dy_map_foreach(dy_t val, dy_map_fn_t fn, void* ctx) DY_NOEXCEPT;
+
+/// <summary>
+/// copies the key-value pairs of the generic map to the array in order, up
+/// to its capacity. Pass an array of <c>dy_get_map_len</c> pairs to get them
+/// all.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="out">the array to fill</param>
+/// <param name="cap">the capacity of the array</param>
+/// <returns>the number of the pairs copied</returns>
+DY_PUBLIC(size_t)
+dy_map_export(dy_t val, dy_keyval_t* out, size_t cap) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the data with the given key
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="key">the key</param>
+/// <returns>the key-value pair with the given key</returns>
+DY_PUBLIC(dy_keyval_t) dy_get_map_key(dy_t val, char const* key) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the data with the given key, which is not necessarily
+/// NUL-terminated
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="key">the pointer to the key</param>
+/// <param name="len">the length of the key</param>
+/// <returns>the key-value pair with the given key</returns>
+DY_PUBLIC(dy_keyval_t)
+dy_get_map_key_n(dy_t val, char const* key, size_t len) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the data with the given key, using a hash computed beforehand
+/// with <c>dy_hash_key</c>. Hashing keys known ahead of time once saves the
+/// hashing on every lookup.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="key">the pointer to the key</param>
+/// <param name="len">the length of the key</param>
+/// <param name="hash">the result of <c>dy_hash_key(key, len)</c></param>
+/// <returns>the key-value pair with the given key</returns>
+DY_PUBLIC(dy_keyval_t)
+dy_get_map_key_hashed(dy_t        val,
+                      char const* key,
+                      size_t      len,
+                      uint64_t    hash) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the data with the interned key
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="key">the interned key</param>
+/// <returns>the key-value pair with the given key</returns>
+DY_PUBLIC(dy_keyval_t)
+dy_get_map_key_interned(dy_t val, dy_key_t key) DY_NOEXCEPT;
+
+/// <summary>
+/// sets the entry with the key as described in <c>dy_arr_push</c>. The entry
+/// replaces the one with the same key, which is disposed, or is appended after
+/// the other keys.
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="key">the key to set</param>
+/// <param name="elem">the entry, which is consumed</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t) dy_map_set(dy_t val, char const* key, dy_t elem) DY_NOEXCEPT;
+
+/// <summary>
+/// disposes the entry with the key and removes it from the map, keeping the
+/// order of the other keys. The value is left as is if the key is not found.
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="key">the key to remove</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t) dy_map_erase(dy_t val, char const* key) DY_NOEXCEPT;
+
+/// <summary>
+/// makes room in the map for the keys to be set
+/// </summary>
+/// <param name="val">the value instance, which is consumed</param>
+/// <param name="len">the number of the keys to be set</param>
+/// <returns>the value instance to be disposed separately, which may be
+/// <c>val</c></returns>
+DY_PUBLIC(dy_t) dy_map_reserve(dy_t val, size_t len) DY_NOEXCEPT;
+
+/// <summary>
+/// hashes the key for <c>dy_get_map_key_hashed</c>. The hash does not change
+/// while the process runs.
+/// </summary>
+/// <param name="key">the pointer to the key</param>
+/// <param name="len">the length of the key</param>
+/// <returns>the hash of the key</returns>
+DY_PUBLIC(uint64_t) dy_hash_key(char const* key, size_t len) DY_NOEXCEPT;
+
+// -------------------------------- builder  -------------------------------- //
+
+// A builder makes a nested value from a sequence of calls in document order,
+// as decoders read it: an array or a map begins, its entries are pushed, and
+// it ends. Each map entry is preceded by its key. The entries are written
+// straight into the arrays and maps they belong to, so the caller gathers
+// nothing in temporary buffers. A builder is not thread-safe.
+//
+//   dy_builder_begin_map(builder, 2);
+//   dy_builder_key(builder, "id");
+//   dy_builder_push_i(builder, 1);
+//   dy_builder_key(builder, "tags");
+//   dy_builder_begin_arr(builder, 0);
+//   dy_builder_push_str(builder, "a");
+//   dy_builder_end(builder);
+//   dy_builder_end(builder);
+//   dy_t val = dy_builder_finish(builder);  // {"id": 1, "tags": ["a"]}
+
+/// <summary>
+/// makes a builder. Maps built on the heap share their shapes as with
+/// <c>dy_make_map</c>.
+/// </summary>
+/// <param name="arena">the arena to make the values in, or <c>NULL</c> to make
+/// them on the heap</param>
+/// <returns>a new builder, or <c>NULL</c> on failure</returns>
+DY_PUBLIC(dy_builder_t) dy_builder_create(dy_arena_t arena) DY_NOEXCEPT;
+
+/// <summary>
+/// begins a generic array, which takes the entries pushed until it ends
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <param name="len_hint">the expected number of the entries, which are
+/// allocated at once, or 0 if not known</param>
+DY_PUBLIC(void)
+dy_builder_begin_arr(dy_builder_t builder, size_t len_hint) DY_NOEXCEPT;
+
+/// <summary>
+/// begins a generic map, which takes the entries pushed until it ends
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <param name="len_hint">the expected number of the keys, which are
+/// allocated at once, or 0 if not known</param>
+DY_PUBLIC(void)
+dy_builder_begin_map(dy_builder_t builder, size_t len_hint) DY_NOEXCEPT;
+
+/// <summary>
+/// sets the key of the next entry of the map begun last. If the map has the
+/// key already, the entry is disposed when pushed, as the first pair wins in
+/// <c>dy_make_map</c>.
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <param name="key">the key, which is copied</param>
+DY_PUBLIC(void)
+dy_builder_key(dy_builder_t builder, char const* key) DY_NOEXCEPT;
+
+/// <summary>
+/// sets the key of the next entry as <c>dy_builder_key</c> does
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <param name="key">the key, which is copied</param>
+/// <param name="len">the length of the key</param>
+DY_PUBLIC(void)
+dy_builder_key_n(dy_builder_t builder, char const* key, size_t len) DY_NOEXCEPT;
+
+/// <summary>
+/// pushes the value into the array or the map begun last, or makes it the
+/// value built if there is none
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <param name="val">the value, which is consumed. Must be in the arena of the
+/// builder, if any, as described in <c>dy_arena_create</c>.</param>
+DY_PUBLIC(void) dy_builder_push(dy_builder_t builder, dy_t val) DY_NOEXCEPT;
+
+/// <summary>
+/// pushes a null value as <c>dy_builder_push</c> does
+/// </summary>
+/// <param name="builder">the builder</param>
+DY_PUBLIC(void) dy_builder_push_null(dy_builder_t builder) DY_NOEXCEPT;
+
+/// <summary>
+/// pushes a boolean value as <c>dy_builder_push</c> does
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <param name="b">the boolean</param>
+DY_PUBLIC(void) dy_builder_push_b(dy_builder_t builder, bool b) DY_NOEXCEPT;
+
+/// <summary>
+/// pushes an integer value as <c>dy_builder_push</c> does
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <param name="i">the integer</param>
+DY_PUBLIC(void) dy_builder_push_i(dy_builder_t builder, int64_t i) DY_NOEXCEPT;
+
+/// <summary>
+/// pushes a double-precision number value as <c>dy_builder_push</c> does
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <param name="f">the number</param>
+DY_PUBLIC(void) dy_builder_push_f(dy_builder_t builder, double f) DY_NOEXCEPT;
+
+/// <summary>
+/// pushes a string value as <c>dy_builder_push</c> does
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <param name="str">the NUL-terminated string, which is copied</param>
+DY_PUBLIC(void)
+dy_builder_push_str(dy_builder_t builder, char const* str) DY_NOEXCEPT;
+
+/// <summary>
+/// pushes a string value as <c>dy_builder_push</c> does
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <param name="str">the string, which is copied</param>
+/// <param name="len">the length of the string</param>
+DY_PUBLIC(void)
+dy_builder_push_str_len(dy_builder_t builder,
+                        char const*  str,
+                        size_t       len) DY_NOEXCEPT;
+
+/// <summary>
+/// ends the array or the map begun last
+/// </summary>
+/// <param name="builder">the builder</param>
+DY_PUBLIC(void) dy_builder_end(dy_builder_t builder) DY_NOEXCEPT;
+
+/// <summary>
+/// hands the value built out, after every array and map has ended. The
+/// builder can build another value afterwards.
+/// </summary>
+/// <param name="builder">the builder</param>
+/// <returns>the value instance to be disposed separately, or <c>NULL</c> if
+/// nothing was pushed</returns>
+DY_PUBLIC(dy_t) dy_builder_finish(dy_builder_t builder) DY_NOEXCEPT;
+
+/// <summary>
+/// destroys the builder, disposing the value being built if any
+/// </summary>
+/// <param name="builder">the builder</param>
+DY_PUBLIC(void) dy_builder_destroy(dy_builder_t builder) DY_NOEXCEPT;
+
+// ---------------------------------- json  --------------------------------- //
+
+/// <summary>
+/// indicates why parsing JSON text or decoding MessagePack failed
+/// </summary>
+typedef enum _dy_parse_error_t
+{
+    /// <summary>
+    /// no error
+    /// </summary>
+    dy_parse_ok,
+
+    /// <summary>
+    /// the text does not follow the grammar of JSON, or the data is not
+    /// MessagePack that can be decoded
+    /// </summary>
+    dy_parse_syntax,
+
+    /// <summary>
+    /// a string has an invalid escape sequence or an unescaped control
+    /// character, or the text is not valid UTF-8
+    /// </summary>
+    dy_parse_string,
+
+    /// <summary>
+    /// a number is out of the range of double-precision numbers
+    /// </summary>
+    dy_parse_number,
+
+    /// <summary>
+    /// arrays and maps are nested deeper than allowed
+    /// </summary>
+    dy_parse_depth,
+
+    /// <summary>
+    /// the text is 4 GiB or longer
+    /// </summary>
+    dy_parse_capacity,
+
+    /// <summary>
+    /// the function receiving the values of an incremental parser stopped it
+    /// </summary>
+    dy_parse_stopped,
+} dy_parse_error_t;
+
+/// <summary>
+/// indicates the options of parsing JSON text or decoding MessagePack.
+/// Zero-initialize it and set the fields to change.
+/// </summary>
+typedef struct _dy_parse_opts_t
+{
+    /// <summary>
+    /// the arena to make the values in, or <c>NULL</c> to make them on the
+    /// heap
+    /// </summary>
+    dy_arena_t arena;
+
+    /// <summary>
+    /// whether to make generic arrays of numbers. Otherwise, arrays of
+    /// integers become integer arrays, and arrays of numbers which are not all
+    /// integers become double-precision number arrays unless an integer is
+    /// not exact in double precision. Unused by MessagePack, whose typed
+    /// arrays are encoded as such.
+    /// </summary>
+    bool generic_arrays;
+
+    /// <summary>
+    /// whether to parse the entries of each array and map on their first
+    /// read. The whole text is still checked at first, so the same texts are
+    /// rejected with the same errors as otherwise. The text is copied, and
+    /// the arena is not used. Arrays which start with a
+    /// number, which may become typed arrays, are parsed at once. Unused by
+    /// MessagePack and incremental parsers.
+    /// </summary>
+    bool lazy;
+
+    /// <summary>
+    /// the maximum depth of the arrays and maps, or 0 for 1024
+    /// </summary>
+    size_t max_depth;
+
+    /// <summary>
+    /// set to the reason parsing failed
+    /// </summary>
+    dy_parse_error_t error;
+
+    /// <summary>
+    /// set to the offset of the byte where parsing failed
+    /// </summary>
+    size_t error_offset;
+} dy_parse_opts_t;
+
+/// <summary>
+/// parses JSON text. Numbers without a fraction or an exponent which fit in
+/// 8-byte integers become integers, and the rest become double-precision
+/// numbers. If a key is given more than once in an object, the first pair
+/// wins. Keys end at their first NUL character, if any.
+/// </summary>
+/// <param name="json">the UTF-8 text, which need not be NUL-terminated</param>
+/// <param name="len">the length of the text in bytes</param>
+/// <param name="opts">the options, or <c>NULL</c> for the default ones</param>
+/// <returns>a new value instance, or <c>NULL</c> if the text is not valid
+/// JSON</returns>
+DY_PUBLIC(dy_t)
+dy_parse_json(char const* json, size_t len, dy_parse_opts_t* opts) DY_NOEXCEPT;
+
+/// <summary>
+/// indicates a function receiving the values of an incremental parser
+/// </summary>
+/// <param name="ctx">the context given with the function</param>
+/// <param name="val">the value instance, which the function owns</param>
+/// <returns><c>true</c> to continue, <c>false</c> to stop parsing</returns>
+typedef bool (*dy_parser_fn_t)(void* ctx, dy_t val);
+
+/// <summary>
+/// makes a parser which reads JSON text in chunks and hands each value to the
+/// function as soon as its text is complete. Only the text of one value is
+/// held at a time, so that a stream of any length can be read in bounded
+/// memory. The values are made in the arena of the options if any, which the
+/// function can reset before returning.
+/// </summary>
+/// <param name="path">a JSON pointer (RFC 6901) to the arrays whose entries
+/// are handed out, such as <c>"/data/items"</c>, or <c>""</c> for the arrays
+/// at the top level. If <c>NULL</c>, each value at the top level is handed
+/// out, as in newline-delimited JSON.</param>
+/// <param name="opts">the options, or <c>NULL</c> for the default ones.
+/// The error fields are not used.</param>
+/// <param name="fn">the function receiving the values</param>
+/// <param name="ctx">the context passed to <c>fn</c></param>
+/// <returns>a new parser, or <c>NULL</c> if the path is not a JSON
+/// pointer</returns>
+DY_PUBLIC(dy_parser_t)
+dy_parser_create(char const*            path,
+                 dy_parse_opts_t const* opts,
+                 dy_parser_fn_t         fn,
+                 void*                  ctx) DY_NOEXCEPT;
+
+/// <summary>
+/// reads the next chunk of the text. Chunks can be split anywhere, even in
+/// the middle of a character. The text outside the values handed out is only
+/// checked for its structure.
+/// </summary>
+/// <param name="parser">the parser</param>
+/// <param name="buf">the chunk, which can be <c>NULL</c> if <c>len</c> is
+/// 0</param>
+/// <param name="len">the length of the chunk in bytes</param>
+/// <returns><c>false</c> if the text is not valid JSON or the function
+/// stopped parsing</returns>
+DY_PUBLIC(bool)
+dy_parser_feed(dy_parser_t parser, char const* buf, size_t len) DY_NOEXCEPT;
+
+/// <summary>
+/// ends the text, handing out a number or a literal at its end
+/// </summary>
+/// <param name="parser">the parser</param>
+/// <returns><c>false</c> if the text is not valid JSON, ends in the middle of
+/// a value, or the function stopped parsing</returns>
+DY_PUBLIC(bool) dy_parser_finish(dy_parser_t parser) DY_NOEXCEPT;
+
+/// <summary>
+/// returns why the parser failed
+/// </summary>
+/// <param name="parser">the parser</param>
+/// <param name="offset">set to the offset of the byte in the whole text where
+/// parsing failed. Can be <c>NULL</c>.</param>
+/// <returns>the reason, or <c>dy_parse_ok</c> if the parser did not
+/// fail</returns>
+DY_PUBLIC(dy_parse_error_t)
+dy_get_parser_error(dy_parser_t parser, size_t* offset) DY_NOEXCEPT;
+
+/// <summary>
+/// destroys the parser
+/// </summary>
+/// <param name="parser">the parser</param>
+DY_PUBLIC(void) dy_parser_destroy(dy_parser_t parser) DY_NOEXCEPT;
+
+/// <summary>
+/// indicates a function receiving a chunk of JSON text or MessagePack
+/// </summary>
+/// <param name="ctx">the context given with the function</param>
+/// <param name="data">the chunk, which is not NUL-terminated</param>
+/// <param name="len">the length of the chunk in bytes</param>
+/// <returns><c>true</c> to continue, <c>false</c> to stop writing</returns>
+typedef bool (*dy_write_fn_t)(void* ctx, char const* data, size_t len);
+
+/// <summary>
+/// indicates the options of writing JSON text, which can be combined
+/// </summary>
+typedef enum _dy_write_flag_t
+{
+    /// <summary>
+    /// writes byte arrays as arrays of numbers
+    /// </summary>
+    dy_write_default = 0,
+
+    /// <summary>
+    /// writes byte arrays as strings in base64
+    /// </summary>
+    dy_write_base64 = 1 << 0,
+} dy_write_flag_t;
+
+/// <summary>
+/// writes the value as JSON text without whitespace, handing it to the
+/// function in chunks of at most a few kilobytes. Double-precision numbers are
+/// written in the shortest form which reads back to the same number, with a
+/// fraction if they are integers, and as <c>null</c> if they are not finite.
+/// Strings are written as they are except for the characters which must be
+/// escaped, and keys end at their first NUL character.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="flags">the combination of <c>dy_write_flag_t</c>s</param>
+/// <param name="write_fn">the function receiving the text</param>
+/// <param name="ctx">the context passed to <c>write_fn</c></param>
+/// <returns><c>true</c> if the whole text was written, <c>false</c> if
+/// <c>write_fn</c> stopped it</returns>
+DY_PUBLIC(bool)
+dy_write_json(dy_t          val,
+              uint32_t      flags,
+              dy_write_fn_t write_fn,
+              void*         ctx) DY_NOEXCEPT;
+
+/// <summary>
+/// writes the value as JSON text into the buffer as <c>dy_write_json</c>
+/// does. As with <c>snprintf</c>, the text is cut to fit and terminated with
+/// a NUL character unless the capacity is 0.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="flags">the combination of <c>dy_write_flag_t</c>s</param>
+/// <param name="buf">the buffer, which can be <c>NULL</c> if <c>cap</c> is
+/// 0</param>
+/// <param name="cap">the size of the buffer in bytes</param>
+/// <returns>the length of the whole text, not counting the NUL
+/// character</returns>
+DY_PUBLIC(size_t)
+dy_write_json_buffer(dy_t     val,
+                     uint32_t flags,
+                     char*    buf,
+                     size_t   cap) DY_NOEXCEPT;
+
+// --------------------------------- msgpack -------------------------------- //
+
+// Values are encoded in the smallest MessagePack formats that hold them.
+// Double-precision numbers are encoded as single-precision ones if that is
+// exact. Byte arrays become bin, and the other typed arrays become extensions
+// holding their entries in little-endian order, so that they are copied at
+// once. The type codes follow the tags of RFC 8746:
+//
+//   dy_type_u32arr   70   dy_type_i32arr   78   dy_type_farr     86
+//   dy_type_i8arr    72   dy_type_iarr     79
+//   dy_type_i16arr   77   dy_type_f32arr   85
+//
+// Boolean arrays have the type code 1, and hold the number of the unused bits
+// in the last byte followed by the bits packed from the least significant one.
+
+/// <summary>
+/// encodes the value in MessagePack, handing it to the function in chunks of
+/// at most a few kilobytes. Keys end at their first NUL character.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="write_fn">the function receiving the bytes</param>
+/// <param name="ctx">the context passed to <c>write_fn</c></param>
+/// <returns><c>true</c> if the whole value was encoded, <c>false</c> if
+/// <c>write_fn</c> stopped it or a string or an array has 4 GiB or more of
+/// bytes or entries</returns>
+DY_PUBLIC(bool)
+dy_encode_msgpack(dy_t val, dy_write_fn_t write_fn, void* ctx) DY_NOEXCEPT;
+
+/// <summary>
+/// encodes the value in MessagePack into the buffer as
+/// <c>dy_encode_msgpack</c> does. The bytes are cut to fit.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="buf">the buffer, which can be <c>NULL</c> if <c>cap</c> is
+/// 0</param>
+/// <param name="cap">the size of the buffer in bytes</param>
+/// <returns>the length of the whole encoding, or 0 if the value cannot be
+/// encoded</returns>
+DY_PUBLIC(size_t)
+dy_encode_msgpack_buffer(dy_t val, void* buf, size_t cap) DY_NOEXCEPT;
+
+/// <summary>
+/// decodes a value from MessagePack. Maps must have string keys, and the
+/// extensions other than the typed arrays above are rejected. Strings are
+/// not checked to be valid UTF-8.
+/// </summary>
+/// <param name="data">the bytes</param>
+/// <param name="len">the number of the bytes</param>
+/// <param name="opts">the options, or <c>NULL</c> for the default ones</param>
+/// <returns>a new value instance, or <c>NULL</c> if the bytes are not one
+/// encoded value</returns>
+DY_PUBLIC(dy_t)
+dy_decode_msgpack(void const* data, size_t len, dy_parse_opts_t* opts)
+    DY_NOEXCEPT;
+
+// --------------------------------- mapped --------------------------------- //
+
+// Mapped files hold values in the layout they are read in, so that a file is
+// mapped into memory and read without being parsed. Strings and typed arrays
+// are views of the file, and generic arrays and maps read their entries from
+// it. Value instances are made in an arena owned by the file only for the
+// values touched, once each, and every map has an index of its keys built by
+// the writer. The values are read-only and live in the arena as described in
+// <c>dy_arena_create</c>, so <c>dy_copy</c> copies them out of the file.
+// Files are read by the targets with the byte order of the writer, and only
+// on 64-bit targets.
+
+/// <summary>
+/// writes the value in the mapped format, handing it to the function in
+/// chunks of at most a few kilobytes. Keys end at their first NUL character.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="write_fn">the function receiving the bytes</param>
+/// <param name="ctx">the context passed to <c>write_fn</c></param>
+/// <returns><c>true</c> if the whole value was written, <c>false</c> if
+/// <c>write_fn</c> stopped it or a key has 4 GiB or more of bytes</returns>
+DY_PUBLIC(bool)
+dy_write_mapped(dy_t val, dy_write_fn_t write_fn, void* ctx) DY_NOEXCEPT;
+
+/// <summary>
+/// writes the value in the mapped format into the buffer as
+/// <c>dy_write_mapped</c> does. The bytes are cut to fit.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="buf">the buffer, which can be <c>NULL</c> if <c>cap</c> is
+/// 0</param>
+/// <param name="cap">the size of the buffer in bytes</param>
+/// <returns>the length of the whole file, or 0 if the value cannot be
+/// written</returns>
+DY_PUBLIC(size_t)
+dy_write_mapped_buffer(dy_t val, void* buf, size_t cap) DY_NOEXCEPT;
+
+/// <summary>
+/// maps the file written by <c>dy_write_mapped</c> into memory read-only.
+/// Only the header and the footer are read here, and the records are checked
+/// to lie in the file as they are touched. The entries which do not lie before
+/// their arrays and maps, as written, read as null, so no file makes a cycle.
+/// </summary>
+/// <param name="path">the path to the file</param>
+/// <returns>a new mapped file instance, or <c>NULL</c> if the file cannot be
+/// mapped or is not in the format</returns>
+DY_PUBLIC(dy_mapped_t) dy_open_mapped(char const* path) DY_NOEXCEPT;
+
+/// <summary>
+/// reads the bytes written by <c>dy_write_mapped</c> in place, as
+/// <c>dy_open_mapped</c> does with a file
+/// </summary>
+/// <param name="data">the bytes, which are 8-byte aligned and must outlive
+/// the instance</param>
+/// <param name="len">the number of the bytes</param>
+/// <returns>a new mapped file instance, or <c>NULL</c> if the bytes are not in
+/// the format</returns>
+DY_PUBLIC(dy_mapped_t)
+dy_open_mapped_buffer(void const* data, size_t len) DY_NOEXCEPT;
+
+/// <summary>
+/// returns the value in the mapped file, which is valid until the file is
+/// closed. Reading the value and the values in it is thread-safe.
+/// </summary>
+/// <param name="mapped">the mapped file instance</param>
+/// <returns>the value</returns>
+DY_PUBLIC(dy_t) dy_get_mapped_root(dy_mapped_t mapped) DY_NOEXCEPT;
+
+/// <summary>
+/// unmaps the file, invalidating every value read from it
+/// </summary>
+/// <param name="mapped">the mapped file instance</param>
+DY_PUBLIC(void) dy_close_mapped(dy_mapped_t mapped) DY_NOEXCEPT;
 
 #endif
\ No newline at end of file
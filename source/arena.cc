@@ -0,0 +1,173 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.p.hh>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+namespace
+{
+
+/// <summary>
+/// the block size used when zero is given to <c>dy_arena_create</c>
+/// </summary>
+constexpr size_t default_block_size = 64 * 1024;
+
+/// <summary>
+/// rounds the pointer up to the given alignment
+/// </summary>
+/// <param name="ptr">the pointer</param>
+/// <param name="alignment">the alignment, which is a power of two</param>
+/// <returns>the aligned pointer</returns>
+inline char* align_up(char* ptr, size_t alignment) noexcept
+{
+    auto addr = reinterpret_cast<uintptr_t>(ptr);
+    return ptr + ((alignment - (addr & (alignment - 1))) & (alignment - 1));
+}
+
+/// <summary>
+/// rounds the size up to the alignment of every scalar type
+/// </summary>
+inline size_t align_size(size_t size) noexcept
+{
+    constexpr size_t alignment = alignof(max_align_t);
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+/// <summary>
+/// returns the first usable byte of the block
+/// </summary>
+inline char* block_begin(_dy_arena_t::block* block) noexcept
+{
+    return reinterpret_cast<char*>(block + 1);
+}
+
+}
+
+_dy_arena_t::_dy_arena_t(size_t block_size) noexcept :
+    block_size { align_size(block_size != 0 ? block_size
+                                            : default_block_size) },
+    head { nullptr },
+    current { nullptr },
+    cur { nullptr },
+    end { nullptr }
+{}
+
+_dy_arena_t::~_dy_arena_t() noexcept
+{
+    for (block* it = head; it != nullptr;)
+    {
+        block* next = it->next;
+        free(it);
+        it = next;
+    }
+}
+
+void _dy_arena_t::reset() noexcept
+{
+    block** link = &head;
+    while (*link != nullptr)
+    {
+        block* it = *link;
+        if (it->size > block_size)
+        {
+            *link = it->next;
+            free(it);
+        }
+        else
+            link = &it->next;
+    }
+
+    current = head;
+    cur     = current != nullptr ? block_begin(current) : nullptr;
+    end     = current != nullptr ? cur + current->size : nullptr;
+}
+
+void* _dy_arena_t::do_allocate(size_t bytes, size_t alignment)
+{
+    // aligning may move the pointer past the end of the block
+    char* ptr = cur != nullptr ? align_up(cur, alignment) : nullptr;
+    if (ptr == nullptr || ptr > end || static_cast<size_t>(end - ptr) < bytes)
+    {
+        next_block(bytes, alignment);
+        ptr = align_up(cur, alignment);
+    }
+
+    cur = ptr + bytes;
+    return ptr;
+}
+
+void _dy_arena_t::do_deallocate(void*, size_t, size_t) {}
+
+bool _dy_arena_t::do_is_equal(memory_resource const& other) const noexcept
+{
+    return this == &other;
+}
+
+void _dy_arena_t::next_block(size_t bytes, size_t alignment) noexcept
+{
+    size_t needed = bytes + alignment;
+
+    // reuse the blocks kept by reset() first
+    block* prev = current;
+    block* it   = current != nullptr ? current->next : head;
+    if (it != nullptr && it->size >= needed)
+    {
+        current = it;
+        cur     = block_begin(it);
+        end     = cur + it->size;
+        return;
+    }
+
+    // the blocks end at the maximum alignment, as they begin
+    size_t size  = align_size(max(block_size, needed));
+    auto   block = static_cast<_dy_arena_t::block*>(
+        malloc(sizeof(_dy_arena_t::block) + size));
+    if (block == nullptr) abort();
+
+    block->size = size;
+    if (prev != nullptr)
+    {
+        block->next = prev->next;
+        prev->next  = block;
+    }
+    else
+    {
+        block->next = head;
+        head        = block;
+    }
+
+    current = block;
+    cur     = block_begin(block);
+    end     = cur + size;
+}
+
+DY_PUBLIC(dy_arena_t) dy_arena_create(size_t block_size) DY_NOEXCEPT
+{
+    return new (nothrow) _dy_arena_t { block_size };
+}
+
+DY_PUBLIC(void) dy_arena_reset(dy_arena_t arena) DY_NOEXCEPT
+{
+    assert(arena != nullptr);
+    arena->reset();
+}
+
+DY_PUBLIC(void) dy_arena_destroy(dy_arena_t arena) DY_NOEXCEPT
+{
+    delete arena;
+}
+
+DY_PUBLIC(size_t) dy_arena_capacity(dy_arena_t arena) DY_NOEXCEPT
+{
+    assert(arena != nullptr);
+
+    size_t capacity = 0;
+    for (auto it = arena->head; it != nullptr; it = it->next)
+        capacity += it->size;
+    return capacity;
+}
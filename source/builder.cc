@@ -0,0 +1,399 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.p.hh>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/// <summary>
+/// a builder of nested values. Each array and map is made when it begins and
+/// added to its parent at once, so the entries are written into the internal
+/// data of the value they end up in, rather than gathered and copied.
+///
+/// Decoders mostly produce maps with the same keys at the same depth, such as
+/// the records of an array. A map begins with the shape of the last map ended
+/// at its depth, and while its keys are the keys of the shape in order, they
+/// are only compared and the values are stored at their indices. Otherwise the
+/// map takes a copy of the keys matched so far and adds the others to it.
+/// </summary>
+struct _dy_builder_t
+{
+  public:
+    explicit _dy_builder_t(dy_arena_t arena) noexcept :
+        arena_ { arena },
+        res_ { arena != nullptr ? arena : dy::heap() },
+        root_ { nullptr },
+        has_key_ { false }
+    {}
+
+    _dy_builder_t(_dy_builder_t const&) = delete;
+
+    ~_dy_builder_t() noexcept
+    {
+        clear();
+        forget_shapes();
+    }
+
+    /// <summary>
+    /// makes a generic array or map, adds it, and makes it the container of
+    /// the entries added next
+    /// </summary>
+    /// <param name="hint">the expected number of the entries</param>
+    void begin(dy_type_t type, size_t hint) noexcept
+    {
+        void*   ptr   = res_->allocate(sizeof(_dy_val_t), alignof(_dy_val_t));
+        uint8_t flags = arena_ != nullptr ? dy::flag_arena : 0;
+
+        dy_t val;
+        if (type == dy_type_arr)
+        {
+            pmr::vector<dy_t> arr(res_);
+            arr.reserve(hint);
+            val = new (ptr) _dy_val_t {
+                .type  = dy_type_arr,
+                .flags = flags,
+                .data  = { .arr = move(arr) },
+            };
+        }
+        else
+        {
+            val = new (ptr) _dy_val_t {
+                .type  = dy_type_map,
+                .flags = flags,
+                .data  = { .map = make_map(hint) },
+            };
+        }
+
+        bool   added   = add(val);
+        size_t matched = type == dy_type_map && predicted() ? 0 : npos;
+        frames_.push_back({ val, added, matched });
+    }
+
+    /// <summary>
+    /// sets the key of the entry added next to the map
+    /// </summary>
+    void key(char const* key, size_t len) noexcept
+    {
+        assert(!frames_.empty() && frames_.back().val->type == dy_type_map);
+        assert(!has_key_);
+
+        key_.assign(key, len);
+        has_key_ = true;
+    }
+
+    /// <summary>
+    /// adds the value, or disposes it if the map has the key already
+    /// </summary>
+    void push(dy_t val) noexcept
+    {
+        if (!add(val)) dy_dispose(val);
+    }
+
+    /// <summary>
+    /// ends the array or the map begun last
+    /// </summary>
+    void end() noexcept
+    {
+        assert(!frames_.empty() && !has_key_);
+
+        frame last = frames_.back();
+        frames_.pop_back();
+
+        if (last.val->type == dy_type_map)
+        {
+            // the map may have fewer keys than its shape
+            auto& map = last.val->data.map;
+            if (last.matched != npos && last.matched != map.size())
+            {
+                map.truncate(last.matched);
+                last.matched = npos;
+            }
+
+            // maps with the same keys share a shape as with dy_make_map
+            if (last.matched == npos && arena_ == nullptr) map.share_shape();
+            remember(map.shape());
+        }
+
+        if (!last.added) dy_dispose(last.val);
+    }
+
+    /// <summary>
+    /// hands the value built out, leaving the builder empty
+    /// </summary>
+    dy_t finish() noexcept
+    {
+        assert(frames_.empty());
+
+        // the shapes in the arena are released when the arena is reset
+        if (arena_ != nullptr) forget_shapes();
+        return exchange(root_, nullptr);
+    }
+
+    /// <summary>
+    /// disposes the value being built and the arrays and maps whose keys were
+    /// found in their parents
+    /// </summary>
+    void clear() noexcept
+    {
+        for (auto const& frame : frames_)
+            if (!frame.added) dy_dispose(frame.val);
+        if (root_ != nullptr) dy_dispose(root_);
+
+        frames_.clear();
+        root_    = nullptr;
+        has_key_ = false;
+    }
+
+    dy_arena_t arena() const noexcept
+    {
+        return arena_;
+    }
+
+  private:
+    /// <summary>
+    /// an array or a map which has begun and not ended
+    /// </summary>
+    struct frame
+    {
+        dy_t val;
+
+        /// <summary>
+        /// whether the value is added to its parent, which is not if the
+        /// parent has the key already
+        /// </summary>
+        bool added;
+
+        /// <summary>
+        /// the number of the keys of the map matching the keys of its shape,
+        /// or <c>npos</c> if the map has a shape of its own
+        /// </summary>
+        size_t matched;
+    };
+
+    static constexpr size_t npos = dy::shape::npos;
+
+    dy_arena_t            arena_;
+    pmr::memory_resource* res_;
+    vector<frame>         frames_;
+    dy_t                  root_;
+    string                key_;
+    bool                  has_key_;
+
+    /// <summary>
+    /// the shape of the last map ended at each depth, with a reference
+    /// </summary>
+    vector<dy::shape*> shapes_;
+
+    /// <summary>
+    /// returns the shape for the map beginning at the current depth
+    /// </summary>
+    /// <returns>the shape, or <c>nullptr</c> if no map has ended at the
+    /// depth</returns>
+    dy::shape* predicted() const noexcept
+    {
+        return frames_.size() < shapes_.size() ? shapes_[frames_.size()]
+                                               : nullptr;
+    }
+
+    /// <summary>
+    /// makes a map for the current depth, which has the predicted shape with
+    /// null values or an empty shape of its own
+    /// </summary>
+    dy::map make_map(size_t hint) noexcept
+    {
+        dy::shape* shape = predicted();
+        if (shape == nullptr)
+        {
+            dy::map map(dy::shape::create(res_), nullptr, res_);
+            map.reserve(hint);
+            return map;
+        }
+
+        size_t len    = shape->size();
+        auto   values = static_cast<dy_t*>(
+            res_->allocate(len * sizeof(dy_t), alignof(dy_t)));
+        fill_n(values, len, dy_make_null());
+
+        shape->retain();
+        return dy::map(shape, values, res_);
+    }
+
+    /// <summary>
+    /// remembers the shape of the map ended at the current depth
+    /// </summary>
+    void remember(dy::shape* shape) noexcept
+    {
+        size_t depth = frames_.size();
+        if (depth >= shapes_.size()) shapes_.resize(depth + 1);
+
+        dy::shape*& last = shapes_[depth];
+        if (last == shape) return;
+
+        shape->retain();
+        if (last != nullptr) last->release();
+        last = shape;
+    }
+
+    void forget_shapes() noexcept
+    {
+        for (auto shape : shapes_)
+            if (shape != nullptr) shape->release();
+        shapes_.clear();
+    }
+
+    /// <summary>
+    /// adds the value to the container, or makes it the root if there is none
+    /// </summary>
+    /// <returns><c>true</c> if added, <c>false</c> if the map has the key
+    /// already</returns>
+    bool add(dy_t val) noexcept
+    {
+        if (frames_.empty())
+        {
+            assert(root_ == nullptr);
+            root_ = val;
+            return true;
+        }
+
+        dy_t parent = frames_.back().val;
+        if (parent->type == dy_type_arr)
+        {
+            parent->data.arr.push_back(val);
+            return true;
+        }
+
+        assert(has_key_);
+        has_key_ = false;
+
+        auto&   map     = parent->data.map;
+        size_t& matched = frames_.back().matched;
+        if (matched != npos)
+        {
+            // the keys matched so far are distinct as the keys of the shape
+            auto entries = map.shape()->begin();
+            if (matched < map.size() && entries[matched].len == key_.size()
+                && memcmp(entries[matched].key, key_.data(), key_.size()) == 0)
+            {
+                map.begin()[matched++] = val;
+                return true;
+            }
+
+            map.truncate(matched);
+            matched = npos;
+        }
+
+        // the first entry wins if a key is given more than once
+        return map.add(key_.data(), key_.size(), val);
+    }
+};
+
+DY_PUBLIC(dy_builder_t) dy_builder_create(dy_arena_t arena) DY_NOEXCEPT
+{
+    return new (nothrow) _dy_builder_t(arena);
+}
+
+DY_PUBLIC(void)
+dy_builder_begin_arr(dy_builder_t builder, size_t len_hint) DY_NOEXCEPT
+{
+    assert(builder != nullptr);
+    builder->begin(dy_type_arr, len_hint);
+}
+
+DY_PUBLIC(void)
+dy_builder_begin_map(dy_builder_t builder, size_t len_hint) DY_NOEXCEPT
+{
+    assert(builder != nullptr);
+    builder->begin(dy_type_map, len_hint);
+}
+
+DY_PUBLIC(void)
+dy_builder_key(dy_builder_t builder, char const* key) DY_NOEXCEPT
+{
+    assert(builder != nullptr && key != nullptr);
+    builder->key(key, strlen(key));
+}
+
+DY_PUBLIC(void)
+dy_builder_key_n(dy_builder_t builder, char const* key, size_t len) DY_NOEXCEPT
+{
+    assert(builder != nullptr && (key != nullptr || len == 0));
+    builder->key(key, len);
+}
+
+DY_PUBLIC(void) dy_builder_push(dy_builder_t builder, dy_t val) DY_NOEXCEPT
+{
+    assert(builder != nullptr && val != nullptr);
+    builder->push(val);
+}
+
+DY_PUBLIC(void) dy_builder_push_null(dy_builder_t builder) DY_NOEXCEPT
+{
+    assert(builder != nullptr);
+    builder->push(dy_make_null());
+}
+
+DY_PUBLIC(void) dy_builder_push_b(dy_builder_t builder, bool b) DY_NOEXCEPT
+{
+    assert(builder != nullptr);
+    builder->push(dy_make_b(b));
+}
+
+DY_PUBLIC(void) dy_builder_push_i(dy_builder_t builder, int64_t i) DY_NOEXCEPT
+{
+    assert(builder != nullptr);
+
+    dy_arena_t arena = builder->arena();
+    builder->push(arena != nullptr ? dy_arena_make_i(arena, i) : dy_make_i(i));
+}
+
+DY_PUBLIC(void) dy_builder_push_f(dy_builder_t builder, double f) DY_NOEXCEPT
+{
+    assert(builder != nullptr);
+
+    dy_arena_t arena = builder->arena();
+    builder->push(arena != nullptr ? dy_arena_make_f(arena, f) : dy_make_f(f));
+}
+
+DY_PUBLIC(void)
+dy_builder_push_str(dy_builder_t builder, char const* str) DY_NOEXCEPT
+{
+    assert(builder != nullptr && str != nullptr);
+    dy_builder_push_str_len(builder, str, strlen(str));
+}
+
+DY_PUBLIC(void)
+dy_builder_push_str_len(dy_builder_t builder,
+                        char const*  str,
+                        size_t       len) DY_NOEXCEPT
+{
+    assert(builder != nullptr && (str != nullptr || len == 0));
+
+    dy_arena_t arena = builder->arena();
+    builder->push(arena != nullptr ? dy_arena_make_str_len(arena, str, len)
+                                   : dy_make_str_len(str, len));
+}
+
+DY_PUBLIC(void) dy_builder_end(dy_builder_t builder) DY_NOEXCEPT
+{
+    assert(builder != nullptr);
+    builder->end();
+}
+
+DY_PUBLIC(dy_t) dy_builder_finish(dy_builder_t builder) DY_NOEXCEPT
+{
+    assert(builder != nullptr);
+    return builder->finish();
+}
+
+DY_PUBLIC(void) dy_builder_destroy(dy_builder_t builder) DY_NOEXCEPT
+{
+    delete builder;
+}
@@ -1,11 +1,17 @@
 // Copyright (c) 2020 Stella Authors. All rights reserved.
 
 #include <dy.p.hh>
+#include <kernels.p.hh>
+#include <pool.p.hh>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <new>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 using namespace std;
 
@@ -13,7 +19,7 @@ using namespace std;
 
 #define DY_ASSERT(t)                                                           \
     assert(val != nullptr);                                                    \
-    assert(val->type == DY_TYPE(t));
+    assert(dy_get_type(val) == DY_TYPE(t));
 
 #define DY_DECL(f) (declval<_dy_val_t>().data.f)
 
@@ -21,20 +27,44 @@ using namespace std;
 
 #define DY_DATA(f) (val->data.f)
 
+#if defined(__GNUC__) || defined(__clang__)
+#    define DY_PREFETCH(ptr) __builtin_prefetch(ptr)
+#elif DY_SSE2
+#    define DY_PREFETCH(ptr)                                                   \
+        _mm_prefetch(reinterpret_cast<char const*>(ptr), _MM_HINT_T0)
+#else
+#    define DY_PREFETCH(ptr) static_cast<void>(ptr)
+#endif
+
+#define DY_NEW(res, f, ...)                                                    \
+    new (alloc_node(res)) _dy_val_t                                            \
+    {                                                                          \
+        .type = DY_TYPE(f), .flags = node_flags(res), .data = {                \
+            .f = __VA_ARGS__                                                   \
+        }                                                                      \
+    }
+
 #define DY_MAKE(f)                                                             \
     DY_PUBLIC(dy_t)                                                            \
     dy_make_##f(DY_DECLTYPE(f) data) DY_NOEXCEPT                               \
     {                                                                          \
-        return new _dy_val_t {                                                 \
-            .type = DY_TYPE(f),                                                \
-            .data = { .f = data },                                             \
-        };                                                                     \
+        if (dy_t imm = dy::imm_##f(data)) return imm;                          \
+        return DY_NEW(dy::heap(), f, data);                                    \
+    }                                                                          \
+                                                                               \
+    DY_PUBLIC(dy_t)                                                            \
+    dy_arena_make_##f(dy_arena_t arena, DY_DECLTYPE(f) data) DY_NOEXCEPT       \
+    {                                                                          \
+        assert(arena != nullptr);                                              \
+        if (dy_t imm = dy::imm_##f(data)) return imm;                          \
+        return DY_NEW(arena, f, data);                                         \
     }
 
 #define DY_GET(f)                                                              \
     DY_PUBLIC(DY_DECLTYPE(f)) dy_get_##f(dy_t val) DY_NOEXCEPT                 \
     {                                                                          \
         DY_ASSERT(f);                                                          \
+        if (!dy::is_node(val)) return dy::imm_get_##f(val);                    \
         return DY_DATA(f);                                                     \
     }
 
@@ -43,10 +73,18 @@ using namespace std;
     dy_make_##f(DY_DECLTYPE(f)::value_type const* ptr, size_t len) DY_NOEXCEPT \
     {                                                                          \
         assert(ptr != nullptr || len == 0);                                    \
-        return new _dy_val_t {                                                 \
-            .type = DY_TYPE(f),                                                \
-            .data = { .f = make_data_len<DY_DECLTYPE(f)>(ptr, len) },          \
-        };                                                                     \
+        return DY_NEW(dy::heap(), f, make_data_len<DY_DECLTYPE(f)>(ptr, len)); \
+    }                                                                          \
+                                                                               \
+    DY_PUBLIC(dy_t)                                                            \
+    dy_arena_make_##f(dy_arena_t arena,                                        \
+                      DY_DECLTYPE(f)::value_type const* ptr,                   \
+                      size_t len) DY_NOEXCEPT                                  \
+    {                                                                          \
+        assert(arena != nullptr);                                              \
+        assert(ptr != nullptr || len == 0);                                    \
+        return DY_NEW(                                                         \
+            arena, f, make_data_len<DY_DECLTYPE(f)>(ptr, len, arena));         \
     }
 
 #define DY_GET_LEN(f)                                                          \
@@ -72,16 +110,168 @@ using namespace std;
         return DY_DATA(f)[idx];                                                \
     }
 
+#define DY_ADOPT(f)                                                            \
+    DY_PUBLIC(dy_t)                                                            \
+    dy_adopt_##f(DY_DECLTYPE(f)::value_type* ptr,                              \
+                 size_t                      len,                              \
+                 dy_free_fn_t                free_fn,                          \
+                 void*                       ctx) DY_NOEXCEPT                  \
+    {                                                                          \
+        assert(ptr != nullptr || len == 0);                                    \
+        return DY_NEW(dy::heap(), f, DY_DECLTYPE(f)(ptr, len, free_fn, ctx)); \
+    }
+
+#define DY_MAKE_VIEW(f)                                                        \
+    DY_PUBLIC(dy_t)                                                            \
+    dy_make_##f##_view(DY_DECLTYPE(f)::value_type const* ptr, size_t len)      \
+        DY_NOEXCEPT                                                            \
+    {                                                                          \
+        assert(ptr != nullptr || len == 0);                                    \
+        using T  = DY_DECLTYPE(f)::value_type;                                 \
+        dy_t val = DY_NEW(                                                     \
+            dy::heap(), f, DY_DECLTYPE(f)(const_cast<T*>(ptr), len, 0, 0));    \
+        val->flags |= dy::flag_view;                                           \
+        return val;                                                            \
+    }
+
+#define DY_RELEASE_DATA(f)                                                     \
+    DY_PUBLIC(DY_DECLTYPE(f)::value_type*)                                     \
+    dy_release_##f##_data(dy_t val, dy_free_fn_t* free_fn, void** ctx)         \
+        DY_NOEXCEPT                                                            \
+    {                                                                          \
+        DY_ASSERT(f);                                                          \
+        assert(free_fn != nullptr && ctx != nullptr);                          \
+        return release_data(val, DY_DATA(f), free_fn, ctx);                    \
+    }
+
+#define DY_PUSH(f)                                                             \
+    DY_PUBLIC(dy_t)                                                            \
+    dy_##f##_push(dy_t val, DY_DECLTYPE(f)::value_type elem) DY_NOEXCEPT       \
+    {                                                                          \
+        DY_ASSERT(f);                                                          \
+        val = unshare_buffer(val);                                             \
+        DY_DATA(f).append(&elem, 1, dy::heap());                               \
+        return val;                                                            \
+    }
+
+#define DY_BARR_OP(name, op)                                                   \
+    DY_PUBLIC(dy_t) dy_barr_##name(dy_t lhs, dy_t rhs) DY_NOEXCEPT             \
+    {                                                                          \
+        assert(lhs != nullptr && dy_get_type(lhs) == dy_type_barr);            \
+        assert(rhs != nullptr && dy_get_type(rhs) == dy_type_barr);            \
+        assert(lhs->data.barr.size() == rhs->data.barr.size());                \
+        return DY_NEW(dy::heap(),                                              \
+                      barr,                                                    \
+                      dy::bitset::combine(                                     \
+                          lhs->data.barr,                                      \
+                          rhs->data.barr,                                      \
+                          [](uint64_t a, uint64_t b) { return a op b; },       \
+                          dy::heap()));                                        \
+    }
+
+#define DY_ASSERT_MASK(mask, f)                                                \
+    assert(mask != nullptr && dy_get_type(mask) == dy_type_barr);              \
+    assert(mask->data.barr.size() == DY_DATA(f).size());
+
+#define DY_REDUCE(f, ty, name)                                                 \
+    DY_PUBLIC(ty) dy_##f##_##name(dy_t val) DY_NOEXCEPT                        \
+    {                                                                          \
+        DY_ASSERT(f);                                                          \
+        return dy::kernels().f##_##name(DY_DATA(f).data(), DY_DATA(f).size()); \
+    }                                                                          \
+                                                                               \
+    DY_PUBLIC(ty) dy_##f##_##name##_masked(dy_t val, dy_t mask) DY_NOEXCEPT    \
+    {                                                                          \
+        DY_ASSERT(f);                                                          \
+        DY_ASSERT_MASK(mask, f);                                               \
+        return dy::kernels().f##_##name##_masked(                              \
+            DY_DATA(f).data(), mask->data.barr.words(), DY_DATA(f).size());    \
+    }
+
+#define DY_PREFIX_SUM(f)                                                       \
+    DY_PUBLIC(dy_t) dy_##f##_prefix_sum(dy_t val) DY_NOEXCEPT                  \
+    {                                                                          \
+        DY_ASSERT(f);                                                          \
+        size_t len = DY_DATA(f).size();                                        \
+        dy_t   result                                                          \
+            = DY_NEW(dy::heap(), f, DY_DECLTYPE(f)(len, dy::heap()));          \
+        dy::kernels().f##_prefix_sum(                                          \
+            DY_DATA(f).data(), result->data.f.data(), len);                    \
+        return result;                                                         \
+    }
+
+#define DY_CONVERT_HELPER(f)                                                   \
+    case dy_type_##f:                                                          \
+    {                                                                          \
+        size_t len = num_arr_len(val);                                         \
+        dy_t   result                                                          \
+            = DY_NEW(dy::heap(), f, DY_DECLTYPE(f)(len, dy::heap()));          \
+        convert(num_arr_data(val), result->data.f.data(), len);                \
+        return result;                                                         \
+    }
+
+#define DY_NUM_ARR_HELPER(f, expr)                                             \
+    case dy_type_##f: return DY_DATA(f).expr
+
+#define DY_COMPACT_HELPER(f, get)                                              \
+    case dy_type_##f:                                                          \
+        result = DY_NEW(dy::heap(), f, collect<DY_DECLTYPE(f)>(arr, get));     \
+        bytes  = arr.size() * sizeof(DY_DECLTYPE(f)::value_type);              \
+        break
+
+#define DY_UNPACK_HELPER(f)                                                    \
+    case dy_type_##f:                                                          \
+    {                                                                          \
+        dy_t val = DY_NEW(res, f, DY_DECLTYPE(f)(len, res));                   \
+        unpack_le(DY_DATA(f).data(), bytes, len);                              \
+        return val;                                                            \
+    }
+
 #define DY_COPY_HELPER(f)                                                      \
+    case dy_type_##f: return DY_NEW(dy::heap(), f, DY_DATA(f))
+
+#define DY_COPY_LEN_HELPER(f)                                                  \
     case dy_type_##f:                                                          \
-        return new _dy_val_t                                                   \
-        {                                                                      \
-            .type = dy_type_##f, .data = { .f = DY_DATA(f) },                  \
-        }
+        return DY_NEW(dy::heap(), f, DY_DECLTYPE(f)(DY_DATA(f), dy::heap()))
 
 namespace
 {
 
+/// <summary>
+/// the resource backing <c>dy::heap()</c>
+/// </summary>
+class heap_resource : public pmr::memory_resource
+{
+  protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        assert(alignment <= alignof(max_align_t));
+        void* ptr = malloc(bytes != 0 ? bytes : 1);
+        if (ptr == nullptr) throw bad_alloc();
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, size_t, size_t) override
+    {
+        free(ptr);
+    }
+
+    bool do_is_equal(memory_resource const& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+/// <summary>
+/// frees the memory allocated from <c>dy::heap()</c>, which ignores the size
+/// </summary>
+/// <param name="ptr">the memory</param>
+/// <param name="ctx">the memory resource, which is <c>dy::heap()</c></param>
+void free_heap(void* ptr, void* ctx) DY_NOEXCEPT
+{
+    static_cast<pmr::memory_resource*>(ctx)->deallocate(ptr, 0);
+}
+
 /// <summary>
 /// checks whether the type is valid. Used in assertions.
 /// </summary>
@@ -89,7 +279,7 @@ namespace
 /// <returns><c>true</c> if valid, <c>false</c> otherwise</returns>
 inline bool valid_type(dy_type_t type) DY_NOEXCEPT
 {
-    return dy_type_null <= type && type <= dy_type_map;
+    return dy_type_null <= type && type <= dy_type_f32arr;
 }
 
 template <typename T>
@@ -104,233 +294,1681 @@ dy_t default_value<dy_t> = nullptr;
 template <>
 char default_value<char> = ' ';
 
+/// <summary>
+/// allocates the memory for a value instance
+/// </summary>
+/// <param name="res">the memory resource to allocate from</param>
+/// <returns>the uninitialized memory</returns>
+inline void* alloc_node(pmr::memory_resource* res) DY_NOEXCEPT
+{
+    return res->allocate(sizeof(_dy_val_t), alignof(_dy_val_t));
+}
+
+/// <summary>
+/// returns the flags of the value instances allocated from the resource
+/// </summary>
+/// <param name="res">the memory resource</param>
+/// <returns>the combination of <c>dy::node_flag</c>s</returns>
+inline uint8_t node_flags(pmr::memory_resource* res) DY_NOEXCEPT
+{
+    return res != dy::heap() ? dy::flag_arena : 0;
+}
+
+/// <summary>
+/// destroys the value instance on the heap and deallocates its memory
+/// </summary>
+/// <param name="val">the value instance</param>
+inline void free_node(dy_t val) DY_NOEXCEPT
+{
+    val->~_dy_val_t();
+    dy::heap()->deallocate(val, sizeof(_dy_val_t), alignof(_dy_val_t));
+}
+
 /// <summary>
 /// makes a container from the pointer
 /// </summary>
 /// <typeparam name="T">the type of the container</typeparam>
 /// <param name="ptr">the pointer to the entries to copy</param>
 /// <param name="len">the number of the entries</param>
+/// <param name="res">the memory resource the container allocates from</param>
 /// <returns>a new container instance</returns>
 template <typename T>
-T make_data_len(typename T::value_type const* ptr, size_t len) DY_NOEXCEPT
+T make_data_len(typename T::value_type const* ptr,
+                size_t                        len,
+                pmr::memory_resource*         res = dy::heap()) DY_NOEXCEPT
 {
-    if (ptr != nullptr) return T(ptr, ptr + len);
+    if (ptr != nullptr) return T(ptr, ptr + len, res);
     else
-        return T(len, default_value<typename T::value_type>);
+        return T(len, default_value<typename T::value_type>, res);
 }
 
+/// <summary>
+/// makes a string value in the given memory resource
+/// </summary>
+/// <param name="res">the memory resource</param>
+/// <param name="str">the string to copy</param>
+/// <param name="len">the length of the string</param>
+/// <returns>a new value instance</returns>
+dy_t make_str(pmr::memory_resource* res, char const* str, size_t len)
+    DY_NOEXCEPT
+{
+    assert(str != nullptr || len == 0);
+    return DY_NEW(res, str, dy::buffer<char>(str, str + len, res));
 }
 
-DY_PUBLIC(dy_type_t) dy_get_type(dy_t val) DY_NOEXCEPT
+/// <summary>
+/// hands the buffer of the value out. The buffer is copied to the heap if the
+/// value is shared, a view, or in an arena, since others still see or own it.
+/// </summary>
+/// <param name="val">the value instance</param>
+/// <param name="data">the buffer of the value</param>
+/// <param name="free_fn">set to the function freeing the buffer</param>
+/// <param name="ctx">set to the context to pass to the function</param>
+/// <returns>the buffer</returns>
+template <typename T>
+T* release_data(dy_t           val,
+                dy::buffer<T>& data,
+                dy_free_fn_t*  free_fn,
+                void**         ctx) DY_NOEXCEPT
 {
-    assert(val != nullptr);
-    assert(valid_type(val->type));
-    return val->type;
+    if (!(val->flags & (dy::flag_arena | dy::flag_view))
+        && val->refs.load(memory_order_acquire) == 1)
+        return data.release(free_fn, ctx, free_heap);
+
+    dy::buffer<T> copy(data, dy::heap());
+    return copy.release(free_fn, ctx, free_heap);
 }
 
-DY_PUBLIC(dy_t) dy_copy(dy_t val) DY_NOEXCEPT
+/// <summary>
+/// returns the type of the entries of the arrays of numbers of the type
+/// </summary>
+/// <param name="type">the type of the array</param>
+/// <returns>the type of the entries, or <c>dy::elem_type_count</c> if the
+/// type is not an array of numbers</returns>
+dy::elem_type elem_type_of(dy_type_t type) DY_NOEXCEPT
 {
-    assert(val != nullptr);
-    assert(valid_type(val->type));
-
-    switch (val->type)
+    switch (type)
     {
-        DY_COPY_HELPER(null);
-        DY_COPY_HELPER(b);
-        DY_COPY_HELPER(i);
-        DY_COPY_HELPER(f);
-        DY_COPY_HELPER(str);
-        DY_COPY_HELPER(bytes);
-        DY_COPY_HELPER(barr);
-        DY_COPY_HELPER(iarr);
-        DY_COPY_HELPER(farr);
-    case dy_type_arr:
-    {
-        // TODO: rewrite this with std::ranges::views::transform
-        vector<dy_t> arr;
-        arr.reserve(DY_DATA(arr).size());
-        for (auto val : DY_DATA(arr)) arr.push_back(dy_copy(val));
-        return new _dy_val_t {
-            .type = dy_type_arr,
-            .data = { .arr = arr },
-        };
+    case dy_type_bytes: return dy::elem_u8;
+    case dy_type_iarr: return dy::elem_i64;
+    case dy_type_farr: return dy::elem_f64;
+    case dy_type_i8arr: return dy::elem_i8;
+    case dy_type_i16arr: return dy::elem_i16;
+    case dy_type_i32arr: return dy::elem_i32;
+    case dy_type_u32arr: return dy::elem_u32;
+    case dy_type_f32arr: return dy::elem_f32;
+    default: return dy::elem_type_count;
     }
-    case dy_type_map:
+}
+
+/// <summary>
+/// returns the entries of the array of numbers
+/// </summary>
+/// <param name="val">the array</param>
+/// <returns>the pointer to the entries</returns>
+void const* num_arr_data(dy_t val) DY_NOEXCEPT
+{
+    switch (val->type)
     {
-        // TODO: rewrite this with std::ranges::views::transform
-        unordered_map<string, dy_t> map;
-        map.reserve(DY_DATA(map).size());
-        for (auto const& [str, dy] : DY_DATA(map))
-            map.insert(make_pair(str, dy_copy(dy)));
-        return new _dy_val_t {
-            .type = dy_type_arr,
-            .data = { .map = map },
-        };
+        DY_NUM_ARR_HELPER(bytes, data());
+        DY_NUM_ARR_HELPER(iarr, data());
+        DY_NUM_ARR_HELPER(farr, data());
+        DY_NUM_ARR_HELPER(i8arr, data());
+        DY_NUM_ARR_HELPER(i16arr, data());
+        DY_NUM_ARR_HELPER(i32arr, data());
+        DY_NUM_ARR_HELPER(u32arr, data());
+        DY_NUM_ARR_HELPER(f32arr, data());
+    default: return nullptr;
     }
-    }
-
-    return dy_make_null();
 }
 
-DY_PUBLIC(void) dy_dispose(dy_t val) DY_NOEXCEPT
+/// <summary>
+/// returns the length of the array of numbers
+/// </summary>
+/// <param name="val">the array</param>
+/// <returns>the number of the entries</returns>
+size_t num_arr_len(dy_t val) DY_NOEXCEPT
 {
     switch (val->type)
     {
-    case dy_type_arr:
-        for (auto dy : DY_DATA(arr)) dy_dispose(dy);
-        break;
-    case dy_type_map:
-        for (auto const& [str, dy] : DY_DATA(map)) dy_dispose(dy);
-        break;
+        DY_NUM_ARR_HELPER(bytes, size());
+        DY_NUM_ARR_HELPER(iarr, size());
+        DY_NUM_ARR_HELPER(farr, size());
+        DY_NUM_ARR_HELPER(i8arr, size());
+        DY_NUM_ARR_HELPER(i16arr, size());
+        DY_NUM_ARR_HELPER(i32arr, size());
+        DY_NUM_ARR_HELPER(u32arr, size());
+        DY_NUM_ARR_HELPER(f32arr, size());
+    default: return 0;
     }
-
-    dy_dispose_self(val);
 }
 
-DY_PUBLIC(void) dy_dispose_self(dy_t val) DY_NOEXCEPT
+/// <summary>
+/// copies the entries from their bytes in little-endian order
+/// </summary>
+/// <param name="out">the entries</param>
+/// <param name="bytes">the bytes, which need not be aligned</param>
+/// <param name="len">the number of the entries</param>
+template <typename T>
+void unpack_le(T* out, void const* bytes, size_t len) DY_NOEXCEPT
 {
-    delete val;
+    if (len != 0) memcpy(out, bytes, len * sizeof(T));
+    if constexpr (endian::native == endian::big && sizeof(T) != 1)
+        for (size_t i = 0; i < len; ++i)
+        {
+            auto p = reinterpret_cast<unsigned char*>(out + i);
+            reverse(p, p + sizeof(T));
+        }
 }
 
-// ---------------------------------- null ---------------------------------- //
-
-DY_PUBLIC(dy_t) dy_make_null() DY_NOEXCEPT
+/// <summary>
+/// makes a buffer from the entries of the generic array
+/// </summary>
+/// <typeparam name="T">the type of the buffer</typeparam>
+/// <param name="arr">the entries</param>
+/// <param name="get">the function getting the value of an entry</param>
+/// <returns>a new buffer on the heap</returns>
+template <typename T, typename Get>
+T collect(pmr::vector<dy_t> const& arr, Get get) DY_NOEXCEPT
 {
-    return new _dy_val_t {
-        .type = dy_type_null,
-        .data = { .null = nullptr },
-    };
-}
+    using U = typename T::value_type;
 
-// ----------------------------------- b  ----------------------------------- //
+    T data(arr.size(), dy::heap());
+    for (size_t i = 0, len = arr.size(); i < len; ++i)
+        data[i] = static_cast<U>(get(arr[i]));
+    return data;
+}
 
-DY_MAKE(b) DY_GET(b);
+/// <summary>
+/// returns the type of the array the integers are compacted into
+/// </summary>
+/// <param name="min">the smallest integer</param>
+/// <param name="max">the largest integer</param>
+/// <param name="flags">the combination of <c>dy_compact_flag_t</c>s</param>
+/// <returns>the type of the array</returns>
+dy_type_t compact_int_type(int64_t min, int64_t max, uint32_t flags) DY_NOEXCEPT
+{
+    if ((flags & dy_compact_bytes) && 0 <= min && max <= UINT8_MAX)
+        return dy_type_bytes;
 
-// ----------------------------------- i  ----------------------------------- //
+    if (flags & dy_compact_narrow)
+    {
+        if (INT8_MIN <= min && max <= INT8_MAX) return dy_type_i8arr;
+        if (INT16_MIN <= min && max <= INT16_MAX) return dy_type_i16arr;
+        if (INT32_MIN <= min && max <= INT32_MAX) return dy_type_i32arr;
+        if (0 <= min && max <= UINT32_MAX) return dy_type_u32arr;
+    }
 
-DY_MAKE(i) DY_GET(i);
+    return dy_type_iarr;
+}
 
-// ----------------------------------- f  ----------------------------------- //
+/// <summary>
+/// replaces the generic array with a typed array if the entries are all
+/// booleans, all integers or all double-precision numbers
+/// </summary>
+/// <param name="val">the only reference to a generic array on the heap, which
+/// is consumed</param>
+/// <param name="flags">the combination of <c>dy_compact_flag_t</c>s</param>
+/// <param name="saved">increased by the number of the bytes saved</param>
+/// <returns>the typed array, or <c>val</c> if it is left as is</returns>
+dy_t compact_arr(dy_t val, uint32_t flags, size_t& saved) DY_NOEXCEPT
+{
+    auto& arr = DY_DATA(arr);
+    if (arr.empty()) return val;
 
-DY_MAKE(f) DY_GET(f);
+    dy_type_t type = dy_get_type(arr.front());
+    int64_t   min = INT64_MAX, max = INT64_MIN;
+    for (auto dy : arr)
+    {
+        if (dy_get_type(dy) != type) return val;
+        if (type != dy_type_i) continue;
 
-// ---------------------------------- str  ---------------------------------- //
+        int64_t i = dy_get_i(dy);
+        min       = std::min(min, i);
+        max       = std::max(max, i);
+    }
 
-DY_PUBLIC(dy_t) dy_make_str(char const* str) DY_NOEXCEPT
-{
-    assert(str != nullptr);
+    switch (type)
+    {
+    case dy_type_b: type = dy_type_barr; break;
+    case dy_type_i: type = compact_int_type(min, max, flags); break;
+    case dy_type_f: type = dy_type_farr; break;
+    default: return val;
+    }
 
-    return new _dy_val_t {
-        .type = dy_type_str,
-        .data = { .str = std::string(str) },
-    };
-}
+    dy_t   result;
+    size_t bytes;
+    switch (type)
+    {
+    case dy_type_barr:
+    {
+        auto bools = collect<dy::buffer<bool>>(arr, dy_get_b);
+        result     = DY_NEW(dy::heap(),
+                        barr,
+                        dy::bitset(bools.begin(), bools.end(), dy::heap()));
+        bytes = dy::bitset::word_count(arr.size()) * sizeof(uint64_t);
+        break;
+    }
+        DY_COMPACT_HELPER(bytes, dy_get_i);
+        DY_COMPACT_HELPER(iarr, dy_get_i);
+        DY_COMPACT_HELPER(i8arr, dy_get_i);
+        DY_COMPACT_HELPER(i16arr, dy_get_i);
+        DY_COMPACT_HELPER(i32arr, dy_get_i);
+        DY_COMPACT_HELPER(u32arr, dy_get_i);
+        DY_COMPACT_HELPER(farr, dy_get_f);
+    default: return val;
+    }
 
-DY_GET_LEN(str);
+    // the entries not encoded in the handles take a node each
+    size_t freed = arr.capacity() * sizeof(dy_t);
+    for (auto dy : arr)
+        if (dy::is_node(dy)) freed += sizeof(_dy_val_t);
+    saved += freed - bytes;
 
-DY_PUBLIC(char const*) dy_get_str_data(dy_t val) DY_NOEXCEPT
-{
-    DY_ASSERT(str);
-    return DY_DATA(str).c_str();
+    dy_dispose(val);
+    return result;
 }
 
-// ---------------------------------- barr ---------------------------------- //
+/// <summary>
+/// returns the only reference to a generic array or map on the heap with the
+/// same entries as the value, copying it if it is shared or in an arena
+/// </summary>
+/// <param name="val">the generic array or map, which is consumed</param>
+/// <returns>the value instance</returns>
+dy_t unshare(dy_t val) DY_NOEXCEPT
+{
+    // values in arenas are not disposed, and their copies do not share
+    if (val->flags & dy::flag_arena) return dy_copy(val);
 
-DY_MAKE_LEN(barr) DY_GET_LEN(barr) DY_GET_IDX(barr);
+    // lazy values hand over the entries they parsed
+    if (val->flags & dy::flag_lazy)
+    {
+        dy_t level = dy_retain(dy::lazy_level(val));
+        dy_dispose(val);
+        return unshare(level);
+    }
 
-// ---------------------------------- bytes --------------------------------- //
+    if (val->refs.load(memory_order_acquire) == 1) return val;
 
-DY_MAKE_LEN(bytes) DY_GET_LEN(bytes) DY_GET_DATA(bytes) DY_GET_IDX(bytes);
+    dy_t result;
+    if (val->type == dy_type_arr)
+    {
+        pmr::vector<dy_t> arr(DY_DATA(arr), dy::heap());
+        for (auto dy : arr) dy_retain(dy);
+        result = DY_NEW(dy::heap(), arr, move(arr));
+    }
+    else
+    {
+        dy::map map(DY_DATA(map), dy::heap());
+        for (auto dy : map) dy_retain(dy);
+        result = DY_NEW(dy::heap(), map, move(map));
+    }
 
-// ---------------------------------- iarr ---------------------------------- //
+    dy_dispose(val);
+    return result;
+}
 
-DY_MAKE_LEN(iarr) DY_GET_LEN(iarr) DY_GET_DATA(iarr) DY_GET_IDX(iarr);
+/// <summary>
+/// returns the only reference to a typed array on the heap owning its
+/// entries, copying the array if it is shared, a view, or in an arena
+/// </summary>
+/// <param name="val">the byte array, the integer array or the double-precision
+/// number array, which is consumed</param>
+/// <returns>the value instance</returns>
+dy_t unshare_buffer(dy_t val) DY_NOEXCEPT
+{
+    if (!(val->flags & (dy::flag_arena | dy::flag_view))
+        && val->refs.load(memory_order_acquire) == 1)
+        return val;
 
-// ---------------------------------- farr ---------------------------------- //
+    dy_t result;
+    switch (val->type)
+    {
+    case dy_type_bytes:
+        result = DY_NEW(
+            dy::heap(), bytes, DY_DECLTYPE(bytes)(DY_DATA(bytes), dy::heap()));
+        break;
+    case dy_type_iarr:
+        result = DY_NEW(
+            dy::heap(), iarr, DY_DECLTYPE(iarr)(DY_DATA(iarr), dy::heap()));
+        break;
+    default:
+        result = DY_NEW(
+            dy::heap(), farr, DY_DECLTYPE(farr)(DY_DATA(farr), dy::heap()));
+        break;
+    }
 
-DY_MAKE_LEN(farr) DY_GET_LEN(farr) DY_GET_DATA(farr) DY_GET_IDX(farr);
+    dy_dispose(val);
+    return result;
+}
 
-// ---------------------------------- arr  ---------------------------------- //
+/// <summary>
+/// compacts the generic arrays in the value, each after its entries. The
+/// arrays and maps are followed with a stack on the heap, so deep trees do not
+/// overflow the stack of the thread.
+/// </summary>
+/// <param name="val">the value, which is consumed</param>
+/// <param name="flags">the combination of <c>dy_compact_flag_t</c>s</param>
+/// <param name="saved">increased by the number of the bytes saved</param>
+/// <returns>the compacted value</returns>
+dy_t compact(dy_t val, uint32_t flags, size_t& saved) DY_NOEXCEPT
+{
+    struct frame
+    {
+        dy_t* slot;
+        dy_t* first;
+        dy_t* last;
+    };
 
-DY_MAKE_LEN(arr) DY_GET_LEN(arr) DY_GET_DATA(arr) DY_GET_IDX(arr);
+    vector<frame> stack;
+    dy_t*         slot = &val;
+    for (;;)
+    {
+        dy_t dy = *slot;
+        if (dy::is_node(dy)
+            && (dy->type == dy_type_arr || dy->type == dy_type_map))
+        {
+            // the entries stay in place while the ones below are compacted
+            dy    = unshare(dy);
+            *slot = dy;
+            if (dy->type == dy_type_map)
+                stack.push_back(
+                    { slot, dy->data.map.begin(), dy->data.map.end() });
+            else
+            {
+                dy_t* data = dy->data.arr.data();
+                stack.push_back({ slot, data, data + dy->data.arr.size() });
+            }
+        }
 
-// ---------------------------------- map  ---------------------------------- //
+        slot = nullptr;
+        while (slot == nullptr && !stack.empty())
+        {
+            frame& top = stack.back();
+            if (top.first != top.last) slot = top.first++;
+            else
+            {
+                dy_t& done = *top.slot;
+                if (done->type == dy_type_arr)
+                    done = compact_arr(done, flags, saved);
+                stack.pop_back();
+            }
+        }
 
-DY_PUBLIC(dy_t) dy_make_map(dy_keyval_t const* ptr, size_t len) DY_NOEXCEPT
-{
-    unordered_map<string, dy_t> map;
-    map.reserve(len);
-    for (size_t i = 0; i < len; ++i)
-    {
-        dy_keyval_t const& pair = ptr[i];
-        map.insert(make_pair(string(pair.key), pair.val));
+        if (slot == nullptr) return val;
     }
-    return new _dy_val_t {
-        .type = dy_type_map,
-        .data = { .map = move(map) },
-    };
 }
 
-DY_GET_LEN(map);
-
-DY_PUBLIC(dy_iter_t) dy_make_map_iter(dy_t val) DY_NOEXCEPT
+/// <summary>
+/// reserves a shape for the keys
+/// </summary>
+void reserve_keys(dy::shape& shape, dy_keyval_t const* ptr, size_t len) noexcept
 {
-    DY_ASSERT(map);
-    return new _dy_iter_t { .it = DY_DATA(map).begin() };
+    // keeps every key in a single chunk
+    size_t key_bytes = 0;
+    for (size_t i = 0; i < len; ++i) key_bytes += strlen(ptr[i].key) + 1;
+    shape.reserve(len, key_bytes);
 }
 
-DY_PUBLIC(dy_keyval_t)
-dy_get_map_iter(dy_t val, dy_iter_t iter) DY_NOEXCEPT
+/// <summary>
+/// reserves a shape for the interned keys, which are not copied
+/// </summary>
+void reserve_keys(dy::shape& shape,
+                  dy_interned_keyval_t const*,
+                  size_t len) noexcept
 {
-    DY_ASSERT(map);
-    assert(iter != nullptr);
-
-    auto& it = iter->it;
-
-    if (it != DY_DATA(map).end())
-    {
-        auto const& pair = *it;
-        ++it;
-
-        return dy_keyval_t {
-            .key = pair.first.c_str(),
-            .val = pair.second,
-        };
-    }
-    else
-    {
-        return dy_keyval_t {
-            .key = nullptr,
-            .val = nullptr,
-        };
-    }
+    shape.reserve(len);
 }
 
-DY_PUBLIC(void) dy_dispose_map_iter(dy_iter_t iter) DY_NOEXCEPT
+/// <summary>
+/// adds the key to the shape
+/// </summary>
+bool insert_key(dy::shape& shape, char const* key) noexcept
 {
-    delete iter;
+    assert(key != nullptr);
+    return shape.insert(key, strlen(key));
 }
 
-DY_PUBLIC(dy_keyval_t) dy_get_map_key(dy_t val, char const* key) DY_NOEXCEPT
+/// <summary>
+/// adds the interned key to the shape
+/// </summary>
+bool insert_key(dy::shape& shape, dy_key_t key) noexcept
 {
-    DY_ASSERT(map);
     assert(key != nullptr);
+    return shape.insert(key);
+}
 
-    auto const& data = DY_DATA(map);
+/// <summary>
+/// allocates the values of a map
+/// </summary>
+/// <param name="res">the memory resource</param>
+/// <param name="len">the number of the values</param>
+/// <returns>the uninitialized values</returns>
+inline dy_t* alloc_values(pmr::memory_resource* res, size_t len) noexcept
+{
+    return static_cast<dy_t*>(res->allocate(len * sizeof(dy_t), alignof(dy_t)));
+}
+
+/// <summary>
+/// makes a generic map value in the given memory resource. Maps on the heap
+/// share the shapes recently made by the thread for the same keys.
+/// </summary>
+/// <typeparam name="T">the type of the key-value pairs</typeparam>
+/// <param name="res">the memory resource</param>
+/// <param name="ptr">the key-value pairs to copy</param>
+/// <param name="len">the number of the pairs</param>
+/// <returns>a new value instance</returns>
+template <typename T>
+dy_t make_map(pmr::memory_resource* res, T const* ptr, size_t len) DY_NOEXCEPT
+{
+    assert(ptr != nullptr || len == 0);
+
+    bool       heap   = res == dy::heap();
+    dy::shape* shape  = heap ? dy::find_cached_shape(ptr, len) : nullptr;
+    dy_t*      values = alloc_values(res, len);
 
-    if (auto it = data.find(key); it != data.end())
+    if (shape != nullptr)
     {
-        auto const& pair = *it;
-        return dy_keyval_t {
-            .key = pair.first.c_str(),
-            .val = pair.second,
-        };
+        for (size_t i = 0; i < len; ++i) values[i] = ptr[i].val;
+        return DY_NEW(res, map, dy::map(shape, values, res));
     }
-    else
+
+    shape = dy::shape::create(res);
+    reserve_keys(*shape, ptr, len);
+
+    // the first pair wins if a key is given more than once
+    size_t size = 0;
+    for (size_t i = 0; i < len; ++i)
+        if (insert_key(*shape, ptr[i].key)) values[size++] = ptr[i].val;
+
+    if (size != len)
+    {
+        dy_t* shrunk = alloc_values(res, size);
+        copy(values, values + size, shrunk);
+        res->deallocate(values, len * sizeof(dy_t), alignof(dy_t));
+        values = shrunk;
+    }
+
+    if (heap) dy::cache_shape(shape);
+    return DY_NEW(res, map, dy::map(shape, values, res));
+}
+
+/// <summary>
+/// makes a generic map value with the shape in the given memory resource
+/// </summary>
+/// <param name="res">the memory resource</param>
+/// <param name="shape">the shape, which the map on the heap holds a reference
+/// to</param>
+/// <param name="ptr">the values to copy</param>
+/// <param name="len">the number of the values</param>
+/// <returns>a new value instance</returns>
+dy_t make_map(pmr::memory_resource* res,
+              dy::shape*            shape,
+              dy_t const*           ptr,
+              size_t                len) DY_NOEXCEPT
+{
+    assert(shape != nullptr);
+    assert(shape->size() == len);
+    assert(ptr != nullptr || len == 0);
+
+    if (res == dy::heap()) shape->retain();
+
+    dy_t* values = alloc_values(res, len);
+    copy(ptr, ptr + len, values);
+    return DY_NEW(res, map, dy::map(shape, values, res));
+}
+
+/// <summary>
+/// returns the key-value pair at the index of the map
+/// </summary>
+/// <param name="map">the map</param>
+/// <param name="idx">the index, or <c>dy::shape::npos</c></param>
+/// <returns>the key-value pair, whose fields are <c>nullptr</c> if the index
+/// is <c>dy::shape::npos</c></returns>
+dy_keyval_t to_keyval(dy::map const& map, size_t idx) noexcept
+{
+    if (idx == dy::shape::npos)
     {
         return dy_keyval_t {
             .key = nullptr,
             .val = nullptr,
         };
     }
+
+    return dy_keyval_t {
+        .key = map.key(idx),
+        .val = map.begin()[idx],
+    };
+}
+
+/// <summary>
+/// the number of the entries ahead of the one read whose key and value are
+/// prefetched when walking a map
+/// </summary>
+constexpr size_t prefetch_distance = 4;
+
+/// <summary>
+/// asks the processor to load the key and the value instance at the index of
+/// the map, which are read soon
+/// </summary>
+inline void prefetch_entry(dy::map const& map, size_t idx) noexcept
+{
+    DY_PREFETCH(map.key(idx));
+
+    dy_t val = map.begin()[idx];
+    if (dy::is_node(val)) DY_PREFETCH(val);
+}
+
+/// <summary>
+/// the entries of a generic array or map left to visit
+/// </summary>
+struct pending
+{
+    dy_t* first;
+    dy_t* last;
+
+    size_t size() const noexcept
+    {
+        return last - first;
+    }
+};
+
+/// <summary>
+/// returns the entries of the generic array or map on the heap
+/// </summary>
+/// <returns>the entries, which are empty for the other values and the lazy
+/// arrays and maps</returns>
+pending entries_of(dy_t val) DY_NOEXCEPT
+{
+    if (val->flags & dy::flag_lazy) return { nullptr, nullptr };
+
+    switch (val->type)
+    {
+    case dy_type_arr:
+    {
+        dy_t* data = DY_DATA(arr).data();
+        return { data, data + DY_DATA(arr).size() };
+    }
+    case dy_type_map: return { DY_DATA(map).begin(), DY_DATA(map).end() };
+    default: break;
+    }
+    return { nullptr, nullptr };
+}
+
+/// <summary>
+/// copies the value in an arena to the heap, except the entries of a generic
+/// array or map, which are left as the entries of the original
+/// </summary>
+/// <param name="val">the value in an arena</param>
+/// <param name="entries">set to the entries of the copy left to copy</param>
+/// <returns>a new value instance</returns>
+dy_t copy_node(dy_t val, pending* entries) DY_NOEXCEPT
+{
+    *entries = { nullptr, nullptr };
+    switch (val->type)
+    {
+        // null and boolean values are always encoded in the handle
+        DY_COPY_HELPER(i);
+        DY_COPY_HELPER(f);
+        DY_COPY_LEN_HELPER(str);
+        DY_COPY_LEN_HELPER(bytes);
+        DY_COPY_LEN_HELPER(barr);
+        DY_COPY_LEN_HELPER(iarr);
+        DY_COPY_LEN_HELPER(farr);
+        DY_COPY_LEN_HELPER(i8arr);
+        DY_COPY_LEN_HELPER(i16arr);
+        DY_COPY_LEN_HELPER(i32arr);
+        DY_COPY_LEN_HELPER(u32arr);
+        DY_COPY_LEN_HELPER(f32arr);
+    case dy_type_arr:
+    {
+        pmr::vector<dy_t> arr(dy::heap());
+        if (val->flags & dy::flag_mapped)
+        {
+            // mapped arrays reference their records instead
+            size_t len = dy::mapped_len(val);
+            arr.reserve(len);
+            for (size_t i = 0; i < len; ++i)
+                arr.push_back(dy::mapped_idx(val, i));
+        }
+        else
+            arr.assign(DY_DATA(arr).begin(), DY_DATA(arr).end());
+
+        dy_t copy = DY_NEW(dy::heap(), arr, move(arr));
+        *entries  = entries_of(copy);
+        return copy;
+    }
+    case dy_type_map:
+    {
+        dy_t copy;
+        if (val->flags & dy::flag_mapped)
+        {
+            size_t                   len = dy::mapped_len(val);
+            pmr::vector<dy_keyval_t> pairs(dy::heap());
+            pairs.reserve(len);
+            for (size_t i = 0; i < len; ++i)
+                pairs.push_back(dy::mapped_keyval(val, i));
+            copy = make_map(dy::heap(), pairs.data(), len);
+        }
+        else
+            copy = DY_NEW(dy::heap(), map, dy::map(DY_DATA(map), dy::heap()));
+
+        *entries = entries_of(copy);
+        return copy;
+    }
+    default: break;
+    }
+
+    return dy_make_null();
+}
+
+/// <summary>
+/// replaces the entries with their copies as <c>dy_copy</c> does. The arrays
+/// and maps in arenas are followed with a stack on the heap, so deep trees do
+/// not overflow the stack of the thread.
+/// </summary>
+/// <param name="entries">the entries of a copy made by
+/// <c>copy_node</c></param>
+void copy_entries(pending entries) DY_NOEXCEPT
+{
+    vector<pending> stack;
+    for (;;)
+    {
+        while (entries.first != entries.last)
+        {
+            dy_t& entry = *entries.first++;
+            if (!dy::is_node(entry) || !(entry->flags & dy::flag_arena))
+            {
+                entry = dy_retain(entry);
+                continue;
+            }
+
+            pending inner;
+            entry = copy_node(entry, &inner);
+            if (inner.first != inner.last)
+            {
+                stack.push_back(entries);
+                entries = inner;
+            }
+        }
+
+        if (stack.empty()) return;
+        entries = stack.back();
+        stack.pop_back();
+    }
+}
+
+/// <summary>
+/// the number of the tasks per thread the parallel variants split the trees
+/// into, so the threads finishing early have something to steal
+/// </summary>
+constexpr size_t tasks_per_thread = 16;
+
+/// <summary>
+/// splits the ranges of entries into tasks of about the same size
+/// </summary>
+/// <param name="total">the number of the entries in the ranges</param>
+/// <param name="tasks">the number of the tasks to make</param>
+vector<pending> split_tasks(vector<pending> const& ranges,
+                            size_t                 total,
+                            size_t                 tasks) DY_NOEXCEPT
+{
+    size_t step = max<size_t>(total / tasks, 1);
+
+    vector<pending> res;
+    for (auto range : ranges)
+    {
+        for (; range.size() > step; range.first += step)
+            res.push_back({ range.first, range.first + step });
+        if (range.size() != 0) res.push_back(range);
+    }
+    return res;
+}
+
+}
+
+pmr::memory_resource* dy::heap() noexcept
+{
+    static heap_resource resource;
+    return &resource;
+}
+
+bool dy::drop_ref(dy_t val) noexcept
+{
+    // the whole tree is released by dy_arena_reset or dy_arena_destroy
+    if (!dy::is_node(val) || (val->flags & dy::flag_arena)) return false;
+    return val->refs.fetch_sub(1, memory_order_acq_rel) == 1;
+}
+
+void dy::free_tree(dy_t val) noexcept
+{
+    struct frame
+    {
+        dy_t    node;
+        pending entries;
+    };
+
+    vector<frame> stack;
+    for (;;)
+    {
+        dy_t next = nullptr;
+        if (val->flags & dy::flag_lazy)
+        {
+            // lazy values hold their entries in another instance
+            dy_t level = dy::lazy_release(val);
+            free_node(val);
+            if (level != nullptr && dy::drop_ref(level)) next = level;
+        }
+        else if (pending entries = entries_of(val); entries.size() != 0)
+            stack.push_back({ val, entries });
+        else
+            free_node(val);
+
+        while (next == nullptr && !stack.empty())
+        {
+            pending& top = stack.back().entries;
+            if (top.first == top.last)
+            {
+                free_node(stack.back().node);
+                stack.pop_back();
+            }
+            else if (dy_t entry = *top.first++; dy::drop_ref(entry))
+                next = entry;
+        }
+
+        if (next == nullptr) return;
+        val = next;
+    }
+}
+
+DY_PUBLIC(dy_type_t) dy_get_type(dy_t val) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+    if (!dy::is_node(val)) return dy::imm_type(val);
+
+    assert(valid_type(val->type));
+    return val->type;
+}
+
+DY_PUBLIC(dy_t) dy_copy(dy_t val) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+    if (!dy::is_node(val)) return val;
+
+    // values on the heap are immutable while shared
+    if (!(val->flags & dy::flag_arena)) return dy_retain(val);
+
+    assert(valid_type(val->type));
+
+    // values in arenas cannot outlive the arena, so they are copied
+    pending entries;
+    dy_t    copy = copy_node(val, &entries);
+    copy_entries(entries);
+    return copy;
+}
+
+DY_PUBLIC(dy_t) dy_copy_parallel(dy_t val) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+    if (!dy::is_node(val) || !(val->flags & dy::flag_arena))
+        return dy_copy(val);
+
+    assert(valid_type(val->type));
+
+    pending entries;
+    dy_t    copy  = copy_node(val, &entries);
+    size_t  tasks = dy::pool_size() * tasks_per_thread;
+
+    // copies the tree level by level until there are enough entries left to
+    // split into the tasks
+    vector<pending> ranges { entries };
+    size_t          total = entries.size();
+    while (total != 0 && total < tasks)
+    {
+        vector<pending> next;
+        size_t          next_total = 0;
+        for (auto range : ranges)
+        {
+            for (auto it = range.first; it != range.last; ++it)
+            {
+                if (!dy::is_node(*it) || !((*it)->flags & dy::flag_arena))
+                {
+                    *it = dy_retain(*it);
+                    continue;
+                }
+
+                *it = copy_node(*it, &entries);
+                if (entries.size() == 0) continue;
+                next.push_back(entries);
+                next_total += entries.size();
+            }
+        }
+        ranges = move(next);
+        total  = next_total;
+    }
+    if (total == 0) return copy;
+
+    auto split = split_tasks(ranges, total, tasks);
+    dy::parallel_for(split.size(),
+                     [&](size_t idx) noexcept { copy_entries(split[idx]); });
+    return copy;
+}
+
+DY_PUBLIC(void) dy_dispose(dy_t val) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+    if (dy::drop_ref(val)) dy::free_tree(val);
+}
+
+DY_PUBLIC(void) dy_dispose_parallel(dy_t val) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+    if (!dy::drop_ref(val)) return;
+
+    pending entries = entries_of(val);
+    size_t  tasks   = dy::pool_size() * tasks_per_thread;
+    if (entries.size() == 0 || dy::pool_size() == 1)
+    {
+        dy::free_tree(val);
+        return;
+    }
+
+    // releases the tree level by level until there are enough entries left to
+    // split into the tasks. The arrays and maps whose entries are handed out
+    // are deallocated after the tasks finish.
+    vector<dy_t>    shells { val };
+    vector<pending> ranges { entries };
+    size_t          total = entries.size();
+    while (total != 0 && total < tasks)
+    {
+        vector<pending> next;
+        size_t          next_total = 0;
+        for (auto range : ranges)
+        {
+            for (auto it = range.first; it != range.last; ++it)
+            {
+                if (!dy::drop_ref(*it)) continue;
+
+                entries = entries_of(*it);
+                if (entries.size() == 0)
+                {
+                    dy::free_tree(*it);
+                    continue;
+                }
+
+                shells.push_back(*it);
+                next.push_back(entries);
+                next_total += entries.size();
+            }
+        }
+        ranges = move(next);
+        total  = next_total;
+    }
+
+    if (total != 0)
+    {
+        auto split = split_tasks(ranges, total, tasks);
+        dy::parallel_for(split.size(), [&](size_t idx) noexcept {
+            for (auto it = split[idx].first; it != split[idx].last; ++it)
+                dy_dispose(*it);
+        });
+    }
+    for (auto shell : shells) free_node(shell);
+}
+
+DY_PUBLIC(void) dy_dispose_self(dy_t val) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+
+    if (!dy::is_node(val) || (val->flags & dy::flag_arena)) return;
+    if (val->refs.fetch_sub(1, memory_order_acq_rel) != 1) return;
+
+    if (val->flags & dy::flag_lazy)
+    {
+        if (dy_t level = dy::lazy_release(val)) dy_dispose_self(level);
+    }
+    free_node(val);
+}
+
+DY_PUBLIC(dy_t) dy_retain(dy_t val) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+
+    if (dy::is_node(val) && !(val->flags & dy::flag_arena))
+        val->refs.fetch_add(1, memory_order_relaxed);
+    return val;
+}
+
+DY_PUBLIC(void) dy_release(dy_t val) DY_NOEXCEPT
+{
+    dy_dispose(val);
+}
+
+DY_PUBLIC(bool) dy_is_view(dy_t val) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+    return dy::is_node(val) && (val->flags & dy::flag_view);
+}
+
+DY_PUBLIC(dy_t) dy_materialize(dy_t val) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+    if (!dy::is_node(val)) return val;
+
+    assert(valid_type(val->type));
+
+    if (val->flags & dy::flag_view)
+    {
+        switch (val->type)
+        {
+            DY_COPY_LEN_HELPER(str);
+            DY_COPY_LEN_HELPER(bytes);
+            DY_COPY_LEN_HELPER(iarr);
+            DY_COPY_LEN_HELPER(farr);
+            DY_COPY_LEN_HELPER(i8arr);
+            DY_COPY_LEN_HELPER(i16arr);
+            DY_COPY_LEN_HELPER(i32arr);
+            DY_COPY_LEN_HELPER(u32arr);
+            DY_COPY_LEN_HELPER(f32arr);
+        default: break;
+        }
+    }
+
+    // mapped arrays and maps hold nothing but views, and lazy ones own their
+    // text
+    if (val->flags & dy::flag_mapped) return dy_copy(val);
+    if (val->flags & dy::flag_lazy) return dy_retain(val);
+
+    // rebuilds the containers only if anything in them was copied
+    switch (val->type)
+    {
+    case dy_type_arr:
+    {
+        pmr::vector<dy_t> arr(dy::heap());
+        arr.reserve(DY_DATA(arr).size());
+
+        bool copied = false;
+        for (auto dy : DY_DATA(arr))
+        {
+            arr.push_back(dy_materialize(dy));
+            copied |= arr.back() != dy;
+        }
+
+        if (copied || (val->flags & dy::flag_arena))
+            return DY_NEW(dy::heap(), arr, move(arr));
+
+        for (auto dy : arr) dy_dispose(dy);
+        break;
+    }
+    case dy_type_map:
+    {
+        dy::map map(DY_DATA(map), dy::heap());
+
+        bool copied = false;
+        auto src    = DY_DATA(map).begin();
+        for (auto& dy : map)
+        {
+            dy = dy_materialize(*src++);
+            copied |= dy != src[-1];
+        }
+
+        if (copied || (val->flags & dy::flag_arena))
+            return DY_NEW(dy::heap(), map, move(map));
+
+        for (auto dy : map) dy_dispose(dy);
+        break;
+    }
+    default: break;
+    }
+
+    return dy_copy(val);
+}
+
+DY_PUBLIC(dy_t) dy_compact(dy_t val, uint32_t flags, size_t* saved) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+
+    size_t bytes = 0;
+    val          = compact(val, flags, bytes);
+    if (saved != nullptr) *saved += bytes;
+    return val;
+}
+
+// ---------------------------------- null ---------------------------------- //
+
+DY_PUBLIC(dy_t) dy_make_null() DY_NOEXCEPT
+{
+    return dy::handle(dy::imm_null);
+}
+
+DY_PUBLIC(dy_t) dy_arena_make_null(dy_arena_t arena) DY_NOEXCEPT
+{
+    assert(arena != nullptr);
+    return dy::handle(dy::imm_null);
+}
+
+// ----------------------------------- b  ----------------------------------- //
+
+DY_MAKE(b) DY_GET(b);
+
+// ----------------------------------- i  ----------------------------------- //
+
+DY_MAKE(i) DY_GET(i);
+
+// ----------------------------------- f  ----------------------------------- //
+
+DY_MAKE(f) DY_GET(f);
+
+// ---------------------------------- str  ---------------------------------- //
+
+DY_PUBLIC(dy_t) dy_make_str(char const* str) DY_NOEXCEPT
+{
+    assert(str != nullptr);
+    return make_str(dy::heap(), str, strlen(str));
+}
+
+DY_PUBLIC(dy_t) dy_arena_make_str(dy_arena_t arena, char const* str) DY_NOEXCEPT
+{
+    assert(arena != nullptr);
+    assert(str != nullptr);
+    return make_str(arena, str, strlen(str));
+}
+
+DY_PUBLIC(dy_t) dy_make_str_len(char const* str, size_t len) DY_NOEXCEPT
+{
+    return make_str(dy::heap(), str, len);
+}
+
+DY_PUBLIC(dy_t)
+dy_arena_make_str_len(dy_arena_t arena, char const* str, size_t len)
+    DY_NOEXCEPT
+{
+    assert(arena != nullptr);
+    return make_str(arena, str, len);
+}
+
+DY_GET_LEN(str);
+
+DY_PUBLIC(char const*) dy_get_str_data(dy_t val) DY_NOEXCEPT
+{
+    DY_ASSERT(str);
+    return DY_DATA(str).data();
+}
+
+DY_ADOPT(str) DY_MAKE_VIEW(str) DY_RELEASE_DATA(str);
+
+// ---------------------------------- barr ---------------------------------- //
+
+DY_MAKE_LEN(barr) DY_GET_LEN(barr) DY_GET_IDX(barr);
+
+DY_PUBLIC(dy_t)
+dy_make_barr_words(uint64_t const* words, size_t len) DY_NOEXCEPT
+{
+    assert(words != nullptr || len == 0);
+    return DY_NEW(dy::heap(), barr, dy::bitset(words, len, dy::heap()));
+}
+
+DY_PUBLIC(uint64_t const*) dy_get_barr_words(dy_t val) DY_NOEXCEPT
+{
+    DY_ASSERT(barr);
+    return DY_DATA(barr).words();
+}
+
+DY_PUBLIC(void)
+dy_get_barr_range(dy_t val, size_t first, size_t len, bool* out) DY_NOEXCEPT
+{
+    DY_ASSERT(barr);
+    assert(first + len <= DY_DATA(barr).size());
+    assert(out != nullptr || len == 0);
+    DY_DATA(barr).unpack(first, len, out);
+}
+
+DY_PUBLIC(size_t) dy_barr_popcount(dy_t val) DY_NOEXCEPT
+{
+    DY_ASSERT(barr);
+    return DY_DATA(barr).popcount();
+}
+
+DY_PUBLIC(size_t) dy_barr_find_first(dy_t val, size_t first) DY_NOEXCEPT
+{
+    DY_ASSERT(barr);
+    return DY_DATA(barr).find_first(first);
+}
+
+DY_BARR_OP(and, &) DY_BARR_OP(or, |) DY_BARR_OP(xor, ^);
+
+// ---------------------------------- bytes --------------------------------- //
+
+DY_MAKE_LEN(bytes) DY_GET_LEN(bytes) DY_GET_DATA(bytes) DY_GET_IDX(bytes);
+DY_ADOPT(bytes) DY_MAKE_VIEW(bytes) DY_RELEASE_DATA(bytes);
+
+DY_PUBLIC(dy_t)
+dy_bytes_append(dy_t val, uint8_t const* ptr, size_t len) DY_NOEXCEPT
+{
+    DY_ASSERT(bytes);
+    assert(ptr != nullptr || len == 0);
+
+    val = unshare_buffer(val);
+    DY_DATA(bytes).append(ptr, len, dy::heap());
+    return val;
+}
+
+// ---------------------------------- iarr ---------------------------------- //
+
+DY_MAKE_LEN(iarr) DY_GET_LEN(iarr) DY_GET_DATA(iarr) DY_GET_IDX(iarr);
+DY_ADOPT(iarr) DY_MAKE_VIEW(iarr) DY_RELEASE_DATA(iarr) DY_PUSH(iarr);
+DY_REDUCE(iarr, int64_t, sum) DY_REDUCE(iarr, int64_t, min);
+DY_REDUCE(iarr, int64_t, max) DY_PREFIX_SUM(iarr);
+
+// ---------------------------------- farr ---------------------------------- //
+
+DY_MAKE_LEN(farr) DY_GET_LEN(farr) DY_GET_DATA(farr) DY_GET_IDX(farr);
+DY_ADOPT(farr) DY_MAKE_VIEW(farr) DY_RELEASE_DATA(farr) DY_PUSH(farr);
+DY_REDUCE(farr, double, sum) DY_PREFIX_SUM(farr);
+
+DY_PUBLIC(double) dy_farr_dot(dy_t lhs, dy_t rhs) DY_NOEXCEPT
+{
+    assert(lhs != nullptr && dy_get_type(lhs) == dy_type_farr);
+    assert(rhs != nullptr && dy_get_type(rhs) == dy_type_farr);
+    assert(lhs->data.farr.size() == rhs->data.farr.size());
+    return dy::kernels().farr_dot(
+        lhs->data.farr.data(), rhs->data.farr.data(), lhs->data.farr.size());
+}
+
+DY_PUBLIC(double)
+dy_farr_dot_masked(dy_t lhs, dy_t rhs, dy_t mask) DY_NOEXCEPT
+{
+    assert(lhs != nullptr && dy_get_type(lhs) == dy_type_farr);
+    assert(rhs != nullptr && dy_get_type(rhs) == dy_type_farr);
+    assert(mask != nullptr && dy_get_type(mask) == dy_type_barr);
+    assert(lhs->data.farr.size() == rhs->data.farr.size());
+    assert(lhs->data.farr.size() == mask->data.barr.size());
+    return dy::kernels().farr_dot_masked(lhs->data.farr.data(),
+                                         rhs->data.farr.data(),
+                                         mask->data.barr.words(),
+                                         lhs->data.farr.size());
+}
+
+// --------------------------------- i8arr  --------------------------------- //
+
+DY_MAKE_LEN(i8arr) DY_GET_LEN(i8arr) DY_GET_DATA(i8arr) DY_GET_IDX(i8arr);
+DY_ADOPT(i8arr) DY_MAKE_VIEW(i8arr) DY_RELEASE_DATA(i8arr);
+
+// --------------------------------- i16arr --------------------------------- //
+
+DY_MAKE_LEN(i16arr) DY_GET_LEN(i16arr) DY_GET_DATA(i16arr) DY_GET_IDX(i16arr);
+DY_ADOPT(i16arr) DY_MAKE_VIEW(i16arr) DY_RELEASE_DATA(i16arr);
+
+// --------------------------------- i32arr --------------------------------- //
+
+DY_MAKE_LEN(i32arr) DY_GET_LEN(i32arr) DY_GET_DATA(i32arr) DY_GET_IDX(i32arr);
+DY_ADOPT(i32arr) DY_MAKE_VIEW(i32arr) DY_RELEASE_DATA(i32arr);
+
+// --------------------------------- u32arr --------------------------------- //
+
+DY_MAKE_LEN(u32arr) DY_GET_LEN(u32arr) DY_GET_DATA(u32arr) DY_GET_IDX(u32arr);
+DY_ADOPT(u32arr) DY_MAKE_VIEW(u32arr) DY_RELEASE_DATA(u32arr);
+
+// --------------------------------- f32arr --------------------------------- //
+
+DY_MAKE_LEN(f32arr) DY_GET_LEN(f32arr) DY_GET_DATA(f32arr) DY_GET_IDX(f32arr);
+DY_ADOPT(f32arr) DY_MAKE_VIEW(f32arr) DY_RELEASE_DATA(f32arr);
+
+// ------------------------------- conversion ------------------------------- //
+
+DY_PUBLIC(bool) dy_is_numeric_arr_type(dy_type_t type) DY_NOEXCEPT
+{
+    return elem_type_of(type) != dy::elem_type_count;
+}
+
+DY_PUBLIC(dy_t) dy_convert_arr(dy_t val, dy_type_t type) DY_NOEXCEPT
+{
+    assert(val != nullptr && dy::is_node(val));
+    assert(dy_is_numeric_arr_type(val->type));
+    assert(dy_is_numeric_arr_type(type));
+
+    if (val->type == type) return dy_copy(val);
+
+    dy::convert_fn convert = dy::kernels().convert[elem_type_of(val->type)]
+                                                  [elem_type_of(type)];
+
+    switch (type)
+    {
+        DY_CONVERT_HELPER(bytes);
+        DY_CONVERT_HELPER(iarr);
+        DY_CONVERT_HELPER(farr);
+        DY_CONVERT_HELPER(i8arr);
+        DY_CONVERT_HELPER(i16arr);
+        DY_CONVERT_HELPER(i32arr);
+        DY_CONVERT_HELPER(u32arr);
+        DY_CONVERT_HELPER(f32arr);
+    default: break;
+    }
+
+    return dy_make_null();
+}
+
+dy_t dy::make_packed(pmr::memory_resource* res,
+                     dy_type_t             type,
+                     void const*           bytes,
+                     size_t                len) noexcept
+{
+    assert(bytes != nullptr || len == 0);
+
+    switch (type)
+    {
+    case dy_type_barr:
+        return DY_NEW(res,
+                      barr,
+                      dy::bitset(static_cast<uint8_t const*>(bytes), len, res));
+        DY_UNPACK_HELPER(bytes);
+        DY_UNPACK_HELPER(iarr);
+        DY_UNPACK_HELPER(farr);
+        DY_UNPACK_HELPER(i8arr);
+        DY_UNPACK_HELPER(i16arr);
+        DY_UNPACK_HELPER(i32arr);
+        DY_UNPACK_HELPER(u32arr);
+        DY_UNPACK_HELPER(f32arr);
+    default: assert(false); return nullptr;
+    }
+}
+
+// ---------------------------------- arr  ---------------------------------- //
+
+DY_MAKE_LEN(arr);
+
+DY_PUBLIC(size_t) dy_get_arr_len(dy_t val) DY_NOEXCEPT
+{
+    DY_ASSERT(arr);
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    if (val->flags & dy::flag_mapped) return dy::mapped_len(val);
+    return DY_DATA(arr).size();
+}
+
+DY_PUBLIC(dy_t const*) dy_get_arr_data(dy_t val) DY_NOEXCEPT
+{
+    DY_ASSERT(arr);
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    if (val->flags & dy::flag_mapped) return dy::mapped_data(val);
+    return DY_DATA(arr).data();
+}
+
+DY_PUBLIC(dy_t) dy_get_arr_idx(dy_t val, size_t idx) DY_NOEXCEPT
+{
+    DY_ASSERT(arr);
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    if (val->flags & dy::flag_mapped) return dy::mapped_idx(val, idx);
+    return DY_DATA(arr)[idx];
+}
+
+DY_PUBLIC(dy_t) dy_arr_push(dy_t val, dy_t elem) DY_NOEXCEPT
+{
+    DY_ASSERT(arr);
+    assert(elem != nullptr);
+
+    val = unshare(val);
+    DY_DATA(arr).push_back(elem);
+    return val;
+}
+
+DY_PUBLIC(dy_t) dy_arr_pop(dy_t val, dy_t* elem) DY_NOEXCEPT
+{
+    DY_ASSERT(arr);
+    assert(dy_get_arr_len(val) != 0);
+
+    val       = unshare(val);
+    dy_t last = DY_DATA(arr).back();
+    DY_DATA(arr).pop_back();
+
+    if (elem != nullptr)
+        *elem = last;
+    else
+        dy_dispose(last);
+    return val;
+}
+
+DY_PUBLIC(dy_t) dy_arr_insert(dy_t val, size_t idx, dy_t elem) DY_NOEXCEPT
+{
+    DY_ASSERT(arr);
+    assert(idx <= dy_get_arr_len(val) && elem != nullptr);
+
+    val       = unshare(val);
+    auto& arr = DY_DATA(arr);
+    arr.insert(arr.begin() + idx, elem);
+    return val;
+}
+
+DY_PUBLIC(dy_t) dy_arr_erase(dy_t val, size_t idx) DY_NOEXCEPT
+{
+    DY_ASSERT(arr);
+    assert(idx < dy_get_arr_len(val));
+
+    val       = unshare(val);
+    auto& arr = DY_DATA(arr);
+    dy_dispose(arr[idx]);
+    arr.erase(arr.begin() + idx);
+    return val;
+}
+
+DY_PUBLIC(dy_t) dy_arr_reserve(dy_t val, size_t len) DY_NOEXCEPT
+{
+    DY_ASSERT(arr);
+
+    val       = unshare(val);
+    auto& arr = DY_DATA(arr);
+    arr.reserve(arr.size() + len);
+    return val;
+}
+
+DY_PUBLIC(dy_t)
+dy_make_arr_compact(dy_t const* ptr, size_t len, uint32_t flags) DY_NOEXCEPT
+{
+    size_t saved = 0;
+    return compact_arr(dy_make_arr(ptr, len), flags, saved);
+}
+
+// --------------------------------- shape  --------------------------------- //
+
+DY_PUBLIC(dy_shape_t)
+dy_make_shape(char const* const* keys, size_t len) DY_NOEXCEPT
+{
+    assert(keys != nullptr || len == 0);
+
+    size_t key_bytes = 0;
+    for (size_t i = 0; i < len; ++i) key_bytes += strlen(keys[i]) + 1;
+
+    dy::shape* shape = dy::shape::create(dy::heap());
+    shape->reserve(len, key_bytes);
+    for (size_t i = 0; i < len; ++i) insert_key(*shape, keys[i]);
+
+    dy::cache_shape(shape);
+    return shape;
+}
+
+DY_PUBLIC(void) dy_dispose_shape(dy_shape_t shape) DY_NOEXCEPT
+{
+    assert(shape != nullptr);
+    shape->release();
+}
+
+DY_PUBLIC(size_t) dy_get_shape_len(dy_shape_t shape) DY_NOEXCEPT
+{
+    assert(shape != nullptr);
+    return shape->size();
+}
+
+DY_PUBLIC(char const*)
+dy_get_shape_key(dy_shape_t shape, size_t idx) DY_NOEXCEPT
+{
+    assert(shape != nullptr);
+    assert(idx < shape->size());
+    return shape->begin()[idx].key;
+}
+
+DY_PUBLIC(size_t)
+dy_find_shape_key(dy_shape_t shape, char const* key, size_t len) DY_NOEXCEPT
+{
+    assert(shape != nullptr);
+    assert(key != nullptr || len == 0);
+    return shape->find(key, len);
+}
+
+// ---------------------------------- map  ---------------------------------- //
+
+DY_PUBLIC(dy_t) dy_make_map(dy_keyval_t const* ptr, size_t len) DY_NOEXCEPT
+{
+    return make_map(dy::heap(), ptr, len);
+}
+
+DY_PUBLIC(dy_t)
+dy_arena_make_map(dy_arena_t         arena,
+                  dy_keyval_t const* ptr,
+                  size_t             len) DY_NOEXCEPT
+{
+    assert(arena != nullptr);
+    return make_map(arena, ptr, len);
+}
+
+DY_PUBLIC(dy_t)
+dy_make_map_interned(dy_interned_keyval_t const* ptr, size_t len) DY_NOEXCEPT
+{
+    return make_map(dy::heap(), ptr, len);
+}
+
+DY_PUBLIC(dy_t)
+dy_arena_make_map_interned(dy_arena_t                  arena,
+                           dy_interned_keyval_t const* ptr,
+                           size_t                      len) DY_NOEXCEPT
+{
+    assert(arena != nullptr);
+    return make_map(arena, ptr, len);
+}
+
+DY_PUBLIC(dy_t)
+dy_make_map_with_shape(dy_shape_t  shape,
+                       dy_t const* ptr,
+                       size_t      len) DY_NOEXCEPT
+{
+    return make_map(dy::heap(), shape, ptr, len);
+}
+
+DY_PUBLIC(dy_t)
+dy_arena_make_map_with_shape(dy_arena_t  arena,
+                             dy_shape_t  shape,
+                             dy_t const* ptr,
+                             size_t      len) DY_NOEXCEPT
+{
+    assert(arena != nullptr);
+    return make_map(arena, shape, ptr, len);
+}
+
+DY_PUBLIC(size_t) dy_get_map_len(dy_t val) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    if (val->flags & dy::flag_mapped) return dy::mapped_len(val);
+    return DY_DATA(map).size();
+}
+
+DY_PUBLIC(dy_shape_t) dy_get_map_shape(dy_t val) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    if (val->flags & dy::flag_mapped) return nullptr;
+    return const_cast<dy::shape*>(DY_DATA(map).shape());
+}
+
+DY_PUBLIC(dy_keyval_t) dy_get_map_idx(dy_t val, size_t idx) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    assert(idx < dy_get_map_len(val));
+    if (val->flags & dy::flag_mapped) return dy::mapped_keyval(val, idx);
+    return to_keyval(DY_DATA(map), idx);
+}
+
+DY_PUBLIC(dy_iter_t) dy_make_map_iter(dy_t val) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    return new _dy_iter_t { .idx = 0 };
+}
+
+DY_PUBLIC(dy_keyval_t)
+dy_get_map_iter(dy_t val, dy_iter_t iter) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    assert(iter != nullptr);
+
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    auto& idx = iter->idx;
+
+    if (val->flags & dy::flag_mapped)
+    {
+        if (idx < dy::mapped_len(val)) return dy::mapped_keyval(val, idx++);
+        return dy::mapped_keyval(val, dy::shape::npos);
+    }
+
+    if (idx < DY_DATA(map).size())
+        return to_keyval(DY_DATA(map), idx++);
+    else
+        return to_keyval(DY_DATA(map), dy::shape::npos);
+}
+
+DY_PUBLIC(void) dy_init_map_iter(dy_t val, dy_iter_t iter) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    assert(iter != nullptr);
+    iter->idx = 0;
+}
+
+DY_PUBLIC(void) dy_dispose_map_iter(dy_iter_t iter) DY_NOEXCEPT
+{
+    delete iter;
+}
+
+DY_PUBLIC(bool)
+dy_map_foreach(dy_t val, dy_map_fn_t fn, void* ctx) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    assert(fn != nullptr);
+
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    if (val->flags & dy::flag_mapped)
+    {
+        size_t len = dy::mapped_len(val);
+        for (size_t i = 0; i < len; ++i)
+            if (!fn(ctx, dy::mapped_keyval(val, i))) return false;
+        return true;
+    }
+
+    auto const& map = DY_DATA(map);
+    size_t      len = map.size();
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (i + prefetch_distance < len)
+            prefetch_entry(map, i + prefetch_distance);
+        if (!fn(ctx, { map.key(i), map.begin()[i] })) return false;
+    }
+    return true;
+}
+
+DY_PUBLIC(size_t)
+dy_map_export(dy_t val, dy_keyval_t* out, size_t cap) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    assert(out != nullptr || cap == 0);
+
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    if (val->flags & dy::flag_mapped)
+    {
+        size_t len = min(dy::mapped_len(val), cap);
+        for (size_t i = 0; i < len; ++i) out[i] = dy::mapped_keyval(val, i);
+        return len;
+    }
+
+    // the caller reads the values next, so they are fetched on the way
+    auto const& map = DY_DATA(map);
+    size_t      len = min(map.size(), cap);
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (i + prefetch_distance < len)
+            prefetch_entry(map, i + prefetch_distance);
+        out[i] = { map.key(i), map.begin()[i] };
+    }
+    return len;
+}
+
+DY_PUBLIC(dy_keyval_t) dy_get_map_key(dy_t val, char const* key) DY_NOEXCEPT
+{
+    assert(key != nullptr);
+    return dy_get_map_key_n(val, key, strlen(key));
+}
+
+DY_PUBLIC(dy_keyval_t)
+dy_get_map_key_n(dy_t val, char const* key, size_t len) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    assert(key != nullptr || len == 0);
+
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    if (val->flags & dy::flag_mapped)
+        return dy::mapped_keyval(val, dy::mapped_find(val, key, len));
+
+    auto const& map = DY_DATA(map);
+    return to_keyval(map, map.shape()->find(key, len));
+}
+
+DY_PUBLIC(dy_keyval_t)
+dy_get_map_key_hashed(dy_t        val,
+                      char const* key,
+                      size_t      len,
+                      uint64_t    hash) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    assert(key != nullptr || len == 0);
+    assert(hash == dy::hash_bytes(key, len));
+
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    if (val->flags & dy::flag_mapped)
+        return dy::mapped_keyval(val, dy::mapped_find(val, key, len, hash));
+
+    auto const& map = DY_DATA(map);
+    return to_keyval(map, map.shape()->find(key, len, hash));
+}
+
+DY_PUBLIC(dy_keyval_t)
+dy_get_map_key_interned(dy_t val, dy_key_t key) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    assert(key != nullptr);
+
+    if (val->flags & dy::flag_lazy) val = dy::lazy_level(val);
+    if (val->flags & dy::flag_mapped)
+    {
+        size_t idx = dy::mapped_find(val, key->data(), key->len, key->hash);
+        return dy::mapped_keyval(val, idx);
+    }
+
+    auto const& map = DY_DATA(map);
+    return to_keyval(map, map.shape()->find(key));
+}
+
+DY_PUBLIC(dy_t) dy_map_set(dy_t val, char const* key, dy_t elem) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    assert(key != nullptr && elem != nullptr);
+
+    val      = unshare(val);
+    dy_t old = DY_DATA(map).set(key, strlen(key), elem);
+    if (old != nullptr) dy_dispose(old);
+    return val;
+}
+
+DY_PUBLIC(dy_t) dy_map_erase(dy_t val, char const* key) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+    assert(key != nullptr);
+
+    // nothing is copied if the key is not found
+    if (dy_get_map_key(val, key).key == nullptr) return val;
+
+    val      = unshare(val);
+    dy_t old = DY_DATA(map).erase(key, strlen(key));
+    dy_dispose(old);
+    return val;
+}
+
+DY_PUBLIC(dy_t) dy_map_reserve(dy_t val, size_t len) DY_NOEXCEPT
+{
+    DY_ASSERT(map);
+
+    val = unshare(val);
+    DY_DATA(map).reserve(len);
+    return val;
+}
+
+DY_PUBLIC(uint64_t) dy_hash_key(char const* key, size_t len) DY_NOEXCEPT
+{
+    assert(key != nullptr || len == 0);
+    return dy::hash_bytes(key, len);
 }
\ No newline at end of file
@@ -0,0 +1,2004 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.p.hh>
+#include <kernels.p.hh>
+#include <sink.p.hh>
+
+#include <bit>
+#include <cassert>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace std;
+
+// The text is parsed in two stages as in simdjson. The first one finds the
+// structural characters with the dispatched kernel, and the second one walks
+// them, parsing the scalar values and making the values.
+
+namespace
+{
+
+constexpr uint64_t ones  = UINT64_C(0x0101010101010101);
+constexpr uint64_t highs = UINT64_C(0x8080808080808080);
+
+/// <summary>
+/// the powers of 10 which are exact in double precision
+/// </summary>
+constexpr double exact_powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/// <summary>
+/// the largest integer such that every integer up to it is exact in double
+/// precision
+/// </summary>
+constexpr uint64_t exact_int_max = uint64_t(1) << 53;
+
+/// <summary>
+/// returns the bits set for the bytes of the word less than <c>n</c>. Only the
+/// lowest set bit is exact, as a match can mark the byte after it.
+/// </summary>
+inline uint64_t bytes_less(uint64_t word, uint8_t n) noexcept
+{
+    return (word - ones * n) & ~word & highs;
+}
+
+/// <summary>
+/// returns the bits set for the bytes of the word equal to <c>c</c>, of which
+/// only the lowest one is exact
+/// </summary>
+inline uint64_t bytes_equal(uint64_t word, uint8_t c) noexcept
+{
+    return bytes_less(word ^ (ones * c), 1);
+}
+
+/// <summary>
+/// checks whether the character ends a scalar value
+/// </summary>
+inline bool is_delimiter(char c) noexcept
+{
+    switch (c)
+    {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+    case ',':
+    case ':':
+    case '[':
+    case ']':
+    case '{':
+    case '}':
+    case '"': return true;
+    default: return false;
+    }
+}
+
+inline bool is_digit(char c) noexcept
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+/// <summary>
+/// checks whether the 8 characters are all digits
+/// </summary>
+inline bool is_eight_digits(uint64_t chars) noexcept
+{
+    // a digit is 0x3? and stays so after adding 6
+    return ((chars & (ones * 0xf0))
+            | (((chars + ones * 0x06) & (ones * 0xf0)) >> 4))
+           == ones * 0x33;
+}
+
+/// <summary>
+/// parses 8 digits loaded as a little-endian word
+/// </summary>
+inline uint64_t parse_eight_digits(uint64_t chars) noexcept
+{
+    // combines the pairs of the digits, then the pairs of the pairs, and so on
+    chars -= ones * '0';
+    chars = chars * 10 + (chars >> 8);
+    constexpr uint64_t mask = UINT64_C(0x000000ff000000ff);
+    chars = (((chars & mask) * UINT64_C(0x000f424000000064))
+             + (((chars >> 16) & mask) * UINT64_C(0x0000271000000001)))
+            >> 32;
+    return chars;
+}
+
+/// <summary>
+/// parses the digits at <c>p</c> into the mantissa
+/// </summary>
+/// <returns>the end of the digits</returns>
+inline char const*
+parse_digits(char const* p, char const* end, uint64_t& mantissa) noexcept
+{
+    if constexpr (endian::native == endian::little)
+    {
+        for (uint64_t chars; end - p >= 8; p += 8)
+        {
+            memcpy(&chars, p, 8);
+            if (!is_eight_digits(chars)) break;
+            mantissa = mantissa * 100000000 + parse_eight_digits(chars);
+        }
+    }
+
+    for (; p != end && is_digit(*p); ++p) mantissa = mantissa * 10 + (*p - '0');
+    return p;
+}
+
+/// <summary>
+/// returns the value of the hexadecimal digit, or -1 if it is not one
+/// </summary>
+inline int hex_value(char c) noexcept
+{
+    if (is_digit(c)) return c - '0';
+    c |= 0x20;
+    if ('a' <= c && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/// <summary>
+/// writes the code point in UTF-8
+/// </summary>
+/// <returns>the end of the written bytes</returns>
+char* write_utf8(uint32_t cp, char* out) noexcept
+{
+    if (cp < 0x80)
+    {
+        *out++ = static_cast<char>(cp);
+    }
+    else if (cp < 0x800)
+    {
+        *out++ = static_cast<char>(0xc0 | (cp >> 6));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    else if (cp < 0x10000)
+    {
+        *out++ = static_cast<char>(0xe0 | (cp >> 12));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    else
+    {
+        *out++ = static_cast<char>(0xf0 | (cp >> 18));
+        *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+    }
+    return out;
+}
+
+/// <summary>
+/// finds the first byte which does not start a valid UTF-8 sequence
+/// </summary>
+/// <param name="ptr">the text</param>
+/// <param name="first">
+/// the offset to start from, which starts a sequence
+/// </param>
+/// <param name="len">the length of the text</param>
+/// <returns>the offset of the byte, or <c>len</c> if there is none</returns>
+size_t find_invalid_utf8(char const* ptr, size_t first, size_t len) noexcept
+{
+    auto const* s = reinterpret_cast<unsigned char const*>(ptr);
+    for (size_t i = first; i < len;)
+    {
+        // skips ASCII characters 8 at a time
+        uint64_t word;
+        if (len - i >= 8 && (memcpy(&word, s + i, 8), (word & highs) == 0))
+        {
+            i += 8;
+            continue;
+        }
+
+        uint32_t c = s[i];
+        if (c < 0x80)
+        {
+            ++i;
+            continue;
+        }
+
+        size_t   n;
+        uint32_t min;
+        if ((c & 0xe0) == 0xc0) n = 2, min = 0x80, c &= 0x1f;
+        else if ((c & 0xf0) == 0xe0)
+            n = 3, min = 0x800, c &= 0x0f;
+        else if ((c & 0xf8) == 0xf0)
+            n = 4, min = 0x10000, c &= 0x07;
+        else
+            return i;
+
+        if (len - i < n) return i;
+        for (size_t k = 1; k < n; ++k)
+        {
+            if ((s[i + k] & 0xc0) != 0x80) return i;
+            c = c << 6 | (s[i + k] & 0x3f);
+        }
+
+        // rejects overlong forms, surrogates and code points out of the range
+        if (c < min || c > 0x10ffff || (0xd800 <= c && c <= 0xdfff)) return i;
+        i += n;
+    }
+    return len;
+}
+
+/// <summary>
+/// a number parsed from the text
+/// </summary>
+struct number
+{
+    bool    is_int;
+    int64_t i;
+    double  f;
+};
+
+class parser
+{
+  public:
+    /// <summary>
+    /// makes a parser
+    /// </summary>
+    /// <param name="doc">the document to make the arrays and maps lazily
+    /// in, or <c>nullptr</c> to make them at once</param>
+    parser(char const*            json,
+           size_t                 len,
+           dy_parse_opts_t const& opts,
+           _dy_lazy_t*            doc = nullptr) noexcept :
+        json_ { json },
+        len_ { len },
+        arena_ { doc == nullptr ? opts.arena : nullptr },
+        typed_ { !opts.generic_arrays },
+        max_depth_ { opts.max_depth != 0 ? opts.max_depth : 1024 },
+        doc_ { doc }
+    {}
+
+    parser(parser const&) = delete;
+
+    ~parser() noexcept
+    {
+        clear();
+    }
+
+    /// <summary>
+    /// parses the text
+    /// </summary>
+    /// <returns>a new value instance, or <c>nullptr</c> on failure</returns>
+    dy_t parse() noexcept
+    {
+        if (len_ >= UINT32_MAX) return fail(dy_parse_capacity, 0);
+
+        size_t ascii_len;
+        index_.reset(new uint32_t[len_ + 1]);
+        count_ = dy::kernels().json_index(
+            json_, len_, index_.get(), &ascii_len);
+
+        size_t invalid = find_invalid_utf8(json_, ascii_len, len_);
+        if (invalid != len_) return fail(dy_parse_string, invalid);
+
+        chars_.reset(new char[len_ + 1]);
+        if (doc_ != nullptr && !find_ends()) return nullptr;
+
+        dy_t val = parse_value(0);
+        if (val != nullptr && next_ != count_)
+        {
+            dy_dispose(val);
+            return fail(dy_parse_syntax, index_[next_]);
+        }
+        return val;
+    }
+
+    dy_parse_error_t error() const noexcept
+    {
+        return error_;
+    }
+
+    size_t error_offset() const noexcept
+    {
+        return error_offset_;
+    }
+
+    /// <summary>
+    /// parses the entries of a lazy array or map, whose arrays and maps are
+    /// lazy in turn
+    /// </summary>
+    /// <param name="pos">the position of its opening bracket in the
+    /// structural index</param>
+    /// <returns>a new generic array or map. The whole text was checked when
+    /// the document was made, so this does not fail.</returns>
+    dy_t parse_level(size_t pos) noexcept
+    {
+        next_    = pos + 1;
+        bool map = json_[index_[pos]] == '{';
+        dy_t val = map ? parse_map(0) : parse_arr(0);
+        assert(val != nullptr);
+        return val;
+    }
+
+  private:
+    char const*            json_;
+    size_t                 len_;
+    dy_arena_t             arena_;
+    bool                   typed_;
+    size_t                 max_depth_;
+    unique_ptr<uint32_t[]> index_;
+    size_t                 count_ = 0;
+    size_t                 next_  = 0;
+
+    /// <summary>
+    /// the document of the lazy arrays and maps, and the position after the
+    /// closing bracket of each array and map in the structural index
+    /// </summary>
+    _dy_lazy_t*            doc_;
+    unique_ptr<uint32_t[]> ends_;
+
+    /// <summary>
+    /// the unescaped keys of the open maps followed by the string being
+    /// parsed. Unescaping never makes a string longer, so this never grows.
+    /// </summary>
+    unique_ptr<char[]> chars_;
+    size_t             chars_len_ = 0;
+
+    /// <summary>
+    /// the entries of the open arrays
+    /// </summary>
+    vector<dy_t> values_;
+
+    /// <summary>
+    /// the pairs of the open maps
+    /// </summary>
+    vector<dy_keyval_t> pairs_;
+
+    /// <summary>
+    /// the numbers of the open array which may become a typed array, both as
+    /// integers and as double-precision numbers
+    /// </summary>
+    vector<int64_t> ints_;
+    vector<double>  floats_;
+
+    /// <summary>
+    /// whether each of the numbers kept aside is an integer
+    /// </summary>
+    vector<bool> kinds_;
+
+    dy_parse_error_t error_        = dy_parse_ok;
+    size_t           error_offset_ = 0;
+
+    /// <summary>
+    /// disposes the values of the arrays and maps left open by an error
+    /// </summary>
+    void clear() noexcept
+    {
+        for (auto val : values_) dy_dispose(val);
+        for (auto& pair : pairs_) dy_dispose(pair.val);
+
+        values_.clear();
+        pairs_.clear();
+        ints_.clear();
+        floats_.clear();
+        kinds_.clear();
+        chars_len_ = 0;
+    }
+
+    dy_t fail(dy_parse_error_t error, size_t offset) noexcept
+    {
+        error_        = error;
+        error_offset_ = offset;
+        return nullptr;
+    }
+
+    bool reject(dy_parse_error_t error, size_t offset) noexcept
+    {
+        fail(error, offset);
+        return false;
+    }
+
+    /// <summary>
+    /// returns the next structural character, or a NUL character at the end
+    /// </summary>
+    char peek() const noexcept
+    {
+        return next_ < count_ ? json_[index_[next_]] : '\0';
+    }
+
+    /// <summary>
+    /// returns the offset of the next structural character
+    /// </summary>
+    size_t offset() const noexcept
+    {
+        return next_ < count_ ? index_[next_] : len_;
+    }
+
+    dy_t parse_value(size_t depth) noexcept
+    {
+        size_t pos = offset();
+        switch (peek())
+        {
+        case '[':
+            if (depth == max_depth_) return fail(dy_parse_depth, pos);
+            if (is_lazy(true)) return make_lazy(dy_type_arr);
+            ++next_;
+            return parse_arr(depth + 1);
+        case '{':
+            if (depth == max_depth_) return fail(dy_parse_depth, pos);
+            if (is_lazy(false)) return make_lazy(dy_type_map);
+            ++next_;
+            return parse_map(depth + 1);
+        case '"':
+        {
+            ++next_;
+            char*  out = chars_.get() + chars_len_;
+            size_t len = parse_str(pos, out);
+            if (len == SIZE_MAX) return nullptr;
+            return arena_ ? dy_arena_make_str_len(arena_, out, len)
+                          : dy_make_str_len(out, len);
+        }
+        case 't':
+            if (!check_literal(pos, "true")) return nullptr;
+            ++next_;
+            return dy_make_b(true);
+        case 'f':
+            if (!check_literal(pos, "false")) return nullptr;
+            ++next_;
+            return dy_make_b(false);
+        case 'n':
+            if (!check_literal(pos, "null")) return nullptr;
+            ++next_;
+            return dy_make_null();
+        default:
+        {
+            number num;
+            if (!parse_number(pos, num)) return nullptr;
+            ++next_;
+            return make_number(num);
+        }
+        }
+    }
+
+    /// <summary>
+    /// checks the text, whose strings and numbers are parsed and dropped, and
+    /// finds the end of each array and map
+    /// </summary>
+    bool find_ends() noexcept
+    {
+        enum class expect : uint8_t
+        {
+            value,
+            value_or_end,
+            next,
+            key,
+            key_or_end,
+            colon,
+        };
+
+        // the index is kept with the document, so it is cut to fit
+        unique_ptr<uint32_t[]> index(new uint32_t[count_]);
+        copy_n(index_.get(), count_, index.get());
+        index_ = move(index);
+        ends_.reset(new uint32_t[count_]);
+
+        vector<uint32_t> open;
+        expect           state = expect::value;
+        for (size_t i = 0; i < count_; ++i)
+        {
+            size_t pos     = index_[i];
+            char   c       = json_[pos];
+            bool   closing = c == ']' || c == '}';
+
+            if (closing
+                && (state == expect::value_or_end
+                    || state == expect::key_or_end || state == expect::next))
+            {
+                bool map = !open.empty() && json_[index_[open.back()]] == '{';
+                if (open.empty() || map != (c == '}'))
+                    return reject(dy_parse_syntax, pos);
+
+                ends_[open.back()] = static_cast<uint32_t>(i + 1);
+                open.pop_back();
+                state = expect::next;
+                continue;
+            }
+
+            switch (state)
+            {
+            case expect::value:
+            case expect::value_or_end:
+                if (c == '[' || c == '{')
+                {
+                    if (open.size() == max_depth_)
+                        return reject(dy_parse_depth, pos);
+
+                    open.push_back(static_cast<uint32_t>(i));
+                    state = c == '[' ? expect::value_or_end
+                                     : expect::key_or_end;
+                }
+                else if (closing || c == ',' || c == ':')
+                    return reject(dy_parse_syntax, pos);
+                else if (!check_scalar(pos))
+                    return false;
+                else
+                    state = expect::next;
+                break;
+            case expect::next:
+                if (c != ',' || open.empty())
+                    return reject(dy_parse_syntax, pos);
+
+                state = json_[index_[open.back()]] == '{' ? expect::key
+                                                          : expect::value;
+                break;
+            case expect::key:
+            case expect::key_or_end:
+                if (c != '"') return reject(dy_parse_syntax, pos);
+                if (!check_scalar(pos)) return false;
+                state = expect::colon;
+                break;
+            case expect::colon:
+                if (c != ':') return reject(dy_parse_syntax, pos);
+                state = expect::value;
+                break;
+            }
+        }
+
+        if (state != expect::next || !open.empty())
+            return reject(dy_parse_syntax, len_);
+        return true;
+    }
+
+    /// <summary>
+    /// checks whether the array or the map at the next position is made
+    /// lazily. Empty ones are made at once, and so are the arrays starting
+    /// with a number, which may become typed arrays.
+    /// </summary>
+    bool is_lazy(bool arr) const noexcept
+    {
+        if (doc_ == nullptr || ends_[next_] == next_ + 2) return false;
+
+        char c = json_[index_[next_ + 1]];
+        return !arr || !typed_ || (c != '-' && !is_digit(c));
+    }
+
+    /// <summary>
+    /// makes the lazy array or map at the next position, skipping its text
+    /// </summary>
+    dy_t make_lazy(dy_type_t type) noexcept;
+
+    bool check_literal(size_t pos, char const* literal) noexcept
+    {
+        size_t len = strlen(literal);
+        if (len_ - pos < len || memcmp(json_ + pos, literal, len) != 0
+            || (pos + len < len_ && !is_delimiter(json_[pos + len])))
+            return reject(dy_parse_syntax, pos);
+        return true;
+    }
+
+    /// <summary>
+    /// checks the string, the number or the literal at the offset, so that
+    /// the text of a lazy document is rejected as a whole as it would be when
+    /// parsed at once
+    /// </summary>
+    bool check_scalar(size_t pos) noexcept
+    {
+        switch (json_[pos])
+        {
+        case '"': return parse_str(pos, chars_.get()) != SIZE_MAX;
+        case 't': return check_literal(pos, "true");
+        case 'f': return check_literal(pos, "false");
+        case 'n': return check_literal(pos, "null");
+        default:
+        {
+            number num;
+            return parse_number(pos, num);
+        }
+        }
+    }
+
+    dy_t make_number(number const& num) noexcept
+    {
+        if (num.is_int)
+            return arena_ ? dy_arena_make_i(arena_, num.i) : dy_make_i(num.i);
+        return arena_ ? dy_arena_make_f(arena_, num.f) : dy_make_f(num.f);
+    }
+
+    dy_t parse_arr(size_t depth) noexcept
+    {
+        size_t first = values_.size();
+
+        // numbers are kept aside until the array turns out not to be typed
+        bool   numeric   = typed_;
+        bool   all_ints  = true;
+        bool   all_exact = true;
+        size_t first_num = ints_.size();
+
+        if (peek() == ']')
+        {
+            ++next_;
+            return make_arr(first);
+        }
+
+        for (;;)
+        {
+            char c = peek();
+            if (numeric && (c == '-' || is_digit(c)))
+            {
+                number num;
+                if (!parse_number(offset(), num)) return nullptr;
+                ++next_;
+
+                uint64_t magnitude = num.i < 0 ? 0 - uint64_t(num.i)
+                                               : uint64_t(num.i);
+                all_ints &= num.is_int;
+                all_exact &= !num.is_int || magnitude <= exact_int_max;
+
+                ints_.push_back(num.is_int ? num.i : 0);
+                floats_.push_back(num.is_int ? static_cast<double>(num.i)
+                                             : num.f);
+                kinds_.push_back(num.is_int);
+            }
+            else
+            {
+                if (numeric) flush_nums(first_num);
+                numeric = false;
+
+                dy_t val = parse_value(depth);
+                if (val == nullptr) return nullptr;
+                values_.push_back(val);
+            }
+
+            size_t pos = offset();
+            c          = peek();
+            ++next_;
+            if (c == ']') break;
+            if (c != ',') return fail(dy_parse_syntax, pos);
+        }
+
+        if (numeric && (all_ints || all_exact))
+            return make_typed_arr(first_num, all_ints);
+        if (numeric) flush_nums(first_num);
+        return make_arr(first);
+    }
+
+    /// <summary>
+    /// makes the values of the numbers kept aside
+    /// </summary>
+    void flush_nums(size_t first) noexcept
+    {
+        for (size_t i = first; i < ints_.size(); ++i)
+            values_.push_back(make_number(number {
+                .is_int = kinds_[i],
+                .i      = ints_[i],
+                .f      = floats_[i],
+            }));
+
+        ints_.resize(first);
+        floats_.resize(first);
+        kinds_.resize(first);
+    }
+
+    dy_t make_arr(size_t first) noexcept
+    {
+        dy_t const* ptr = values_.data() + first;
+        size_t      len = values_.size() - first;
+        dy_t        arr = arena_ ? dy_arena_make_arr(arena_, ptr, len)
+                                 : dy_make_arr(ptr, len);
+        values_.resize(first);
+        return arr;
+    }
+
+    dy_t make_typed_arr(size_t first, bool all_ints) noexcept
+    {
+        size_t len = ints_.size() - first;
+        dy_t   arr;
+        if (all_ints)
+        {
+            int64_t const* ptr = ints_.data() + first;
+            arr                = arena_ ? dy_arena_make_iarr(arena_, ptr, len)
+                                        : dy_make_iarr(ptr, len);
+        }
+        else
+        {
+            double const* ptr = floats_.data() + first;
+            arr               = arena_ ? dy_arena_make_farr(arena_, ptr, len)
+                                       : dy_make_farr(ptr, len);
+        }
+
+        ints_.resize(first);
+        floats_.resize(first);
+        kinds_.resize(first);
+        return arr;
+    }
+
+    dy_t parse_map(size_t depth) noexcept
+    {
+        size_t first       = pairs_.size();
+        size_t first_chars = chars_len_;
+
+        if (peek() == '}')
+        {
+            ++next_;
+            return make_map(first, first_chars);
+        }
+
+        for (;;)
+        {
+            size_t pos = offset();
+            if (peek() != '"') return fail(dy_parse_syntax, pos);
+            ++next_;
+
+            // the key stays until the map is made
+            char*  key = chars_.get() + chars_len_;
+            size_t len = parse_str(pos, key);
+            if (len == SIZE_MAX) return nullptr;
+            key[len] = '\0';
+            chars_len_ += len + 1;
+
+            pos = offset();
+            if (peek() != ':') return fail(dy_parse_syntax, pos);
+            ++next_;
+
+            dy_t val = parse_value(depth);
+            if (val == nullptr) return nullptr;
+            pairs_.push_back(dy_keyval_t { .key = key, .val = val });
+
+            pos    = offset();
+            char c = peek();
+            ++next_;
+            if (c == '}') break;
+            if (c != ',') return fail(dy_parse_syntax, pos);
+        }
+
+        return make_map(first, first_chars);
+    }
+
+    dy_t make_map(size_t first, size_t first_chars) noexcept
+    {
+        dy_keyval_t const* ptr = pairs_.data() + first;
+        size_t             len = pairs_.size() - first;
+        dy_t               map = arena_ ? dy_arena_make_map(arena_, ptr, len)
+                                        : dy_make_map(ptr, len);
+
+        // the values of the keys given more than once are left out
+        if (dy_get_map_len(map) != len)
+            for (size_t i = 0; i < len; ++i)
+                if (dy_get_map_key(map, ptr[i].key).val != ptr[i].val)
+                    dy_dispose(ptr[i].val);
+
+        pairs_.resize(first);
+        chars_len_ = first_chars;
+        return map;
+    }
+
+    /// <summary>
+    /// unescapes a string
+    /// </summary>
+    /// <param name="pos">the offset of the opening quote</param>
+    /// <param name="out">the characters, which has room for the string</param>
+    /// <returns>
+    /// the length of the string, or <c>SIZE_MAX</c> on failure
+    /// </returns>
+    size_t parse_str(size_t pos, char* out) noexcept
+    {
+        char const* p     = json_ + pos + 1;
+        char const* end   = json_ + len_;
+        char*       first = out;
+
+        for (;;)
+        {
+            if constexpr (endian::native == endian::little)
+            {
+                // copies 8 characters at a time until a quote, a backslash or
+                // a control character
+                while (end - p >= 8)
+                {
+                    uint64_t word;
+                    memcpy(&word, p, 8);
+
+                    uint64_t special = bytes_equal(word, '"')
+                                       | bytes_equal(word, '\\')
+                                       | bytes_less(word, 0x20);
+                    size_t   n       = special != 0 ? countr_zero(special) / 8
+                                                    : 8;
+                    memcpy(out, p, n);
+                    p += n;
+                    out += n;
+                    if (n != 8) break;
+                }
+            }
+
+            if (p == end) return reject(dy_parse_syntax, len_), SIZE_MAX;
+
+            char c = *p;
+            if (c == '"') return static_cast<size_t>(out - first);
+
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                fail(dy_parse_string, p - json_);
+                return SIZE_MAX;
+            }
+
+            if (c != '\\')
+            {
+                *out++ = *p++;
+                continue;
+            }
+
+            if (!unescape(p, out)) return SIZE_MAX;
+        }
+    }
+
+    /// <summary>
+    /// unescapes the escape sequence at <c>p</c>, advancing both pointers
+    /// </summary>
+    bool unescape(char const*& p, char*& out) noexcept
+    {
+        char const* end = json_ + len_;
+        if (end - p < 2) return reject(dy_parse_string, p - json_);
+
+        char c = p[1];
+        switch (c)
+        {
+        case '"':
+        case '\\':
+        case '/': *out++ = c; break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u':
+        {
+            char const* first = p;
+
+            int32_t cp = parse_hex4(p + 2, end);
+            if (cp < 0) return reject(dy_parse_string, first - json_);
+            p += 6;
+
+            // a high surrogate must be followed by a low one
+            if (0xdc00 <= cp && cp <= 0xdfff)
+                return reject(dy_parse_string, first - json_);
+            if (0xd800 <= cp && cp <= 0xdbff)
+            {
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u')
+                    return reject(dy_parse_string, first - json_);
+
+                int32_t low = parse_hex4(p + 2, end);
+                if (low < 0xdc00 || 0xdfff < low)
+                    return reject(dy_parse_string, first - json_);
+                p += 6;
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            }
+
+            out = write_utf8(static_cast<uint32_t>(cp), out);
+            return true;
+        }
+        default: return reject(dy_parse_string, p - json_);
+        }
+
+        p += 2;
+        return true;
+    }
+
+    /// <summary>
+    /// parses 4 hexadecimal digits
+    /// </summary>
+    /// <returns>the value, or -1 if they are not</returns>
+    static int32_t parse_hex4(char const* p, char const* end) noexcept
+    {
+        if (end - p < 4) return -1;
+
+        int32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            int digit = hex_value(p[i]);
+            if (digit < 0) return -1;
+            value = value << 4 | digit;
+        }
+        return value;
+    }
+
+    /// <summary>
+    /// parses a number
+    /// </summary>
+    /// <param name="pos">the offset of the first character</param>
+    /// <param name="num">set to the number</param>
+    /// <returns><c>true</c> on success, <c>false</c> on failure</returns>
+    bool parse_number(size_t pos, number& num) noexcept
+    {
+        char const* first = json_ + pos;
+        char const* end   = json_ + len_;
+        char const* p     = first;
+
+        bool negative = p != end && *p == '-';
+        p += negative;
+
+        // the significant digits, which are exact up to 19 digits
+        uint64_t mantissa = 0;
+        size_t   digits   = 0;
+        int64_t  exponent = 0;
+
+        char const* int_first = p;
+        if (p != end && *p == '0') ++p;
+        else
+            p = parse_digits(p, end, mantissa);
+        if (p == int_first) return reject(dy_parse_syntax, pos);
+        digits = p - int_first;
+
+        bool is_int = true;
+        if (p != end && *p == '.')
+        {
+            char const* frac_first = ++p;
+            p                      = parse_digits(p, end, mantissa);
+            if (p == frac_first) return reject(dy_parse_syntax, pos);
+
+            digits += p - frac_first;
+            exponent -= p - frac_first;
+            is_int = false;
+        }
+
+        if (p != end && (*p | 0x20) == 'e')
+        {
+            ++p;
+            bool exp_negative = p != end && *p == '-';
+            if (p != end && (*p == '-' || *p == '+')) ++p;
+
+            char const* exp_first = p;
+            int64_t     exp       = 0;
+            for (; p != end && is_digit(*p); ++p)
+                if (exp < 100000) exp = exp * 10 + (*p - '0');
+            if (p == exp_first) return reject(dy_parse_syntax, pos);
+
+            exponent += exp_negative ? -exp : exp;
+            is_int = false;
+        }
+
+        if (p != end && !is_delimiter(*p)) return reject(dy_parse_syntax, pos);
+
+        // leading zeros of the fraction are counted, so more digits only take
+        // the slow path
+        if (is_int && digits <= 18)
+        {
+            num.is_int = true;
+            num.i      = negative ? -int64_t(mantissa) : int64_t(mantissa);
+            return true;
+        }
+
+        if (is_int)
+        {
+            num.is_int = true;
+            if (from_chars(first, p, num.i).ec == errc {}) return true;
+        }
+
+        num.is_int = false;
+        if (digits <= 19 && mantissa <= exact_int_max && -22 <= exponent
+            && exponent <= 22)
+        {
+            // both operands are exact, so the result is correctly rounded
+            double value = static_cast<double>(mantissa);
+            value        = exponent < 0 ? value / exact_powers[-exponent]
+                                        : value * exact_powers[exponent];
+            num.f        = negative ? -value : value;
+            return true;
+        }
+
+        auto [last, ec] = from_chars(first, p, num.f);
+        if (ec == errc::result_out_of_range)
+        {
+            // numbers too small to represent become zero
+            if (exponent + int64_t(digits) < 0)
+            {
+                num.f = negative ? -0.0 : 0.0;
+                return true;
+            }
+            return reject(dy_parse_number, pos);
+        }
+        assert(ec == errc {} && last == p);
+        return true;
+    }
+};
+
+/// <summary>
+/// writes JSON text to a sink. Scalars are formatted in place after reserving
+/// room for the longest one in the chunk.
+/// </summary>
+class writer
+{
+  public:
+    writer(uint32_t flags, dy_write_fn_t write_fn, void* ctx) noexcept :
+        flags_ { flags },
+        sink_ { write_fn, ctx }
+    {}
+
+    writer(writer const&) = delete;
+
+    /// <summary>
+    /// writes the value and hands out the rest of the text
+    /// </summary>
+    /// <returns><c>false</c> if the function stopped writing</returns>
+    bool write(dy_t val) noexcept
+    {
+        write_value(val);
+        sink_.flush();
+        return sink_.ok();
+    }
+
+  private:
+    /// <summary>
+    /// the room needed for any scalar value
+    /// </summary>
+    static constexpr size_t scalar_max = 32;
+
+    uint32_t flags_;
+    dy::sink sink_;
+
+    char* reserve(size_t len) noexcept
+    {
+        return sink_.reserve(len);
+    }
+
+    void commit(char* end) noexcept
+    {
+        sink_.commit(end);
+    }
+
+    void put(char c) noexcept
+    {
+        sink_.put(c);
+    }
+
+    void append(char const* data, size_t len) noexcept
+    {
+        sink_.append(data, len);
+    }
+
+    template <typename I>
+    static char* format_int(char* p, I i) noexcept
+    {
+        return to_chars(p, p + scalar_max, i).ptr;
+    }
+
+    template <typename F>
+    static char* format_float(char* p, F f) noexcept
+    {
+        if (!isfinite(f))
+        {
+            memcpy(p, "null", 4);
+            return p + 4;
+        }
+
+        // the shortest form of an integer lacks a fraction, which would make
+        // it read back as an integer
+        char* end = to_chars(p, p + scalar_max, f).ptr;
+        if (find_if(p, end, [](char c) { return c == '.' || c == 'e'; })
+            == end)
+        {
+            memcpy(end, ".0", 2);
+            end += 2;
+        }
+        return end;
+    }
+
+    template <typename T, typename Format>
+    void write_elems(T const* ptr, size_t len, Format format) noexcept
+    {
+        put('[');
+        for (size_t i = 0; i < len; ++i)
+        {
+            char* p = reserve(scalar_max + 1);
+            *p      = ',';
+            commit(format(p + (i != 0), ptr[i]));
+        }
+        put(']');
+    }
+
+    void write_barr(dy_t val) noexcept
+    {
+        uint64_t const* words = dy_get_barr_words(val);
+        size_t          len   = dy_get_barr_len(val);
+
+        put('[');
+        for (size_t i = 0; i < len; i += 64)
+        {
+            uint64_t word = words[i / 64];
+            size_t   bits = min<size_t>(len - i, 64);
+
+            // copies the NUL terminator of "true" as well to keep the length
+            // of the copies fixed
+            char* p = reserve(bits * 6);
+            for (size_t j = 0; j < bits; ++j, word >>= 1)
+            {
+                *p = ',';
+                p += i + j != 0;
+                memcpy(p, word & 1 ? "true" : "false", 5);
+                p += 5 - (word & 1);
+            }
+            commit(p);
+        }
+        put(']');
+    }
+
+    void write_base64(uint8_t const* ptr, size_t len) noexcept
+    {
+        constexpr char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                  "abcdefghijklmnopqrstuvwxyz"
+                                  "0123456789+/";
+
+        put('"');
+        size_t i = 0;
+        for (; i + 3 <= len; i += 3)
+        {
+            uint32_t n = uint32_t(ptr[i]) << 16 | uint32_t(ptr[i + 1]) << 8
+                         | ptr[i + 2];
+
+            char* p = reserve(4);
+            p[0]    = digits[n >> 18];
+            p[1]    = digits[n >> 12 & 63];
+            p[2]    = digits[n >> 6 & 63];
+            p[3]    = digits[n & 63];
+            commit(p + 4);
+        }
+        if (i != len)
+        {
+            uint32_t n = uint32_t(ptr[i]) << 16;
+            if (i + 1 != len) n |= uint32_t(ptr[i + 1]) << 8;
+
+            char* p = reserve(4);
+            p[0]    = digits[n >> 18];
+            p[1]    = digits[n >> 12 & 63];
+            p[2]    = i + 1 != len ? digits[n >> 6 & 63] : '=';
+            p[3]    = '=';
+            commit(p + 4);
+        }
+        put('"');
+    }
+
+    void write_str(char const* str, size_t len) noexcept
+    {
+        auto escape_len = dy::kernels().json_escape_len;
+
+        put('"');
+        while (true)
+        {
+            size_t run = escape_len(str, len);
+            append(str, run);
+            if (run == len) break;
+
+            write_escape(str[run]);
+            str += run + 1;
+            len -= run + 1;
+        }
+        put('"');
+    }
+
+    void write_escape(char c) noexcept
+    {
+        char* p = reserve(6);
+        p[0]    = '\\';
+        switch (c)
+        {
+        case '"':
+        case '\\': p[1] = c; break;
+        case '\b': p[1] = 'b'; break;
+        case '\f': p[1] = 'f'; break;
+        case '\n': p[1] = 'n'; break;
+        case '\r': p[1] = 'r'; break;
+        case '\t': p[1] = 't'; break;
+        default:
+            memcpy(p + 1, "u00", 3);
+            p[4] = "0123456789abcdef"[c >> 4];
+            p[5] = "0123456789abcdef"[c & 15];
+            commit(p + 6);
+            return;
+        }
+        commit(p + 2);
+    }
+
+    /// <summary>
+    /// writes the value. The arrays and maps are followed with a stack on the
+    /// heap, so deep trees do not overflow the stack of the thread.
+    /// </summary>
+    void write_value(dy_t val) noexcept
+    {
+        struct frame
+        {
+            dy_t        val;
+            dy_t const* elems;
+            size_t      next;
+            size_t      len;
+            bool        map;
+        };
+
+        vector<frame> stack;
+        for (;;)
+        {
+            switch (dy_get_type(val))
+            {
+            case dy_type_arr:
+                put('[');
+                stack.push_back({ val,
+                                  dy_get_arr_data(val),
+                                  0,
+                                  dy_get_arr_len(val),
+                                  false });
+                break;
+            case dy_type_map:
+                put('{');
+                stack.push_back(
+                    { val, nullptr, 0, dy_get_map_len(val), true });
+                break;
+            default: write_scalar(val); break;
+            }
+
+            // closes the arrays and maps written until one has an entry left
+            val = nullptr;
+            while (val == nullptr && !stack.empty())
+            {
+                frame& top = stack.back();
+                if (top.next == top.len || !sink_.ok())
+                {
+                    put(top.map ? '}' : ']');
+                    stack.pop_back();
+                    continue;
+                }
+
+                if (top.next != 0) put(',');
+                if (!top.map)
+                {
+                    val = top.elems[top.next++];
+                    continue;
+                }
+
+                dy_keyval_t pair = dy_get_map_idx(top.val, top.next++);
+                write_str(pair.key, strlen(pair.key));
+                put(':');
+                val = pair.val;
+            }
+
+            if (val == nullptr) return;
+        }
+    }
+
+    void write_scalar(dy_t val) noexcept
+    {
+        auto ints   = [](char* p, auto i) { return format_int(p, i); };
+        auto floats = [](char* p, auto f) { return format_float(p, f); };
+
+        switch (dy_get_type(val))
+        {
+        case dy_type_null: append("null", 4); break;
+        case dy_type_b:
+            if (dy_get_b(val)) append("true", 4);
+            else
+                append("false", 5);
+            break;
+        case dy_type_i:
+            commit(format_int(reserve(scalar_max), dy_get_i(val)));
+            break;
+        case dy_type_f:
+            commit(format_float(reserve(scalar_max), dy_get_f(val)));
+            break;
+        case dy_type_str:
+            write_str(dy_get_str_data(val), dy_get_str_len(val));
+            break;
+        case dy_type_barr: write_barr(val); break;
+        case dy_type_bytes:
+            if (flags_ & dy_write_base64)
+                write_base64(dy_get_bytes_data(val), dy_get_bytes_len(val));
+            else
+                write_elems(
+                    dy_get_bytes_data(val), dy_get_bytes_len(val), ints);
+            break;
+        case dy_type_iarr:
+            write_elems(dy_get_iarr_data(val), dy_get_iarr_len(val), ints);
+            break;
+        case dy_type_farr:
+            write_elems(dy_get_farr_data(val), dy_get_farr_len(val), floats);
+            break;
+        case dy_type_i8arr:
+            write_elems(dy_get_i8arr_data(val), dy_get_i8arr_len(val), ints);
+            break;
+        case dy_type_i16arr:
+            write_elems(dy_get_i16arr_data(val), dy_get_i16arr_len(val), ints);
+            break;
+        case dy_type_i32arr:
+            write_elems(dy_get_i32arr_data(val), dy_get_i32arr_len(val), ints);
+            break;
+        case dy_type_u32arr:
+            write_elems(dy_get_u32arr_data(val), dy_get_u32arr_len(val), ints);
+            break;
+        case dy_type_f32arr:
+            write_elems(
+                dy_get_f32arr_data(val), dy_get_f32arr_len(val), floats);
+            break;
+        default: break;
+        }
+    }
+};
+
+}
+
+/// <summary>
+/// a document parsed lazily. It holds a copy of the text with its structural
+/// index, and lives as long as any of its lazy arrays and maps.
+/// </summary>
+struct _dy_lazy_t
+{
+  public:
+    /// <summary>
+    /// parses the text, making the arrays and maps lazily
+    /// </summary>
+    /// <returns>a new value instance, or <c>nullptr</c> on failure</returns>
+    static dy_t parse(char const*      json,
+                      size_t           len,
+                      dy_parse_opts_t& opts) noexcept
+    {
+        auto doc = new _dy_lazy_t(json, len, opts);
+        dy_t val = doc->parser_.parse();
+
+        opts.error        = doc->parser_.error();
+        opts.error_offset = doc->parser_.error_offset();
+
+        // the arrays and maps made retain the document
+        doc->release();
+        return val;
+    }
+
+    _dy_lazy_t(_dy_lazy_t const&) = delete;
+
+    void retain() noexcept
+    {
+        refs_.fetch_add(1, memory_order_relaxed);
+    }
+
+    void release() noexcept
+    {
+        if (refs_.fetch_sub(1, memory_order_acq_rel) == 1) delete this;
+    }
+
+    /// <summary>
+    /// returns the entries of the lazy array or map, parsing them once
+    /// </summary>
+    dy_t level(dy::lazy_ref& ref) noexcept
+    {
+        lock_guard<mutex> lock(mutex_);
+
+        dy_t level = ref.level.load(memory_order_relaxed);
+        if (level == nullptr)
+        {
+            level = parser_.parse_level(ref.pos);
+            ref.level.store(level, memory_order_release);
+        }
+        return level;
+    }
+
+  private:
+    atomic<uint32_t>   refs_ { 1 };
+    unique_ptr<char[]> text_;
+
+    /// <summary>
+    /// the parser holding the structural index, which is reused for every
+    /// array and map under the mutex
+    /// </summary>
+    parser parser_;
+    mutex  mutex_;
+
+    _dy_lazy_t(char const*            json,
+               size_t                 len,
+               dy_parse_opts_t const& opts) noexcept :
+        text_ { new char[len + 1] },
+        parser_ { text_.get(), len, opts, this }
+    {
+        if (len != 0) memcpy(text_.get(), json, len);
+    }
+};
+
+dy_t parser::make_lazy(dy_type_t type) noexcept
+{
+    size_t pos = next_;
+    next_      = ends_[pos];
+    doc_->retain();
+
+    void* ptr = dy::heap()->allocate(sizeof(_dy_val_t), alignof(_dy_val_t));
+    return new (ptr) _dy_val_t {
+        .type  = type,
+        .flags = dy::flag_lazy,
+        .data  = { .lazy = { doc_, pos, nullptr } },
+    };
+}
+
+dy_t dy::lazy_level(dy_t val) noexcept
+{
+    auto& ref   = val->data.lazy;
+    dy_t  level = ref.level.load(memory_order_acquire);
+    return level != nullptr ? level : ref.doc->level(ref);
+}
+
+dy_t dy::lazy_release(dy_t val) noexcept
+{
+    auto& ref = val->data.lazy;
+    ref.doc->release();
+    return ref.level.load(memory_order_acquire);
+}
+
+/// <summary>
+/// an incremental parser. The text outside the values handed out is only
+/// scanned for its structure: the arrays and maps on the path are followed
+/// with their keys and indices, and the other ones are skipped by counting
+/// their brackets. The text of each value handed out is collected, across
+/// the chunks if needed, and parsed by <c>parser</c>, so the memory taken is
+/// bounded by the largest value.
+/// </summary>
+struct _dy_parser_t
+{
+  public:
+    /// <summary>
+    /// makes a parser for the values at the path
+    /// </summary>
+    /// <returns>a new instance, or <c>nullptr</c> if the path is not a JSON
+    /// pointer</returns>
+    static _dy_parser_t* create(char const*            path,
+                                dy_parse_opts_t const& opts,
+                                dy_parser_fn_t         fn,
+                                void*                  ctx) noexcept
+    {
+        if (path != nullptr && *path != '\0' && *path != '/') return nullptr;
+
+        auto parser = new (nothrow) _dy_parser_t(opts, fn, ctx);
+        if (parser == nullptr || path == nullptr) return parser;
+
+        parser->has_path_ = true;
+        for (char const* p = path; *p != '\0';)
+        {
+            // each token follows a slash, and ~1 and ~0 are / and ~
+            string token;
+            for (++p; *p != '\0' && *p != '/'; ++p)
+            {
+                if (*p == '~' && (p[1] == '0' || p[1] == '1'))
+                    token += *++p == '0' ? '~' : '/';
+                else
+                    token += *p;
+            }
+            parser->indices_.push_back(parse_index(token));
+            parser->tokens_.push_back(move(token));
+        }
+        return parser;
+    }
+
+    _dy_parser_t(_dy_parser_t const&) = delete;
+
+    bool feed(char const* data, size_t len) noexcept
+    {
+        if (error_ != dy_parse_ok) return false;
+        if (len == 0) return true;
+
+        data_ = data;
+        if (collect_ || keep_key_) mark_ = data;
+
+        char const* p   = data;
+        char const* end = data + len;
+        while (p != end && error_ == dy_parse_ok) p = step(p, end);
+
+        if (error_ == dy_parse_ok)
+        {
+            if (collect_) text_.append(mark_, end - mark_);
+            if (keep_key_) key_.append(mark_, end - mark_);
+        }
+        offset_ += len;
+        return error_ == dy_parse_ok;
+    }
+
+    bool finish() noexcept
+    {
+        if (error_ != dy_parse_ok) return false;
+
+        // a scalar at the end of the text has no delimiter after it
+        data_ = mark_ = nullptr;
+        if (state_ == state::scalar) end_value(nullptr);
+        if (error_ != dy_parse_ok) return false;
+
+        if (state_ != state::value || !frames_.empty())
+        {
+            fail(dy_parse_syntax, offset_);
+            return false;
+        }
+        return true;
+    }
+
+    dy_parse_error_t error() const noexcept
+    {
+        return error_;
+    }
+
+    size_t error_offset() const noexcept
+    {
+        return error_offset_;
+    }
+
+  private:
+    enum class state : uint8_t
+    {
+        /// <summary>
+        /// expecting a value, or another value at the top level
+        /// </summary>
+        value,
+
+        /// <summary>
+        /// expecting a value or the end of an array
+        /// </summary>
+        first_value,
+
+        /// <summary>
+        /// expecting a comma or the end of an array or a map
+        /// </summary>
+        next,
+
+        /// <summary>
+        /// expecting a key or the end of a map
+        /// </summary>
+        first_key,
+
+        key,
+        colon,
+        string,
+        scalar,
+
+        /// <summary>
+        /// in an array or a map which is skipped or collected
+        /// </summary>
+        nested,
+    };
+
+    /// <summary>
+    /// an array or a map on the path
+    /// </summary>
+    struct frame
+    {
+        bool map;
+
+        /// <summary>
+        /// whether the key of the value being read is on the path
+        /// </summary>
+        bool match;
+
+        /// <summary>
+        /// the index of the entry being read
+        /// </summary>
+        size_t idx;
+    };
+
+    dy_parse_opts_t opts_;
+    dy_parser_fn_t  fn_;
+    void*           ctx_;
+
+    /// <summary>
+    /// the tokens of the path, and the tokens as array indices
+    /// </summary>
+    bool           has_path_ = false;
+    vector<string> tokens_;
+    vector<size_t> indices_;
+    vector<frame>  frames_;
+
+    state  state_   = state::value;
+    bool   is_key_  = false;
+    bool   in_str_  = false;
+    bool   escape_  = false;
+    size_t nesting_ = 0;
+
+    /// <summary>
+    /// whether the text of the current value is collected to be parsed, and
+    /// whether the characters of the current key are
+    /// </summary>
+    bool collect_  = false;
+    bool keep_key_ = false;
+
+    /// <summary>
+    /// the start of the text collected in the current chunk
+    /// </summary>
+    char const* mark_ = nullptr;
+    char const* data_ = nullptr;
+
+    /// <summary>
+    /// the text collected from the previous chunks
+    /// </summary>
+    string text_;
+    string key_;
+
+    /// <summary>
+    /// the offsets of the current chunk and the value collected
+    /// </summary>
+    size_t offset_ = 0;
+    size_t start_  = 0;
+
+    dy_parse_error_t error_        = dy_parse_ok;
+    size_t           error_offset_ = 0;
+
+    _dy_parser_t(dy_parse_opts_t const& opts,
+                 dy_parser_fn_t         fn,
+                 void*                  ctx) noexcept :
+        opts_ { opts },
+        fn_ { fn },
+        ctx_ { ctx }
+    {}
+
+    /// <summary>
+    /// returns the token as an array index
+    /// </summary>
+    /// <returns>the index, or <c>SIZE_MAX</c> if the token is not
+    /// one</returns>
+    static size_t parse_index(string const& token) noexcept
+    {
+        if (token.empty() || token.size() > 18) return SIZE_MAX;
+        if (token.size() > 1 && token[0] == '0') return SIZE_MAX;
+
+        size_t idx = 0;
+        for (char c : token)
+        {
+            if (!is_digit(c)) return SIZE_MAX;
+            idx = idx * 10 + (c - '0');
+        }
+        return idx;
+    }
+
+    void fail(dy_parse_error_t error, size_t offset) noexcept
+    {
+        error_        = error;
+        error_offset_ = offset;
+    }
+
+    /// <summary>
+    /// returns the offset of the character in the current chunk
+    /// </summary>
+    size_t offset(char const* p) const noexcept
+    {
+        return offset_ + static_cast<size_t>(p - data_);
+    }
+
+    /// <summary>
+    /// skips the rest of a string
+    /// </summary>
+    /// <returns>the character after the string, or <c>end</c> if the string
+    /// goes on in the next chunk</returns>
+    char const* skip_str(char const* p, char const* end) noexcept
+    {
+        if (escape_ && p != end)
+        {
+            escape_ = false;
+            ++p;
+        }
+
+        for (;;)
+        {
+            p += dy::kernels().json_escape_len(p, end - p);
+            if (p == end) return end;
+
+            char c = *p++;
+            if (c == '"')
+            {
+                in_str_ = false;
+                return p;
+            }
+            if (c != '\\')
+            {
+                fail(dy_parse_string, offset(p - 1));
+                return end;
+            }
+            if (p == end)
+            {
+                escape_ = true;
+                return end;
+            }
+            ++p;
+        }
+    }
+
+    /// <summary>
+    /// skips an array or a map which is not on the path, or finds the end of
+    /// the one collected
+    /// </summary>
+    char const* skip_nested(char const* p, char const* end) noexcept
+    {
+        while (p != end)
+        {
+            if (in_str_)
+            {
+                p = skip_str(p, end);
+                continue;
+            }
+
+            switch (*p++)
+            {
+            case '"': in_str_ = true; break;
+            case '[':
+            case '{': ++nesting_; break;
+            case ']':
+            case '}':
+                if (--nesting_ == 0)
+                {
+                    end_value(p);
+                    return p;
+                }
+                break;
+            }
+        }
+        return end;
+    }
+
+    /// <summary>
+    /// reads the text up to the next change of the state
+    /// </summary>
+    /// <returns>the character to read next</returns>
+    char const* step(char const* p, char const* end) noexcept
+    {
+        switch (state_)
+        {
+        case state::string:
+        {
+            in_str_ = true;
+            p       = skip_str(p, end);
+            if (!in_str_) is_key_ ? end_key(p) : end_value(p);
+            return p;
+        }
+        case state::scalar:
+            while (p != end && !is_delimiter(*p)) ++p;
+            if (p != end) end_value(p);
+            return p;
+        case state::nested: return skip_nested(p, end);
+        default: break;
+        }
+
+        char c = *p;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') return p + 1;
+
+        switch (state_)
+        {
+        case state::first_value:
+            if (c == ']') return close(p);
+            [[fallthrough]];
+        case state::value: begin_value(p); return p + (state_ != state::scalar);
+        case state::next:
+            if (c == ']' || c == '}') return close(p);
+            if (c != ',') break;
+
+            if (frames_.back().map)
+                state_ = state::key;
+            else
+            {
+                ++frames_.back().idx;
+                state_ = state::value;
+            }
+            return p + 1;
+        case state::first_key:
+            if (c == '}') return close(p);
+            [[fallthrough]];
+        case state::key:
+            if (c != '"') break;
+
+            // only the keys leading to the path are read
+            is_key_   = true;
+            keep_key_ = frames_.size() <= tokens_.size();
+            mark_     = p;
+            state_    = state::string;
+            return p + 1;
+        case state::colon:
+            if (c != ':') break;
+            state_ = state::value;
+            return p + 1;
+        default: break;
+        }
+
+        fail(dy_parse_syntax, offset(p));
+        return end;
+    }
+
+    /// <summary>
+    /// starts reading the value at the character
+    /// </summary>
+    void begin_value(char const* p) noexcept
+    {
+        size_t depth = frames_.size();
+        bool   entry = !has_path_ ? depth == 0
+                                  : depth == tokens_.size() + 1
+                                        && !frames_.back().map;
+
+        if (entry)
+        {
+            collect_ = true;
+            mark_    = p;
+            start_   = offset(p);
+        }
+
+        char c = *p;
+        if (c == '[' || c == '{')
+        {
+            if (!entry && has_path_ && depth <= tokens_.size() && on_path())
+            {
+                frames_.push_back(frame { c == '{', false, 0 });
+                state_ = c == '{' ? state::first_key : state::first_value;
+            }
+            else
+            {
+                nesting_ = 1;
+                state_   = state::nested;
+            }
+        }
+        else if (c == '"')
+        {
+            is_key_ = false;
+            state_  = state::string;
+        }
+        else if (c == ']' || c == '}' || c == ',' || c == ':')
+            fail(dy_parse_syntax, offset(p));
+        else
+            state_ = state::scalar;
+    }
+
+    /// <summary>
+    /// checks whether the value being read is on the path
+    /// </summary>
+    bool on_path() const noexcept
+    {
+        if (frames_.empty()) return true;
+
+        frame const& parent = frames_.back();
+        return parent.map ? parent.match
+                          : parent.idx == indices_[frames_.size() - 1];
+    }
+
+    /// <summary>
+    /// closes the array or the map on the path at the character
+    /// </summary>
+    char const* close(char const* p) noexcept
+    {
+        if (frames_.back().map != (*p == '}'))
+        {
+            fail(dy_parse_syntax, offset(p));
+            return p + 1;
+        }
+
+        frames_.pop_back();
+        end_value(p + 1);
+        return p + 1;
+    }
+
+    /// <summary>
+    /// finishes the value ending before the character, handing it out if it
+    /// is collected
+    /// </summary>
+    void end_value(char const* end) noexcept
+    {
+        state_ = frames_.empty() ? state::value : state::next;
+        if (!collect_) return;
+
+        char const* text = mark_;
+        size_t      len  = static_cast<size_t>(end - mark_);
+        if (!text_.empty() || data_ == nullptr)
+        {
+            if (len != 0) text_.append(mark_, len);
+            text = text_.data();
+            len  = text_.size();
+        }
+
+        parser parser(text, len, opts_);
+        dy_t   val = parser.parse();
+        collect_   = false;
+        text_.clear();
+
+        if (val == nullptr)
+            fail(parser.error(), start_ + parser.error_offset());
+        else if (!fn_(ctx_, val))
+            fail(dy_parse_stopped, start_ + len);
+    }
+
+    /// <summary>
+    /// finishes the key ending before the character
+    /// </summary>
+    void end_key(char const* end) noexcept
+    {
+        state_ = state::colon;
+        if (!keep_key_) return;
+
+        key_.append(mark_, end - mark_);
+        keep_key_ = false;
+
+        // the key is unescaped as a JSON string
+        dy_t   key = dy_parse_json(key_.data(), key_.size(), nullptr);
+        auto&  top = frames_.back();
+        string const& token = tokens_[frames_.size() - 1];
+        top.match = key != nullptr && dy_get_str_len(key) == token.size()
+                    && memcmp(dy_get_str_data(key), token.data(), token.size())
+                           == 0;
+        if (key != nullptr) dy_dispose(key);
+        key_.clear();
+    }
+};
+
+DY_PUBLIC(dy_t)
+dy_parse_json(char const* json, size_t len, dy_parse_opts_t* opts) DY_NOEXCEPT
+{
+    assert(json != nullptr || len == 0);
+
+    dy_parse_opts_t defaults {};
+    if (opts == nullptr) opts = &defaults;
+    if (opts->lazy) return _dy_lazy_t::parse(json, len, *opts);
+
+    parser parser(json, len, *opts);
+    dy_t   val = parser.parse();
+
+    opts->error        = parser.error();
+    opts->error_offset = parser.error_offset();
+    return val;
+}
+
+DY_PUBLIC(dy_parser_t)
+dy_parser_create(char const*            path,
+                 dy_parse_opts_t const* opts,
+                 dy_parser_fn_t         fn,
+                 void*                  ctx) DY_NOEXCEPT
+{
+    assert(fn != nullptr);
+
+    dy_parse_opts_t defaults {};
+    return _dy_parser_t::create(path,
+                                opts != nullptr ? *opts : defaults,
+                                fn,
+                                ctx);
+}
+
+DY_PUBLIC(bool)
+dy_parser_feed(dy_parser_t parser, char const* buf, size_t len) DY_NOEXCEPT
+{
+    assert(parser != nullptr && (buf != nullptr || len == 0));
+    return parser->feed(buf, len);
+}
+
+DY_PUBLIC(bool) dy_parser_finish(dy_parser_t parser) DY_NOEXCEPT
+{
+    assert(parser != nullptr);
+    return parser->finish();
+}
+
+DY_PUBLIC(dy_parse_error_t)
+dy_get_parser_error(dy_parser_t parser, size_t* offset) DY_NOEXCEPT
+{
+    assert(parser != nullptr);
+
+    if (offset != nullptr) *offset = parser->error_offset();
+    return parser->error();
+}
+
+DY_PUBLIC(void) dy_parser_destroy(dy_parser_t parser) DY_NOEXCEPT
+{
+    delete parser;
+}
+
+DY_PUBLIC(bool)
+dy_write_json(dy_t          val,
+              uint32_t      flags,
+              dy_write_fn_t write_fn,
+              void*         ctx) DY_NOEXCEPT
+{
+    assert(val != nullptr && write_fn != nullptr);
+
+    writer writer(flags, write_fn, ctx);
+    return writer.write(val);
+}
+
+DY_PUBLIC(size_t)
+dy_write_json_buffer(dy_t     val,
+                     uint32_t flags,
+                     char*    buf,
+                     size_t   cap) DY_NOEXCEPT
+{
+    assert(buf != nullptr || cap == 0);
+
+    dy::buffer_sink sink { buf, cap, 0 };
+    dy_write_json(val, flags, dy::write_to_buffer, &sink);
+    if (cap != 0) buf[min(sink.len, cap - 1)] = '\0';
+    return sink.len;
+}
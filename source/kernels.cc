@@ -0,0 +1,763 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <kernels.p.hh>
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#    define DY_KERNELS_X86 1
+#    include <immintrin.h>
+#else
+#    define DY_KERNELS_X86 0
+#endif
+
+using namespace std;
+
+#if defined(__GNUC__) || defined(__clang__)
+#    define DY_KERNEL_INLINE __attribute__((always_inline)) inline
+#elif defined(_MSC_VER)
+#    define DY_KERNEL_INLINE __forceinline
+#else
+#    define DY_KERNEL_INLINE inline
+#endif
+
+namespace
+{
+
+// The kernels below are written once and compiled for each instruction set by
+// DY_KERNELS. They keep a fixed number of independent accumulators so that the
+// compiler can map them onto vector registers without reassociating anything,
+// which keeps floating-point results identical on every processor.
+
+/// <summary>
+/// the number of the independent accumulators
+/// </summary>
+constexpr size_t lanes = 8;
+
+/// <summary>
+/// the number of the elements covered by a word of a mask
+/// </summary>
+constexpr size_t word_bits = 64;
+
+struct add_op
+{
+    DY_KERNEL_INLINE int64_t operator()(int64_t a, int64_t b) const noexcept
+    {
+        // wraps around on overflow
+        return static_cast<int64_t>(static_cast<uint64_t>(a)
+                                    + static_cast<uint64_t>(b));
+    }
+};
+
+struct min_op
+{
+    DY_KERNEL_INLINE int64_t operator()(int64_t a, int64_t b) const noexcept
+    {
+        return b < a ? b : a;
+    }
+};
+
+struct max_op
+{
+    DY_KERNEL_INLINE int64_t operator()(int64_t a, int64_t b) const noexcept
+    {
+        return a < b ? b : a;
+    }
+};
+
+/// <summary>
+/// selects the value if the bit is set, or the other one otherwise. Done with
+/// bitwise operations so that no branch is emitted.
+/// </summary>
+template <typename T>
+DY_KERNEL_INLINE T select(uint64_t bit, T val, T other) noexcept
+{
+    uint64_t mask = uint64_t(0) - bit;
+    return bit_cast<T>((bit_cast<uint64_t>(val) & mask)
+                       | (bit_cast<uint64_t>(other) & ~mask));
+}
+
+/// <summary>
+/// reduces the integers
+/// </summary>
+/// <param name="init">the identity of the operation</param>
+template <typename Op>
+DY_KERNEL_INLINE int64_t
+reduce(int64_t const* ptr, size_t len, int64_t init, Op op) noexcept
+{
+    int64_t acc[lanes];
+    for (size_t j = 0; j < lanes; ++j) acc[j] = init;
+
+    size_t i = 0;
+    for (; i + lanes <= len; i += lanes)
+        for (size_t j = 0; j < lanes; ++j) acc[j] = op(acc[j], ptr[i + j]);
+    for (; i < len; ++i) acc[0] = op(acc[0], ptr[i]);
+
+    for (size_t j = 1; j < lanes; ++j) acc[0] = op(acc[0], acc[j]);
+    return acc[0];
+}
+
+/// <summary>
+/// reduces the integers of which the bits in the mask are set
+/// </summary>
+/// <param name="init">the identity of the operation</param>
+template <typename Op>
+DY_KERNEL_INLINE int64_t reduce_masked(int64_t const*  ptr,
+                                       uint64_t const* mask,
+                                       size_t          len,
+                                       int64_t         init,
+                                       Op              op) noexcept
+{
+    int64_t acc[lanes];
+    for (size_t j = 0; j < lanes; ++j) acc[j] = init;
+
+    size_t i = 0;
+    for (; i + word_bits <= len; i += word_bits)
+    {
+        uint64_t bits = mask[i / word_bits];
+        if (bits == 0) continue;
+
+        for (size_t k = 0; k < word_bits; k += lanes)
+            for (size_t j = 0; j < lanes; ++j)
+            {
+                uint64_t bit = (bits >> (k + j)) & 1;
+                acc[j]       = op(acc[j], select(bit, ptr[i + k + j], init));
+            }
+    }
+    for (; i < len; ++i)
+        if ((mask[i / word_bits] >> (i % word_bits)) & 1)
+            acc[0] = op(acc[0], ptr[i]);
+
+    for (size_t j = 1; j < lanes; ++j) acc[0] = op(acc[0], acc[j]);
+    return acc[0];
+}
+
+/// <summary>
+/// adds the number to the sum, carrying the rounding error in a separate term.
+/// The error is computed exactly with Knuth's TwoSum, which needs no branch
+/// unlike Neumaier's comparison.
+/// </summary>
+/// <param name="sum">the sum</param>
+/// <param name="comp">the compensation term</param>
+/// <param name="val">the number</param>
+DY_KERNEL_INLINE void add_compensated(double& sum,
+                                      double& comp,
+                                      double  val) noexcept
+{
+    double next     = sum + val;
+    double val_part = next - sum;
+    comp += (sum - (next - val_part)) + (val - val_part);
+    sum = next;
+}
+
+/// <summary>
+/// adds up the lanes of the compensated sums
+/// </summary>
+DY_KERNEL_INLINE double finish_compensated(double const* sums,
+                                           double const* comps) noexcept
+{
+    double sum = 0, comp = 0;
+    for (size_t j = 0; j < lanes; ++j) add_compensated(sum, comp, sums[j]);
+    for (size_t j = 0; j < lanes; ++j) comp += comps[j];
+    return sum + comp;
+}
+
+DY_KERNEL_INLINE double sum(double const* ptr, size_t len) noexcept
+{
+    double sums[lanes] = {}, comps[lanes] = {};
+
+    size_t i = 0;
+    for (; i + lanes <= len; i += lanes)
+        for (size_t j = 0; j < lanes; ++j)
+            add_compensated(sums[j], comps[j], ptr[i + j]);
+    for (; i < len; ++i) add_compensated(sums[0], comps[0], ptr[i]);
+
+    return finish_compensated(sums, comps);
+}
+
+DY_KERNEL_INLINE double
+sum_masked(double const* ptr, uint64_t const* mask, size_t len) noexcept
+{
+    double sums[lanes] = {}, comps[lanes] = {};
+
+    size_t i = 0;
+    for (; i + word_bits <= len; i += word_bits)
+    {
+        uint64_t bits = mask[i / word_bits];
+        if (bits == 0) continue;
+
+        // zeroes the invalid numbers first, as the sums do not vectorize with
+        // the selection in the same loop
+        double        vals[word_bits];
+        double const* src = ptr + i;
+        if (bits != ~uint64_t(0))
+        {
+            for (size_t k = 0; k < word_bits; ++k)
+                vals[k] = select((bits >> k) & 1, src[k], 0.0);
+            src = vals;
+        }
+
+        for (size_t k = 0; k < word_bits; k += lanes)
+            for (size_t j = 0; j < lanes; ++j)
+                add_compensated(sums[j], comps[j], src[k + j]);
+    }
+    for (; i < len; ++i)
+        if ((mask[i / word_bits] >> (i % word_bits)) & 1)
+            add_compensated(sums[0], comps[0], ptr[i]);
+
+    return finish_compensated(sums, comps);
+}
+
+DY_KERNEL_INLINE double
+dot(double const* lhs, double const* rhs, size_t len) noexcept
+{
+    double acc[lanes] = {};
+
+    size_t i = 0;
+    for (; i + lanes <= len; i += lanes)
+        for (size_t j = 0; j < lanes; ++j) acc[j] += lhs[i + j] * rhs[i + j];
+    for (; i < len; ++i) acc[0] += lhs[i] * rhs[i];
+
+    double result = 0;
+    for (size_t j = 0; j < lanes; ++j) result += acc[j];
+    return result;
+}
+
+DY_KERNEL_INLINE double dot_masked(double const*   lhs,
+                                   double const*   rhs,
+                                   uint64_t const* mask,
+                                   size_t          len) noexcept
+{
+    double acc[lanes] = {};
+
+    size_t i = 0;
+    for (; i + word_bits <= len; i += word_bits)
+    {
+        uint64_t bits = mask[i / word_bits];
+        if (bits == 0) continue;
+
+        for (size_t k = 0; k < word_bits; k += lanes)
+            for (size_t j = 0; j < lanes; ++j)
+            {
+                uint64_t bit     = (bits >> (k + j)) & 1;
+                double   product = lhs[i + k + j] * rhs[i + k + j];
+                acc[j] += select(bit, product, 0.0);
+            }
+    }
+    for (; i < len; ++i)
+        if ((mask[i / word_bits] >> (i % word_bits)) & 1)
+            acc[0] += lhs[i] * rhs[i];
+
+    double result = 0;
+    for (size_t j = 0; j < lanes; ++j) result += acc[j];
+    return result;
+}
+
+template <typename T>
+DY_KERNEL_INLINE void prefix_sum(T const* ptr, T* out, size_t len) noexcept
+{
+    // each sum depends on the previous one, so this stays sequential
+    T acc = 0;
+    for (size_t i = 0; i < len; ++i)
+    {
+        if constexpr (is_same_v<T, int64_t>) acc = add_op {}(acc, ptr[i]);
+        else
+            acc += ptr[i];
+        out[i] = acc;
+    }
+}
+
+/// <summary>
+/// converts a number, clamping it to the range of the type
+/// </summary>
+template <typename From, typename To>
+DY_KERNEL_INLINE To convert_one(From val) noexcept
+{
+    using limits = numeric_limits<To>;
+
+    if constexpr (is_floating_point_v<To>)
+    {
+        return static_cast<To>(val);
+    }
+    else if constexpr (is_integral_v<From>)
+    {
+        // every integer type here fits in 64-bit integers, and the bounds
+        // which cannot be exceeded are folded away
+        int64_t wide = val;
+        wide         = wide < int64_t(limits::min()) ? limits::min() : wide;
+        wide         = wide > int64_t(limits::max()) ? limits::max() : wide;
+        return static_cast<To>(wide);
+    }
+    else
+    {
+        // 2^63 is the first number out of the range of 64-bit integers, and
+        // the bounds of narrower integers are exact in double precision
+        double wide = val == val ? val : 0;
+        if constexpr (sizeof(To) == 8)
+        {
+            if (wide >= 0x1p63) return limits::max();
+            if (wide < -0x1p63) return limits::min();
+            return static_cast<To>(wide);
+        }
+        else
+        {
+            wide = wide < double(limits::min()) ? limits::min() : wide;
+            wide = wide > double(limits::max()) ? limits::max() : wide;
+            return static_cast<To>(wide);
+        }
+    }
+}
+
+template <typename From, typename To>
+DY_KERNEL_INLINE void convert(void const* ptr, void* out, size_t len) noexcept
+{
+    From const* in  = static_cast<From const*>(ptr);
+    To*         dst = static_cast<To*>(out);
+    for (size_t i = 0; i < len; ++i) dst[i] = convert_one<From, To>(in[i]);
+}
+
+template <typename Converter, typename... Ts>
+struct convert_table_builder
+{
+    template <typename From>
+    static constexpr array<dy::convert_fn, sizeof...(Ts)> row() noexcept
+    {
+        return { &Converter::template run<From, Ts>... };
+    }
+
+    static constexpr dy::convert_table build() noexcept
+    {
+        static_assert(sizeof...(Ts) == dy::elem_type_count);
+        return { row<Ts>()... };
+    }
+};
+
+/// <summary>
+/// makes the table of the conversions for every pair of the entry types
+/// </summary>
+template <typename Converter>
+constexpr dy::convert_table make_convert_table() noexcept
+{
+    // in the order of dy::elem_type
+    return convert_table_builder<Converter,
+                                 uint8_t,
+                                 int8_t,
+                                 int16_t,
+                                 int32_t,
+                                 uint32_t,
+                                 int64_t,
+                                 float,
+                                 double>::build();
+}
+
+// JSON text is scanned 64 bytes at a time as in simdjson. Each block is
+// classified into bit masks with the widest comparisons available, and the
+// rest works on the masks with scalar instructions: escaped characters come
+// from the runs of backslashes, the insides of strings from the prefix xor of
+// the unescaped quotes, and the values other than strings, arrays and maps
+// start where a run of characters of no other class does.
+
+/// <summary>
+/// the bits of a block of 64 bytes of JSON text which are set for the bytes
+/// of each class
+/// </summary>
+struct json_block
+{
+    uint64_t backslash;
+    uint64_t quote;
+    uint64_t space;
+    uint64_t op;
+    uint64_t non_ascii;
+};
+
+#if DY_KERNELS_X86
+
+/// <summary>
+/// returns the bits set for the bytes equal to the character
+/// </summary>
+DY_KERNEL_INLINE uint64_t eq_sse2(__m128i bytes, char c) noexcept
+{
+    return static_cast<uint16_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(c))));
+}
+
+DY_KERNEL_INLINE json_block classify_sse2(char const* ptr) noexcept
+{
+    json_block block {};
+    for (size_t i = 0; i < 64; i += 16)
+    {
+        __m128i bytes
+            = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr + i));
+
+        // brackets and braces differ in 0x20 only
+        __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+
+        block.backslash |= eq_sse2(bytes, '\\') << i;
+        block.quote |= eq_sse2(bytes, '"') << i;
+        block.space |= (eq_sse2(bytes, ' ') | eq_sse2(bytes, '\t')
+                        | eq_sse2(bytes, '\n') | eq_sse2(bytes, '\r'))
+                       << i;
+        block.op |= (eq_sse2(folded, '{') | eq_sse2(folded, '}')
+                     | eq_sse2(bytes, ':') | eq_sse2(bytes, ','))
+                    << i;
+        block.non_ascii |= uint64_t(uint16_t(_mm_movemask_epi8(bytes))) << i;
+    }
+    return block;
+}
+
+__attribute__((target("avx2"))) DY_KERNEL_INLINE uint64_t
+eq_avx2(__m256i bytes, char c) noexcept
+{
+    return static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(c))));
+}
+
+__attribute__((target("avx2"))) DY_KERNEL_INLINE json_block
+classify_avx2(char const* ptr) noexcept
+{
+    json_block block {};
+    for (size_t i = 0; i < 64; i += 32)
+    {
+        __m256i bytes
+            = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr + i));
+        __m256i folded = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+
+        block.backslash |= eq_avx2(bytes, '\\') << i;
+        block.quote |= eq_avx2(bytes, '"') << i;
+        block.space |= (eq_avx2(bytes, ' ') | eq_avx2(bytes, '\t')
+                        | eq_avx2(bytes, '\n') | eq_avx2(bytes, '\r'))
+                       << i;
+        block.op |= (eq_avx2(folded, '{') | eq_avx2(folded, '}')
+                     | eq_avx2(bytes, ':') | eq_avx2(bytes, ','))
+                    << i;
+        block.non_ascii |= uint64_t(uint32_t(_mm256_movemask_epi8(bytes)))
+                           << i;
+    }
+    return block;
+}
+
+#else
+
+DY_KERNEL_INLINE json_block classify_scalar(char const* ptr) noexcept
+{
+    json_block block {};
+    for (size_t i = 0; i < 64; ++i)
+    {
+        uint64_t bit = uint64_t(1) << i;
+        switch (ptr[i])
+        {
+        case '\\': block.backslash |= bit; break;
+        case '"': block.quote |= bit; break;
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r': block.space |= bit; break;
+        case '[':
+        case ']':
+        case '{':
+        case '}':
+        case ':':
+        case ',': block.op |= bit; break;
+        default:
+            if (static_cast<unsigned char>(ptr[i]) >= 0x80)
+                block.non_ascii |= bit;
+            break;
+        }
+    }
+    return block;
+}
+
+#endif
+
+/// <summary>
+/// sets each bit to the xor of itself and the bits below it
+/// </summary>
+DY_KERNEL_INLINE uint64_t prefix_xor(uint64_t bits) noexcept
+{
+    for (int shift = 1; shift < 64; shift *= 2) bits ^= bits << shift;
+    return bits;
+}
+
+template <typename Classify>
+DY_KERNEL_INLINE size_t json_index(char const* ptr,
+                                   size_t      len,
+                                   uint32_t*   out,
+                                   size_t*     ascii_len,
+                                   Classify    classify) noexcept
+{
+    constexpr uint64_t even_bits = UINT64_C(0x5555555555555555);
+
+    // the states carried over from the previous block
+    uint64_t escaped_next = 0, in_string_prev = 0, scalar_prev = 0;
+
+    size_t count = 0;
+    *ascii_len   = len;
+    for (size_t base = 0; base < len; base += 64)
+    {
+        json_block block;
+        if (len - base >= 64) block = classify(ptr + base);
+        else
+        {
+            // pads the last block with spaces
+            char tail[64];
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, ptr + base, len - base);
+            block = classify(tail);
+        }
+
+        if (block.non_ascii != 0 && *ascii_len == len) *ascii_len = base;
+
+        // a backslash escapes the next character unless it is escaped itself,
+        // so the characters after the odd runs of backslashes are escaped
+        uint64_t backslash  = block.backslash & ~escaped_next;
+        uint64_t follows    = backslash << 1 | escaped_next;
+        uint64_t odd_starts = backslash & ~even_bits & ~follows;
+        uint64_t even_runs  = odd_starts + backslash;
+        escaped_next        = even_runs < odd_starts;
+        uint64_t escaped    = (even_bits ^ (even_runs << 1)) & follows;
+
+        // the opening quotes are inside the strings and the closing ones are
+        // not
+        uint64_t quote     = block.quote & ~escaped;
+        uint64_t in_string = prefix_xor(quote) ^ in_string_prev;
+        in_string_prev     = uint64_t(int64_t(in_string) >> 63);
+
+        uint64_t outside = ~in_string;
+        uint64_t scalar  = ~(block.op | block.space | quote) & outside;
+        uint64_t starts  = scalar & ~(scalar << 1 | scalar_prev);
+        scalar_prev      = scalar >> 63;
+
+        uint64_t structural
+            = (block.op & outside) | (quote & in_string) | starts;
+        for (; structural != 0; structural &= structural - 1)
+            out[count++]
+                = static_cast<uint32_t>(base + countr_zero(structural));
+    }
+    return count;
+}
+
+/// <summary>
+/// checks whether the character must be escaped in JSON strings
+/// </summary>
+DY_KERNEL_INLINE bool needs_escape(char c) noexcept
+{
+    return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+}
+
+#if DY_KERNELS_X86
+
+DY_KERNEL_INLINE size_t escape_len_sse2(char const* ptr, size_t len) noexcept
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i bytes
+            = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr + i));
+
+        // the control characters are the bytes not above 0x1f
+        __m128i control
+            = _mm_cmpeq_epi8(_mm_min_epu8(bytes, _mm_set1_epi8(0x1f)), bytes);
+        uint32_t mask = eq_sse2(bytes, '"') | eq_sse2(bytes, '\\')
+                        | static_cast<uint16_t>(_mm_movemask_epi8(control));
+        if (mask != 0) return i + countr_zero(mask);
+    }
+    while (i < len && !needs_escape(ptr[i])) ++i;
+    return i;
+}
+
+__attribute__((target("avx2"))) DY_KERNEL_INLINE size_t
+escape_len_avx2(char const* ptr, size_t len) noexcept
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i bytes
+            = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr + i));
+        __m256i control = _mm256_cmpeq_epi8(
+            _mm256_min_epu8(bytes, _mm256_set1_epi8(0x1f)), bytes);
+        uint64_t mask = eq_avx2(bytes, '"') | eq_avx2(bytes, '\\')
+                        | static_cast<uint32_t>(_mm256_movemask_epi8(control));
+        if (mask != 0) return i + countr_zero(mask);
+    }
+    return i + escape_len_sse2(ptr + i, len - i);
+}
+
+#else
+
+DY_KERNEL_INLINE size_t escape_len_scalar(char const* ptr, size_t len) noexcept
+{
+    size_t i = 0;
+    while (i < len && !needs_escape(ptr[i])) ++i;
+    return i;
+}
+
+#endif
+
+}
+
+#define DY_KERNELS(isa, attr, classify, escape_len)                            \
+    namespace isa                                                              \
+    {                                                                          \
+    attr int64_t iarr_sum(int64_t const* ptr, size_t len) noexcept             \
+    {                                                                          \
+        return reduce(ptr, len, 0, add_op {});                                 \
+    }                                                                          \
+                                                                               \
+    attr int64_t iarr_min(int64_t const* ptr, size_t len) noexcept             \
+    {                                                                          \
+        return reduce(ptr, len, INT64_MAX, min_op {});                         \
+    }                                                                          \
+                                                                               \
+    attr int64_t iarr_max(int64_t const* ptr, size_t len) noexcept             \
+    {                                                                          \
+        return reduce(ptr, len, INT64_MIN, max_op {});                         \
+    }                                                                          \
+                                                                               \
+    attr int64_t iarr_sum_masked(                                              \
+        int64_t const* ptr, uint64_t const* mask, size_t len) noexcept         \
+    {                                                                          \
+        return reduce_masked(ptr, mask, len, 0, add_op {});                    \
+    }                                                                          \
+                                                                               \
+    attr int64_t iarr_min_masked(                                              \
+        int64_t const* ptr, uint64_t const* mask, size_t len) noexcept         \
+    {                                                                          \
+        return reduce_masked(ptr, mask, len, INT64_MAX, min_op {});            \
+    }                                                                          \
+                                                                               \
+    attr int64_t iarr_max_masked(                                              \
+        int64_t const* ptr, uint64_t const* mask, size_t len) noexcept         \
+    {                                                                          \
+        return reduce_masked(ptr, mask, len, INT64_MIN, max_op {});            \
+    }                                                                          \
+                                                                               \
+    attr void iarr_prefix_sum(                                                 \
+        int64_t const* ptr, int64_t* out, size_t len) noexcept                 \
+    {                                                                          \
+        prefix_sum(ptr, out, len);                                             \
+    }                                                                          \
+                                                                               \
+    attr double farr_sum(double const* ptr, size_t len) noexcept               \
+    {                                                                          \
+        return sum(ptr, len);                                                  \
+    }                                                                          \
+                                                                               \
+    attr double farr_sum_masked(                                               \
+        double const* ptr, uint64_t const* mask, size_t len) noexcept          \
+    {                                                                          \
+        return sum_masked(ptr, mask, len);                                     \
+    }                                                                          \
+                                                                               \
+    attr double farr_dot(                                                      \
+        double const* lhs, double const* rhs, size_t len) noexcept             \
+    {                                                                          \
+        return dot(lhs, rhs, len);                                             \
+    }                                                                          \
+                                                                               \
+    attr double farr_dot_masked(double const*   lhs,                           \
+                                double const*   rhs,                           \
+                                uint64_t const* mask,                          \
+                                size_t          len) noexcept                  \
+    {                                                                          \
+        return dot_masked(lhs, rhs, mask, len);                                \
+    }                                                                          \
+                                                                               \
+    attr void farr_prefix_sum(double const* ptr, double* out, size_t len)      \
+        noexcept                                                               \
+    {                                                                          \
+        prefix_sum(ptr, out, len);                                             \
+    }                                                                          \
+                                                                               \
+    struct converter                                                           \
+    {                                                                          \
+        template <typename From, typename To>                                  \
+        attr static void run(void const* ptr, void* out, size_t len) noexcept  \
+        {                                                                      \
+            convert<From, To>(ptr, out, len);                                  \
+        }                                                                      \
+    };                                                                         \
+                                                                               \
+    attr size_t json_index(                                                    \
+        char const* ptr, size_t len, uint32_t* out, size_t* ascii_len)         \
+        noexcept                                                               \
+    {                                                                          \
+        return ::json_index(ptr, len, out, ascii_len, classify);               \
+    }                                                                          \
+                                                                               \
+    attr size_t json_escape_len(char const* ptr, size_t len) noexcept         \
+    {                                                                          \
+        return escape_len(ptr, len);                                           \
+    }                                                                          \
+                                                                               \
+    constexpr dy::kernel_table table {                                         \
+        #isa,                                                                  \
+        iarr_sum,                                                              \
+        iarr_min,                                                              \
+        iarr_max,                                                              \
+        iarr_sum_masked,                                                       \
+        iarr_min_masked,                                                       \
+        iarr_max_masked,                                                       \
+        iarr_prefix_sum,                                                       \
+        farr_sum,                                                              \
+        farr_sum_masked,                                                       \
+        farr_dot,                                                              \
+        farr_dot_masked,                                                       \
+        farr_prefix_sum,                                                       \
+        make_convert_table<converter>(),                                       \
+        json_index,                                                            \
+        json_escape_len,                                                       \
+    };                                                                         \
+    }
+
+namespace
+{
+
+#if DY_KERNELS_X86
+
+// SSE2 is the baseline of x86-64
+DY_KERNELS(sse2, , classify_sse2, escape_len_sse2)
+DY_KERNELS(avx2,
+           __attribute__((target("avx2"))),
+           classify_avx2,
+           escape_len_avx2)
+DY_KERNELS(avx512,
+           __attribute__((target("avx512f"))),
+           classify_avx2,
+           escape_len_avx2)
+
+/// <summary>
+/// selects the kernels for the processor
+/// </summary>
+dy::kernel_table const& select_kernels() noexcept
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return avx512::table;
+    if (__builtin_cpu_supports("avx2")) return avx2::table;
+    return sse2::table;
+}
+
+#else
+
+DY_KERNELS(scalar, , classify_scalar, escape_len_scalar)
+
+/// <summary>
+/// selects the kernels for the processor
+/// </summary>
+dy::kernel_table const& select_kernels() noexcept
+{
+    return scalar::table;
+}
+
+#endif
+
+}
+
+dy::kernel_table const& dy::kernels() noexcept
+{
+    static kernel_table const& table = select_kernels();
+    return table;
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <key.p.hh>
+#include <map.p.hh>
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+using namespace std;
+
+namespace
+{
+
+constexpr size_t shard_bits     = 6;
+constexpr size_t shard_count    = size_t(1) << shard_bits;
+constexpr size_t min_capacity   = 64;
+constexpr size_t min_chunk_size = 4096;
+
+/// <summary>
+/// a part of the intern table selected by the top bits of the hashes, so that
+/// threads interning different keys rarely wait for each other
+/// </summary>
+struct shard
+{
+    mutex mtx;
+
+    /// <summary>
+    /// an open-addressing table of the keys probed linearly
+    /// </summary>
+    _dy_key_t** slots;
+    size_t      capacity;
+    size_t      size;
+
+    /// <summary>
+    /// the free space of the chunk the keys are stored in
+    /// </summary>
+    char* cur;
+    char* end;
+};
+
+shard shards[shard_count];
+
+/// <summary>
+/// allocates memory that is never freed
+/// </summary>
+void* allocate(size_t bytes)
+{
+    void* ptr = calloc(1, bytes);
+    if (ptr == nullptr) throw bad_alloc();
+    return ptr;
+}
+
+/// <summary>
+/// doubles the table of the shard
+/// </summary>
+void grow(shard& s)
+{
+    size_t capacity = s.capacity != 0 ? s.capacity * 2 : min_capacity;
+    auto   slots
+        = static_cast<_dy_key_t**>(allocate(capacity * sizeof(_dy_key_t*)));
+
+    for (size_t i = 0; i < s.capacity; ++i)
+    {
+        _dy_key_t* key = s.slots[i];
+        if (key == nullptr) continue;
+
+        size_t pos = key->hash & (capacity - 1);
+        while (slots[pos] != nullptr) pos = (pos + 1) & (capacity - 1);
+        slots[pos] = key;
+    }
+
+    free(s.slots);
+    s.slots    = slots;
+    s.capacity = capacity;
+}
+
+/// <summary>
+/// copies the key to the chunk of the shard
+/// </summary>
+_dy_key_t* store(shard& s, char const* key, size_t len, uint64_t hash)
+{
+    size_t size = sizeof(_dy_key_t) + len + 1;
+    size        = (size + alignof(_dy_key_t) - 1) & ~(alignof(_dy_key_t) - 1);
+
+    if (static_cast<size_t>(s.end - s.cur) < size)
+    {
+        // keys larger than a chunk get a chunk of their own
+        size_t chunk_size = size > min_chunk_size ? size : min_chunk_size;
+        s.cur             = static_cast<char*>(allocate(chunk_size));
+        s.end             = s.cur + chunk_size;
+    }
+
+    auto stored = new (s.cur) _dy_key_t { .hash = hash, .len = uint32_t(len) };
+    // the empty key may be null
+    if (len != 0) memcpy(const_cast<char*>(stored->data()), key, len);
+    s.cur += size;
+    return stored;
+}
+
+}
+
+DY_PUBLIC(dy_key_t) dy_intern_key(char const* key, size_t len) DY_NOEXCEPT
+{
+    assert(key != nullptr || len == 0);
+    assert(len <= UINT32_MAX);
+
+    uint64_t   hash = dy::hash_bytes(key, len);
+    shard&     s    = shards[hash >> (64 - shard_bits)];
+    lock_guard lock(s.mtx);
+
+    if (s.capacity != 0)
+    {
+        for (size_t pos = hash & (s.capacity - 1);;
+             pos        = (pos + 1) & (s.capacity - 1))
+        {
+            _dy_key_t* stored = s.slots[pos];
+            if (stored == nullptr) break;
+            if (stored->hash == hash && stored->len == len
+                && (len == 0 || memcmp(stored->data(), key, len) == 0))
+                return stored;
+        }
+    }
+
+    // keeps the load factor at most 1/2
+    if ((s.size + 1) * 2 > s.capacity) grow(s);
+
+    _dy_key_t* stored = store(s, key, len, hash);
+    size_t     pos    = hash & (s.capacity - 1);
+    while (s.slots[pos] != nullptr) pos = (pos + 1) & (s.capacity - 1);
+    s.slots[pos] = stored;
+    ++s.size;
+
+    return stored;
+}
+
+DY_PUBLIC(char const*) dy_get_key_data(dy_key_t key) DY_NOEXCEPT
+{
+    assert(key != nullptr);
+    return key->data();
+}
+
+DY_PUBLIC(size_t) dy_get_key_len(dy_key_t key) DY_NOEXCEPT
+{
+    assert(key != nullptr);
+    return key->len;
+}
+
+DY_PUBLIC(uint64_t) dy_get_key_hash(dy_key_t key) DY_NOEXCEPT
+{
+    assert(key != nullptr);
+    return key->hash;
+}
@@ -0,0 +1,719 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.p.hh>
+#include <map.p.hh>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <utility>
+
+using namespace std;
+
+namespace
+{
+
+constexpr int8_t ctrl_empty = -128;
+
+// the index of a shape promoted from the small mode holds at least
+// small_max + 1 keys within the load factor of 7/8
+constexpr size_t min_capacity   = _dy_shape_t::group_width * 2;
+constexpr size_t min_chunk_size = 256;
+
+static_assert((_dy_shape_t::small_max + 1) * 8 <= min_capacity * 7);
+
+/// <summary>
+/// a group of control bytes
+/// </summary>
+class group
+{
+  public:
+    explicit group(int8_t const* ctrl) noexcept
+    {
+#if DY_SSE2
+        ctrl_ = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ctrl));
+#else
+        memcpy(ctrl_, ctrl, sizeof(ctrl_));
+#endif
+    }
+
+    /// <summary>
+    /// returns the bit mask of the control bytes equal to the given one
+    /// </summary>
+    uint32_t match(int8_t h2) const noexcept
+    {
+#if DY_SSE2
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(h2)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < _dy_shape_t::group_width; ++i)
+            mask |= uint32_t(ctrl_[i] == h2) << i;
+        return mask;
+#endif
+    }
+
+    /// <summary>
+    /// returns the bit mask of the empty control bytes
+    /// </summary>
+    uint32_t match_empty() const noexcept
+    {
+        return match(ctrl_empty);
+    }
+
+  private:
+#if DY_SSE2
+    __m128i ctrl_;
+#else
+    int8_t ctrl_[_dy_shape_t::group_width];
+#endif
+};
+
+/// <summary>
+/// returns the 7 bits of the hash stored in the control bytes
+/// </summary>
+inline int8_t h2(uint32_t hash) noexcept
+{
+    return static_cast<int8_t>(hash & 0x7f);
+}
+
+/// <summary>
+/// returns the bits of the hash selecting the first group to probe
+/// </summary>
+inline size_t h1(uint32_t hash) noexcept
+{
+    return hash >> 7;
+}
+
+/// <summary>
+/// returns the size of the memory block holding the index
+/// </summary>
+inline size_t index_bytes(size_t capacity) noexcept
+{
+    return capacity * sizeof(uint32_t) + capacity + _dy_shape_t::group_width;
+}
+
+/// <summary>
+/// returns the size of the memory block holding the tags and the entries
+/// </summary>
+inline size_t entries_bytes(size_t len) noexcept
+{
+    return _dy_shape_t::small_max + len * sizeof(_dy_shape_t::entry);
+}
+
+/// <summary>
+/// returns the 7 bits of the prefix and the length of the key stored in the
+/// tags of a small shape whose keys are not all interned
+/// </summary>
+inline int8_t small_tag(uint64_t prefix, size_t len) noexcept
+{
+    return static_cast<int8_t>(((prefix ^ len) * UINT64_C(0x9e3779b97f4a7c15))
+                               >> 57);
+}
+
+/// <summary>
+/// compares the keys of the entries with the given one
+/// </summary>
+struct bytes_eq
+{
+    char const* key;
+    size_t      len;
+    uint64_t    prefix;
+
+    bool operator()(_dy_shape_t::entry const& entry) const noexcept
+    {
+        return entry.prefix == prefix && entry.len == len
+               && (len <= 8 || memcmp(entry.key + 8, key + 8, len - 8) == 0);
+    }
+};
+
+}
+
+_dy_shape_t* _dy_shape_t::create(pmr::memory_resource* res) noexcept
+{
+    void* ptr = res->allocate(sizeof(_dy_shape_t), alignof(_dy_shape_t));
+    return new (ptr) _dy_shape_t(res);
+}
+
+_dy_shape_t* _dy_shape_t::create(_dy_shape_t const&    other,
+                                 pmr::memory_resource* res) noexcept
+{
+    _dy_shape_t* copy = create(res);
+    copy->interned_ = other.interned_;
+
+    // interned keys are shared rather than copied
+    size_t key_bytes = 0;
+    if (!other.interned_)
+        for (auto const& entry : other) key_bytes += entry.len + 1;
+
+    if (other.size_ != 0)
+    {
+        copy->grow_entries(other.size_);
+        memcpy(copy->tags(), other.tags(), small_max);
+    }
+    copy->reserve(0, key_bytes);
+
+    for (auto const& entry : other)
+    {
+        char const* key = entry.key;
+        if (!other.interned_) key = copy->store_key(key, entry.len);
+
+        copy->entries_[copy->size_++] = {
+            .prefix = entry.prefix,
+            .len    = entry.len,
+            .hash   = entry.hash,
+            .key    = key,
+        };
+    }
+
+    if (other.capacity_ != 0)
+    {
+        // the hashes and the key indices do not change
+        size_t capacity = other.capacity_;
+        auto   index    = static_cast<char*>(
+            res->allocate(index_bytes(capacity), alignof(uint32_t)));
+        memcpy(index, other.slots_, index_bytes(capacity));
+
+        copy->capacity_ = capacity;
+        copy->slots_    = reinterpret_cast<uint32_t*>(index);
+        copy->ctrl_     = reinterpret_cast<int8_t*>(copy->slots_ + capacity);
+    }
+
+    return copy;
+}
+
+_dy_shape_t::_dy_shape_t(pmr::memory_resource* res) noexcept :
+    res_ { res },
+    refs_ { 1 },
+    size_ { 0 },
+    entries_ { nullptr },
+    entries_cap_ { 0 },
+    interned_ { true },
+    ctrl_ { nullptr },
+    slots_ { nullptr },
+    capacity_ { 0 },
+    chunks_ { nullptr },
+    key_cur_ { nullptr },
+    key_end_ { nullptr }
+{}
+
+_dy_shape_t::~_dy_shape_t() noexcept
+{
+    if (entries_ != nullptr)
+        res_->deallocate(tags(), entries_bytes(entries_cap_), alignof(entry));
+
+    if (slots_ != nullptr)
+        res_->deallocate(slots_, index_bytes(capacity_), alignof(uint32_t));
+
+    for (key_chunk* it = chunks_; it != nullptr;)
+    {
+        key_chunk* next = it->next;
+        res_->deallocate(it, sizeof(key_chunk) + it->size, alignof(key_chunk));
+        it = next;
+    }
+}
+
+void _dy_shape_t::release() noexcept
+{
+    if (refs_.fetch_sub(1, memory_order_acq_rel) != 1) return;
+
+    pmr::memory_resource* res = res_;
+    this->~_dy_shape_t();
+    res->deallocate(this, sizeof(_dy_shape_t), alignof(_dy_shape_t));
+}
+
+void _dy_shape_t::reserve(size_t len, size_t key_bytes) noexcept
+{
+    if (entries_cap_ < size_ + len) grow_entries(size_ + len);
+
+    if (size_ + len > small_max)
+    {
+        size_t capacity = capacity_ != 0 ? capacity_ : min_capacity;
+        while ((size_ + len) * 8 > capacity * 7) capacity *= 2;
+        if (capacity != capacity_) rehash(capacity);
+    }
+
+    if (static_cast<size_t>(key_end_ - key_cur_) < key_bytes)
+    {
+        auto chunk = static_cast<key_chunk*>(res_->allocate(
+            sizeof(key_chunk) + key_bytes, alignof(key_chunk)));
+        chunk->next = chunks_;
+        chunk->size = key_bytes;
+        chunks_     = chunk;
+        key_cur_    = reinterpret_cast<char*>(chunk + 1);
+        key_end_    = key_cur_ + key_bytes;
+    }
+}
+
+bool _dy_shape_t::insert(char const* key, size_t len) noexcept
+{
+    if (capacity_ == 0 && size_ < small_max && !interned_)
+    {
+        if (find(key, len) != npos) return false;
+
+        append(store_key(key, len), len, 0);
+        return true;
+    }
+
+    return insert(key, len, dy::hash_bytes(key, len));
+}
+
+bool _dy_shape_t::insert(char const* key, size_t len, uint64_t hash) noexcept
+{
+    if (find(key, len, hash) != npos) return false;
+
+    clear_interned();
+    append(store_key(key, len), len, dy::fold_hash(hash));
+    return true;
+}
+
+bool _dy_shape_t::insert(dy_key_t key) noexcept
+{
+    if (find(key) != npos) return false;
+
+    append(key->data(), key->len, dy::fold_hash(key->hash));
+    return true;
+}
+
+void _dy_shape_t::erase(size_t idx) noexcept
+{
+    assert(idx < size_);
+
+    memmove(entries_ + idx,
+            entries_ + idx + 1,
+            (size_ - idx - 1) * sizeof(entry));
+    --size_;
+
+    // the key indices after the key change, so the index is rebuilt
+    if (capacity_ != 0)
+        rehash(capacity_);
+    else
+        memmove(tags() + idx, tags() + idx + 1, size_ - idx);
+}
+
+size_t _dy_shape_t::find(char const* key, size_t len) const noexcept
+{
+    // the tags of interned keys are taken from the hashes
+    if (capacity_ != 0 || interned_)
+        return find(key, len, dy::hash_bytes(key, len));
+
+    uint64_t prefix = dy::key_prefix(key, len);
+    return scan(small_tag(prefix, len), bytes_eq { key, len, prefix });
+}
+
+size_t
+_dy_shape_t::find(char const* key, size_t len, uint64_t hash) const noexcept
+{
+    uint64_t prefix = dy::key_prefix(key, len);
+    uint32_t folded = dy::fold_hash(hash);
+    bytes_eq eq { key, len, prefix };
+
+    if (capacity_ != 0) return probe(folded, eq);
+    return scan(interned_ ? h2(folded) : small_tag(prefix, len), eq);
+}
+
+size_t _dy_shape_t::find(dy_key_t key) const noexcept
+{
+    if (!interned_) return find(key->data(), key->len, key->hash);
+
+    // the same interned key has the same address
+    char const* data   = key->data();
+    uint32_t    folded = dy::fold_hash(key->hash);
+    auto        eq = [data](entry const& entry) { return entry.key == data; };
+
+    if (capacity_ != 0) return probe(folded, eq);
+    return scan(h2(folded), eq);
+}
+
+template <typename Eq>
+size_t _dy_shape_t::scan(int8_t tag, Eq eq) const noexcept
+{
+    if (size_ == 0) return npos;
+
+    uint32_t mask = group(tags()).match(tag) & ((uint32_t(1) << size_) - 1);
+    for (; mask != 0; mask &= mask - 1)
+    {
+        size_t idx = countr_zero(mask);
+        if (eq(entries_[idx])) return idx;
+    }
+
+    return npos;
+}
+
+template <typename Eq>
+size_t _dy_shape_t::probe(uint32_t hash, Eq eq) const noexcept
+{
+    size_t mask = capacity_ - 1;
+    size_t pos  = h1(hash) & mask;
+
+    for (size_t step = group_width;; step += group_width)
+    {
+        group g(ctrl_ + pos);
+        for (uint32_t m = g.match(h2(hash)); m != 0; m &= m - 1)
+        {
+            uint32_t     idx   = slots_[(pos + countr_zero(m)) & mask];
+            entry const& entry = entries_[idx];
+            if (entry.hash == hash && eq(entry)) return idx;
+        }
+
+        if (g.match_empty() != 0) return npos;
+        pos = (pos + step) & mask;
+    }
+}
+
+void _dy_shape_t::append(char const* key, size_t len, uint32_t hash) noexcept
+{
+    assert(len <= UINT32_MAX);
+
+    if (size_ == entries_cap_)
+        grow_entries(max<size_t>(entries_cap_ * 2, 4));
+
+    // promotes the shape when it outgrows the small mode
+    if (capacity_ != 0 ? (size_ + 1) * 8 > capacity_ * 7 : size_ == small_max)
+        rehash(max(capacity_ * 2, min_capacity));
+
+    uint64_t prefix = dy::key_prefix(key, len);
+    uint32_t idx    = size_++;
+    entries_[idx]   = {
+        .prefix = prefix,
+        .len    = static_cast<uint32_t>(len),
+        .hash   = hash,
+        .key    = key,
+    };
+
+    if (capacity_ != 0)
+        insert_slot(hash, idx);
+    else
+        tags()[idx] = interned_ ? h2(hash) : small_tag(prefix, len);
+}
+
+char const* _dy_shape_t::store_key(char const* key, size_t len) noexcept
+{
+    if (static_cast<size_t>(key_end_ - key_cur_) < len + 1)
+    {
+        size_t size = max(len + 1, min_chunk_size);
+        if (chunks_ != nullptr) size = max(size, chunks_->size * 2);
+
+        auto chunk = static_cast<key_chunk*>(
+            res_->allocate(sizeof(key_chunk) + size, alignof(key_chunk)));
+        chunk->next = chunks_;
+        chunk->size = size;
+        chunks_     = chunk;
+        key_cur_    = reinterpret_cast<char*>(chunk + 1);
+        key_end_    = key_cur_ + size;
+    }
+
+    char* stored = key_cur_;
+    memcpy(stored, key, len);
+    stored[len] = '\0';
+    key_cur_ += len + 1;
+    return stored;
+}
+
+void _dy_shape_t::clear_interned() noexcept
+{
+    if (!interned_) return;
+    interned_ = false;
+
+    // the tags of the keys which are not interned cannot use the hashes
+    if (capacity_ == 0)
+    {
+        for (uint32_t i = 0; i < size_; ++i)
+            tags()[i] = small_tag(entries_[i].prefix, entries_[i].len);
+    }
+}
+
+void _dy_shape_t::grow_entries(size_t len) noexcept
+{
+    assert(len <= UINT32_MAX);
+
+    auto block = static_cast<char*>(
+        res_->allocate(entries_bytes(len), alignof(entry)));
+    auto entries = reinterpret_cast<entry*>(block + small_max);
+    if (entries_ != nullptr)
+    {
+        memcpy(block, tags(), small_max);
+        memcpy(entries, entries_, size_ * sizeof(entry));
+        res_->deallocate(tags(), entries_bytes(entries_cap_), alignof(entry));
+    }
+
+    entries_     = entries;
+    entries_cap_ = static_cast<uint32_t>(len);
+}
+
+void _dy_shape_t::rehash(size_t capacity) noexcept
+{
+    assert(has_single_bit(capacity) && capacity >= group_width);
+
+    if (slots_ != nullptr)
+        res_->deallocate(slots_, index_bytes(capacity_), alignof(uint32_t));
+    else if (!interned_)
+    {
+        // the keys of a small shape are not hashed yet
+        for (uint32_t i = 0; i < size_; ++i)
+        {
+            entry& entry = entries_[i];
+            entry.hash   = dy::fold_hash(dy::hash_bytes(entry.key, entry.len));
+        }
+    }
+
+    auto index = static_cast<char*>(
+        res_->allocate(index_bytes(capacity), alignof(uint32_t)));
+
+    capacity_ = capacity;
+    slots_    = reinterpret_cast<uint32_t*>(index);
+    ctrl_     = reinterpret_cast<int8_t*>(slots_ + capacity);
+    memset(ctrl_, static_cast<uint8_t>(ctrl_empty), capacity + group_width);
+
+    for (uint32_t i = 0; i < size_; ++i) insert_slot(entries_[i].hash, i);
+}
+
+void _dy_shape_t::insert_slot(uint32_t hash, uint32_t idx) noexcept
+{
+    size_t mask = capacity_ - 1;
+    size_t pos  = h1(hash) & mask;
+
+    for (size_t step = group_width;; step += group_width)
+    {
+        if (uint32_t m = group(ctrl_ + pos).match_empty(); m != 0)
+        {
+            size_t slot  = (pos + countr_zero(m)) & mask;
+            ctrl_[slot]  = h2(hash);
+            slots_[slot] = idx;
+
+            // mirrors the first group after the last control byte
+            if (slot < group_width) ctrl_[capacity_ + slot] = h2(hash);
+            return;
+        }
+
+        pos = (pos + step) & mask;
+    }
+}
+
+dy::map::map(dy::shape*            shape,
+             dy_t*                 values,
+             pmr::memory_resource* res) noexcept :
+    shape_ { shape },
+    values_ { values },
+    res_ { res },
+    capacity_ { shape->size() }
+{}
+
+dy::map::map(map const& other, pmr::memory_resource* res) noexcept :
+    shape_ { other.shape_ },
+    values_ { nullptr },
+    res_ { res },
+    capacity_ { other.size() }
+{
+    // maps on the heap cannot hold a reference to a shape in an arena
+    if (res == heap() && shape_->resource() == heap())
+        shape_->retain();
+    else
+        shape_ = dy::shape::create(*other.shape_, res);
+
+    size_t len = size();
+    values_    = static_cast<dy_t*>(
+        res->allocate(len * sizeof(dy_t), alignof(dy_t)));
+    copy(other.values_, other.values_ + len, values_);
+}
+
+dy::map::map(map&& other) noexcept :
+    shape_ { exchange(other.shape_, nullptr) },
+    values_ { exchange(other.values_, nullptr) },
+    res_ { other.res_ },
+    capacity_ { exchange(other.capacity_, 0) }
+{}
+
+dy::map::~map() noexcept
+{
+    if (shape_ == nullptr) return;
+
+    res_->deallocate(values_, capacity_ * sizeof(dy_t), alignof(dy_t));
+    shape_->release();
+}
+
+void dy::map::reserve(size_t len) noexcept
+{
+    own_shape();
+    shape_->reserve(len);
+    grow(len);
+}
+
+dy_t dy::map::set(char const* key, size_t len, dy_t val) noexcept
+{
+    size_t idx = shape_->find(key, len);
+    if (idx != shape::npos) return exchange(values_[idx], val);
+
+    own_shape();
+    grow(1);
+    shape_->insert(key, len);
+    values_[size() - 1] = val;
+    return nullptr;
+}
+
+dy_t dy::map::erase(char const* key, size_t len) noexcept
+{
+    size_t idx = shape_->find(key, len);
+    if (idx == shape::npos) return nullptr;
+
+    own_shape();
+    dy_t val = values_[idx];
+    shape_->erase(idx);
+    move(values_ + idx + 1, values_ + size() + 1, values_ + idx);
+    return val;
+}
+
+bool dy::map::add(char const* key, size_t len, dy_t val) noexcept
+{
+    own_shape();
+    grow(1);
+    if (!shape_->insert(key, len)) return false;
+
+    values_[size() - 1] = val;
+    return true;
+}
+
+void dy::map::truncate(size_t len) noexcept
+{
+    assert(len <= size());
+
+    dy::shape* copy = dy::shape::create(res_);
+    copy->reserve(len);
+    for (size_t i = 0; i < len; ++i)
+        copy->insert(shape_->begin()[i].key, shape_->begin()[i].len);
+
+    shape_->release();
+    shape_ = copy;
+}
+
+void dy::map::share_shape() noexcept
+{
+    assert(res_ == heap());
+
+    if (dy::shape* cached = find_cached_shape(*shape_))
+    {
+        shape_->release();
+        shape_ = cached;
+    }
+    else
+        cache_shape(shape_);
+}
+
+void dy::map::own_shape() noexcept
+{
+    if (!shape_->shared() && shape_->resource() == res_) return;
+
+    dy::shape* copy = dy::shape::create(*shape_, res_);
+    shape_->release();
+    shape_ = copy;
+}
+
+void dy::map::grow(size_t len) noexcept
+{
+    size_t size = this->size();
+    if (capacity_ - size >= len) return;
+
+    size_t capacity = max(size + len, capacity_ * 2);
+    auto   values   = static_cast<dy_t*>(
+        res_->allocate(capacity * sizeof(dy_t), alignof(dy_t)));
+    // the values of an empty map may be null
+    if (size != 0) copy(values_, values_ + size, values);
+    res_->deallocate(values_, capacity_ * sizeof(dy_t), alignof(dy_t));
+
+    values_   = values;
+    capacity_ = capacity;
+}
+
+namespace
+{
+
+/// <summary>
+/// the shapes recently used by a thread, the most recent first
+/// </summary>
+class shape_cache
+{
+  public:
+    static constexpr size_t capacity = 8;
+
+    ~shape_cache() noexcept
+    {
+        for (auto shape : shapes_)
+            if (shape != nullptr) shape->release();
+    }
+
+    /// <summary>
+    /// finds the shape of the given length whose keys satisfy the predicate,
+    /// and moves it to the front
+    /// </summary>
+    template <typename Eq>
+    dy::shape* find(size_t len, Eq eq) noexcept
+    {
+        for (size_t i = 0; i < capacity && shapes_[i] != nullptr; ++i)
+        {
+            dy::shape* shape = shapes_[i];
+            if (shape->size() != len) continue;
+
+            size_t j = 0;
+            while (j < len && eq(shape->begin()[j], j)) ++j;
+            if (j != len) continue;
+
+            move_backward(shapes_, shapes_ + i, shapes_ + i + 1);
+            shapes_[0] = shape;
+            shape->retain();
+            return shape;
+        }
+
+        return nullptr;
+    }
+
+    /// <summary>
+    /// adds a shape to the front, evicting the least recent one
+    /// </summary>
+    void add(dy::shape* shape) noexcept
+    {
+        if (dy::shape* last = shapes_[capacity - 1]) last->release();
+
+        move_backward(shapes_, shapes_ + capacity - 1, shapes_ + capacity);
+        shapes_[0] = shape;
+        shape->retain();
+    }
+
+  private:
+    dy::shape* shapes_[capacity] = {};
+};
+
+thread_local shape_cache cache;
+
+}
+
+dy::shape* dy::find_cached_shape(dy_keyval_t const* ptr, size_t len) noexcept
+{
+    return cache.find(len, [ptr](shape::entry const& entry, size_t i) {
+        char const* key = ptr[i].key;
+        return strlen(key) == entry.len
+               && memcmp(entry.key, key, entry.len) == 0;
+    });
+}
+
+dy::shape*
+dy::find_cached_shape(dy_interned_keyval_t const* ptr, size_t len) noexcept
+{
+    // only shapes of interned keys compare the keys by their addresses
+    return cache.find(len, [ptr](shape::entry const& entry, size_t i) {
+        return entry.key == ptr[i].key->data();
+    });
+}
+
+dy::shape* dy::find_cached_shape(shape const& other) noexcept
+{
+    auto entries = other.begin();
+    return cache.find(other.size(), [entries](auto const& entry, size_t i) {
+        return entry.len == entries[i].len
+               && memcmp(entry.key, entries[i].key, entry.len) == 0;
+    });
+}
+
+void dy::cache_shape(shape* shape) noexcept
+{
+    assert(shape->resource() == heap());
+    cache.add(shape);
+}
@@ -0,0 +1,952 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.p.hh>
+#include <sink.p.hh>
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#    define WIN32_LEAN_AND_MEAN
+#    define NOMINMAX
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+using namespace std;
+
+// A mapped file is a header, the records of the values and the keys, and a
+// footer. Records start at offsets which are multiples of 8 and are padded to
+// them, and offsets count from the start of the file, so the file can be
+// mapped at any address and the entries of typed arrays are aligned. Numbers
+// are in the byte order of the writer, which the header tells.
+//
+//   header  "dymapped", the version (u32), 0x01020304 (u32)
+//   record  the type and the index of the value instance (u64, the type in
+//           the lowest 8 bits), the length (u64), and the payload
+//   key     the characters and a NUL character
+//   footer  the slot of the root (u64), the number of the records (u64),
+//           "dymapped"
+//
+// A slot holds a value as the handles on 64-bit targets do: null, booleans,
+// 48-bit integers and double-precision numbers are in the slot, and the other
+// values are the offsets of their records. The payloads of the records are:
+//
+//   i       the integer (i64), with the length 0
+//   str     the characters and a NUL character
+//   barr    the words holding the bits (u64), with the length in bits
+//   arr     the slots of the entries
+//   map     the capacity of the index (u64), the entries, and the index
+//   others  the entries of the typed arrays
+//
+// The entries of a map are <c>mapped_entry</c>s in the order of the map, and
+// keys are shared by every map having them. The index is an open-addressing
+// table of u32, which are the indices of the entries plus 1 or 0 for the
+// empty ones, probed linearly from the folded hash of the key. Its capacity
+// is a power of two larger than the number of the entries, or 0 for empty
+// maps.
+
+#define DY_DECLTYPE(f) remove_reference_t<decltype(declval<_dy_val_t>().data.f)>
+
+#define DY_MAPPED_NEW(f, bits, ...)                                            \
+    new (arena_.allocate(sizeof(_dy_val_t), alignof(_dy_val_t))) _dy_val_t     \
+    {                                                                          \
+        .type = dy_type_##f, .flags = bits, .data = {                          \
+            .f = __VA_ARGS__                                                   \
+        }                                                                      \
+    }
+
+#define DY_VIEW_HELPER(f)                                                      \
+    case dy_type_##f:                                                          \
+    {                                                                          \
+        using T = DY_DECLTYPE(f)::value_type;                                  \
+        if (len > room / sizeof(T)) return dy_make_null();                     \
+        auto ptr = reinterpret_cast<T*>(const_cast<uint64_t*>(record + 2));    \
+        return DY_MAPPED_NEW(f, view_flags, DY_DECLTYPE(f)(ptr, len, 0, 0));   \
+    }
+
+namespace
+{
+
+constexpr char     magic[8]      = { 'd', 'y', 'm', 'a', 'p', 'p', 'e', 'd' };
+constexpr uint32_t version       = 1;
+constexpr uint32_t byte_order    = 0x01020304;
+constexpr size_t   header_size   = 16;
+constexpr size_t   footer_size   = 24;
+constexpr size_t   record_header = 16;
+
+// slots are the handles of the values on 64-bit targets
+constexpr uint64_t slot_null          = 0x1;
+constexpr uint64_t slot_false         = 0x2;
+constexpr uint64_t slot_true          = 0x3;
+constexpr uint64_t slot_double_offset = uint64_t(1) << 48;
+constexpr uint64_t slot_int_tag       = uint64_t(0xffff) << 48;
+constexpr int64_t  slot_int_min       = -(int64_t(1) << 47);
+constexpr int64_t  slot_int_max       = (int64_t(1) << 47) - 1;
+
+#if DY_NANBOX
+static_assert(slot_null == dy::imm_null && slot_true == dy::imm_true);
+static_assert(slot_double_offset == dy::imm_double_offset);
+static_assert(slot_int_tag == dy::imm_int_tag);
+#endif
+
+/// <summary>
+/// an entry of a map in a mapped file
+/// </summary>
+struct mapped_entry
+{
+    /// <summary>
+    /// the offset of the key
+    /// </summary>
+    uint64_t key;
+
+    /// <summary>
+    /// the slot of the value
+    /// </summary>
+    uint64_t slot;
+
+    /// <summary>
+    /// the length of the key
+    /// </summary>
+    uint32_t len;
+
+    /// <summary>
+    /// the result of <c>dy::fold_hash</c> on the hash of the key
+    /// </summary>
+    uint32_t hash;
+};
+
+static_assert(sizeof(mapped_entry) == 24);
+
+/// <summary>
+/// the header of a mapped file
+/// </summary>
+struct file_header
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+};
+
+/// <summary>
+/// the footer of a mapped file
+/// </summary>
+struct file_footer
+{
+    uint64_t root;
+    uint64_t records;
+    char     magic[8];
+};
+
+static_assert(sizeof(file_header) == header_size);
+static_assert(sizeof(file_footer) == footer_size);
+
+/// <summary>
+/// checks whether the slot is the offset of a record
+/// </summary>
+inline bool is_offset(uint64_t slot) noexcept
+{
+    return (slot & (slot_int_tag | 0x7)) == 0;
+}
+
+/// <summary>
+/// writes values in the mapped format. The records of the entries are written
+/// before the records of their arrays and maps, so that every offset is known
+/// when it is written.
+/// </summary>
+class writer
+{
+  public:
+    writer(dy_write_fn_t write_fn, void* ctx) noexcept :
+        sink_ { write_fn, ctx }
+    {}
+
+    writer(writer const&) = delete;
+
+    bool write(dy_t val) noexcept
+    {
+        file_header header;
+        memcpy(header.magic, magic, sizeof(magic));
+        header.version    = version;
+        header.byte_order = byte_order;
+        append(&header, sizeof(header));
+
+        file_footer footer;
+        footer.root    = write_value(val);
+        footer.records = records_;
+        memcpy(footer.magic, magic, sizeof(magic));
+        append(&footer, sizeof(footer));
+
+        sink_.flush();
+        return sink_.ok();
+    }
+
+  private:
+    dy::sink sink_;
+    uint64_t offset_  = 0;
+    uint64_t records_ = 0;
+
+    /// <summary>
+    /// the offsets of the keys written
+    /// </summary>
+    unordered_map<string_view, uint64_t> keys_;
+
+    /// <summary>
+    /// the slots of the entries of the open arrays
+    /// </summary>
+    vector<uint64_t> slots_;
+
+    /// <summary>
+    /// the entries of the open maps
+    /// </summary>
+    vector<mapped_entry> entries_;
+
+    void append(void const* data, size_t len) noexcept
+    {
+        // the data of empty arrays may be null
+        if (len != 0) sink_.append(data, len);
+        offset_ += len;
+    }
+
+    void pad() noexcept
+    {
+        static constexpr char zeros[8] {};
+        append(zeros, static_cast<size_t>(-offset_ & 7));
+    }
+
+    /// <summary>
+    /// writes the header of a record
+    /// </summary>
+    /// <returns>the offset of the record</returns>
+    uint64_t begin_record(dy_type_t type, uint64_t len) noexcept
+    {
+        uint64_t offset    = offset_;
+        uint64_t header[2] = { type | records_++ << 8, len };
+        append(header, sizeof(header));
+        return offset;
+    }
+
+    template <typename T>
+    uint64_t write_elems(dy_type_t type, T const* data, size_t len) noexcept
+    {
+        uint64_t offset = begin_record(type, len);
+        append(data, len * sizeof(T));
+        pad();
+        return offset;
+    }
+
+    /// <summary>
+    /// writes the key unless it is written already
+    /// </summary>
+    /// <returns>the offset of the key</returns>
+    uint64_t write_key(char const* key, size_t len) noexcept
+    {
+        auto [it, added] = keys_.try_emplace(string_view(key, len), offset_);
+        if (added)
+        {
+            append(key, len + 1);
+            pad();
+        }
+        return it->second;
+    }
+
+    /// <summary>
+    /// writes the records of the value. The arrays and maps are followed with
+    /// a stack on the heap, so deep trees do not overflow the stack of the
+    /// thread, and the record of each is written once its entries are.
+    /// </summary>
+    /// <returns>the slot of the value</returns>
+    uint64_t write_value(dy_t val) noexcept
+    {
+        struct frame
+        {
+            dy_t   val;
+            size_t next;
+            size_t len;
+            size_t first;
+            bool   map;
+        };
+
+        vector<frame> stack;
+        for (;;)
+        {
+            uint64_t slot    = 0;
+            bool     written = true;
+            switch (dy_get_type(val))
+            {
+            case dy_type_arr:
+                stack.push_back(
+                    { val, 0, dy_get_arr_len(val), slots_.size(), false });
+                written = false;
+                break;
+            case dy_type_map:
+                stack.push_back(
+                    { val, 0, dy_get_map_len(val), entries_.size(), true });
+                written = false;
+                break;
+            default: slot = write_scalar(val); break;
+            }
+
+            // hands the slot to the array or the map holding the value, and
+            // writes the ones whose entries are all written
+            val = nullptr;
+            while (val == nullptr)
+            {
+                if (written && stack.empty()) return slot;
+                if (written && stack.back().map)
+                    entries_.back().slot = slot;
+                else if (written)
+                    slots_.push_back(slot);
+
+                frame& top = stack.back();
+                if (top.next == top.len || !sink_.ok())
+                {
+                    slot = top.map ? write_map(top.first, top.len)
+                                   : write_arr(top.first, top.len);
+                    written = true;
+                    stack.pop_back();
+                }
+                else if (!top.map)
+                    val = dy_get_arr_idx(top.val, top.next++);
+                else
+                {
+                    dy_keyval_t pair = dy_get_map_idx(top.val, top.next++);
+                    size_t      key  = strlen(pair.key);
+                    if (key > UINT32_MAX)
+                    {
+                        sink_.stop();
+                        written = false;
+                        continue;
+                    }
+
+                    entries_.push_back(mapped_entry {
+                        .key  = write_key(pair.key, key),
+                        .slot = 0,
+                        .len  = static_cast<uint32_t>(key),
+                        .hash = dy::fold_hash(dy::hash_bytes(pair.key, key)),
+                    });
+                    val = pair.val;
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// writes the record of the value other than an array and a map
+    /// </summary>
+    /// <returns>the slot of the value</returns>
+    uint64_t write_scalar(dy_t val) noexcept
+    {
+        switch (dy_get_type(val))
+        {
+        case dy_type_null: return slot_null;
+        case dy_type_b: return dy_get_b(val) ? slot_true : slot_false;
+        case dy_type_i:
+        {
+            int64_t i = dy_get_i(val);
+            if (slot_int_min <= i && i <= slot_int_max)
+                return (static_cast<uint64_t>(i) & ~slot_int_tag)
+                       | slot_int_tag;
+
+            uint64_t offset = begin_record(dy_type_i, 0);
+            append(&i, sizeof(i));
+            return offset;
+        }
+        case dy_type_f:
+        {
+            double f = dy_get_f(val);
+            return (f == f ? bit_cast<uint64_t>(f)
+                           : UINT64_C(0x7ff8000000000000))
+                   + slot_double_offset;
+        }
+        case dy_type_str:
+        {
+            size_t   len    = dy_get_str_len(val);
+            uint64_t offset = begin_record(dy_type_str, len);
+            append(dy_get_str_data(val), len);
+            append("", 1);
+            pad();
+            return offset;
+        }
+        case dy_type_barr:
+        {
+            size_t   len    = dy_get_barr_len(val);
+            uint64_t offset = begin_record(dy_type_barr, len);
+            append(dy_get_barr_words(val), dy::bitset::word_count(len) * 8);
+            return offset;
+        }
+        case dy_type_bytes:
+            return write_elems(
+                dy_type_bytes, dy_get_bytes_data(val), dy_get_bytes_len(val));
+        case dy_type_iarr:
+            return write_elems(
+                dy_type_iarr, dy_get_iarr_data(val), dy_get_iarr_len(val));
+        case dy_type_farr:
+            return write_elems(
+                dy_type_farr, dy_get_farr_data(val), dy_get_farr_len(val));
+        case dy_type_i8arr:
+            return write_elems(
+                dy_type_i8arr, dy_get_i8arr_data(val), dy_get_i8arr_len(val));
+        case dy_type_i16arr:
+            return write_elems(dy_type_i16arr,
+                               dy_get_i16arr_data(val),
+                               dy_get_i16arr_len(val));
+        case dy_type_i32arr:
+            return write_elems(dy_type_i32arr,
+                               dy_get_i32arr_data(val),
+                               dy_get_i32arr_len(val));
+        case dy_type_u32arr:
+            return write_elems(dy_type_u32arr,
+                               dy_get_u32arr_data(val),
+                               dy_get_u32arr_len(val));
+        case dy_type_f32arr:
+            return write_elems(dy_type_f32arr,
+                               dy_get_f32arr_data(val),
+                               dy_get_f32arr_len(val));
+        default: break;
+        }
+
+        return slot_null;
+    }
+
+    /// <summary>
+    /// writes the record of the array whose slots start at <c>first</c>,
+    /// which are missing if the sink stopped
+    /// </summary>
+    uint64_t write_arr(size_t first, size_t len) noexcept
+    {
+        slots_.resize(first + len);
+        uint64_t offset = begin_record(dy_type_arr, len);
+        append(slots_.data() + first, len * sizeof(uint64_t));
+        slots_.resize(first);
+        return offset;
+    }
+
+    /// <summary>
+    /// writes the record of the map whose entries start at <c>first</c>,
+    /// which are missing if the sink stopped
+    /// </summary>
+    uint64_t write_map(size_t first, size_t len) noexcept
+    {
+        entries_.resize(first + len);
+        mapped_entry const* entries = entries_.data() + first;
+
+        // keeps the index at most half full
+        uint64_t         capacity = len != 0 ? bit_ceil(len * 2) : 0;
+        vector<uint32_t> index(capacity);
+        for (size_t i = 0; i < len; ++i)
+        {
+            size_t pos = entries[i].hash & (capacity - 1);
+            while (index[pos] != 0) pos = (pos + 1) & (capacity - 1);
+            index[pos] = static_cast<uint32_t>(i + 1);
+        }
+
+        uint64_t offset = begin_record(dy_type_map, len);
+        append(&capacity, sizeof(capacity));
+        append(entries, len * sizeof(mapped_entry));
+        append(index.data(), capacity * sizeof(uint32_t));
+        pad();
+
+        entries_.resize(first);
+        return offset;
+    }
+};
+
+/// <summary>
+/// unmaps the memory mapped by <c>map_file</c>
+/// </summary>
+void unmap_file(char const* data, size_t len) noexcept
+{
+#if defined(_WIN32)
+    (void)len;
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<char*>(data), len);
+#endif
+}
+
+/// <summary>
+/// maps the whole file into memory read-only
+/// </summary>
+/// <param name="path">the path to the file</param>
+/// <param name="len">set to the size of the file</param>
+/// <returns>the memory, or <c>nullptr</c> on failure</returns>
+char const* map_file(char const* path, size_t& len) noexcept
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path,
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+    LARGE_INTEGER size;
+    HANDLE        mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart != 0)
+        mapping = CreateFileMappingA(
+            file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) return nullptr;
+
+    // the view keeps the mapping open
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    len = static_cast<size_t>(size.QuadPart);
+    return static_cast<char const*>(data);
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    void*       data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        data = mmap(nullptr,
+                    static_cast<size_t>(st.st_size),
+                    PROT_READ,
+                    MAP_PRIVATE,
+                    fd,
+                    0);
+    close(fd);
+    if (data == MAP_FAILED) return nullptr;
+
+    len = static_cast<size_t>(st.st_size);
+    return static_cast<char const*>(data);
+#endif
+}
+
+}
+
+/// <summary>
+/// a mapped file. The value instances of the records are made in an arena on
+/// their first use and kept in a table indexed by the records, so that every
+/// record has a single instance. The table is allocated zeroed and touched
+/// only where the records are used. Reading is thread-safe, and the arena is
+/// guarded by a mutex.
+/// </summary>
+struct _dy_mapped_t
+{
+  public:
+    /// <summary>
+    /// checks the header and the footer of the bytes
+    /// </summary>
+    /// <param name="data">the 8-byte aligned bytes</param>
+    /// <param name="len">the number of the bytes</param>
+    /// <param name="owned">whether the bytes are unmapped with the
+    /// instance</param>
+    /// <returns>a new instance, or <c>nullptr</c> if the bytes are not in the
+    /// format</returns>
+    static _dy_mapped_t* open(char const* data, size_t len, bool owned) noexcept
+    {
+        assert(reinterpret_cast<uintptr_t>(data) % 8 == 0);
+
+        if (!DY_NANBOX || len < header_size + footer_size || len % 8 != 0)
+            return nullptr;
+
+        file_header header;
+        file_footer footer;
+        memcpy(&header, data, header_size);
+        memcpy(&footer, data + len - footer_size, footer_size);
+
+        if (memcmp(header.magic, magic, sizeof(magic)) != 0
+            || memcmp(footer.magic, magic, sizeof(magic)) != 0
+            || header.version != version || header.byte_order != byte_order
+            || footer.records > len / record_header)
+            return nullptr;
+
+        // calloc gets large tables from the system untouched
+        auto nodes = static_cast<dy_t*>(
+            calloc(static_cast<size_t>(footer.records) + 1, sizeof(dy_t)));
+        if (nodes == nullptr) return nullptr;
+
+        auto mapped = new (nothrow) _dy_mapped_t(data, len, owned, nodes);
+        if (mapped == nullptr)
+        {
+            free(nodes);
+            return nullptr;
+        }
+
+        mapped->records_ = footer.records;
+        mapped->root_    = mapped->value(footer.root, len);
+        return mapped;
+    }
+
+    _dy_mapped_t(_dy_mapped_t const&) = delete;
+
+    ~_dy_mapped_t() noexcept
+    {
+        free(nodes_);
+        if (owned_) unmap_file(data_, len_);
+    }
+
+    dy_t root() const noexcept
+    {
+        return root_;
+    }
+
+    /// <summary>
+    /// returns the value in the slot, making its instance on the first use
+    /// </summary>
+    /// <param name="end">the offset the record must lie before</param>
+    dy_t value(uint64_t slot, uint64_t end) noexcept
+    {
+        if (!is_offset(slot)) return dy::handle(static_cast<uintptr_t>(slot));
+
+        // the records lie between the header and the footer
+        if (slot < header_size || slot > len_ - footer_size - record_header
+            || slot >= end)
+            return dy_make_null();
+
+        auto     record = reinterpret_cast<uint64_t const*>(data_ + slot);
+        uint64_t idx    = record[0] >> 8;
+        if (idx >= records_) return dy_make_null();
+
+        atomic_ref<dy_t> node(nodes_[idx]);
+        if (dy_t val = node.load(memory_order_acquire)) return val;
+
+        lock_guard<mutex> lock(mutex_);
+        dy_t              val = node.load(memory_order_relaxed);
+        if (val == nullptr)
+        {
+            val = make_node(record);
+            node.store(val, memory_order_release);
+        }
+        return val;
+    }
+
+    /// <summary>
+    /// returns the value in the slot of an entry of the record. The records
+    /// of the entries are written before the record, so the slots pointing
+    /// elsewhere, which may make a cycle, are broken.
+    /// </summary>
+    dy_t entry(uint64_t const* record, uint64_t slot) noexcept
+    {
+        return value(slot, reinterpret_cast<char const*>(record) - data_);
+    }
+
+    /// <summary>
+    /// allocates from the arena of the instance
+    /// </summary>
+    void* allocate(size_t bytes, size_t alignment) noexcept
+    {
+        lock_guard<mutex> lock(mutex_);
+        return arena_.allocate(bytes, alignment);
+    }
+
+    /// <summary>
+    /// returns the key of the entry
+    /// </summary>
+    /// <returns>the NUL-terminated key, or <c>nullptr</c> if it does not lie
+    /// in the file</returns>
+    char const* key(mapped_entry const& entry) const noexcept
+    {
+        if (entry.key < header_size || entry.len >= len_ - footer_size
+            || entry.key >= len_ - footer_size - entry.len)
+            return nullptr;
+
+        char const* key = data_ + entry.key;
+        return key[entry.len] == '\0' ? key : nullptr;
+    }
+
+  private:
+    char const* data_;
+    size_t      len_;
+    bool        owned_;
+    uint64_t    records_ = 0;
+    dy_t        root_    = nullptr;
+
+    /// <summary>
+    /// the value instances of the records, which are <c>nullptr</c> until
+    /// made. Accessed through <c>std::atomic_ref</c>.
+    /// </summary>
+    dy_t* nodes_;
+
+    mutex       mutex_;
+    _dy_arena_t arena_ { 0 };
+
+    _dy_mapped_t(char const* data, size_t len, bool owned, dy_t* nodes) noexcept
+        :
+        data_ { data },
+        len_ { len },
+        owned_ { owned },
+        nodes_ { nodes }
+    {}
+
+    /// <summary>
+    /// makes the instance of the generic array or map reading the record.
+    /// Called with the mutex locked.
+    /// </summary>
+    dy_t make_mapped(dy_type_t type, uint64_t const* record) noexcept
+    {
+        void* ptr = arena_.allocate(sizeof(_dy_val_t), alignof(_dy_val_t));
+        return new (ptr) _dy_val_t {
+            .type  = type,
+            .flags = dy::flag_arena | dy::flag_mapped,
+            .data  = { .mapped = { this, record, nullptr } },
+        };
+    }
+
+    /// <summary>
+    /// makes the value instance of the record, checking that its payload lies
+    /// in the file. Called with the mutex locked.
+    /// </summary>
+    /// <returns>the instance, or null if the record is broken</returns>
+    dy_t make_node(uint64_t const* record) noexcept
+    {
+        constexpr uint8_t view_flags = dy::flag_arena | dy::flag_view;
+
+        auto     type = static_cast<dy_type_t>(record[0] & 0xff);
+        uint64_t len  = record[1];
+        size_t   room = len_ - footer_size - record_header
+                      - (reinterpret_cast<char const*>(record) - data_);
+
+        switch (type)
+        {
+        case dy_type_i:
+        {
+            if (room < sizeof(int64_t)) return dy_make_null();
+            return DY_MAPPED_NEW(
+                i, dy::flag_arena, static_cast<int64_t>(record[2]));
+        }
+        case dy_type_str:
+        {
+            auto ptr = const_cast<char*>(
+                reinterpret_cast<char const*>(record + 2));
+            if (len >= room || ptr[len] != '\0') return dy_make_null();
+            return DY_MAPPED_NEW(
+                str, view_flags, dy::buffer<char>(ptr, len, 0, 0));
+        }
+        case dy_type_barr:
+        {
+            size_t words = len / 64 + (len % 64 != 0);
+            if (words > room / 8) return dy_make_null();
+
+            auto ptr = const_cast<uint64_t*>(record + 2);
+            return DY_MAPPED_NEW(
+                barr,
+                view_flags,
+                dy::bitset(dy::buffer<uint64_t>(ptr, words, 0, 0), len));
+        }
+            DY_VIEW_HELPER(bytes);
+            DY_VIEW_HELPER(iarr);
+            DY_VIEW_HELPER(farr);
+            DY_VIEW_HELPER(i8arr);
+            DY_VIEW_HELPER(i16arr);
+            DY_VIEW_HELPER(i32arr);
+            DY_VIEW_HELPER(u32arr);
+            DY_VIEW_HELPER(f32arr);
+        case dy_type_arr:
+        {
+            if (len > room / sizeof(uint64_t)) return dy_make_null();
+            return make_mapped(type, record);
+        }
+        case dy_type_map:
+        {
+            if (room < sizeof(uint64_t)) return dy_make_null();
+            room -= sizeof(uint64_t);
+
+            uint64_t capacity = record[2];
+            if (len > room / sizeof(mapped_entry)) return dy_make_null();
+            room -= len * sizeof(mapped_entry);
+
+            // the capacity is a power of two larger than the length, or 0
+            if (capacity > room / sizeof(uint32_t)
+                || (capacity & (capacity - 1)) != 0
+                || (len != 0 && capacity <= len))
+                return dy_make_null();
+
+            return make_mapped(type, record);
+        }
+        default: return dy_make_null();
+        }
+    }
+};
+
+namespace
+{
+
+/// <summary>
+/// the largest number of the entries of the maps looked up without the index
+/// unless the hash of the key is given
+/// </summary>
+constexpr size_t scan_max = 8;
+
+/// <summary>
+/// returns the entries of the mapped map
+/// </summary>
+inline mapped_entry const* entries_of(dy::mapped_ref const& ref) noexcept
+{
+    return reinterpret_cast<mapped_entry const*>(ref.record + 3);
+}
+
+}
+
+size_t dy::mapped_len(dy_t val) noexcept
+{
+    return static_cast<size_t>(val->data.mapped.record[1]);
+}
+
+dy_t dy::mapped_idx(dy_t val, size_t idx) noexcept
+{
+    auto& ref = val->data.mapped;
+    assert(idx < ref.record[1]);
+
+    if (dy_t const* elems = ref.elems.load(memory_order_acquire))
+        return elems[idx];
+    return ref.owner->entry(ref.record, ref.record[2 + idx]);
+}
+
+dy_t const* dy::mapped_data(dy_t val) noexcept
+{
+    auto& ref = val->data.mapped;
+    if (dy_t const* elems = ref.elems.load(memory_order_acquire)) return elems;
+
+    size_t len   = static_cast<size_t>(ref.record[1]);
+    auto   elems = static_cast<dy_t*>(
+        ref.owner->allocate(len * sizeof(dy_t), alignof(dy_t)));
+    for (size_t i = 0; i < len; ++i)
+        elems[i] = ref.owner->entry(ref.record, ref.record[2 + i]);
+
+    // the entries made by another thread at the same time win, leaving these
+    // in the arena
+    dy_t const* expected = nullptr;
+    if (!ref.elems.compare_exchange_strong(expected, elems))
+        return expected;
+    return elems;
+}
+
+dy_keyval_t dy::mapped_keyval(dy_t val, size_t idx) noexcept
+{
+    if (idx == dy::shape::npos)
+    {
+        return dy_keyval_t {
+            .key = nullptr,
+            .val = nullptr,
+        };
+    }
+
+    auto&       ref   = val->data.mapped;
+    auto const& entry = entries_of(ref)[idx];
+    char const* key   = ref.owner->key(entry);
+    return dy_keyval_t {
+        .key = key != nullptr ? key : "",
+        .val = ref.owner->entry(ref.record, entry.slot),
+    };
+}
+
+size_t dy::mapped_find(dy_t val, char const* key, size_t len) noexcept
+{
+    auto& ref = val->data.mapped;
+    if (ref.record[1] > scan_max)
+        return mapped_find(val, key, len, dy::hash_bytes(key, len));
+
+    // the entries of small maps are in a few cache lines, which are read
+    // faster than the key is hashed
+    auto entries = entries_of(ref);
+    for (size_t i = 0, size = ref.record[1]; i < size; ++i)
+    {
+        if (entries[i].len != len) continue;
+
+        char const* found = ref.owner->key(entries[i]);
+        if (found != nullptr && memcmp(found, key, len) == 0) return i;
+    }
+    return dy::shape::npos;
+}
+
+size_t dy::mapped_find(dy_t        val,
+                       char const* key,
+                       size_t      len,
+                       uint64_t    hash) noexcept
+{
+    auto&    ref      = val->data.mapped;
+    uint64_t size     = ref.record[1];
+    uint64_t capacity = ref.record[2];
+    if (capacity == 0) return dy::shape::npos;
+
+    auto entries = entries_of(ref);
+    auto index   = reinterpret_cast<uint32_t const*>(entries + size);
+    auto folded  = dy::fold_hash(hash);
+
+    // the index has an empty slot, which the count bounds if it is broken
+    size_t pos = folded & (capacity - 1);
+    for (uint64_t i = 0; i < capacity; ++i, pos = (pos + 1) & (capacity - 1))
+    {
+        uint32_t slot = index[pos];
+        if (slot == 0 || slot > size) break;
+
+        auto const& entry = entries[slot - 1];
+        if (entry.hash != folded || entry.len != len) continue;
+
+        char const* found = ref.owner->key(entry);
+        if (found != nullptr && memcmp(found, key, len) == 0) return slot - 1;
+    }
+    return dy::shape::npos;
+}
+
+DY_PUBLIC(bool)
+dy_write_mapped(dy_t val, dy_write_fn_t write_fn, void* ctx) DY_NOEXCEPT
+{
+    assert(val != nullptr && write_fn != nullptr);
+
+    writer writer(write_fn, ctx);
+    return writer.write(val);
+}
+
+DY_PUBLIC(size_t)
+dy_write_mapped_buffer(dy_t val, void* buf, size_t cap) DY_NOEXCEPT
+{
+    assert(buf != nullptr || cap == 0);
+
+    dy::buffer_sink sink { static_cast<char*>(buf), cap, 0 };
+    if (!dy_write_mapped(val, dy::write_to_buffer, &sink)) return 0;
+    return sink.len;
+}
+
+DY_PUBLIC(dy_mapped_t) dy_open_mapped(char const* path) DY_NOEXCEPT
+{
+    assert(path != nullptr);
+
+    size_t      len;
+    char const* data = map_file(path, len);
+    if (data == nullptr) return nullptr;
+
+    dy_mapped_t mapped = _dy_mapped_t::open(data, len, true);
+    if (mapped == nullptr) unmap_file(data, len);
+    return mapped;
+}
+
+DY_PUBLIC(dy_mapped_t)
+dy_open_mapped_buffer(void const* data, size_t len) DY_NOEXCEPT
+{
+    assert(data != nullptr || len == 0);
+    if (data == nullptr) return nullptr;
+    return _dy_mapped_t::open(static_cast<char const*>(data), len, false);
+}
+
+DY_PUBLIC(dy_t) dy_get_mapped_root(dy_mapped_t mapped) DY_NOEXCEPT
+{
+    assert(mapped != nullptr);
+    return mapped->root();
+}
+
+DY_PUBLIC(void) dy_close_mapped(dy_mapped_t mapped) DY_NOEXCEPT
+{
+    delete mapped;
+}
@@ -0,0 +1,874 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.p.hh>
+#include <sink.p.hh>
+
+#include <bit>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+/// <summary>
+/// the type code of the boolean arrays
+/// </summary>
+constexpr int8_t ext_barr = 1;
+
+/// <summary>
+/// returns the type code of the extension holding the typed array, which
+/// follows the tags of RFC 8746 for the little-endian arrays
+/// </summary>
+/// <param name="type">the type of the array</param>
+/// <returns>the type code, or 0 if the type is not encoded as an
+/// extension</returns>
+int8_t ext_type_of(dy_type_t type) noexcept
+{
+    switch (type)
+    {
+    case dy_type_barr: return ext_barr;
+    case dy_type_u32arr: return 70;
+    case dy_type_i8arr: return 72;
+    case dy_type_i16arr: return 77;
+    case dy_type_i32arr: return 78;
+    case dy_type_iarr: return 79;
+    case dy_type_f32arr: return 85;
+    case dy_type_farr: return 86;
+    default: return 0;
+    }
+}
+
+/// <summary>
+/// returns the type of the typed array held by the extension
+/// </summary>
+/// <param name="code">the type code of the extension</param>
+/// <returns>the type, or <c>dy_type_null</c> if the extension is not
+/// supported</returns>
+dy_type_t type_of_ext(int8_t code) noexcept
+{
+    switch (code)
+    {
+    case ext_barr: return dy_type_barr;
+    case 70: return dy_type_u32arr;
+    case 72: return dy_type_i8arr;
+    case 77: return dy_type_i16arr;
+    case 78: return dy_type_i32arr;
+    case 79: return dy_type_iarr;
+    case 85: return dy_type_f32arr;
+    case 86: return dy_type_farr;
+    default: return dy_type_null;
+    }
+}
+
+/// <summary>
+/// returns the size of the entries of the typed array
+/// </summary>
+size_t elem_size_of(dy_type_t type) noexcept
+{
+    switch (type)
+    {
+    case dy_type_i8arr: return 1;
+    case dy_type_i16arr: return 2;
+    case dy_type_i32arr:
+    case dy_type_u32arr:
+    case dy_type_f32arr: return 4;
+    default: return 8;
+    }
+}
+
+/// <summary>
+/// checks whether the number is exact in single precision
+/// </summary>
+bool is_exact_float(double f) noexcept
+{
+    // converting a finite number out of the range is undefined
+    if (!(-FLT_MAX <= f && f <= FLT_MAX)) return isinf(f);
+    return static_cast<double>(static_cast<float>(f)) == f;
+}
+
+/// <summary>
+/// stores the integer in big-endian order
+/// </summary>
+template <typename T>
+char* store_be(char* p, T value) noexcept
+{
+    for (size_t i = sizeof(T); i-- != 0; value >>= 8)
+        p[i] = static_cast<char>(value & 0xff);
+    return p + sizeof(T);
+}
+
+/// <summary>
+/// loads an integer in big-endian order
+/// </summary>
+template <typename T>
+T load_be(uint8_t const* p) noexcept
+{
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) value = T(value << 8) | p[i];
+    return value;
+}
+
+/// <summary>
+/// encodes values in MessagePack to a sink
+/// </summary>
+class encoder
+{
+  public:
+    encoder(dy_write_fn_t write_fn, void* ctx) noexcept :
+        sink_ { write_fn, ctx }
+    {}
+
+    encoder(encoder const&) = delete;
+
+    /// <summary>
+    /// encodes the value and hands out the rest of the bytes
+    /// </summary>
+    /// <returns><c>false</c> if the function stopped writing or the value is
+    /// too large</returns>
+    bool encode(dy_t val) noexcept
+    {
+        encode_value(val);
+        sink_.flush();
+        return sink_.ok();
+    }
+
+  private:
+    /// <summary>
+    /// the room needed for any header or scalar value
+    /// </summary>
+    static constexpr size_t header_max = 10;
+
+    dy::sink sink_;
+
+    /// <summary>
+    /// writes the header of a string, a bin, an array or a map
+    /// </summary>
+    /// <param name="fix">the first byte of the fixed-size format, or 0 if
+    /// there is none</param>
+    /// <param name="fix_max">the largest length of the fixed-size
+    /// format</param>
+    /// <param name="first">the first byte of the formats with the lengths of
+    /// 1, 2 and 4 bytes, or that of the second one if the first is not
+    /// available</param>
+    /// <param name="len">the length</param>
+    /// <param name="has_len8">whether the format with the length of 1 byte
+    /// is available</param>
+    void write_header(uint8_t fix,
+                      size_t  fix_max,
+                      uint8_t first,
+                      size_t  len,
+                      bool    has_len8 = true) noexcept
+    {
+        if (len > UINT32_MAX) return sink_.stop();
+
+        char* p = sink_.reserve(header_max);
+        if (fix != 0 && len <= fix_max)
+            *p++ = static_cast<char>(fix | len);
+        else if (has_len8 && len <= UINT8_MAX)
+        {
+            *p++ = static_cast<char>(first);
+            *p++ = static_cast<char>(len);
+        }
+        else if (len <= UINT16_MAX)
+        {
+            *p++ = static_cast<char>(first + has_len8);
+            p    = store_be(p, static_cast<uint16_t>(len));
+        }
+        else
+        {
+            *p++ = static_cast<char>(first + has_len8 + 1);
+            p    = store_be(p, static_cast<uint32_t>(len));
+        }
+        sink_.commit(p);
+    }
+
+    void encode_i(int64_t i) noexcept
+    {
+        char* p = sink_.reserve(header_max);
+        if (-32 <= i && i <= 127) *p++ = static_cast<char>(i);
+        else if (i >= 0)
+        {
+            if (i <= UINT8_MAX)
+            {
+                *p++ = '\xcc';
+                *p++ = static_cast<char>(i);
+            }
+            else if (i <= UINT16_MAX)
+                p = store_be(store_be(p, uint8_t(0xcd)), uint16_t(i));
+            else if (i <= UINT32_MAX)
+                p = store_be(store_be(p, uint8_t(0xce)), uint32_t(i));
+            else
+                p = store_be(store_be(p, uint8_t(0xcf)), uint64_t(i));
+        }
+        else if (i >= INT8_MIN)
+        {
+            *p++ = '\xd0';
+            *p++ = static_cast<char>(i);
+        }
+        else if (i >= INT16_MIN)
+            p = store_be(store_be(p, uint8_t(0xd1)), uint16_t(i));
+        else if (i >= INT32_MIN)
+            p = store_be(store_be(p, uint8_t(0xd2)), uint32_t(i));
+        else
+            p = store_be(store_be(p, uint8_t(0xd3)), uint64_t(i));
+        sink_.commit(p);
+    }
+
+    void encode_f(double f) noexcept
+    {
+        char* p = sink_.reserve(header_max);
+        if (is_exact_float(f))
+        {
+            *p++ = '\xca';
+            p    = store_be(p, bit_cast<uint32_t>(static_cast<float>(f)));
+        }
+        else
+        {
+            *p++ = '\xcb';
+            p    = store_be(p, bit_cast<uint64_t>(f));
+        }
+        sink_.commit(p);
+    }
+
+    void encode_str(char const* str, size_t len) noexcept
+    {
+        write_header(0xa0, 31, 0xd9, len);
+        sink_.append(str, len);
+    }
+
+    /// <summary>
+    /// writes the header of an extension
+    /// </summary>
+    void write_ext_header(int8_t code, size_t len) noexcept
+    {
+        if (len > UINT32_MAX) return sink_.stop();
+
+        // uses the fixed-size formats where the size matches
+        char* p = sink_.reserve(header_max);
+        switch (len)
+        {
+        case 1: *p++ = '\xd4'; break;
+        case 2: *p++ = '\xd5'; break;
+        case 4: *p++ = '\xd6'; break;
+        case 8: *p++ = '\xd7'; break;
+        case 16: *p++ = '\xd8'; break;
+        default:
+            if (len <= UINT8_MAX)
+            {
+                *p++ = '\xc7';
+                *p++ = static_cast<char>(len);
+            }
+            else if (len <= UINT16_MAX)
+                p = store_be(store_be(p, uint8_t(0xc8)), uint16_t(len));
+            else
+                p = store_be(store_be(p, uint8_t(0xc9)), uint32_t(len));
+            break;
+        }
+        *p++ = static_cast<char>(code);
+        sink_.commit(p);
+    }
+
+    /// <summary>
+    /// writes the entries of the typed array in little-endian order
+    /// </summary>
+    template <typename T>
+    void encode_elems(int8_t code, T const* ptr, size_t len) noexcept
+    {
+        write_ext_header(code, len * sizeof(T));
+        if (!sink_.ok()) return;
+
+        if constexpr (endian::native == endian::little || sizeof(T) == 1)
+            sink_.append(ptr, len * sizeof(T));
+        else
+            for (size_t i = 0; i < len; ++i)
+            {
+                char bytes[sizeof(T)];
+                memcpy(bytes, ptr + i, sizeof(T));
+                reverse(bytes, bytes + sizeof(T));
+                sink_.append(bytes, sizeof(T));
+            }
+    }
+
+    void encode_barr(dy_t val) noexcept
+    {
+        uint64_t const* words = dy_get_barr_words(val);
+        size_t          len   = dy_get_barr_len(val);
+        size_t          count = (len + 7) / 8;
+
+        write_ext_header(ext_barr, count + 1);
+        if (!sink_.ok()) return;
+
+        sink_.put(static_cast<char>(count * 8 - len));
+        if constexpr (endian::native == endian::little)
+            sink_.append(words, count);
+        else
+            for (size_t i = 0; i < count; ++i)
+                sink_.put(static_cast<char>(words[i / 8] >> (i % 8 * 8)));
+    }
+
+    /// <summary>
+    /// writes the value. The arrays and maps are followed with a stack on the
+    /// heap, so deep trees do not overflow the stack of the thread.
+    /// </summary>
+    void encode_value(dy_t val) noexcept
+    {
+        struct frame
+        {
+            dy_t        val;
+            dy_t const* elems;
+            size_t      next;
+            size_t      len;
+            bool        map;
+        };
+
+        vector<frame> stack;
+        for (;;)
+        {
+            switch (dy_get_type(val))
+            {
+            case dy_type_arr:
+            {
+                size_t len = dy_get_arr_len(val);
+                write_header(0x90, 15, 0xdc, len, false);
+                stack.push_back({ val, dy_get_arr_data(val), 0, len, false });
+                break;
+            }
+            case dy_type_map:
+            {
+                size_t len = dy_get_map_len(val);
+                write_header(0x80, 15, 0xde, len, false);
+                stack.push_back({ val, nullptr, 0, len, true });
+                break;
+            }
+            default: encode_scalar(val); break;
+            }
+
+            // drops the arrays and maps written until one has an entry left
+            val = nullptr;
+            while (val == nullptr && !stack.empty())
+            {
+                frame& top = stack.back();
+                if (top.next == top.len || !sink_.ok()) stack.pop_back();
+                else if (!top.map) val = top.elems[top.next++];
+                else
+                {
+                    dy_keyval_t pair = dy_get_map_idx(top.val, top.next++);
+                    encode_str(pair.key, strlen(pair.key));
+                    val = pair.val;
+                }
+            }
+
+            if (val == nullptr) return;
+        }
+    }
+
+    void encode_scalar(dy_t val) noexcept
+    {
+        dy_type_t type = dy_get_type(val);
+        switch (type)
+        {
+        case dy_type_null: sink_.put('\xc0'); break;
+        case dy_type_b: sink_.put(dy_get_b(val) ? '\xc3' : '\xc2'); break;
+        case dy_type_i: encode_i(dy_get_i(val)); break;
+        case dy_type_f: encode_f(dy_get_f(val)); break;
+        case dy_type_str:
+            encode_str(dy_get_str_data(val), dy_get_str_len(val));
+            break;
+        case dy_type_barr: encode_barr(val); break;
+        case dy_type_bytes:
+        {
+            size_t len = dy_get_bytes_len(val);
+            write_header(0, 0, 0xc4, len);
+            sink_.append(dy_get_bytes_data(val), len);
+            break;
+        }
+        case dy_type_iarr:
+            encode_elems(ext_type_of(type),
+                         dy_get_iarr_data(val),
+                         dy_get_iarr_len(val));
+            break;
+        case dy_type_farr:
+            encode_elems(ext_type_of(type),
+                         dy_get_farr_data(val),
+                         dy_get_farr_len(val));
+            break;
+        case dy_type_i8arr:
+            encode_elems(ext_type_of(type),
+                         dy_get_i8arr_data(val),
+                         dy_get_i8arr_len(val));
+            break;
+        case dy_type_i16arr:
+            encode_elems(ext_type_of(type),
+                         dy_get_i16arr_data(val),
+                         dy_get_i16arr_len(val));
+            break;
+        case dy_type_i32arr:
+            encode_elems(ext_type_of(type),
+                         dy_get_i32arr_data(val),
+                         dy_get_i32arr_len(val));
+            break;
+        case dy_type_u32arr:
+            encode_elems(ext_type_of(type),
+                         dy_get_u32arr_data(val),
+                         dy_get_u32arr_len(val));
+            break;
+        case dy_type_f32arr:
+            encode_elems(ext_type_of(type),
+                         dy_get_f32arr_data(val),
+                         dy_get_f32arr_len(val));
+            break;
+        default: break;
+        }
+    }
+};
+
+/// <summary>
+/// decodes values from MessagePack. Every length is checked against the
+/// bytes left before anything is allocated for it.
+/// </summary>
+class decoder
+{
+  public:
+    decoder(uint8_t const*         data,
+            size_t                 len,
+            dy_parse_opts_t const& opts) noexcept :
+        data_ { data },
+        len_ { len },
+        arena_ { opts.arena },
+        max_depth_ { opts.max_depth != 0 ? opts.max_depth : 1024 }
+    {}
+
+    decoder(decoder const&) = delete;
+
+    ~decoder() noexcept
+    {
+        // the values of the arrays and maps left open by an error
+        for (auto val : values_) dy_dispose(val);
+        for (auto& pair : pairs_) dy_dispose(pair.val);
+    }
+
+    /// <summary>
+    /// decodes the bytes, which must hold exactly one value
+    /// </summary>
+    /// <returns>a new value instance, or <c>nullptr</c> on failure</returns>
+    dy_t decode() noexcept
+    {
+        dy_t val = decode_value(0);
+        if (val != nullptr && pos_ != len_)
+        {
+            dy_dispose(val);
+            return fail(dy_parse_syntax, pos_);
+        }
+        return val;
+    }
+
+    dy_parse_error_t error() const noexcept
+    {
+        return error_;
+    }
+
+    size_t error_offset() const noexcept
+    {
+        return error_offset_;
+    }
+
+  private:
+    uint8_t const* data_;
+    size_t         len_;
+    size_t         pos_ = 0;
+    dy_arena_t     arena_;
+    size_t         max_depth_;
+
+    dy_parse_error_t error_        = dy_parse_ok;
+    size_t           error_offset_ = 0;
+
+    /// <summary>
+    /// the keys of the maps being decoded, each followed by a NUL terminator.
+    /// It grows with the keys, so the pairs point into it once a map is
+    /// complete.
+    /// </summary>
+    vector<char> chars_;
+
+    /// <summary>
+    /// the offset of the key of each pair in <c>chars_</c>
+    /// </summary>
+    vector<size_t> keys_;
+
+    /// <summary>
+    /// the entries of the arrays being decoded
+    /// </summary>
+    vector<dy_t> values_;
+
+    /// <summary>
+    /// the pairs of the maps being decoded
+    /// </summary>
+    vector<dy_keyval_t> pairs_;
+
+    dy_t fail(dy_parse_error_t error, size_t offset) noexcept
+    {
+        error_        = error;
+        error_offset_ = offset;
+        return nullptr;
+    }
+
+    pmr::memory_resource* resource() const noexcept
+    {
+        if (arena_ != nullptr) return arena_;
+        return dy::heap();
+    }
+
+    /// <summary>
+    /// checks whether <c>len</c> more bytes are left
+    /// </summary>
+    bool has(size_t len) const noexcept
+    {
+        return len_ - pos_ >= len;
+    }
+
+    /// <summary>
+    /// reads a big-endian integer
+    /// </summary>
+    /// <returns><c>false</c> if the bytes run out</returns>
+    template <typename T>
+    bool read(T& value) noexcept
+    {
+        if (!has(sizeof(T))) return false;
+        value = load_be<T>(data_ + pos_);
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    /// <summary>
+    /// reads the length of the given size
+    /// </summary>
+    template <typename T>
+    bool read_len(size_t& len) noexcept
+    {
+        T value;
+        if (!read(value)) return false;
+        len = value;
+        return true;
+    }
+
+    dy_t make_i(int64_t i) noexcept
+    {
+        return arena_ ? dy_arena_make_i(arena_, i) : dy_make_i(i);
+    }
+
+    dy_t make_f(double f) noexcept
+    {
+        return arena_ ? dy_arena_make_f(arena_, f) : dy_make_f(f);
+    }
+
+    dy_t decode_value(size_t depth) noexcept
+    {
+        size_t  pos = pos_;
+        uint8_t tag;
+        if (!read(tag)) return fail(dy_parse_syntax, pos);
+
+        if (tag <= 0x7f) return make_i(tag);
+        if (tag >= 0xe0) return make_i(static_cast<int8_t>(tag));
+        if ((tag & 0xe0) == 0xa0) return decode_str(pos, tag & 0x1f);
+        if ((tag & 0xf0) == 0x90) return decode_arr(pos, tag & 0x0f, depth);
+        if ((tag & 0xf0) == 0x80) return decode_map(pos, tag & 0x0f, depth);
+
+        size_t len = 0;
+        bool   ok  = true;
+        switch (tag)
+        {
+        case 0xc0: return dy_make_null();
+        case 0xc2: return dy_make_b(false);
+        case 0xc3: return dy_make_b(true);
+        case 0xc4: ok = read_len<uint8_t>(len); break;
+        case 0xc5: ok = read_len<uint16_t>(len); break;
+        case 0xc6: ok = read_len<uint32_t>(len); break;
+        case 0xc7: ok = read_len<uint8_t>(len); break;
+        case 0xc8: ok = read_len<uint16_t>(len); break;
+        case 0xc9: ok = read_len<uint32_t>(len); break;
+        case 0xd4: len = 1; break;
+        case 0xd5: len = 2; break;
+        case 0xd6: len = 4; break;
+        case 0xd7: len = 8; break;
+        case 0xd8: len = 16; break;
+        case 0xd9: ok = read_len<uint8_t>(len); break;
+        case 0xda: ok = read_len<uint16_t>(len); break;
+        case 0xdb: ok = read_len<uint32_t>(len); break;
+        case 0xdc: ok = read_len<uint16_t>(len); break;
+        case 0xdd: ok = read_len<uint32_t>(len); break;
+        case 0xde: ok = read_len<uint16_t>(len); break;
+        case 0xdf: ok = read_len<uint32_t>(len); break;
+        default: return decode_number(pos, tag);
+        }
+        if (!ok) return fail(dy_parse_syntax, pos);
+
+        switch (tag)
+        {
+        case 0xc4:
+        case 0xc5:
+        case 0xc6:
+            if (!has(len)) return fail(dy_parse_syntax, pos);
+            pos_ += len;
+            return dy::make_packed(
+                resource(), dy_type_bytes, data_ + pos_ - len, len);
+        case 0xd9:
+        case 0xda:
+        case 0xdb: return decode_str(pos, len);
+        case 0xdc:
+        case 0xdd: return decode_arr(pos, len, depth);
+        case 0xde:
+        case 0xdf: return decode_map(pos, len, depth);
+        default: return decode_ext(pos, len);
+        }
+    }
+
+    dy_t decode_number(size_t pos, uint8_t tag) noexcept
+    {
+        switch (tag)
+        {
+        case 0xca:
+        {
+            uint32_t bits;
+            if (!read(bits)) break;
+            return make_f(bit_cast<float>(bits));
+        }
+        case 0xcb:
+        {
+            uint64_t bits;
+            if (!read(bits)) break;
+            return make_f(bit_cast<double>(bits));
+        }
+        case 0xcc:
+        {
+            uint8_t i;
+            if (!read(i)) break;
+            return make_i(i);
+        }
+        case 0xcd:
+        {
+            uint16_t i;
+            if (!read(i)) break;
+            return make_i(i);
+        }
+        case 0xce:
+        {
+            uint32_t i;
+            if (!read(i)) break;
+            return make_i(i);
+        }
+        case 0xcf:
+        {
+            // as in JSON, integers out of the range become numbers
+            uint64_t i;
+            if (!read(i)) break;
+            if (i > INT64_MAX) return make_f(static_cast<double>(i));
+            return make_i(static_cast<int64_t>(i));
+        }
+        case 0xd0:
+        {
+            uint8_t i;
+            if (!read(i)) break;
+            return make_i(static_cast<int8_t>(i));
+        }
+        case 0xd1:
+        {
+            uint16_t i;
+            if (!read(i)) break;
+            return make_i(static_cast<int16_t>(i));
+        }
+        case 0xd2:
+        {
+            uint32_t i;
+            if (!read(i)) break;
+            return make_i(static_cast<int32_t>(i));
+        }
+        case 0xd3:
+        {
+            uint64_t i;
+            if (!read(i)) break;
+            return make_i(static_cast<int64_t>(i));
+        }
+        }
+        return fail(dy_parse_syntax, pos);
+    }
+
+    dy_t decode_str(size_t pos, size_t len) noexcept
+    {
+        if (!has(len)) return fail(dy_parse_syntax, pos);
+
+        auto str = reinterpret_cast<char const*>(data_ + pos_);
+        pos_ += len;
+        return arena_ ? dy_arena_make_str_len(arena_, str, len)
+                      : dy_make_str_len(str, len);
+    }
+
+    dy_t decode_ext(size_t pos, size_t len) noexcept
+    {
+        uint8_t code;
+        if (!read(code) || !has(len)) return fail(dy_parse_syntax, pos);
+
+        dy_type_t      type  = type_of_ext(static_cast<int8_t>(code));
+        uint8_t const* bytes = data_ + pos_;
+        size_t         count;
+        if (type == dy_type_barr)
+        {
+            // the number of the unused bits comes first
+            if (len == 0 || bytes[0] > 7 || (len == 1 && bytes[0] != 0))
+                return fail(dy_parse_syntax, pos);
+            count = (len - 1) * 8 - bytes[0];
+            ++bytes;
+        }
+        else
+        {
+            if (type == dy_type_null || len % elem_size_of(type) != 0)
+                return fail(dy_parse_syntax, pos);
+            count = len / elem_size_of(type);
+        }
+
+        pos_ += len;
+        return dy::make_packed(resource(), type, bytes, count);
+    }
+
+    dy_t decode_arr(size_t pos, size_t len, size_t depth) noexcept
+    {
+        if (depth == max_depth_) return fail(dy_parse_depth, pos);
+
+        // every entry takes a byte at least
+        if (!has(len)) return fail(dy_parse_syntax, pos);
+
+        size_t first = values_.size();
+        values_.reserve(first + len);
+        for (size_t i = 0; i < len; ++i)
+        {
+            dy_t val = decode_value(depth + 1);
+            if (val == nullptr) return nullptr;
+            values_.push_back(val);
+        }
+
+        dy_t const* ptr = values_.data() + first;
+        dy_t        arr = arena_ ? dy_arena_make_arr(arena_, ptr, len)
+                                 : dy_make_arr(ptr, len);
+        values_.resize(first);
+        return arr;
+    }
+
+    dy_t decode_map(size_t pos, size_t len, size_t depth) noexcept
+    {
+        if (depth == max_depth_) return fail(dy_parse_depth, pos);
+
+        // every pair takes 2 bytes at least
+        if (len > (len_ - pos_) / 2) return fail(dy_parse_syntax, pos);
+
+        size_t first       = pairs_.size();
+        size_t first_keys  = keys_.size();
+        size_t first_chars = chars_.size();
+        pairs_.reserve(first + len);
+        keys_.reserve(first_keys + len);
+        for (size_t i = 0; i < len; ++i)
+        {
+            size_t key_pos = pos_;
+            if (!read_key()) return fail(dy_parse_syntax, key_pos);
+
+            dy_t val = decode_value(depth + 1);
+            if (val == nullptr) return nullptr;
+            pairs_.push_back(dy_keyval_t { .key = nullptr, .val = val });
+        }
+
+        // the keys are in place, as the maps inside have dropped theirs
+        for (size_t i = 0; i < len; ++i)
+            pairs_[first + i].key = chars_.data() + keys_[first_keys + i];
+
+        dy_keyval_t const* ptr = pairs_.data() + first;
+        dy_t               map = arena_ ? dy_arena_make_map(arena_, ptr, len)
+                                        : dy_make_map(ptr, len);
+
+        // the values of the keys given more than once are left out
+        if (dy_get_map_len(map) != len)
+            for (size_t i = 0; i < len; ++i)
+                if (dy_get_map_key(map, ptr[i].key).val != ptr[i].val)
+                    dy_dispose(ptr[i].val);
+
+        pairs_.resize(first);
+        keys_.resize(first_keys);
+        chars_.resize(first_chars);
+        return map;
+    }
+
+    /// <summary>
+    /// reads a string key into the scratch
+    /// </summary>
+    /// <returns><c>false</c> if there is no string</returns>
+    bool read_key() noexcept
+    {
+        uint8_t tag;
+        size_t  len;
+        if (!read(tag)) return false;
+        if ((tag & 0xe0) == 0xa0) len = tag & 0x1f;
+        else if (tag == 0xd9)
+        {
+            if (!read_len<uint8_t>(len)) return false;
+        }
+        else if (tag == 0xda)
+        {
+            if (!read_len<uint16_t>(len)) return false;
+        }
+        else if (tag == 0xdb)
+        {
+            if (!read_len<uint32_t>(len)) return false;
+        }
+        else
+            return false;
+        if (!has(len)) return false;
+
+        size_t offset = chars_.size();
+        chars_.resize(offset + len + 1);
+        if (len != 0) memcpy(chars_.data() + offset, data_ + pos_, len);
+        keys_.push_back(offset);
+        pos_ += len;
+        return true;
+    }
+};
+
+}
+
+DY_PUBLIC(bool)
+dy_encode_msgpack(dy_t val, dy_write_fn_t write_fn, void* ctx) DY_NOEXCEPT
+{
+    assert(val != nullptr && write_fn != nullptr);
+
+    encoder encoder(write_fn, ctx);
+    return encoder.encode(val);
+}
+
+DY_PUBLIC(size_t)
+dy_encode_msgpack_buffer(dy_t val, void* buf, size_t cap) DY_NOEXCEPT
+{
+    assert(buf != nullptr || cap == 0);
+
+    dy::buffer_sink sink { static_cast<char*>(buf), cap, 0 };
+    if (!dy_encode_msgpack(val, dy::write_to_buffer, &sink)) return 0;
+    return sink.len;
+}
+
+DY_PUBLIC(dy_t)
+dy_decode_msgpack(void const* data, size_t len, dy_parse_opts_t* opts)
+    DY_NOEXCEPT
+{
+    assert(data != nullptr || len == 0);
+
+    dy_parse_opts_t defaults {};
+    if (opts == nullptr) opts = &defaults;
+
+    decoder decoder(static_cast<uint8_t const*>(data), len, *opts);
+    dy_t    val = decoder.decode();
+
+    opts->error        = decoder.error();
+    opts->error_offset = decoder.error_offset();
+    return val;
+}
@@ -0,0 +1,203 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <pool.p.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+/// <summary>
+/// a call to <c>dy::parallel_for</c>
+/// </summary>
+struct job
+{
+    dy::index_fn_t fn;
+    void*          ctx;
+
+    /// <summary>
+    /// the number of the indices not run yet
+    /// </summary>
+    atomic<size_t> pending;
+};
+
+/// <summary>
+/// the indices of a job not taken by any thread yet
+/// </summary>
+struct range
+{
+    job*   owner;
+    size_t first;
+    size_t last;
+};
+
+/// <summary>
+/// a work-stealing thread pool. Each thread has a queue of ranges, taking the
+/// newest one from its own queue and the oldest one from the others, which is
+/// the largest one left. The threads calling <c>dy::parallel_for</c> share
+/// the first queue and run the tasks until their jobs finish.
+/// </summary>
+class pool
+{
+  public:
+    pool() :
+        size_ { max<size_t>(thread::hardware_concurrency(), 1) },
+        queues_ { make_unique<queue[]>(size_) }
+    {
+        for (size_t i = 1; i < size_; ++i)
+            threads_.emplace_back([this, i] { work(i); });
+    }
+
+    pool(pool const&) = delete;
+
+    ~pool() noexcept
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            stop_ = true;
+        }
+        idle_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    void run(size_t len, dy::index_fn_t fn, void* ctx) noexcept
+    {
+        if (len == 0) return;
+
+        job job { fn, ctx, len };
+        push(0, { &job, 0, len });
+
+        // the job lives on the stack, so the thread waits for every run
+        while (job.pending.load(memory_order_acquire) != 0)
+            if (!run_one(0)) this_thread::yield();
+    }
+
+  private:
+    struct queue
+    {
+        mutex        guard;
+        deque<range> ranges;
+    };
+
+    size_t              size_;
+    unique_ptr<queue[]> queues_;
+    vector<thread>      threads_;
+    mutex               mutex_;
+    condition_variable  idle_;
+
+    /// <summary>
+    /// the number of the ranges in the queues
+    /// </summary>
+    atomic<size_t> queued_ { 0 };
+    bool           stop_ = false;
+
+    void push(size_t idx, range r) noexcept
+    {
+        {
+            lock_guard<mutex> lock(queues_[idx].guard);
+            queues_[idx].ranges.push_back(r);
+        }
+        queued_.fetch_add(1, memory_order_release);
+
+        // the lock orders the notification after the check of the waiter
+        {
+            lock_guard<mutex> lock(mutex_);
+        }
+        idle_.notify_one();
+    }
+
+    bool take(size_t idx, bool own, range* r) noexcept
+    {
+        auto&             q = queues_[idx];
+        lock_guard<mutex> lock(q.guard);
+        if (q.ranges.empty()) return false;
+
+        if (own)
+        {
+            *r = q.ranges.back();
+            q.ranges.pop_back();
+        }
+        else
+        {
+            *r = q.ranges.front();
+            q.ranges.pop_front();
+        }
+
+        queued_.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+
+    /// <summary>
+    /// runs an index taken from the own queue of the thread, or stolen from
+    /// another one
+    /// </summary>
+    /// <returns><c>true</c> if any index is run, <c>false</c> if every queue
+    /// is empty</returns>
+    bool run_one(size_t idx) noexcept
+    {
+        range r;
+        bool  found = take(idx, true, &r);
+        for (size_t i = 1; !found && i < size_; ++i)
+            found = take((idx + i) % size_, false, &r);
+        if (!found) return false;
+
+        // the halves are left for the idle threads to steal
+        while (r.last - r.first > 1)
+        {
+            size_t mid = r.first + (r.last - r.first) / 2;
+            push(idx, { r.owner, mid, r.last });
+            r.last = mid;
+        }
+
+        job* owner = r.owner;
+        owner->fn(owner->ctx, r.first);
+        owner->pending.fetch_sub(1, memory_order_acq_rel);
+        return true;
+    }
+
+    void work(size_t idx) noexcept
+    {
+        for (;;)
+        {
+            if (run_one(idx)) continue;
+
+            unique_lock<mutex> lock(mutex_);
+            idle_.wait(lock, [this] {
+                return stop_ || queued_.load(memory_order_acquire) != 0;
+            });
+            if (stop_) return;
+        }
+    }
+};
+
+pool& instance() noexcept
+{
+    static pool pool;
+    return pool;
+}
+
+}
+
+size_t dy::pool_size() noexcept
+{
+    return instance().size();
+}
+
+void dy::parallel_for(size_t len, index_fn_t fn, void* ctx) noexcept
+{
+    instance().run(len, fn, ctx);
+}
@@ -0,0 +1,264 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <dy.p.hh>
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+/// <summary>
+/// a value whose last reference was released, waiting for a reclaimer
+/// </summary>
+struct deferred
+{
+    dy_t      val;
+    deferred* next;
+};
+
+/// <summary>
+/// a thread deallocating the values deferred to it. Its queue is a lock-free
+/// stack which any thread pushes to and the reclaimer empties at once,
+/// disposing the values in the order they were deferred. The reclaimer sleeps
+/// until a batch of values is queued or a flush is requested.
+/// </summary>
+class reclaimer
+{
+  public:
+    explicit reclaimer(size_t batch) noexcept :
+        batch_ { batch },
+        thread_ { [this] { work(); } }
+    {}
+
+    reclaimer(reclaimer const&) = delete;
+
+    ~reclaimer() noexcept
+    {
+        stop_.store(true, memory_order_release);
+        wake();
+        thread_.join();
+    }
+
+    /// <summary>
+    /// queues the value, which is disposed inline if the queue cannot grow
+    /// </summary>
+    void push(dy_t val) noexcept
+    {
+        auto item = new (nothrow) deferred { val, nullptr };
+        if (item == nullptr)
+        {
+            dy::free_tree(val);
+            return;
+        }
+
+        // counted before pushed, so the values disposed are never more than
+        // the ones counted, and a flush waits for every value counted
+        uint64_t pushed = pushed_.fetch_add(1, memory_order_acq_rel) + 1;
+
+        item->next = head_.load(memory_order_relaxed);
+        while (!head_.compare_exchange_weak(
+            item->next, item, memory_order_release, memory_order_relaxed))
+            ;
+
+        uint64_t done = done_.load(memory_order_acquire);
+        if (pushed > done && pushed - done >= batch_) wake();
+    }
+
+    /// <summary>
+    /// waits until the values queued so far are disposed
+    /// </summary>
+    void flush() noexcept
+    {
+        uint64_t target = pushed_.load(memory_order_acquire);
+        uint64_t flush  = flush_.load(memory_order_relaxed);
+        while (flush < target
+               && !flush_.compare_exchange_weak(
+                   flush, target, memory_order_release, memory_order_relaxed))
+            ;
+        wake();
+
+        for (uint64_t done; (done = done_.load(memory_order_acquire)) < target;)
+            done_.wait(done, memory_order_acquire);
+    }
+
+  private:
+    size_t            batch_;
+    atomic<deferred*> head_ { nullptr };
+    atomic<uint64_t>  pushed_ { 0 };
+    atomic<uint64_t>  done_ { 0 };
+    atomic<bool>      stop_ { false };
+
+    /// <summary>
+    /// the number of the values to dispose without waiting for a batch
+    /// </summary>
+    atomic<uint64_t> flush_ { 0 };
+
+    /// <summary>
+    /// changed whenever the reclaimer is to check its queue
+    /// </summary>
+    atomic<uint32_t> wakes_ { 0 };
+
+    thread thread_;
+
+    void wake() noexcept
+    {
+        wakes_.fetch_add(1, memory_order_release);
+        wakes_.notify_one();
+    }
+
+    void work() noexcept
+    {
+        for (;;)
+        {
+            // read before the counters, so no wake after them is missed
+            uint32_t wakes  = wakes_.load(memory_order_acquire);
+            bool     stop   = stop_.load(memory_order_acquire);
+            uint64_t pushed = pushed_.load(memory_order_acquire);
+            uint64_t done   = done_.load(memory_order_relaxed);
+
+            // a value counted may not be pushed yet, which takes a moment
+            if (pushed > done
+                && (pushed - done >= batch_
+                    || flush_.load(memory_order_acquire) > done))
+            {
+                if (drain() == 0) this_thread::yield();
+                continue;
+            }
+
+            if (stop)
+            {
+                while (drain() != 0)
+                    ;
+                return;
+            }
+            wakes_.wait(wakes, memory_order_acquire);
+        }
+    }
+
+    /// <summary>
+    /// disposes every value in the queue
+    /// </summary>
+    /// <returns>the number of the values disposed</returns>
+    size_t drain() noexcept
+    {
+        deferred* newest = head_.exchange(nullptr, memory_order_acquire);
+
+        deferred* oldest = nullptr;
+        while (newest != nullptr)
+        {
+            deferred* next = newest->next;
+            newest->next   = oldest;
+            oldest         = newest;
+            newest         = next;
+        }
+
+        size_t count = 0;
+        while (oldest != nullptr)
+        {
+            deferred* next = oldest->next;
+            dy::free_tree(oldest->val);
+            delete oldest;
+            oldest = next;
+            ++count;
+        }
+
+        done_.fetch_add(count, memory_order_release);
+        done_.notify_all();
+        return count;
+    }
+};
+
+/// <summary>
+/// the reclaimers shared by the process, which start with the first value
+/// deferred. Each thread deferring values sticks to one of them.
+/// </summary>
+class service
+{
+  public:
+    bool configure(dy_reclaim_opts_t const& opts) noexcept
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (started_.load(memory_order_relaxed)) return false;
+
+        opts_ = opts;
+        return true;
+    }
+
+    reclaimer& pick() noexcept
+    {
+        if (!started_.load(memory_order_acquire)) start();
+
+        thread_local size_t slot = next_.fetch_add(1, memory_order_relaxed);
+        return *reclaimers_[slot % reclaimers_.size()];
+    }
+
+    void flush() noexcept
+    {
+        if (!started_.load(memory_order_acquire)) return;
+        for (auto& reclaimer : reclaimers_) reclaimer->flush();
+    }
+
+  private:
+    mutex                         mutex_;
+    dy_reclaim_opts_t             opts_ {};
+    vector<unique_ptr<reclaimer>> reclaimers_;
+    atomic<bool>                  started_ { false };
+    atomic<size_t>                next_ { 0 };
+
+    void start() noexcept
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (started_.load(memory_order_relaxed)) return;
+
+        size_t threads = opts_.threads != 0 ? opts_.threads : 1;
+        size_t batch   = opts_.batch != 0 ? opts_.batch : 1;
+        for (size_t i = 0; i < threads; ++i)
+            reclaimers_.push_back(make_unique<reclaimer>(batch));
+        started_.store(true, memory_order_release);
+    }
+};
+
+service& instance() noexcept
+{
+    static service service;
+    return service;
+}
+
+}
+
+DY_PUBLIC(void) dy_dispose_deferred(dy_t val) DY_NOEXCEPT
+{
+    assert(val != nullptr);
+    if (!dy::drop_ref(val)) return;
+
+    // values without entries take less time to deallocate than to hand over
+    if (!(val->flags & dy::flag_lazy) && val->type != dy_type_arr
+        && val->type != dy_type_map)
+    {
+        dy::free_tree(val);
+        return;
+    }
+
+    instance().pick().push(val);
+}
+
+DY_PUBLIC(bool)
+dy_reclaim_configure(dy_reclaim_opts_t const* opts) DY_NOEXCEPT
+{
+    assert(opts != nullptr);
+    return instance().configure(*opts);
+}
+
+DY_PUBLIC(void) dy_reclaim_flush(void) DY_NOEXCEPT
+{
+    instance().flush();
+}
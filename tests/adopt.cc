@@ -0,0 +1,152 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+void count_free(void* ptr, void* ctx)
+{
+    ++*static_cast<int*>(ctx);
+    free(ptr);
+}
+
+template <typename T>
+T* alloc_array(size_t len)
+{
+    return static_cast<T*>(malloc(len * sizeof(T)));
+}
+
+}
+
+TEST(AdoptTest, AdoptFrees)
+{
+    int freed = 0;
+
+    int64_t* ptr = alloc_array<int64_t>(4);
+    for (int i = 0; i < 4; ++i) ptr[i] = i * 3;
+
+    dy_t dy = dy_adopt_iarr(ptr, 4, count_free, &freed);
+    ASSERT_EQ(dy_get_type(dy), dy_type_iarr);
+    ASSERT_EQ(dy_get_iarr_len(dy), 4);
+    ASSERT_EQ(dy_get_iarr_data(dy), ptr);
+    ASSERT_EQ(dy_get_iarr_idx(dy, 3), 9);
+
+    dy_t copy = dy_copy(dy);
+    dy_dispose(dy);
+    ASSERT_EQ(freed, 0);
+
+    dy_dispose(copy);
+    ASSERT_EQ(freed, 1);
+}
+
+TEST(AdoptTest, AdoptWithoutFree)
+{
+    double samples[] = { 0.5, 1.5 };
+
+    dy_t dy = dy_adopt_farr(samples, 2, NULL, NULL);
+    ASSERT_EQ(dy_get_farr_data(dy), samples);
+    ASSERT_EQ(dy_get_farr_idx(dy, 1), 1.5);
+    dy_dispose(dy);
+
+    ASSERT_EQ(samples[0], 0.5);
+}
+
+TEST(AdoptTest, AdoptStr)
+{
+    int   freed = 0;
+    char* str   = alloc_array<char>(6);
+    memcpy(str, "hello", 6);
+
+    dy_t dy = dy_adopt_str(str, 5, count_free, &freed);
+    ASSERT_EQ(dy_get_str_len(dy), 5);
+    ASSERT_EQ(dy_get_str_data(dy), str);
+    ASSERT_STREQ(dy_get_str_data(dy), "hello");
+
+    dy_dispose(dy);
+    ASSERT_EQ(freed, 1);
+}
+
+TEST(AdoptTest, ReleaseUnique)
+{
+    uint8_t bytes[] = { 1, 2, 3 };
+
+    dy_t           dy   = dy_make_bytes(bytes, 3);
+    uint8_t const* data = dy_get_bytes_data(dy);
+
+    dy_free_fn_t free_fn;
+    void*        ctx;
+    uint8_t*     released = dy_release_bytes_data(dy, &free_fn, &ctx);
+    ASSERT_EQ(released, data);
+    ASSERT_EQ(dy_get_bytes_len(dy), 0);
+    dy_dispose(dy);
+
+    ASSERT_EQ(released[2], 3);
+    ASSERT_NE(free_fn, nullptr);
+    free_fn(released, ctx);
+}
+
+TEST(AdoptTest, ReleaseAdopted)
+{
+    int   freed = 0;
+    char* str   = alloc_array<char>(4);
+    memcpy(str, "abc", 4);
+
+    dy_t dy = dy_adopt_str(str, 3, count_free, &freed);
+
+    // the buffer goes back with the function it was adopted with
+    dy_free_fn_t free_fn;
+    void*        ctx;
+    char*        released = dy_release_str_data(dy, &free_fn, &ctx);
+    ASSERT_EQ(released, str);
+    ASSERT_EQ(free_fn, count_free);
+    ASSERT_EQ(ctx, &freed);
+
+    dy_dispose(dy);
+    ASSERT_EQ(freed, 0);
+
+    free_fn(released, ctx);
+    ASSERT_EQ(freed, 1);
+}
+
+TEST(AdoptTest, ReleaseShared)
+{
+    int64_t samples[] = { 4, 5, 6 };
+
+    dy_t dy   = dy_make_iarr(samples, 3);
+    dy_t copy = dy_copy(dy);
+
+    // the other reference keeps seeing the buffer, so a copy is handed out
+    dy_free_fn_t free_fn;
+    void*        ctx;
+    int64_t*     released = dy_release_iarr_data(dy, &free_fn, &ctx);
+    ASSERT_NE(released, dy_get_iarr_data(copy));
+    ASSERT_EQ(dy_get_iarr_len(copy), 3);
+    ASSERT_EQ(released[1], 5);
+
+    free_fn(released, ctx);
+    dy_dispose(dy);
+    dy_dispose(copy);
+}
+
+TEST(AdoptTest, ReleaseArena)
+{
+    dy_arena_t arena = dy_arena_create(0);
+
+    dy_t dy = dy_arena_make_str(arena, "arena");
+
+    dy_free_fn_t free_fn;
+    void*        ctx;
+    char*        released = dy_release_str_data(dy, &free_fn, &ctx);
+    ASSERT_STREQ(released, "arena");
+
+    dy_arena_destroy(arena);
+
+    // the copy outlives the arena
+    ASSERT_STREQ(released, "arena");
+    free_fn(released, ctx);
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <string>
+#include <vector>
+
+dy_t make_arena_record(dy_arena_t arena, int64_t id) DY_NOEXCEPT
+{
+    int64_t samples[] = { id, id + 1, id + 2 };
+
+    dy_keyval_t fields[] = {
+        { "id", dy_arena_make_i(arena, id) },
+        { "name", dy_arena_make_str(arena, "record") },
+        { "samples", dy_arena_make_iarr(arena, samples, 3) },
+        { "valid", dy_arena_make_b(arena, true) },
+    };
+
+    return dy_arena_make_map(arena, fields, 4);
+}
+
+TEST(ArenaTest, BuildTree)
+{
+    dy_arena_t arena = dy_arena_create(0);
+    ASSERT_NE(arena, nullptr);
+
+    dy_t records[16];
+    for (int i = 0; i < 16; ++i) records[i] = make_arena_record(arena, i);
+
+    dy_t arr = dy_arena_make_arr(arena, records, 16);
+    ASSERT_EQ(dy_get_type(arr), dy_type_arr);
+    ASSERT_EQ(dy_get_arr_len(arr), 16);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        dy_t record = dy_get_arr_idx(arr, i);
+        ASSERT_EQ(dy_get_type(record), dy_type_map);
+        ASSERT_EQ(dy_get_map_len(record), 4);
+        ASSERT_EQ(dy_get_i(dy_get_map_key(record, "id").val), i);
+        ASSERT_STREQ(dy_get_str_data(dy_get_map_key(record, "name").val),
+                     "record");
+        ASSERT_EQ(dy_get_iarr_idx(dy_get_map_key(record, "samples").val, 2),
+                  i + 2);
+    }
+
+    // does nothing on arena values
+    dy_dispose(arr);
+
+    dy_arena_destroy(arena);
+}
+
+TEST(ArenaTest, ResetReusesBlocks)
+{
+    dy_arena_t arena = dy_arena_create(4096);
+
+    for (int i = 0; i < 64; ++i) make_arena_record(arena, i);
+    size_t capacity = dy_arena_capacity(arena);
+    ASSERT_GT(capacity, 4096);
+
+    dy_arena_reset(arena);
+    for (int i = 0; i < 64; ++i) make_arena_record(arena, i);
+    ASSERT_EQ(dy_arena_capacity(arena), capacity);
+
+    dy_arena_destroy(arena);
+}
+
+TEST(ArenaTest, LargeAllocation)
+{
+    dy_arena_t arena = dy_arena_create(256);
+
+    int64_t data[1024];
+    for (int i = 0; i < 1024; ++i) data[i] = i;
+
+    dy_t iarr = dy_arena_make_iarr(arena, data, 1024);
+    ASSERT_EQ(dy_get_iarr_len(iarr), 1024);
+    ASSERT_EQ(dy_get_iarr_idx(iarr, 1023), 1023);
+
+    // blocks larger than the block size are returned on reset
+    dy_arena_reset(arena);
+    ASSERT_LE(dy_arena_capacity(arena), 256);
+
+    dy_arena_destroy(arena);
+}
+
+TEST(ArenaTest, UnalignedBlocks)
+{
+    // blocks whose sizes are not multiples of the alignment, whether given or
+    // made for a large allocation, leave aligned values past their ends
+    for (size_t block_size : { 0, 100, 1001 })
+    {
+        dy_arena_t arena = dy_arena_create(block_size);
+
+        std::string large(65537, 'x');
+        dy_t        str = dy_arena_make_str_len(arena, large.data(), 65537);
+
+        std::vector<dy_t> nums;
+        for (int i = 0; i < 100; ++i)
+        {
+            dy_arena_make_str_len(arena, large.data(), i % 7);
+            nums.push_back(dy_arena_make_i(arena, INT64_MAX - i));
+        }
+
+        ASSERT_EQ(dy_get_str_len(str), 65537);
+        for (int i = 0; i < 100; ++i)
+            ASSERT_EQ(dy_get_i(nums[i]), INT64_MAX - i);
+
+        dy_arena_destroy(arena);
+    }
+}
+
+TEST(ArenaTest, CopyLeavesArena)
+{
+    dy_arena_t arena = dy_arena_create(0);
+    dy_t       copy  = dy_copy(make_arena_record(arena, 7));
+    dy_arena_destroy(arena);
+
+    ASSERT_EQ(dy_get_type(copy), dy_type_map);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(copy, "id").val), 7);
+    ASSERT_STREQ(dy_get_str_data(dy_get_map_key(copy, "name").val), "record");
+
+    dy_dispose(copy);
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+unique_ptr<bool[]> random_bools(size_t len, uint64_t seed)
+{
+    unique_ptr<bool[]> bools(new bool[len]);
+    mt19937_64         rng(seed);
+    for (size_t i = 0; i < len; ++i) bools[i] = rng() % 3 == 0;
+    return bools;
+}
+
+}
+
+TEST(BarrTest, Words)
+{
+    for (size_t len : { 0, 1, 7, 63, 64, 65, 200 })
+    {
+        auto bools = random_bools(len, len);
+        dy_t dy    = dy_make_barr(bools.get(), len);
+
+        uint64_t const* words = dy_get_barr_words(dy);
+        for (size_t i = 0; i < len; ++i)
+        {
+            ASSERT_EQ(dy_get_barr_idx(dy, i), bools[i]);
+            ASSERT_EQ((words[i / 64] >> (i % 64)) & 1, bools[i]);
+        }
+
+        // the bits after the last entry are zero
+        if (len % 64 != 0)
+        {
+            ASSERT_EQ(words[len / 64] >> (len % 64), 0);
+        }
+
+        dy_t copy = dy_make_barr_words(words, len);
+        for (size_t i = 0; i < len; ++i)
+            ASSERT_EQ(dy_get_barr_idx(copy, i), bools[i]);
+
+        dy_dispose(copy);
+        dy_dispose(dy);
+    }
+}
+
+TEST(BarrTest, WordsTail)
+{
+    uint64_t words[] = { ~uint64_t(0), ~uint64_t(0) };
+
+    // the bits after the last entry are cleared
+    dy_t dy = dy_make_barr_words(words, 70);
+    ASSERT_EQ(dy_get_barr_words(dy)[1], 0x3f);
+    ASSERT_EQ(dy_barr_popcount(dy), 70);
+    dy_dispose(dy);
+}
+
+TEST(BarrTest, Range)
+{
+    constexpr size_t len   = 1000;
+    auto             bools = random_bools(len, 1);
+    dy_t             dy    = dy_make_barr(bools.get(), len);
+
+    vector<bool> expected(bools.get(), bools.get() + len);
+    for (size_t first : { 0, 3, 8, 61, 64, 500 })
+    {
+        for (size_t n : { 0, 1, 9, 64, 130, 300 })
+        {
+            unique_ptr<bool[]> out(new bool[n + 1]);
+            out[n] = true;
+
+            dy_get_barr_range(dy, first, n, out.get());
+            for (size_t i = 0; i < n; ++i)
+                ASSERT_EQ(out[i], expected[first + i]);
+            ASSERT_TRUE(out[n]);
+        }
+    }
+
+    dy_dispose(dy);
+}
+
+TEST(BarrTest, PopcountAndFind)
+{
+    constexpr size_t len   = 777;
+    auto             bools = random_bools(len, 2);
+    dy_t             dy    = dy_make_barr(bools.get(), len);
+
+    size_t count = 0;
+    for (size_t i = 0; i < len; ++i) count += bools[i];
+    ASSERT_EQ(dy_barr_popcount(dy), count);
+
+    // visits every set entry
+    size_t visited = 0;
+    for (size_t i = dy_barr_find_first(dy, 0); i < len;
+         i        = dy_barr_find_first(dy, i + 1))
+    {
+        ASSERT_TRUE(bools[i]);
+        ++visited;
+    }
+    ASSERT_EQ(visited, count);
+    ASSERT_EQ(dy_barr_find_first(dy, len), len);
+
+    dy_dispose(dy);
+
+    bool none[100] = {};
+    dy             = dy_make_barr(none, 100);
+    ASSERT_EQ(dy_barr_find_first(dy, 0), 100);
+    dy_dispose(dy);
+}
+
+TEST(BarrTest, Combine)
+{
+    constexpr size_t len = 300;
+    auto             a   = random_bools(len, 3);
+    auto             b   = random_bools(len, 4);
+
+    dy_t lhs = dy_make_barr(a.get(), len);
+    dy_t rhs = dy_make_barr(b.get(), len);
+
+    dy_t both   = dy_barr_and(lhs, rhs);
+    dy_t either = dy_barr_or(lhs, rhs);
+    dy_t one    = dy_barr_xor(lhs, rhs);
+
+    ASSERT_EQ(dy_get_barr_len(both), len);
+    for (size_t i = 0; i < len; ++i)
+    {
+        ASSERT_EQ(dy_get_barr_idx(both, i), a[i] && b[i]);
+        ASSERT_EQ(dy_get_barr_idx(either, i), a[i] || b[i]);
+        ASSERT_EQ(dy_get_barr_idx(one, i), a[i] != b[i]);
+    }
+
+    dy_dispose(both);
+    dy_dispose(either);
+    dy_dispose(one);
+    dy_dispose(lhs);
+    dy_dispose(rhs);
+}
@@ -0,0 +1,254 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include "sink.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+/// <summary>
+/// builds a record with a nested array and map
+/// </summary>
+void build_record(dy_builder_t builder, int64_t id, size_t hint)
+{
+    dy_builder_begin_map(builder, hint);
+    dy_builder_key(builder, "id");
+    dy_builder_push_i(builder, id);
+    dy_builder_key(builder, "name");
+    dy_builder_push_str(builder, "record");
+    dy_builder_key(builder, "tags");
+    dy_builder_begin_arr(builder, hint);
+    dy_builder_push_str_len(builder, "ab", 1);
+    dy_builder_push_b(builder, true);
+    dy_builder_push_null(builder);
+    dy_builder_end(builder);
+    dy_builder_key_n(builder, "inner!", 5);
+    dy_builder_begin_map(builder, 0);
+    dy_builder_key(builder, "f");
+    dy_builder_push_f(builder, 0.5);
+    dy_builder_end(builder);
+    dy_builder_end(builder);
+}
+
+char const record[] = R"({"id":1,"name":"record","tags":["a",true,null],)"
+                      R"("inner":{"f":0.5}})";
+
+}
+
+TEST(BuilderTest, Nested)
+{
+    dy_builder_t builder = dy_builder_create(NULL);
+    ASSERT_NE(builder, nullptr);
+
+    build_record(builder, 1, 0);
+    dy_t val = dy_builder_finish(builder);
+    ASSERT_EQ(to_json(val), record);
+    dy_dispose(val);
+
+    // the builder is reused, and the hints do not change the value
+    build_record(builder, 1, 100);
+    val = dy_builder_finish(builder);
+    ASSERT_EQ(to_json(val), record);
+    dy_dispose(val);
+
+    ASSERT_EQ(dy_builder_finish(builder), nullptr);
+    dy_builder_destroy(builder);
+}
+
+TEST(BuilderTest, Scalar)
+{
+    dy_builder_t builder = dy_builder_create(NULL);
+
+    dy_builder_push_i(builder, INT64_MAX);
+    dy_t val = dy_builder_finish(builder);
+    ASSERT_EQ(dy_get_i(val), INT64_MAX);
+    dy_dispose(val);
+
+    dy_builder_push(builder, dy_make_str("pushed"));
+    val = dy_builder_finish(builder);
+    ASSERT_STREQ(dy_get_str_data(val), "pushed");
+    dy_dispose(val);
+
+    dy_builder_destroy(builder);
+}
+
+TEST(BuilderTest, Large)
+{
+    vector<string> keys;
+    for (int i = 0; i < 1000; ++i) keys.push_back("key_" + to_string(i));
+
+    dy_builder_t builder = dy_builder_create(NULL);
+    dy_builder_begin_arr(builder, 0);
+    for (int i = 0; i < 1000; ++i) dy_builder_push_i(builder, i);
+    dy_builder_begin_map(builder, 0);
+    for (int i = 0; i < 1000; ++i)
+    {
+        dy_builder_key(builder, keys[i].c_str());
+        dy_builder_push_i(builder, i);
+    }
+    dy_builder_end(builder);
+    dy_builder_end(builder);
+
+    dy_t arr = dy_builder_finish(builder);
+    ASSERT_EQ(dy_get_arr_len(arr), 1001);
+    ASSERT_EQ(dy_get_i(dy_get_arr_idx(arr, 999)), 999);
+
+    dy_t map = dy_get_arr_idx(arr, 1000);
+    ASSERT_EQ(dy_get_map_len(map), 1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_EQ(dy_get_i(dy_get_map_key(map, keys[i].c_str()).val), i);
+        ASSERT_STREQ(dy_get_map_idx(map, i).key, keys[i].c_str());
+    }
+
+    dy_dispose(arr);
+    dy_builder_destroy(builder);
+}
+
+TEST(BuilderTest, Duplicates)
+{
+    dy_builder_t builder = dy_builder_create(NULL);
+
+    // the first entry wins, and the others are disposed with their entries
+    dy_builder_begin_map(builder, 0);
+    dy_builder_key(builder, "a");
+    dy_builder_push_str(builder, "first");
+    dy_builder_key(builder, "a");
+    dy_builder_push_str(builder, "second");
+    dy_builder_key(builder, "a");
+    dy_builder_begin_arr(builder, 4);
+    dy_builder_push_str(builder, "third");
+    dy_builder_end(builder);
+    dy_builder_end(builder);
+
+    dy_t val = dy_builder_finish(builder);
+    ASSERT_EQ(to_json(val), R"({"a":"first"})");
+    dy_dispose(val);
+    dy_builder_destroy(builder);
+}
+
+TEST(BuilderTest, Shapes)
+{
+    dy_builder_t builder = dy_builder_create(NULL);
+    dy_builder_begin_arr(builder, 0);
+    for (int i = 0; i < 3; ++i) build_record(builder, i, 0);
+    dy_builder_end(builder);
+    dy_t arr = dy_builder_finish(builder);
+
+    // maps with the same keys share a shape, as made by dy_make_map
+    dy_shape_t shape = dy_get_map_shape(dy_get_arr_idx(arr, 0));
+    ASSERT_EQ(dy_get_map_shape(dy_get_arr_idx(arr, 2)), shape);
+
+    dy_keyval_t pairs[] = {
+        { "id", dy_make_i(0) },
+        { "name", dy_make_null() },
+        { "tags", dy_make_null() },
+        { "inner", dy_make_null() },
+    };
+    dy_t made = dy_make_map(pairs, 4);
+    ASSERT_EQ(dy_get_map_shape(made), shape);
+
+    // and are copied when changed
+    dy_t first = dy_retain(dy_get_arr_idx(arr, 0));
+    first      = dy_map_set(first, "x", dy_make_i(1));
+    ASSERT_NE(dy_get_map_shape(first), shape);
+    ASSERT_EQ(dy_get_map_len(dy_get_arr_idx(arr, 1)), 4);
+
+    dy_dispose(first);
+    dy_dispose(made);
+    dy_dispose(arr);
+    dy_builder_destroy(builder);
+}
+
+TEST(BuilderTest, Mismatch)
+{
+    // maps at the same depth whose keys differ from the previous ones
+    vector<vector<string>> records = {
+        { "a", "b", "c" },
+        { "a", "b" },
+        { "a", "x", "c" },
+        { "a", "x", "c", "d" },
+        {},
+        { "c", "a" },
+        { "a", "a", "b" },
+        { "a", "b", "c" },
+    };
+
+    for (dy_arena_t arena : { (dy_arena_t)NULL, dy_arena_create(0) })
+    {
+        dy_builder_t builder = dy_builder_create(arena);
+        dy_builder_begin_arr(builder, 0);
+        for (auto const& keys : records)
+        {
+            dy_builder_begin_map(builder, 0);
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                dy_builder_key(builder, keys[i].c_str());
+                dy_builder_push_i(builder, i);
+            }
+            dy_builder_end(builder);
+        }
+        dy_builder_end(builder);
+
+        dy_t arr = dy_builder_finish(builder);
+        ASSERT_EQ(to_json(arr),
+                  R"([{"a":0,"b":1,"c":2},{"a":0,"b":1},{"a":0,"x":1,"c":2},)"
+                  R"({"a":0,"x":1,"c":2,"d":3},{},{"c":0,"a":1},)"
+                  R"({"a":0,"b":2},{"a":0,"b":1,"c":2}])");
+        ASSERT_EQ(dy_get_map_key(dy_get_arr_idx(arr, 1), "c").key, nullptr);
+
+        if (arena == NULL)
+        {
+            ASSERT_EQ(dy_get_map_shape(dy_get_arr_idx(arr, 0)),
+                      dy_get_map_shape(dy_get_arr_idx(arr, 7)));
+            dy_dispose(arr);
+        }
+
+        dy_builder_destroy(builder);
+        if (arena != NULL) dy_arena_destroy(arena);
+    }
+}
+
+TEST(BuilderTest, Arena)
+{
+    dy_arena_t   arena   = dy_arena_create(0);
+    dy_builder_t builder = dy_builder_create(arena);
+
+    dy_builder_begin_arr(builder, 100);
+    for (int i = 0; i < 100; ++i) build_record(builder, 1, 4);
+    dy_builder_push(builder, dy_arena_make_str(arena, "end"));
+    dy_builder_end(builder);
+    dy_t arr = dy_builder_finish(builder);
+
+    ASSERT_EQ(dy_get_arr_len(arr), 101);
+    ASSERT_EQ(to_json(dy_get_arr_idx(arr, 99)), record);
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(arr, 100)), "end");
+
+    // copies of the values do not belong to the arena
+    dy_t copy = dy_copy(arr);
+    dy_builder_destroy(builder);
+    dy_arena_destroy(arena);
+    ASSERT_EQ(to_json(dy_get_arr_idx(copy, 0)), record);
+    dy_dispose(copy);
+}
+
+TEST(BuilderTest, Unfinished)
+{
+    // the value being built is disposed with the builder
+    dy_builder_t builder = dy_builder_create(NULL);
+    dy_builder_begin_arr(builder, 0);
+    dy_builder_push_str(builder, "left");
+    dy_builder_begin_map(builder, 0);
+    dy_builder_key(builder, "a");
+    dy_builder_push_str(builder, "open");
+    dy_builder_key(builder, "a");
+    dy_builder_begin_arr(builder, 0);
+    dy_builder_push_str(builder, "discarded");
+    dy_builder_destroy(builder);
+}
@@ -0,0 +1,178 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <vector>
+
+namespace
+{
+
+dy_t make_ints(int64_t first, size_t len)
+{
+    std::vector<dy_t> ints(len);
+    for (size_t i = 0; i < len; ++i) ints[i] = dy_make_i(first + i);
+    return dy_make_arr(ints.data(), len);
+}
+
+}
+
+TEST(CompactTest, Integers)
+{
+    size_t saved = 0;
+    dy_t   arr   = dy_compact(make_ints(-2, 5), dy_compact_default, &saved);
+
+    ASSERT_EQ(dy_get_type(arr), dy_type_iarr);
+    ASSERT_EQ(dy_get_iarr_len(arr), 5);
+    ASSERT_EQ(dy_get_iarr_idx(arr, 0), -2);
+    ASSERT_EQ(dy_get_iarr_idx(arr, 4), 2);
+
+    dy_dispose(arr);
+}
+
+TEST(CompactTest, SavedBytes)
+{
+    // integers which do not fit in the handles take a node each
+    size_t saved = 0;
+    dy_t   arr   = dy_compact(
+        make_ints(INT64_C(1) << 60, 100), dy_compact_default, &saved);
+
+    ASSERT_EQ(dy_get_type(arr), dy_type_iarr);
+    ASSERT_EQ(dy_get_iarr_idx(arr, 99), (INT64_C(1) << 60) + 99);
+    ASSERT_GE(saved, 100 * sizeof(int64_t));
+
+    dy_dispose(arr);
+}
+
+TEST(CompactTest, BooleansAndNumbers)
+{
+    dy_t bools[] = { dy_make_b(true), dy_make_b(false), dy_make_b(true) };
+    dy_t nums[]  = { dy_make_f(0.5), dy_make_f(-1.5) };
+
+    dy_t barr = dy_compact(dy_make_arr(bools, 3), dy_compact_default, NULL);
+    ASSERT_EQ(dy_get_type(barr), dy_type_barr);
+    ASSERT_EQ(dy_get_barr_len(barr), 3);
+    ASSERT_TRUE(dy_get_barr_idx(barr, 0));
+    ASSERT_FALSE(dy_get_barr_idx(barr, 1));
+    ASSERT_TRUE(dy_get_barr_idx(barr, 2));
+
+    dy_t farr = dy_compact(dy_make_arr(nums, 2), dy_compact_default, NULL);
+    ASSERT_EQ(dy_get_type(farr), dy_type_farr);
+    ASSERT_EQ(dy_get_farr_idx(farr, 1), -1.5);
+
+    dy_dispose(barr);
+    dy_dispose(farr);
+}
+
+TEST(CompactTest, LeftAsIs)
+{
+    dy_t mixed[] = { dy_make_i(1), dy_make_f(1.0) };
+
+    dy_t arr   = dy_make_arr(mixed, 2);
+    dy_t empty = dy_make_arr(NULL, 0);
+
+    ASSERT_EQ(dy_compact(arr, dy_compact_default, NULL), arr);
+    ASSERT_EQ(dy_compact(empty, dy_compact_default, NULL), empty);
+    ASSERT_EQ(dy_get_type(arr), dy_type_arr);
+
+    dy_dispose(arr);
+    dy_dispose(empty);
+}
+
+TEST(CompactTest, Flags)
+{
+    dy_t bytes = dy_compact(make_ints(0, 256), dy_compact_bytes, NULL);
+    ASSERT_EQ(dy_get_type(bytes), dy_type_bytes);
+    ASSERT_EQ(dy_get_bytes_idx(bytes, 255), 255);
+
+    dy_t i8 = dy_compact(make_ints(-128, 256), dy_compact_bytes, NULL);
+    ASSERT_EQ(dy_get_type(i8), dy_type_iarr);
+    dy_dispose(i8);
+
+    i8 = dy_compact(make_ints(-128, 256), dy_compact_narrow, NULL);
+    ASSERT_EQ(dy_get_type(i8), dy_type_i8arr);
+    ASSERT_EQ(dy_get_i8arr_idx(i8, 0), -128);
+
+    dy_t i32 = dy_compact(make_ints(-40000, 3), dy_compact_narrow, NULL);
+    ASSERT_EQ(dy_get_type(i32), dy_type_i32arr);
+
+    dy_t u32 = dy_compact(make_ints(INT32_MAX, 3), dy_compact_narrow, NULL);
+    ASSERT_EQ(dy_get_type(u32), dy_type_u32arr);
+    ASSERT_EQ(dy_get_u32arr_idx(u32, 2), UINT32_C(0x80000001));
+
+    dy_dispose(bytes);
+    dy_dispose(i8);
+    dy_dispose(i32);
+    dy_dispose(u32);
+}
+
+TEST(CompactTest, Nested)
+{
+    dy_t bools[] = { dy_make_b(false), dy_make_b(true) };
+    dy_t mixed[] = { dy_make_i(1), dy_make_str("x") };
+    dy_t inner[] = { make_ints(0, 3), dy_make_arr(mixed, 2) };
+
+    dy_keyval_t pairs[] = {
+        { "ints", dy_make_arr(inner, 2) },
+        { "bools", dy_make_arr(bools, 2) },
+    };
+
+    dy_t map = dy_compact(dy_make_map(pairs, 2), dy_compact_default, NULL);
+    ASSERT_EQ(dy_get_type(map), dy_type_map);
+
+    dy_t ints = dy_get_map_key(map, "ints").val;
+    ASSERT_EQ(dy_get_type(ints), dy_type_arr);
+    ASSERT_EQ(dy_get_type(dy_get_arr_idx(ints, 0)), dy_type_iarr);
+    ASSERT_EQ(dy_get_type(dy_get_arr_idx(ints, 1)), dy_type_arr);
+    ASSERT_EQ(dy_get_type(dy_get_map_key(map, "bools").val), dy_type_barr);
+
+    dy_dispose(map);
+}
+
+TEST(CompactTest, Shared)
+{
+    dy_t arr  = make_ints(0, 4);
+    dy_t copy = dy_copy(arr);
+
+    // the other reference keeps seeing the generic array
+    dy_t compacted = dy_compact(arr, dy_compact_default, NULL);
+    ASSERT_EQ(dy_get_type(compacted), dy_type_iarr);
+    ASSERT_EQ(dy_get_type(copy), dy_type_arr);
+    ASSERT_EQ(dy_get_i(dy_get_arr_idx(copy, 3)), 3);
+
+    dy_dispose(compacted);
+    dy_dispose(copy);
+}
+
+TEST(CompactTest, Arena)
+{
+    dy_arena_t arena = dy_arena_create(0);
+
+    dy_t nums[] = { dy_arena_make_f(arena, 1.5), dy_arena_make_f(arena, 2.5) };
+    dy_t arr    = dy_arena_make_arr(arena, nums, 2);
+
+    dy_t compacted = dy_compact(arr, dy_compact_default, NULL);
+    dy_arena_destroy(arena);
+
+    // the compacted array does not belong to the arena
+    ASSERT_EQ(dy_get_type(compacted), dy_type_farr);
+    ASSERT_EQ(dy_get_farr_idx(compacted, 1), 2.5);
+    dy_dispose(compacted);
+}
+
+TEST(CompactTest, MakeArr)
+{
+    dy_t ints[]  = { dy_make_i(7), dy_make_i(-7) };
+    dy_t mixed[] = { dy_make_i(7), dy_make_null() };
+
+    dy_t iarr = dy_make_arr_compact(ints, 2, dy_compact_narrow);
+    ASSERT_EQ(dy_get_type(iarr), dy_type_i8arr);
+    ASSERT_EQ(dy_get_i8arr_idx(iarr, 1), -7);
+
+    dy_t arr = dy_make_arr_compact(mixed, 2, dy_compact_narrow);
+    ASSERT_EQ(dy_get_type(arr), dy_type_arr);
+    ASSERT_EQ(dy_get_arr_len(arr), 2);
+
+    dy_dispose(iarr);
+    dy_dispose(arr);
+}
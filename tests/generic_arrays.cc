@@ -54,19 +54,19 @@ TEST(GenericArrayTest, DoubledArray)
     ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(arr, 0)), "hello");
     ASSERT_EQ(dy_get_type(dy_get_arr_idx(arr, 3)), dy_type_str);
     ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(arr, 3)), "hello");
-    ASSERT_NE(dy_get_arr_idx(arr, 0), dy_get_arr_idx(arr, 3));
+    ASSERT_EQ(dy_get_arr_idx(arr, 0), dy_get_arr_idx(arr, 3));
 
     ASSERT_EQ(dy_get_type(dy_get_arr_idx(arr, 1)), dy_type_i);
     ASSERT_EQ(dy_get_i(dy_get_arr_idx(arr, 1)), 15);
     ASSERT_EQ(dy_get_type(dy_get_arr_idx(arr, 4)), dy_type_i);
     ASSERT_EQ(dy_get_i(dy_get_arr_idx(arr, 4)), 15);
-    ASSERT_NE(dy_get_arr_idx(arr, 1), dy_get_arr_idx(arr, 4));
+    ASSERT_EQ(dy_get_arr_idx(arr, 1), dy_get_arr_idx(arr, 4));
 
     ASSERT_EQ(dy_get_type(dy_get_arr_idx(arr, 2)), dy_type_b);
     ASSERT_EQ(dy_get_b(dy_get_arr_idx(arr, 2)), true);
     ASSERT_EQ(dy_get_type(dy_get_arr_idx(arr, 5)), dy_type_b);
     ASSERT_EQ(dy_get_b(dy_get_arr_idx(arr, 5)), true);
-    ASSERT_NE(dy_get_arr_idx(arr, 2), dy_get_arr_idx(arr, 5));
+    ASSERT_EQ(dy_get_arr_idx(arr, 2), dy_get_arr_idx(arr, 5));
 
     dy_dispose(arr);
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <gtest/gtest.h>
 
 #include "dll.h"
+#include <string>
+#include <vector>
 
 TEST(GenericMapTest, DllRetrieve)
 {
@@ -43,4 +45,200 @@ TEST(GenericMapTest, DllRetrieve)
 
     dy_dispose_map_iter(iter);
     dy_dispose(dy);
-}
\ No newline at end of file
+}
+
+TEST(GenericMapTest, LargeMap)
+{
+    constexpr size_t len = 10000;
+
+    std::vector<std::string> keys;
+    std::vector<dy_keyval_t> pairs;
+    for (size_t i = 0; i < len; ++i) keys.push_back("key" + std::to_string(i));
+    for (size_t i = 0; i < len; ++i)
+        pairs.push_back({ keys[i].c_str(), dy_make_i(i) });
+
+    dy_t dy = dy_make_map(pairs.data(), len);
+    ASSERT_EQ(dy_get_map_len(dy), len);
+
+    for (size_t i = 0; i < len; ++i)
+    {
+        dy_keyval_t keyval = dy_get_map_key(dy, keys[i].c_str());
+        ASSERT_STREQ(keyval.key, keys[i].c_str());
+        ASSERT_EQ(dy_get_i(keyval.val), i);
+    }
+
+    ASSERT_EQ(dy_get_map_key(dy, "key").key, nullptr);
+    ASSERT_EQ(dy_get_map_key(dy, "key10000").val, nullptr);
+
+    size_t    count = 0;
+    dy_iter_t iter  = dy_make_map_iter(dy);
+    for (dy_keyval_t keyval = dy_get_map_iter(dy, iter); keyval.key != NULL;
+         keyval             = dy_get_map_iter(dy, iter))
+    {
+        ASSERT_EQ(std::to_string(dy_get_i(keyval.val)), keyval.key + 3);
+        ++count;
+    }
+    dy_dispose_map_iter(iter);
+    ASSERT_EQ(count, len);
+
+    dy_t copy = dy_copy(dy);
+    dy_dispose(dy);
+
+    ASSERT_EQ(dy_get_type(copy), dy_type_map);
+    ASSERT_EQ(dy_get_map_len(copy), len);
+    for (size_t i = 0; i < len; i += 97)
+        ASSERT_EQ(dy_get_i(dy_get_map_key(copy, keys[i].c_str()).val), i);
+
+    dy_dispose(copy);
+}
+
+TEST(GenericMapTest, EdgeKeys)
+{
+    dy_keyval_t pairs[] = {
+        { "", dy_make_i(1) },
+        { "a", dy_make_i(2) },
+        { "a", dy_make_i(3) },
+    };
+
+    // the first pair wins
+    dy_t dy = dy_make_map(pairs, 3);
+
+    ASSERT_EQ(dy_get_map_len(dy), 2);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(dy, "").val), 1);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(dy, "a").val), 2);
+
+    dy_dispose(dy);
+}
+
+TEST(GenericMapTest, SharedPrefixes)
+{
+    // keys sharing the first 8 bytes, around the size without an index
+    for (size_t len : { 1, 15, 16, 17, 40 })
+    {
+        std::vector<std::string> keys;
+        std::vector<dy_keyval_t> pairs;
+        for (size_t i = 0; i < len; ++i)
+            keys.push_back(std::string(i % 12, 'k') + "_prefix_"
+                           + std::to_string(i));
+        for (size_t i = 0; i < len; ++i)
+            pairs.push_back({ keys[i].c_str(), dy_make_i(i) });
+
+        dy_t dy = dy_make_map(pairs.data(), len);
+        ASSERT_EQ(dy_get_map_len(dy), len);
+
+        for (size_t i = 0; i < len; ++i)
+            ASSERT_EQ(dy_get_i(dy_get_map_key(dy, keys[i].c_str()).val), i);
+
+        ASSERT_EQ(dy_get_map_key(dy, "_prefix_").key, nullptr);
+        ASSERT_EQ(dy_get_map_key(dy, "_prefix_00").key, nullptr);
+        ASSERT_EQ(dy_get_map_key(dy, "kk_prefix_9").key, nullptr);
+
+        dy_dispose(dy);
+    }
+}
+
+TEST(GenericMapTest, LengthAndHash)
+{
+    for (size_t len : { 3, 100 })
+    {
+        std::vector<std::string> keys;
+        std::vector<dy_keyval_t> pairs;
+        for (size_t i = 0; i < len; ++i)
+            keys.push_back("field" + std::to_string(i));
+        for (size_t i = 0; i < len; ++i)
+            pairs.push_back({ keys[i].c_str(), dy_make_i(i) });
+
+        dy_t dy = dy_make_map(pairs.data(), len);
+
+        for (size_t i = 0; i < len; ++i)
+        {
+            // the key is followed by other characters
+            std::string padded = keys[i] + "_suffix";
+            size_t      n      = keys[i].size();
+
+            dy_keyval_t keyval = dy_get_map_key_n(dy, padded.c_str(), n);
+            ASSERT_STREQ(keyval.key, keys[i].c_str());
+            ASSERT_EQ(dy_get_i(keyval.val), i);
+
+            uint64_t hash = dy_hash_key(padded.c_str(), n);
+            ASSERT_EQ(hash, dy_hash_key(keys[i].c_str(), n));
+            keyval = dy_get_map_key_hashed(dy, padded.c_str(), n, hash);
+            ASSERT_EQ(dy_get_i(keyval.val), i);
+        }
+
+        ASSERT_EQ(dy_get_map_key_n(dy, "field1", 5).key, nullptr);
+        ASSERT_EQ(dy_get_map_key_hashed(dy, "x", 1, dy_hash_key("x", 1)).val,
+                  nullptr);
+
+        dy_dispose(dy);
+    }
+}
+
+TEST(GenericMapTest, Traversal)
+{
+    dy_keyval_t pairs[] = {
+        { "a", dy_make_i(1) },
+        { "b", dy_make_str("two") },
+        { "c", dy_make_f(3.5) },
+        { "d", dy_make_null() },
+        { "e", dy_make_i(5) },
+        { "f", dy_make_str("six") },
+    };
+
+    std::string json = R"({"a":1,"b":"two","c":3.5,"d":null,"e":5,"f":"six"})";
+
+    dy_parse_opts_t opts {};
+    opts.lazy = true;
+
+    dy_t maps[] = {
+        dy_make_map(pairs, 6),
+        dy_parse_json(json.data(), json.size(), &opts),
+    };
+
+    for (dy_t dy : maps)
+    {
+        // the iterator lives on the stack
+        dy_iter_state_t state;
+        dy_iter_t       iter = &state;
+        dy_init_map_iter(dy, iter);
+        for (size_t i = 0; i < 6; ++i)
+            ASSERT_EQ(dy_get_map_iter(dy, iter).key[0], 'a' + i);
+        ASSERT_EQ(dy_get_map_iter(dy, iter).key, nullptr);
+
+        std::string keys;
+        ASSERT_TRUE(dy_map_foreach(
+            dy,
+            [](void* ctx, dy_keyval_t keyval) {
+                static_cast<std::string*>(ctx)->append(keyval.key);
+                return true;
+            },
+            &keys));
+        ASSERT_EQ(keys, "abcdef");
+
+        // the function stops the traversal
+        keys.clear();
+        ASSERT_FALSE(dy_map_foreach(
+            dy,
+            [](void* ctx, dy_keyval_t keyval) {
+                static_cast<std::string*>(ctx)->append(keyval.key);
+                return dy_get_type(keyval.val) != dy_type_f;
+            },
+            &keys));
+        ASSERT_EQ(keys, "abc");
+
+        dy_keyval_t out[8];
+        ASSERT_EQ(dy_map_export(dy, out, 8), 6);
+        for (size_t i = 0; i < 6; ++i)
+        {
+            ASSERT_EQ(out[i].key[0], 'a' + i);
+            ASSERT_EQ(out[i].val, dy_get_map_idx(dy, i).val);
+        }
+        ASSERT_STREQ(dy_get_str_data(out[5].val), "six");
+
+        ASSERT_EQ(dy_map_export(dy, out, 2), 2);
+        ASSERT_STREQ(out[1].key, "b");
+        ASSERT_EQ(dy_map_export(dy, NULL, 0), 0);
+
+        dy_dispose(dy);
+    }
+}
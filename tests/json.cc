@@ -0,0 +1,435 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include "sink.h"
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+dy_t parse(string const& json, dy_parse_opts_t* opts = NULL)
+{
+    return dy_parse_json(json.data(), json.size(), opts);
+}
+
+/// <summary>
+/// parses the text expecting a failure
+/// </summary>
+dy_parse_opts_t parse_error(string const& json)
+{
+    dy_parse_opts_t opts {};
+    EXPECT_EQ(parse(json, &opts), nullptr) << json;
+    return opts;
+}
+
+/// <summary>
+/// writes the value and disposes it
+/// </summary>
+string write(dy_t val, uint32_t flags = dy_write_default)
+{
+    string json;
+    EXPECT_TRUE(dy_write_json(val, flags, append, &json));
+    dy_dispose(val);
+    return json;
+}
+
+}
+
+TEST(JsonTest, Scalars)
+{
+    ASSERT_EQ(dy_get_type(parse("null")), dy_type_null);
+    ASSERT_TRUE(dy_get_b(parse("true")));
+    ASSERT_FALSE(dy_get_b(parse(" \t\r\nfalse \n")));
+
+    ASSERT_EQ(dy_get_i(parse("42")), 42);
+    ASSERT_EQ(dy_get_i(parse("-7")), -7);
+    ASSERT_EQ(dy_get_i(parse("-0")), 0);
+    ASSERT_EQ(dy_get_f(parse("3.5")), 3.5);
+    ASSERT_EQ(dy_get_f(parse("1e3")), 1000.0);
+    ASSERT_EQ(dy_get_f(parse("-0.25E-2")), -0.0025);
+    ASSERT_EQ(dy_get_f(parse("0.1")), 0.1);
+    ASSERT_EQ(dy_get_f(parse("1e-400")), 0.0);
+
+    dy_t max = parse("9223372036854775807");
+    dy_t min = parse("-9223372036854775808");
+    ASSERT_EQ(dy_get_i(max), INT64_MAX);
+    ASSERT_EQ(dy_get_i(min), INT64_MIN);
+    dy_dispose(max);
+    dy_dispose(min);
+
+    // integers out of the range become double-precision numbers, and digits
+    // beyond the fast path are rounded correctly
+    dy_t big = parse("18446744073709551616");
+    ASSERT_EQ(dy_get_type(big), dy_type_f);
+    ASSERT_EQ(dy_get_f(big), 18446744073709551616.0);
+    dy_dispose(big);
+
+    ASSERT_EQ(dy_get_f(parse("2.2250738585072014e-308")),
+              2.2250738585072014e-308);
+    ASSERT_EQ(dy_get_f(parse("3.14159265358979323846264338327950288")),
+              3.14159265358979323846264338327950288);
+}
+
+TEST(JsonTest, Strings)
+{
+    dy_t str = parse(R"("a\"b\\c\/d\b\f\n\r\t")");
+    ASSERT_STREQ(dy_get_str_data(str), "a\"b\\c/d\b\f\n\r\t");
+    dy_dispose(str);
+
+    str = parse(R"("\u00e9\u4e2d\ud83d\ude00")");
+    ASSERT_STREQ(dy_get_str_data(str), "\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80");
+    dy_dispose(str);
+
+    str = parse("\"caf\xc3\xa9\"");
+    ASSERT_EQ(dy_get_str_len(str), 5);
+    dy_dispose(str);
+
+    str = parse(R"("nul\u0000inside")");
+    ASSERT_EQ(dy_get_str_len(str), 10);
+    ASSERT_EQ(memcmp(dy_get_str_data(str), "nul\0inside", 10), 0);
+    dy_dispose(str);
+}
+
+TEST(JsonTest, LongStrings)
+{
+    // escaped quotes and runs of backslashes across the blocks of 64 bytes
+    string expected, json = "[";
+    for (int i = 0; i < 40; ++i)
+    {
+        string value(i, 'x');
+        value += string(i % 5, '\\') + "\"";
+
+        json += "\"";
+        for (char c : value)
+            json += c == 'x' ? "x" : c == '"' ? "\\\"" : "\\\\";
+        json += "\",";
+        expected += value;
+    }
+    json += "0]";
+
+    dy_parse_opts_t opts {};
+    opts.generic_arrays = true;
+
+    dy_t arr = parse(json, &opts);
+    ASSERT_NE(arr, nullptr);
+    ASSERT_EQ(dy_get_arr_len(arr), 41);
+
+    string actual;
+    for (size_t i = 0; i < 40; ++i)
+        actual += dy_get_str_data(dy_get_arr_idx(arr, i));
+    ASSERT_EQ(actual, expected);
+
+    dy_dispose(arr);
+}
+
+TEST(JsonTest, TypedArrays)
+{
+    dy_t iarr = parse("[1, -2, 30000000000]");
+    ASSERT_EQ(dy_get_type(iarr), dy_type_iarr);
+    ASSERT_EQ(dy_get_iarr_idx(iarr, 2), 30000000000);
+
+    dy_t farr = parse("[1, 2.5, -3]");
+    ASSERT_EQ(dy_get_type(farr), dy_type_farr);
+    ASSERT_EQ(dy_get_farr_idx(farr, 0), 1.0);
+    ASSERT_EQ(dy_get_farr_idx(farr, 1), 2.5);
+
+    // 2^53 + 1 is not exact in double precision
+    dy_t inexact = parse("[0.5, 9007199254740993]");
+    ASSERT_EQ(dy_get_type(inexact), dy_type_arr);
+    ASSERT_EQ(dy_get_i(dy_get_arr_idx(inexact, 1)), 9007199254740993);
+
+    dy_t mixed = parse("[1, 2, \"three\", 4.5]");
+    ASSERT_EQ(dy_get_type(mixed), dy_type_arr);
+    ASSERT_EQ(dy_get_i(dy_get_arr_idx(mixed, 1)), 2);
+    ASSERT_EQ(dy_get_f(dy_get_arr_idx(mixed, 3)), 4.5);
+
+    dy_t nested = parse("[[1, 2], [3.5], []]");
+    ASSERT_EQ(dy_get_type(nested), dy_type_arr);
+    ASSERT_EQ(dy_get_type(dy_get_arr_idx(nested, 0)), dy_type_iarr);
+    ASSERT_EQ(dy_get_type(dy_get_arr_idx(nested, 1)), dy_type_farr);
+    ASSERT_EQ(dy_get_type(dy_get_arr_idx(nested, 2)), dy_type_arr);
+
+    dy_parse_opts_t opts {};
+    opts.generic_arrays = true;
+    dy_t generic        = parse("[1, 2]", &opts);
+    ASSERT_EQ(dy_get_type(generic), dy_type_arr);
+
+    dy_dispose(iarr);
+    dy_dispose(farr);
+    dy_dispose(inexact);
+    dy_dispose(mixed);
+    dy_dispose(nested);
+    dy_dispose(generic);
+}
+
+TEST(JsonTest, Maps)
+{
+    dy_t map = parse(R"({"id": 7, "tags": ["a", "b"], "geo": {"lat": 1.5},
+                         "ok": true, "none": null, "": {}})");
+    ASSERT_EQ(dy_get_type(map), dy_type_map);
+    ASSERT_EQ(dy_get_map_len(map), 6);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(map, "id").val), 7);
+
+    dy_t tags = dy_get_map_key(map, "tags").val;
+    ASSERT_EQ(dy_get_arr_len(tags), 2);
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(tags, 1)), "b");
+
+    dy_t geo = dy_get_map_key(map, "geo").val;
+    ASSERT_EQ(dy_get_f(dy_get_map_key(geo, "lat").val), 1.5);
+    ASSERT_EQ(dy_get_type(dy_get_map_key(map, "").val), dy_type_map);
+
+    dy_dispose(map);
+}
+
+TEST(JsonTest, DuplicateKeys)
+{
+    dy_t map = parse(R"({"a": "first", "b": 2, "a": ["second"]})");
+    ASSERT_EQ(dy_get_map_len(map), 2);
+    ASSERT_STREQ(dy_get_str_data(dy_get_map_key(map, "a").val), "first");
+    dy_dispose(map);
+}
+
+TEST(JsonTest, Arena)
+{
+    dy_arena_t      arena = dy_arena_create(0);
+    dy_parse_opts_t opts {};
+    opts.arena = arena;
+
+    dy_t map = parse(R"({"name": "arena", "values": [1, 2, 3]})", &opts);
+    ASSERT_STREQ(dy_get_str_data(dy_get_map_key(map, "name").val), "arena");
+
+    // copies do not belong to the arena
+    dy_t copy = dy_copy(dy_get_map_key(map, "values").val);
+    dy_arena_destroy(arena);
+
+    ASSERT_EQ(dy_get_iarr_idx(copy, 2), 3);
+    dy_dispose(copy);
+}
+
+TEST(JsonTest, Errors)
+{
+    ASSERT_EQ(parse_error("").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("[1,]").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("[1 2]").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("{\"a\" 1}").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("{1: 2}").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("tru").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("truex").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("01").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("1.").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("-").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("1e").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("\"abc").error, dy_parse_syntax);
+    ASSERT_EQ(parse_error("[\"a\", \"b]").error, dy_parse_syntax);
+
+    ASSERT_EQ(parse_error("\"\\x\"").error, dy_parse_string);
+    ASSERT_EQ(parse_error("\"\\u12\"").error, dy_parse_string);
+    ASSERT_EQ(parse_error("\"\\ud800\"").error, dy_parse_string);
+    ASSERT_EQ(parse_error("\"\x01\"").error, dy_parse_string);
+    ASSERT_EQ(parse_error("\"\xff\"").error, dy_parse_string);
+    ASSERT_EQ(parse_error("\"\xc0\xaf\"").error, dy_parse_string);
+
+    ASSERT_EQ(parse_error("1e400").error, dy_parse_number);
+
+    dy_parse_opts_t trailing = parse_error("[1] [2]");
+    ASSERT_EQ(trailing.error, dy_parse_syntax);
+    ASSERT_EQ(trailing.error_offset, 4);
+
+    // the values made before the failure are released
+    dy_parse_opts_t late = parse_error(R"({"a": ["x", {"b": "y"}], "c": [1, )");
+    ASSERT_EQ(late.error, dy_parse_syntax);
+}
+
+TEST(JsonTest, Depth)
+{
+    dy_parse_opts_t opts {};
+    opts.max_depth = 2;
+
+    dy_t val = parse("[[1]]", &opts);
+    ASSERT_NE(val, nullptr);
+    dy_dispose(val);
+
+    ASSERT_EQ(parse("[[[1]]]", &opts), nullptr);
+    ASSERT_EQ(opts.error, dy_parse_depth);
+    ASSERT_EQ(opts.error_offset, 2);
+
+    string deep = string(2000, '[') + string(2000, ']');
+    ASSERT_EQ(parse_error(deep).error, dy_parse_depth);
+}
+
+TEST(JsonTest, Document)
+{
+    // a document spanning many blocks
+    string json = "[";
+    for (int i = 0; i < 500; ++i)
+    {
+        if (i != 0) json += ",\n  ";
+        json += "{\"id\": " + to_string(i) + ", \"name\": \"user "
+                + to_string(i)
+                + "\", \"scores\": [" + to_string(i) + ".5, " + to_string(i * 2)
+                + "], \"active\": " + (i % 2 ? "true" : "false") + "}";
+    }
+    json += "]";
+
+    dy_t arr = parse(json);
+    ASSERT_NE(arr, nullptr);
+    ASSERT_EQ(dy_get_arr_len(arr), 500);
+
+    for (size_t i = 0; i < 500; ++i)
+    {
+        dy_t user = dy_get_arr_idx(arr, i);
+        ASSERT_EQ(dy_get_i(dy_get_map_key(user, "id").val), (int64_t)i);
+        ASSERT_EQ(dy_get_str_data(dy_get_map_key(user, "name").val),
+                  "user " + to_string(i));
+
+        dy_t scores = dy_get_map_key(user, "scores").val;
+        ASSERT_EQ(dy_get_type(scores), dy_type_farr);
+        ASSERT_EQ(dy_get_farr_idx(scores, 0), i + 0.5);
+        ASSERT_EQ(dy_get_b(dy_get_map_key(user, "active").val), i % 2 == 1);
+    }
+
+    dy_dispose(arr);
+}
+
+TEST(JsonTest, WriteScalars)
+{
+    ASSERT_EQ(write(dy_make_null()), "null");
+    ASSERT_EQ(write(dy_make_b(true)), "true");
+    ASSERT_EQ(write(dy_make_b(false)), "false");
+    ASSERT_EQ(write(dy_make_i(-42)), "-42");
+    ASSERT_EQ(write(dy_make_i(INT64_MIN)), "-9223372036854775808");
+
+    // numbers keep a fraction or an exponent to read back as numbers
+    ASSERT_EQ(write(dy_make_f(0.1)), "0.1");
+    ASSERT_EQ(write(dy_make_f(-1.5)), "-1.5");
+    ASSERT_EQ(write(dy_make_f(3.0)), "3.0");
+    ASSERT_EQ(write(dy_make_f(-0.0)), "-0.0");
+    ASSERT_EQ(write(dy_make_f(1e300)), "1e+300");
+    ASSERT_EQ(write(dy_make_f(5e-324)), "5e-324");
+    ASSERT_EQ(write(dy_make_f(NAN)), "null");
+    ASSERT_EQ(write(dy_make_f(-INFINITY)), "null");
+}
+
+TEST(JsonTest, WriteStrings)
+{
+    ASSERT_EQ(write(dy_make_str("")), R"("")");
+    ASSERT_EQ(write(dy_make_str("caf\xc3\xa9")), "\"caf\xc3\xa9\"");
+    ASSERT_EQ(write(dy_make_str("a\"b\\c/\n\t\x01\x1f")),
+              R"("a\"b\\c/\n\t\u0001\u001f")");
+
+    // runs longer than the vectors and the chunks
+    for (size_t len : { 15, 16, 33, 100, 20000 })
+    {
+        string str(len, 'x');
+        str[len - 1] = '"';
+        str[len / 2] = '\n';
+
+        string expected = "\"" + str + "\"";
+        expected.replace(len / 2 + 1, 1, "\\n");
+        expected.replace(expected.size() - 2, 1, "\\\"");
+        ASSERT_EQ(write(dy_make_str_len(str.data(), len)), expected) << len;
+    }
+}
+
+TEST(JsonTest, WriteArrays)
+{
+    int64_t  ints[]   = { 1, -2, INT64_MAX };
+    double   nums[]   = { 0.5, 2, -1e-7 };
+    uint8_t  bytes[]  = { 'f', 'o', 'o', 'b', 'a', 'r' };
+    int16_t  shorts[] = { -32768, 7 };
+    uint32_t words[]  = { UINT32_MAX };
+    float    floats[] = { 0.1f, 16777216.0f };
+
+    ASSERT_EQ(write(dy_make_iarr(ints, 3)), "[1,-2,9223372036854775807]");
+    ASSERT_EQ(write(dy_make_farr(nums, 3)), "[0.5,2.0,-1e-07]");
+    ASSERT_EQ(write(dy_make_iarr(NULL, 0)), "[]");
+    ASSERT_EQ(write(dy_make_i16arr(shorts, 2)), "[-32768,7]");
+    ASSERT_EQ(write(dy_make_u32arr(words, 1)), "[4294967295]");
+    ASSERT_EQ(write(dy_make_f32arr(floats, 2)), "[0.1,16777216.0]");
+
+    ASSERT_EQ(write(dy_make_bytes(bytes, 3)), "[102,111,111]");
+    ASSERT_EQ(write(dy_make_bytes(bytes, 6), dy_write_base64), R"("Zm9vYmFy")");
+    ASSERT_EQ(write(dy_make_bytes(bytes, 5), dy_write_base64), R"("Zm9vYmE=")");
+    ASSERT_EQ(write(dy_make_bytes(bytes, 4), dy_write_base64), R"("Zm9vYg==")");
+    ASSERT_EQ(write(dy_make_bytes(NULL, 0), dy_write_base64), R"("")");
+
+    bool   bools[70] = {};
+    string expected  = "[";
+    for (size_t i = 0; i < 70; ++i)
+    {
+        bools[i] = i % 3 == 0;
+        expected += (i != 0 ? "," : "") + string(bools[i] ? "true" : "false");
+    }
+    ASSERT_EQ(write(dy_make_barr(bools, 70)), expected + "]");
+}
+
+TEST(JsonTest, WriteNested)
+{
+    dy_t elems[] = { dy_make_i(1), dy_make_str("two"), dy_make_arr(NULL, 0) };
+
+    dy_keyval_t pairs[] = {
+        { "arr", dy_make_arr(elems, 3) },
+        { "key\"", dy_make_null() },
+        { "map", dy_make_map(NULL, 0) },
+    };
+
+    ASSERT_EQ(write(dy_make_map(pairs, 3)),
+              R"({"arr":[1,"two",[]],"key\"":null,"map":{}})");
+}
+
+TEST(JsonTest, WriteRoundTrip)
+{
+    string json = R"({"id":12345678901234,"name":"\u00e9\ud83d\ude00\\",)"
+                  R"("scores":[0.1,2.5e-300,1.7976931348623157e+308],)"
+                  R"("ids":[1,2,3],"mixed":[1,"a",null,true,{}],)"
+                  R"("nested":{"a":{"b":[[1.5],[]]}}})";
+
+    dy_t   val     = parse(json);
+    string written = write(val);
+    ASSERT_EQ(write(parse(written)), written);
+    ASSERT_NE(written.find("1.7976931348623157e+308"), string::npos);
+    ASSERT_NE(written.find("2.5e-300"), string::npos);
+}
+
+TEST(JsonTest, WriteBuffer)
+{
+    int64_t ints[] = { 10, 20, 30 };
+    dy_t    iarr   = dy_make_iarr(ints, 3);
+
+    char buf[16];
+    memset(buf, '#', sizeof(buf));
+    ASSERT_EQ(
+        dy_write_json_buffer(iarr, dy_write_default, buf, sizeof(buf)), 10);
+    ASSERT_STREQ(buf, "[10,20,30]");
+
+    // the text is cut to fit and still terminated
+    ASSERT_EQ(dy_write_json_buffer(iarr, dy_write_default, buf, 5), 10);
+    ASSERT_STREQ(buf, "[10,");
+    ASSERT_EQ(dy_write_json_buffer(iarr, dy_write_default, NULL, 0), 10);
+
+    dy_dispose(iarr);
+}
+
+TEST(JsonTest, WriteStop)
+{
+    vector<dy_t> elems;
+    for (int i = 0; i < 10000; ++i) elems.push_back(dy_make_str("element"));
+    dy_t arr = dy_make_arr(elems.data(), elems.size());
+
+    size_t calls = 0;
+    auto   stop  = [](void* ctx, char const*, size_t) {
+        ++*static_cast<size_t*>(ctx);
+        return false;
+    };
+    ASSERT_FALSE(dy_write_json(arr, dy_write_default, stop, &calls));
+    ASSERT_EQ(calls, 1);
+
+    dy_dispose(arr);
+}
@@ -0,0 +1,152 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+constexpr size_t lengths[] = { 0, 1, 7, 8, 63, 64, 65, 130, 1000 };
+
+unique_ptr<bool[]> random_mask(size_t len, uint64_t seed)
+{
+    unique_ptr<bool[]> mask(new bool[len]);
+    mt19937_64         rng(seed);
+
+    // runs of valid and invalid entries as well as scattered ones
+    for (size_t i = 0; i < len; ++i)
+        mask[i] = (i / 70) % 3 == 1 ? true : (i / 70) % 3 == 2 && rng() % 2;
+    return mask;
+}
+
+}
+
+TEST(KernelTest, IntegerReductions)
+{
+    for (size_t len : lengths)
+    {
+        mt19937_64      rng(len);
+        vector<int64_t> ints(len);
+        for (auto& i : ints) i = static_cast<int64_t>(rng());
+
+        auto mask = random_mask(len, len);
+        dy_t iarr = dy_make_iarr(ints.data(), len);
+        dy_t barr = dy_make_barr(mask.get(), len);
+
+        int64_t sum = 0, min = INT64_MAX, max = INT64_MIN;
+        int64_t msum = 0, mmin = INT64_MAX, mmax = INT64_MIN;
+        for (size_t i = 0; i < len; ++i)
+        {
+            sum += static_cast<uint64_t>(ints[i]);
+            min = std::min(min, ints[i]);
+            max = std::max(max, ints[i]);
+            if (!mask[i]) continue;
+            msum += static_cast<uint64_t>(ints[i]);
+            mmin = std::min(mmin, ints[i]);
+            mmax = std::max(mmax, ints[i]);
+        }
+
+        ASSERT_EQ(dy_iarr_sum(iarr), sum);
+        ASSERT_EQ(dy_iarr_min(iarr), min);
+        ASSERT_EQ(dy_iarr_max(iarr), max);
+        ASSERT_EQ(dy_iarr_sum_masked(iarr, barr), msum);
+        ASSERT_EQ(dy_iarr_min_masked(iarr, barr), mmin);
+        ASSERT_EQ(dy_iarr_max_masked(iarr, barr), mmax);
+
+        dy_dispose(iarr);
+        dy_dispose(barr);
+    }
+}
+
+TEST(KernelTest, PrefixSums)
+{
+    for (size_t len : lengths)
+    {
+        vector<int64_t> ints(len);
+        vector<double>  nums(len);
+        for (size_t i = 0; i < len; ++i) ints[i] = i * 3 - 7, nums[i] = i / 4.0;
+
+        dy_t iarr  = dy_make_iarr(ints.data(), len);
+        dy_t farr  = dy_make_farr(nums.data(), len);
+        dy_t isums = dy_iarr_prefix_sum(iarr);
+        dy_t fsums = dy_farr_prefix_sum(farr);
+        ASSERT_EQ(dy_get_iarr_len(isums), len);
+        ASSERT_EQ(dy_get_farr_len(fsums), len);
+
+        int64_t iacc = 0;
+        double  facc = 0;
+        for (size_t i = 0; i < len; ++i)
+        {
+            ASSERT_EQ(dy_get_iarr_idx(isums, i), iacc += ints[i]);
+            ASSERT_EQ(dy_get_farr_idx(fsums, i), facc += nums[i]);
+        }
+
+        dy_dispose(iarr);
+        dy_dispose(farr);
+        dy_dispose(isums);
+        dy_dispose(fsums);
+    }
+}
+
+TEST(KernelTest, FloatReductions)
+{
+    for (size_t len : lengths)
+    {
+        vector<double> lhs(len), rhs(len);
+        for (size_t i = 0; i < len; ++i) lhs[i] = i % 17, rhs[i] = i % 5 - 2.0;
+
+        auto mask = random_mask(len, len + 1);
+        dy_t a    = dy_make_farr(lhs.data(), len);
+        dy_t b    = dy_make_farr(rhs.data(), len);
+        dy_t barr = dy_make_barr(mask.get(), len);
+
+        // small integers, so every order gives the exact result
+        double sum = 0, msum = 0, dot = 0, mdot = 0;
+        for (size_t i = 0; i < len; ++i)
+        {
+            sum += lhs[i];
+            dot += lhs[i] * rhs[i];
+            if (!mask[i]) continue;
+            msum += lhs[i];
+            mdot += lhs[i] * rhs[i];
+        }
+
+        ASSERT_EQ(dy_farr_sum(a), sum);
+        ASSERT_EQ(dy_farr_sum_masked(a, barr), msum);
+        ASSERT_EQ(dy_farr_dot(a, b), dot);
+        ASSERT_EQ(dy_farr_dot_masked(a, b, barr), mdot);
+
+        dy_dispose(a);
+        dy_dispose(b);
+        dy_dispose(barr);
+    }
+}
+
+TEST(KernelTest, CompensatedSum)
+{
+    // a naive sum loses every 1 added to 1e16
+    vector<double> nums { 1e16 };
+    for (int i = 0; i < 1000; ++i) nums.push_back(1);
+    nums.push_back(-1e16);
+
+    dy_t farr = dy_make_farr(nums.data(), nums.size());
+    ASSERT_EQ(dy_farr_sum(farr), 1000);
+
+    vector<bool> valid(nums.size(), true);
+    valid[500] = false;
+
+    unique_ptr<bool[]> mask(new bool[nums.size()]);
+    copy(valid.begin(), valid.end(), mask.get());
+    dy_t barr = dy_make_barr(mask.get(), nums.size());
+    ASSERT_EQ(dy_farr_sum_masked(farr, barr), 999);
+
+    dy_dispose(farr);
+    dy_dispose(barr);
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(KeyTest, Intern)
+{
+    dy_key_t foo = dy_intern_key("foo", 3);
+    ASSERT_EQ(dy_intern_key("foobar", 3), foo);
+    ASSERT_STREQ(dy_get_key_data(foo), "foo");
+    ASSERT_EQ(dy_get_key_len(foo), 3);
+    ASSERT_EQ(dy_get_key_hash(foo), dy_hash_key("foo", 3));
+
+    ASSERT_NE(dy_intern_key("fo", 2), foo);
+    ASSERT_NE(dy_intern_key("foo\0", 4), foo);
+    ASSERT_EQ(dy_get_key_len(dy_intern_key("foo\0", 4)), 4);
+
+    dy_key_t empty = dy_intern_key(nullptr, 0);
+    ASSERT_EQ(dy_intern_key("", 0), empty);
+    ASSERT_EQ(dy_intern_key(nullptr, 0), empty);
+    ASSERT_STREQ(dy_get_key_data(empty), "");
+}
+
+TEST(KeyTest, Threads)
+{
+    constexpr size_t key_count    = 5000;
+    constexpr size_t thread_count = 8;
+
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < key_count; ++i)
+        keys.push_back("thread_key_" + std::to_string(i));
+
+    std::vector<std::vector<dy_key_t>> interned(thread_count);
+    std::vector<std::thread>           threads;
+    for (size_t t = 0; t < thread_count; ++t)
+    {
+        threads.emplace_back([&, t] {
+            // every thread interns the keys in a different order
+            for (size_t i = 0; i < key_count; ++i)
+            {
+                auto const& key = keys[(i * (t + 1)) % key_count];
+                interned[t].push_back(dy_intern_key(key.c_str(), key.size()));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    for (size_t t = 0; t < thread_count; ++t)
+    {
+        for (size_t i = 0; i < key_count; ++i)
+        {
+            auto const& key = keys[(i * (t + 1)) % key_count];
+            ASSERT_EQ(interned[t][i], dy_intern_key(key.c_str(), key.size()));
+            ASSERT_STREQ(dy_get_key_data(interned[t][i]), key.c_str());
+        }
+    }
+}
+
+TEST(KeyTest, InternedMap)
+{
+    for (size_t len : { 5, 16, 17, 1000 })
+    {
+        std::vector<std::string>          keys;
+        std::vector<dy_interned_keyval_t> pairs;
+        for (size_t i = 0; i < len; ++i)
+            keys.push_back("interned_" + std::to_string(i));
+        for (size_t i = 0; i < len; ++i)
+        {
+            dy_key_t key = dy_intern_key(keys[i].c_str(), keys[i].size());
+            pairs.push_back({ key, dy_make_i(i) });
+        }
+
+        dy_t dy = dy_make_map_interned(pairs.data(), len);
+        ASSERT_EQ(dy_get_map_len(dy), len);
+
+        dy_t copy = dy_copy(dy);
+        for (dy_t map : { dy, copy })
+        {
+            for (size_t i = 0; i < len; ++i)
+            {
+                dy_keyval_t keyval = dy_get_map_key_interned(map, pairs[i].key);
+                ASSERT_EQ(keyval.key, dy_get_key_data(pairs[i].key));
+                ASSERT_EQ(dy_get_i(keyval.val), i);
+                ASSERT_EQ(dy_get_i(dy_get_map_key(map, keys[i].c_str()).val),
+                          i);
+            }
+
+            dy_key_t missing = dy_intern_key("interned_", 9);
+            ASSERT_EQ(dy_get_map_key_interned(map, missing).key, nullptr);
+        }
+
+        dy_dispose(dy);
+        dy_dispose(copy);
+    }
+}
+
+TEST(KeyTest, MixedMap)
+{
+    // a map with copied keys is looked up by the characters of interned keys
+    for (size_t len : { 5, 100 })
+    {
+        std::vector<std::string> keys;
+        std::vector<dy_keyval_t> pairs;
+        for (size_t i = 0; i < len; ++i)
+            keys.push_back("copied_" + std::to_string(i));
+        for (size_t i = 0; i < len; ++i)
+            pairs.push_back({ keys[i].c_str(), dy_make_i(i) });
+
+        dy_t dy = dy_make_map(pairs.data(), len);
+        for (size_t i = 0; i < len; ++i)
+        {
+            dy_key_t key = dy_intern_key(keys[i].c_str(), keys[i].size());
+            ASSERT_EQ(dy_get_i(dy_get_map_key_interned(dy, key).val), i);
+        }
+        dy_dispose(dy);
+    }
+}
+
+TEST(KeyTest, ArenaInternedMap)
+{
+    dy_arena_t arena = dy_arena_create(0);
+
+    dy_interned_keyval_t pairs[] = {
+        { dy_intern_key("id", 2), dy_arena_make_i(arena, 1) },
+        { dy_intern_key("name", 4), dy_arena_make_str(arena, "dy") },
+        { dy_intern_key("id", 2), dy_arena_make_i(arena, 2) },
+    };
+
+    // the first pair wins
+    dy_t dy = dy_arena_make_map_interned(arena, pairs, 3);
+    ASSERT_EQ(dy_get_map_len(dy), 2);
+    ASSERT_EQ(dy_get_i(dy_get_map_key_interned(dy, pairs[0].key).val), 1);
+    ASSERT_STREQ(dy_get_str_data(dy_get_map_key(dy, "name").val), "dy");
+
+    dy_t copy = dy_copy(dy);
+    dy_arena_destroy(arena);
+
+    ASSERT_EQ(dy_get_i(dy_get_map_key_interned(copy, pairs[0].key).val), 1);
+    dy_dispose(copy);
+}
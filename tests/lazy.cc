@@ -0,0 +1,190 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include "sink.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+dy_t parse_lazy(string const& json, dy_parse_opts_t* opts = NULL)
+{
+    dy_parse_opts_t defaults {};
+    if (opts == NULL) opts = &defaults;
+    opts->lazy = true;
+    return dy_parse_json(json.data(), json.size(), opts);
+}
+
+char const document[] = R"({
+    "name": "lazy",
+    "version": 3,
+    "nums": [1, 2, 3],
+    "mixed": [1.5, "x", null],
+    "items": [{"id": 1, "tags": ["a", "b"]}, {"id": 2, "tags": []}],
+    "empty": {},
+    "nested": {"a": {"b": {"c": [true, false, "\u00e9"]}}},
+    "name": "twice"
+})";
+
+}
+
+TEST(LazyTest, Read)
+{
+    string json = document;
+    dy_t   eager = dy_parse_json(json.data(), json.size(), NULL);
+    dy_t   lazy  = parse_lazy(json);
+
+    ASSERT_NE(lazy, nullptr);
+    ASSERT_EQ(dy_get_type(lazy), dy_type_map);
+    ASSERT_STREQ(dy_get_str_data(dy_get_map_key(lazy, "name").val), "lazy");
+
+    dy_t items = dy_get_map_key(lazy, "items").val;
+    ASSERT_EQ(dy_get_type(items), dy_type_arr);
+    ASSERT_EQ(dy_get_arr_len(items), 2);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(dy_get_arr_idx(items, 1), "id").val), 2);
+
+    // arrays of numbers are typed as usual
+    ASSERT_EQ(dy_get_type(dy_get_map_key(lazy, "nums").val), dy_type_iarr);
+    ASSERT_EQ(dy_get_type(dy_get_map_key(lazy, "mixed").val), dy_type_arr);
+
+    ASSERT_EQ(dy_get_map_len(lazy), dy_get_map_len(eager));
+    ASSERT_EQ(to_json(lazy), to_json(eager));
+
+    dy_dispose(eager);
+    dy_dispose(lazy);
+}
+
+TEST(LazyTest, Partial)
+{
+    string json = document;
+    dy_t   lazy = parse_lazy(json);
+
+    // the values read stay valid while the document is alive
+    dy_t nested = dy_copy(dy_get_map_key(lazy, "nested").val);
+    dy_dispose(lazy);
+
+    dy_t c = dy_get_map_key(dy_get_map_key(dy_get_map_key(nested, "a").val,
+                                           "b")
+                                .val,
+                            "c")
+                 .val;
+    ASSERT_EQ(dy_get_type(c), dy_type_arr);
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(c, 2)), "\xc3\xa9");
+    dy_dispose(nested);
+
+    // nothing is read at all
+    dy_dispose(parse_lazy(json));
+}
+
+TEST(LazyTest, Iterate)
+{
+    dy_t lazy = parse_lazy(R"({"b": [1, {}], "a": "x", "b": 3})");
+
+    dy_iter_t   iter = dy_make_map_iter(lazy);
+    dy_keyval_t pair = dy_get_map_iter(lazy, iter);
+    ASSERT_STREQ(pair.key, "b");
+    ASSERT_EQ(dy_get_type(pair.val), dy_type_arr);
+    ASSERT_STREQ(dy_get_map_iter(lazy, iter).key, "a");
+    ASSERT_EQ(dy_get_map_iter(lazy, iter).key, nullptr);
+    dy_dispose_map_iter(iter);
+
+    ASSERT_NE(dy_get_map_shape(lazy), nullptr);
+    ASSERT_STREQ(dy_get_map_idx(lazy, 1).key, "a");
+    ASSERT_EQ(dy_get_map_key_hashed(lazy, "a", 1, dy_hash_key("a", 1)).val,
+              dy_get_map_idx(lazy, 1).val);
+    ASSERT_EQ(dy_get_map_key_interned(lazy, dy_intern_key("b", 1)).val,
+              dy_get_map_idx(lazy, 0).val);
+    dy_dispose(lazy);
+
+    // scalars and empty containers are made at once
+    dy_t scalar = parse_lazy(" 12 ");
+    ASSERT_EQ(dy_get_i(scalar), 12);
+    dy_t empty = parse_lazy("[]");
+    ASSERT_EQ(dy_get_arr_len(empty), 0);
+    dy_dispose(empty);
+}
+
+TEST(LazyTest, Copy)
+{
+    string json  = document;
+    dy_t   lazy  = parse_lazy(json);
+    dy_t   items = dy_get_map_key(lazy, "items").val;
+
+    dy_t copy        = dy_copy(lazy);
+    dy_t materialize = dy_materialize(items);
+    ASSERT_EQ(copy, lazy);
+    ASSERT_EQ(materialize, items);
+    dy_dispose(copy);
+    dy_dispose(materialize);
+
+    // compacting takes the entries over
+    dy_t compacted = dy_compact(lazy, dy_compact_default, NULL);
+    dy_t first = dy_get_arr_idx(dy_get_map_key(compacted, "items").val, 0);
+    ASSERT_EQ(dy_get_type(dy_get_map_key(first, "tags").val), dy_type_arr);
+    ASSERT_EQ(dy_get_type(dy_get_map_key(compacted, "version").val),
+              dy_type_i);
+    dy_dispose(compacted);
+}
+
+TEST(LazyTest, Errors)
+{
+    // strings, numbers and literals nested in lazy maps are checked as well
+    char const* texts[] = {
+        "", "[1, 2", "{\"a\" 1}", "[1,]", "{\"a\": 1,}", "[1] 2", "[}",
+        "{1: 2}", "[1 2]", "{\"a\": [1}}",
+        "{\"a\":{\"b\":\"\\u0001x\\q\"}}", "{\"a\":[true, tru]}",
+        "{\"a\":{\"x\":1e999}}", "{\"a\":{\"\\x\":1}}",
+        "[[\"\\x\", 1], [2], {\"a\": tru}]",
+    };
+
+    for (auto text : texts)
+    {
+        string          json = text;
+        dy_parse_opts_t eager {};
+        ASSERT_EQ(dy_parse_json(json.data(), json.size(), &eager), nullptr);
+
+        dy_parse_opts_t opts {};
+        ASSERT_EQ(parse_lazy(json, &opts), nullptr) << text;
+        ASSERT_EQ(opts.error, eager.error) << text;
+        ASSERT_EQ(opts.error_offset, eager.error_offset) << text;
+    }
+
+    dy_parse_opts_t opts {};
+    opts.max_depth = 2;
+    ASSERT_EQ(parse_lazy("[[[\"a\"]]]", &opts), nullptr);
+    ASSERT_EQ(opts.error, dy_parse_depth);
+    ASSERT_EQ(opts.error_offset, 2);
+}
+
+TEST(LazyTest, Threads)
+{
+    string json = "[";
+    for (int i = 0; i < 1000; ++i)
+        json += (i != 0 ? ",{\"v\":[\"" : "{\"v\":[\"") + to_string(i) + "\"]}";
+    json += "]";
+    dy_t lazy = parse_lazy(json);
+
+    // every thread sees the same instances
+    vector<vector<dy_t>> seen(4);
+    vector<thread>       threads;
+    for (auto& vals : seen)
+        threads.emplace_back([&] {
+            for (size_t i = 0; i < 1000; ++i)
+            {
+                dy_t v = dy_get_map_key(dy_get_arr_idx(lazy, i), "v").val;
+                vals.push_back(dy_get_arr_idx(v, 0));
+            }
+        });
+    for (auto& t : threads) t.join();
+
+    for (auto& vals : seen)
+        for (size_t i = 0; i < 1000; ++i) ASSERT_EQ(vals[i], seen[0][i]);
+    ASSERT_STREQ(dy_get_str_data(seen[0][999]), "999");
+    dy_dispose(lazy);
+}
@@ -0,0 +1,312 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include "sink.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+/// <summary>
+/// writes the value into 8-byte aligned words and disposes it
+/// </summary>
+vector<uint64_t> write(dy_t val, size_t* len = NULL)
+{
+    size_t           size = dy_write_mapped_buffer(val, NULL, 0);
+    vector<uint64_t> words((size + 7) / 8);
+    EXPECT_EQ(dy_write_mapped_buffer(val, words.data(), size), size);
+    dy_dispose(val);
+
+    if (len != NULL) *len = size;
+    return words;
+}
+
+dy_mapped_t open(vector<uint64_t> const& words)
+{
+    return dy_open_mapped_buffer(words.data(), words.size() * 8);
+}
+
+dy_t make_document()
+{
+    int64_t ints[]   = { 1, -2, INT64_MAX };
+    double  nums[]   = { 0.5, -1e300 };
+    int16_t shorts[] = { -32768, 7 };
+    bool    bools[]  = { true, false, true };
+
+    dy_t elems[] = {
+        dy_make_null(),       dy_make_b(true), dy_make_i(-5),
+        dy_make_i(1LL << 60), dy_make_f(2.25), dy_make_str("elem"),
+    };
+
+    dy_keyval_t inner[] = {
+        { "x", dy_make_i(1) },
+        { "", dy_make_str("") },
+    };
+
+    dy_keyval_t pairs[] = {
+        { "name", dy_make_str("mapped") },
+        { "ints", dy_make_iarr(ints, 3) },
+        { "nums", dy_make_farr(nums, 2) },
+        { "shorts", dy_make_i16arr(shorts, 2) },
+        { "bools", dy_make_barr(bools, 3) },
+        { "elems", dy_make_arr(elems, 6) },
+        { "inner", dy_make_map(inner, 2) },
+        { "empty", dy_make_arr(NULL, 0) },
+    };
+    return dy_make_map(pairs, 8);
+}
+
+}
+
+TEST(MappedTest, RoundTrip)
+{
+    dy_t   doc  = make_document();
+    string json = to_json(doc);
+
+    auto        words  = write(doc);
+    dy_mapped_t mapped = open(words);
+    ASSERT_NE(mapped, nullptr);
+
+    dy_t root = dy_get_mapped_root(mapped);
+    ASSERT_EQ(dy_get_type(root), dy_type_map);
+    ASSERT_EQ(to_json(root), json);
+
+    // strings and typed arrays are views of the bytes
+    dy_t name = dy_get_map_key(root, "name").val;
+    ASSERT_TRUE(dy_is_view(name));
+    ASSERT_STREQ(dy_get_str_data(name), "mapped");
+
+    auto ints  = dy_get_iarr_data(dy_get_map_key(root, "ints").val);
+    auto first = reinterpret_cast<char const*>(words.data());
+    ASSERT_GE(reinterpret_cast<char const*>(ints), first);
+    ASSERT_LT(reinterpret_cast<char const*>(ints), first + words.size() * 8);
+    ASSERT_EQ(ints[2], INT64_MAX);
+
+    dy_t elems = dy_get_map_key(root, "elems").val;
+    ASSERT_EQ(dy_get_arr_len(elems), 6);
+    ASSERT_EQ(dy_get_i(dy_get_arr_idx(elems, 3)), 1LL << 60);
+    ASSERT_EQ(dy_get_arr_data(elems)[5], dy_get_arr_idx(elems, 5));
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_data(elems)[5]), "elem");
+
+    dy_t bools = dy_get_map_key(root, "bools").val;
+    ASSERT_EQ(dy_get_barr_len(bools), 3);
+    ASSERT_EQ(dy_barr_popcount(bools), 2);
+
+    // the mapped values are made once and never disposed
+    ASSERT_EQ(dy_get_map_key(root, "name").val, name);
+    dy_dispose(root);
+    dy_dispose(name);
+
+    dy_close_mapped(mapped);
+}
+
+TEST(MappedTest, Scalars)
+{
+    dy_t vals[] = {
+        dy_make_null(),       dy_make_b(false), dy_make_i(-1),
+        dy_make_i(INT64_MIN), dy_make_f(-0.0),  dy_make_str("only"),
+    };
+
+    for (dy_t val : vals)
+    {
+        string      json   = to_json(val);
+        auto        words  = write(val);
+        dy_mapped_t mapped = open(words);
+        ASSERT_NE(mapped, nullptr);
+        ASSERT_EQ(to_json(dy_get_mapped_root(mapped)), json);
+        dy_close_mapped(mapped);
+    }
+}
+
+TEST(MappedTest, Lookup)
+{
+    vector<string>      keys;
+    vector<dy_keyval_t> pairs;
+    for (int i = 0; i < 1000; ++i) keys.push_back("key_" + to_string(i * 7));
+    for (int i = 0; i < 1000; ++i)
+        pairs.push_back({ keys[i].c_str(), dy_make_i(i) });
+
+    auto        words  = write(dy_make_map(pairs.data(), pairs.size()));
+    dy_mapped_t mapped = open(words);
+    dy_t        map    = dy_get_mapped_root(mapped);
+
+    ASSERT_EQ(dy_get_map_len(map), 1000);
+    ASSERT_EQ(dy_get_map_shape(map), nullptr);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        char const* key = keys[i].c_str();
+        size_t      len = keys[i].size();
+        ASSERT_EQ(dy_get_i(dy_get_map_key(map, key).val), i);
+        ASSERT_EQ(dy_get_map_key_n(map, key, len).val,
+                  dy_get_map_idx(map, i).val);
+        ASSERT_EQ(
+            dy_get_map_key_hashed(map, key, len, dy_hash_key(key, len)).val,
+            dy_get_map_key(map, key).val);
+
+        dy_key_t interned = dy_intern_key(key, len);
+        ASSERT_EQ(dy_get_i(dy_get_map_key_interned(map, interned).val), i);
+        ASSERT_STREQ(dy_get_map_idx(map, i).key, key);
+    }
+
+    ASSERT_EQ(dy_get_map_key(map, "key_1").key, nullptr);
+    ASSERT_EQ(dy_get_map_key(map, "").val, nullptr);
+
+    dy_iter_t iter = dy_make_map_iter(map);
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_EQ(dy_get_i(dy_get_map_iter(map, iter).val), i);
+    ASSERT_EQ(dy_get_map_iter(map, iter).key, nullptr);
+    dy_dispose_map_iter(iter);
+
+    vector<dy_keyval_t> exported(1000);
+    ASSERT_EQ(dy_map_export(map, exported.data(), exported.size()), 1000);
+    ASSERT_EQ(dy_get_i(exported[999].val), 999);
+    ASSERT_STREQ(exported[999].key, dy_get_map_idx(map, 999).key);
+
+    dy_close_mapped(mapped);
+}
+
+TEST(MappedTest, Copy)
+{
+    dy_t   doc  = make_document();
+    string json = to_json(doc);
+
+    auto        words  = write(doc);
+    dy_mapped_t mapped = open(words);
+    dy_t        root   = dy_get_mapped_root(mapped);
+
+    // copies do not reference the file
+    dy_t copy        = dy_copy(root);
+    dy_t materialize = dy_materialize(root);
+    dy_t compacted   = dy_compact(root, dy_compact_default, NULL);
+    dy_close_mapped(mapped);
+
+    ASSERT_FALSE(dy_is_view(dy_get_map_key(copy, "name").val));
+    ASSERT_NE(dy_get_map_shape(copy), nullptr);
+    ASSERT_EQ(to_json(copy), json);
+    ASSERT_EQ(to_json(materialize), json);
+    ASSERT_EQ(dy_get_type(dy_get_map_key(compacted, "elems").val),
+              dy_type_arr);
+
+    dy_dispose(copy);
+    dy_dispose(materialize);
+    dy_dispose(compacted);
+}
+
+TEST(MappedTest, File)
+{
+    dy_t   doc  = make_document();
+    string json = to_json(doc);
+    string path = testing::TempDir() + "dy_mapped_test.dym";
+
+    FILE* file = fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    ASSERT_TRUE(dy_write_mapped(
+        doc,
+        [](void* ctx, char const* data, size_t len) {
+            return fwrite(data, 1, len, static_cast<FILE*>(ctx)) == len;
+        },
+        file));
+    fclose(file);
+    dy_dispose(doc);
+
+    dy_mapped_t mapped = dy_open_mapped(path.c_str());
+    ASSERT_NE(mapped, nullptr);
+    ASSERT_EQ(to_json(dy_get_mapped_root(mapped)), json);
+    dy_close_mapped(mapped);
+
+    remove(path.c_str());
+    ASSERT_EQ(dy_open_mapped(path.c_str()), nullptr);
+}
+
+TEST(MappedTest, Threads)
+{
+    vector<dy_t> elems;
+    for (int i = 0; i < 1000; ++i)
+        elems.push_back(dy_make_str(to_string(i).c_str()));
+
+    auto        words  = write(dy_make_arr(elems.data(), elems.size()));
+    dy_mapped_t mapped = open(words);
+    dy_t        arr    = dy_get_mapped_root(mapped);
+
+    // every thread sees the same instances
+    vector<vector<dy_t>> seen(4);
+    vector<thread>       threads;
+    for (auto& vals : seen)
+        threads.emplace_back([&] {
+            for (size_t i = 0; i < 1000; ++i)
+                vals.push_back(dy_get_arr_idx(arr, i));
+        });
+    for (auto& t : threads) t.join();
+
+    dy_t const* data = dy_get_arr_data(arr);
+    for (auto& vals : seen)
+        for (size_t i = 0; i < 1000; ++i) ASSERT_EQ(vals[i], data[i]);
+    ASSERT_STREQ(dy_get_str_data(data[999]), "999");
+
+    dy_close_mapped(mapped);
+}
+
+TEST(MappedTest, Errors)
+{
+    size_t len;
+    auto   words = write(dy_make_str("abc"), &len);
+
+    ASSERT_EQ(dy_open_mapped_buffer(words.data(), 0), nullptr);
+    ASSERT_EQ(dy_open_mapped_buffer(words.data(), len - 8), nullptr);
+
+    auto bad = words;
+    reinterpret_cast<char*>(bad.data())[0] = 'x';
+    ASSERT_EQ(open(bad), nullptr);
+
+    // records out of the file read as null
+    bad                 = words;
+    bad[bad.size() - 3] = 1 << 20;
+    dy_mapped_t mapped  = open(bad);
+    ASSERT_NE(mapped, nullptr);
+    ASSERT_EQ(dy_get_type(dy_get_mapped_root(mapped)), dy_type_null);
+    dy_close_mapped(mapped);
+
+    // so do the strings longer than their records
+    bad    = words;
+    bad[3] = 100;
+    mapped = open(bad);
+    ASSERT_EQ(dy_get_type(dy_get_mapped_root(mapped)), dy_type_null);
+    dy_close_mapped(mapped);
+
+    // and the entries pointing to their arrays or the ones holding them,
+    // which would make a cycle
+    dy_t inner = dy_make_i(1);
+    dy_t outer = dy_make_arr(&inner, 1);
+    words      = write(dy_make_arr(&outer, 1));
+
+    uint64_t root  = words[words.size() - 3];
+    uint64_t child = words[root / 8 + 2];
+
+    bad               = words;
+    bad[root / 8 + 2] = root;
+    mapped            = open(bad);
+    ASSERT_EQ(dy_get_type(dy_get_arr_idx(dy_get_mapped_root(mapped), 0)),
+              dy_type_null);
+    dy_close_mapped(mapped);
+
+    for (uint64_t slot : { root, child })
+    {
+        bad                = words;
+        bad[child / 8 + 2] = slot;
+        mapped             = open(bad);
+
+        dy_t copy = dy_copy(dy_get_mapped_root(mapped));
+        ASSERT_EQ(to_json(copy), "[[null]]");
+        dy_dispose(copy);
+        dy_close_mapped(mapped);
+    }
+}
@@ -0,0 +1,294 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include "sink.h"
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+/// <summary>
+/// encodes the value and disposes it
+/// </summary>
+string encode(dy_t val)
+{
+    string bytes;
+    EXPECT_TRUE(dy_encode_msgpack(val, append, &bytes));
+    dy_dispose(val);
+    return bytes;
+}
+
+dy_t decode(string const& bytes, dy_parse_opts_t* opts = NULL)
+{
+    return dy_decode_msgpack(bytes.data(), bytes.size(), opts);
+}
+
+/// <summary>
+/// decodes the bytes expecting a failure
+/// </summary>
+dy_parse_opts_t decode_error(string const& bytes)
+{
+    dy_parse_opts_t opts {};
+    EXPECT_EQ(decode(bytes, &opts), nullptr);
+    return opts;
+}
+
+}
+
+TEST(MsgpackTest, Scalars)
+{
+    ASSERT_EQ(encode(dy_make_null()), "\xc0");
+    ASSERT_EQ(encode(dy_make_b(true)), "\xc3");
+    ASSERT_EQ(encode(dy_make_i(5)), "\x05");
+    ASSERT_EQ(encode(dy_make_i(-3)), "\xfd");
+    ASSERT_EQ(encode(dy_make_i(200)), "\xcc\xc8");
+    ASSERT_EQ(encode(dy_make_i(-200)), string("\xd1\xff\x38", 3));
+    ASSERT_EQ(encode(dy_make_i(65536)), string("\xce\x00\x01\x00\x00", 5));
+    ASSERT_EQ(encode(dy_make_f(1.5)), string("\xca\x3f\xc0\x00\x00", 5));
+    ASSERT_EQ(encode(dy_make_f(0.1)).size(), 9);
+    ASSERT_EQ(encode(dy_make_f(1e300)).size(), 9);
+
+    int64_t ints[] = { 0,        -1,        127,       -32,       128,
+                       -33,      255,       -128,      65535,     -32768,
+                       1 << 20,  -1 << 20,  INT64_MAX, INT64_MIN, 1LL << 40 };
+    for (int64_t i : ints)
+    {
+        dy_t val = decode(encode(dy_make_i(i)));
+        ASSERT_EQ(dy_get_type(val), dy_type_i) << i;
+        ASSERT_EQ(dy_get_i(val), i);
+        dy_dispose(val);
+    }
+
+    double nums[] = { 0.5, -0.0, 0.1, 1e300, INFINITY };
+    for (double f : nums)
+    {
+        dy_t val = decode(encode(dy_make_f(f)));
+        ASSERT_EQ(dy_get_type(val), dy_type_f) << f;
+        ASSERT_EQ(dy_get_f(val), f);
+        ASSERT_EQ(signbit(dy_get_f(val)), signbit(f));
+        dy_dispose(val);
+    }
+
+    // unsigned integers out of the range become numbers
+    dy_t big = decode(string("\xcf\xff\xff\xff\xff\xff\xff\xff\xff", 9));
+    ASSERT_EQ(dy_get_type(big), dy_type_f);
+    ASSERT_EQ(dy_get_f(big), 18446744073709551615.0);
+    dy_dispose(big);
+}
+
+TEST(MsgpackTest, Strings)
+{
+    ASSERT_EQ(encode(dy_make_str("abc")), "\xa3"
+                                          "abc");
+
+    for (size_t len : { 31, 32, 255, 256, 70000 })
+    {
+        string str(len, 'x');
+        string bytes = encode(dy_make_str_len(str.data(), len));
+
+        dy_t val = decode(bytes);
+        ASSERT_EQ(dy_get_type(val), dy_type_str);
+        ASSERT_EQ(string(dy_get_str_data(val), dy_get_str_len(val)), str);
+        dy_dispose(val);
+    }
+}
+
+TEST(MsgpackTest, TypedArrays)
+{
+    int64_t  ints[]   = { 1, -2, INT64_MAX };
+    double   nums[]   = { 0.5, -1e300, 3 };
+    uint8_t  bytes[]  = { 0, 1, 255 };
+    int8_t   tiny[]   = { -128, 127 };
+    int16_t  shorts[] = { -32768, 7, 8, 9 };
+    int32_t  longs[]  = { INT32_MIN };
+    uint32_t words[]  = { UINT32_MAX, 0 };
+    float    floats[] = { 0.1f, -2.5f };
+
+    // the entries follow the header in little-endian order
+    string encoded = encode(dy_make_iarr(ints, 3));
+    ASSERT_EQ(encoded.substr(0, 3), "\xc7\x18\x4f");
+    ASSERT_EQ(encoded.size(), 3 + sizeof(ints));
+    ASSERT_EQ(memcmp(encoded.data() + 3, ints, sizeof(ints)), 0);
+
+    dy_t vals[] = {
+        dy_make_iarr(ints, 3),    dy_make_farr(nums, 3),
+        dy_make_bytes(bytes, 3),  dy_make_i8arr(tiny, 2),
+        dy_make_i16arr(shorts, 4), dy_make_i32arr(longs, 1),
+        dy_make_u32arr(words, 2), dy_make_f32arr(floats, 2),
+        dy_make_iarr(NULL, 0),
+    };
+
+    for (dy_t val : vals)
+    {
+        dy_t decoded = decode(encode(dy_copy(val)));
+        ASSERT_EQ(dy_get_type(decoded), dy_get_type(val));
+        ASSERT_EQ(to_json(decoded), to_json(val));
+        dy_dispose(decoded);
+        dy_dispose(val);
+    }
+}
+
+TEST(MsgpackTest, BooleanArrays)
+{
+    for (size_t len : { 0, 1, 8, 9, 64, 100 })
+    {
+        vector<char> bools(len);
+        for (size_t i = 0; i < len; ++i) bools[i] = i % 3 == 1;
+
+        dy_t val = decode(encode(
+            dy_make_barr(reinterpret_cast<bool const*>(bools.data()), len)));
+        ASSERT_EQ(dy_get_type(val), dy_type_barr);
+        ASSERT_EQ(dy_get_barr_len(val), len);
+        for (size_t i = 0; i < len; ++i)
+            ASSERT_EQ(dy_get_barr_idx(val, i), i % 3 == 1) << len;
+        dy_dispose(val);
+    }
+
+    // the unused bits are ignored
+    dy_t val = decode(string("\xd5\x01\x05\xff", 4));
+    ASSERT_EQ(dy_get_barr_len(val), 3);
+    ASSERT_EQ(dy_get_barr_words(val)[0], 7);
+    dy_dispose(val);
+}
+
+TEST(MsgpackTest, Containers)
+{
+    dy_t elems[] = { dy_make_i(1), dy_make_str("two"), dy_make_null() };
+
+    dy_keyval_t pairs[] = {
+        { "a", dy_make_arr(elems, 3) },
+        { "b", dy_make_map(NULL, 0) },
+    };
+
+    string bytes = encode(dy_make_map(pairs, 2));
+    ASSERT_EQ(bytes,
+              string("\x82\xa1"
+                     "a"
+                     "\x93\x01\xa3"
+                     "two"
+                     "\xc0\xa1"
+                     "b"
+                     "\x80",
+                     13));
+
+    dy_t map = decode(bytes);
+    ASSERT_EQ(dy_get_map_len(map), 2);
+    dy_t arr = dy_get_map_key(map, "a").val;
+    ASSERT_EQ(dy_get_arr_len(arr), 3);
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(arr, 1)), "two");
+    ASSERT_EQ(dy_get_type(dy_get_map_key(map, "b").val), dy_type_map);
+    dy_dispose(map);
+
+    // long arrays take the headers with lengths
+    vector<dy_t> many;
+    for (int i = 0; i < 70000; ++i) many.push_back(dy_make_b(i % 2));
+    dy_t decoded = decode(encode(dy_make_arr(many.data(), many.size())));
+    ASSERT_EQ(dy_get_arr_len(decoded), 70000);
+    ASSERT_TRUE(dy_get_b(dy_get_arr_idx(decoded, 69999)));
+    dy_dispose(decoded);
+
+    // the keys of the outer maps are kept while the inner ones are decoded
+    vector<dy_keyval_t> outer;
+    vector<string>      keys;
+    for (int i = 0; i < 100; ++i) keys.push_back("key " + to_string(i));
+    for (int i = 0; i < 100; ++i)
+    {
+        vector<dy_keyval_t> inner;
+        for (int j = 0; j < 100; ++j)
+            inner.push_back({ keys[j].c_str(), dy_make_i(i * j) });
+        outer.push_back(
+            { keys[i].c_str(), dy_make_map(inner.data(), inner.size()) });
+    }
+    dy_t   nested = dy_make_map(outer.data(), outer.size());
+    string json   = to_json(nested);
+    decoded       = decode(encode(nested));
+    ASSERT_EQ(to_json(decoded), json);
+    dy_dispose(decoded);
+
+    // the first pair wins as in JSON
+    dy_t dup = decode(string("\x82\xa1k\x01\xa1k\xa1x", 8));
+    ASSERT_EQ(dy_get_map_len(dup), 1);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(dup, "k").val), 1);
+    dy_dispose(dup);
+}
+
+TEST(MsgpackTest, Arena)
+{
+    double nums[] = { 1.5, 2.5 };
+
+    dy_keyval_t pairs[] = {
+        { "name", dy_make_str("arena") },
+        { "nums", dy_make_farr(nums, 2) },
+    };
+    string bytes = encode(dy_make_map(pairs, 2));
+
+    dy_arena_t      arena = dy_arena_create(0);
+    dy_parse_opts_t opts {};
+    opts.arena = arena;
+
+    dy_t map = decode(bytes, &opts);
+    ASSERT_STREQ(dy_get_str_data(dy_get_map_key(map, "name").val), "arena");
+    ASSERT_EQ(dy_get_farr_idx(dy_get_map_key(map, "nums").val, 1), 2.5);
+
+    dy_arena_destroy(arena);
+}
+
+TEST(MsgpackTest, Errors)
+{
+    // truncated values
+    ASSERT_EQ(decode_error("").error, dy_parse_syntax);
+    ASSERT_EQ(decode_error("\xcd\x01").error, dy_parse_syntax);
+    ASSERT_EQ(decode_error("\xa5"
+                           "abc")
+                  .error,
+              dy_parse_syntax);
+    ASSERT_EQ(decode_error(string("\xc6\xff\xff\xff\xff\x00", 6)).error,
+              dy_parse_syntax);
+    ASSERT_EQ(decode_error(string("\xdd\xff\xff\xff\xff\x00", 6)).error,
+              dy_parse_syntax);
+    ASSERT_EQ(decode_error(string("\xdf\x7f\xff\xff\xff\x00", 6)).error,
+              dy_parse_syntax);
+
+    // lengths are checked before the entries
+    dy_parse_opts_t opts = decode_error("\x93\x01\x02");
+    ASSERT_EQ(opts.error, dy_parse_syntax);
+    ASSERT_EQ(opts.error_offset, 0);
+    ASSERT_EQ(decode_error("\x92\x01\xcd\x01").error_offset, 2);
+
+    // trailing bytes, reserved tags, keys which are not strings
+    ASSERT_EQ(decode_error("\x01\x02").error_offset, 1);
+    ASSERT_EQ(decode_error("\xc1").error, dy_parse_syntax);
+    ASSERT_EQ(decode_error("\x81\x01\x02").error_offset, 1);
+
+    // unknown extensions, and entries cut in the middle
+    ASSERT_EQ(decode_error("\xd4\x05\x00").error, dy_parse_syntax);
+    ASSERT_EQ(decode_error("\xd5\x4f\x00\x00").error, dy_parse_syntax);
+    ASSERT_EQ(decode_error(string("\xd4\x01\x08", 3)).error, dy_parse_syntax);
+
+    string deep(2000, '\x91');
+    deep += '\xc0';
+    ASSERT_EQ(decode_error(deep).error, dy_parse_depth);
+}
+
+TEST(MsgpackTest, Buffer)
+{
+    int64_t ints[] = { 1, 2, 3 };
+    dy_t    iarr   = dy_make_iarr(ints, 3);
+
+    char buf[32];
+    ASSERT_EQ(dy_encode_msgpack_buffer(iarr, buf, sizeof(buf)), 27);
+    ASSERT_EQ(dy_encode_msgpack_buffer(iarr, NULL, 0), 27);
+
+    dy_t decoded = dy_decode_msgpack(buf, 27, NULL);
+    ASSERT_EQ(dy_get_iarr_idx(decoded, 2), 3);
+
+    dy_dispose(decoded);
+    dy_dispose(iarr);
+}
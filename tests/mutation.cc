@@ -0,0 +1,186 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include "sink.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+dy_t parse(string const& json, bool lazy = false)
+{
+    dy_parse_opts_t opts {};
+    opts.lazy = lazy;
+    return dy_parse_json(json.data(), json.size(), &opts);
+}
+
+}
+
+TEST(MutationTest, Arr)
+{
+    dy_t arr = dy_make_arr(NULL, 0);
+    for (int i = 0; i < 1000; ++i) arr = dy_arr_push(arr, dy_make_i(i));
+    ASSERT_EQ(dy_get_arr_len(arr), 1000);
+    ASSERT_EQ(dy_get_i(dy_get_arr_idx(arr, 999)), 999);
+
+    dy_t last;
+    arr = dy_arr_pop(arr, &last);
+    ASSERT_EQ(dy_get_i(last), 999);
+    dy_dispose(last);
+    arr = dy_arr_pop(arr, NULL);
+    ASSERT_EQ(dy_get_arr_len(arr), 998);
+
+    arr = dy_arr_insert(arr, 0, dy_make_str("first"));
+    arr = dy_arr_insert(arr, 999, dy_make_str("last"));
+    arr = dy_arr_erase(arr, 1);
+    ASSERT_EQ(dy_get_arr_len(arr), 999);
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(arr, 0)), "first");
+    ASSERT_EQ(dy_get_i(dy_get_arr_idx(arr, 1)), 1);
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(arr, 998)), "last");
+
+    // no copy is made when the array is not shared
+    dy_t same = dy_arr_reserve(arr, 100);
+    ASSERT_EQ(same, arr);
+    ASSERT_EQ(dy_arr_push(arr, dy_make_null()), arr);
+    dy_dispose(arr);
+}
+
+TEST(MutationTest, Shared)
+{
+    dy_t elems[] = { dy_make_i(1), dy_make_str("two") };
+    dy_t arr     = dy_make_arr(elems, 2);
+    dy_t shared  = dy_copy(arr);
+
+    dy_t changed = dy_arr_push(arr, dy_make_i(3));
+    changed      = dy_arr_erase(changed, 0);
+    ASSERT_EQ(to_json(shared), R"([1,"two"])");
+    ASSERT_EQ(to_json(changed), R"(["two",3])");
+
+    // the entries are shared by both
+    ASSERT_EQ(dy_get_arr_idx(shared, 1), dy_get_arr_idx(changed, 0));
+    dy_dispose(shared);
+    dy_dispose(changed);
+}
+
+TEST(MutationTest, Map)
+{
+    dy_keyval_t pairs[] = {
+        { "a", dy_make_i(1) },
+        { "b", dy_make_i(2) },
+        { "c", dy_make_i(3) },
+    };
+    dy_t map   = dy_map_reserve(dy_make_map(pairs, 3), 50);
+    dy_t other = dy_make_map(pairs, 0);
+
+    map = dy_map_set(map, "b", dy_make_str("two"));
+    map = dy_map_set(map, "d", dy_make_i(4));
+    map = dy_map_erase(map, "a");
+    map = dy_map_erase(map, "none");
+    ASSERT_EQ(to_json(map), R"({"b":"two","c":3,"d":4})");
+    ASSERT_EQ(dy_get_map_key(map, "a").key, nullptr);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(map, "d").val), 4);
+
+    // maps made with the same keys share their shape until changed
+    dy_keyval_t again[] = {
+        { "b", dy_make_i(0) },
+        { "c", dy_make_i(0) },
+        { "d", dy_make_i(0) },
+    };
+    dy_t same = dy_make_map(again, 3);
+    same      = dy_map_set(same, "e", dy_make_i(5));
+    ASSERT_EQ(to_json(map), R"({"b":"two","c":3,"d":4})");
+    ASSERT_EQ(dy_get_map_len(same), 4);
+
+    dy_dispose(map);
+    dy_dispose(other);
+    dy_dispose(same);
+}
+
+TEST(MutationTest, LargeMap)
+{
+    vector<string> keys;
+    for (int i = 0; i < 200; ++i) keys.push_back("key_" + to_string(i));
+
+    // the keys are indexed once the map outgrows the small mode
+    dy_t map = dy_make_map(NULL, 0);
+    for (int i = 0; i < 200; ++i)
+        map = dy_map_set(map, keys[i].c_str(), dy_make_i(i));
+    for (int i = 0; i < 200; i += 2) map = dy_map_erase(map, keys[i].c_str());
+
+    ASSERT_EQ(dy_get_map_len(map), 100);
+    for (int i = 0; i < 200; ++i)
+    {
+        dy_keyval_t pair = dy_get_map_key(map, keys[i].c_str());
+        if (i % 2 == 0)
+            ASSERT_EQ(pair.key, nullptr);
+        else
+            ASSERT_EQ(dy_get_i(pair.val), i);
+    }
+
+    // the order of the keys is kept
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(dy_get_map_idx(map, i).key, keys[i * 2 + 1]);
+    dy_dispose(map);
+}
+
+TEST(MutationTest, Typed)
+{
+    dy_t iarr  = dy_make_iarr(NULL, 0);
+    dy_t farr  = dy_make_farr(NULL, 0);
+    dy_t bytes = dy_make_bytes(NULL, 0);
+    for (int i = 0; i < 100; ++i)
+    {
+        iarr = dy_iarr_push(iarr, i);
+        farr = dy_farr_push(farr, i * 0.5);
+    }
+
+    uint8_t chunk[] = { 1, 2, 3 };
+    for (int i = 0; i < 10; ++i) bytes = dy_bytes_append(bytes, chunk, 3);
+    bytes = dy_bytes_append(bytes, NULL, 0);
+
+    ASSERT_EQ(dy_get_iarr_len(iarr), 100);
+    ASSERT_EQ(dy_iarr_sum(iarr), 4950);
+    ASSERT_EQ(dy_get_farr_idx(farr, 99), 49.5);
+    ASSERT_EQ(dy_get_bytes_len(bytes), 30);
+    ASSERT_EQ(dy_get_bytes_idx(bytes, 29), 3);
+
+    dy_dispose(iarr);
+    dy_dispose(farr);
+    dy_dispose(bytes);
+}
+
+TEST(MutationTest, Copies)
+{
+    // views are copied before they are changed
+    int64_t ints[] = { 1, 2 };
+    dy_t    view   = dy_make_iarr_view(ints, 2);
+    dy_t    iarr   = dy_iarr_push(view, 3);
+    ASSERT_FALSE(dy_is_view(iarr));
+    ASSERT_EQ(dy_get_iarr_len(iarr), 3);
+    ASSERT_EQ(ints[1], 2);
+    dy_dispose(iarr);
+
+    // so are the values in arenas, whose copies are on the heap
+    dy_arena_t arena   = dy_arena_create(0);
+    dy_t       elems[] = { dy_make_i(1) };
+    dy_t       in      = dy_arena_make_arr(arena, elems, 1);
+    dy_t       arr     = dy_arr_push(in, dy_make_i(2));
+    ASSERT_NE(arr, in);
+    ASSERT_EQ(dy_get_arr_len(in), 1);
+    dy_arena_destroy(arena);
+    ASSERT_EQ(to_json(arr), "[1,2]");
+    dy_dispose(arr);
+
+    // and the values parsed lazily
+    string json = R"({"a": [1, {"b": 2}], "c": "x"})";
+    dy_t   lazy = parse(json, true);
+    dy_t   map  = dy_map_set(lazy, "c", dy_make_i(3));
+    map         = dy_map_set(map, "d", dy_make_null());
+    ASSERT_EQ(to_json(map), R"({"a":[1,{"b":2}],"c":3,"d":null})");
+    dy_dispose(map);
+}
@@ -0,0 +1,172 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace std;
+
+TEST(NarrowArrayTest, MakeAndGet)
+{
+    int16_t samples[]  = { -300, 0, 12000 };
+    float   features[] = { 0.5f, -1.25f };
+
+    dy_t i16 = dy_make_i16arr(samples, 3);
+    dy_t f32 = dy_make_f32arr(features, 2);
+
+    ASSERT_EQ(dy_get_type(i16), dy_type_i16arr);
+    ASSERT_EQ(dy_get_i16arr_len(i16), 3);
+    ASSERT_EQ(dy_get_i16arr_idx(i16, 0), -300);
+    ASSERT_EQ(dy_get_i16arr_data(i16)[2], 12000);
+    ASSERT_NE(dy_get_i16arr_data(i16), samples);
+
+    ASSERT_EQ(dy_get_type(f32), dy_type_f32arr);
+    ASSERT_EQ(dy_get_f32arr_idx(f32, 1), -1.25f);
+
+    dy_t copy = dy_copy(f32);
+    ASSERT_EQ(dy_get_f32arr_len(copy), 2);
+
+    dy_dispose(copy);
+    dy_dispose(f32);
+    dy_dispose(i16);
+}
+
+TEST(NarrowArrayTest, ArenaAndViews)
+{
+    int8_t   bytes[]  = { -1, 2, -3 };
+    uint32_t ids[]    = { 7, UINT32_MAX };
+    int32_t  counts[] = { 1, 2, 3, 4 };
+
+    dy_arena_t arena = dy_arena_create(0);
+    dy_t       i8    = dy_arena_make_i8arr(arena, bytes, 3);
+    dy_t       copy  = dy_copy(i8);
+    dy_arena_destroy(arena);
+
+    ASSERT_EQ(dy_get_i8arr_idx(copy, 2), -3);
+    dy_dispose(copy);
+
+    dy_t view = dy_make_u32arr_view(ids, 2);
+    ASSERT_TRUE(dy_is_view(view));
+    ASSERT_EQ(dy_get_u32arr_data(view), ids);
+
+    dy_t owned = dy_materialize(view);
+    ASSERT_EQ(dy_get_u32arr_idx(owned, 1), UINT32_MAX);
+    dy_dispose(owned);
+    dy_dispose(view);
+
+    dy_t i32 = dy_make_i32arr(counts, 4);
+
+    dy_free_fn_t free_fn;
+    void*        ctx;
+    int32_t*     released = dy_release_i32arr_data(i32, &free_fn, &ctx);
+    ASSERT_EQ(released[3], 4);
+    free_fn(released, ctx);
+    dy_dispose(i32);
+}
+
+TEST(NarrowArrayTest, NumericTypes)
+{
+    ASSERT_TRUE(dy_is_numeric_arr_type(dy_type_bytes));
+    ASSERT_TRUE(dy_is_numeric_arr_type(dy_type_iarr));
+    ASSERT_TRUE(dy_is_numeric_arr_type(dy_type_f32arr));
+    ASSERT_FALSE(dy_is_numeric_arr_type(dy_type_barr));
+    ASSERT_FALSE(dy_is_numeric_arr_type(dy_type_arr));
+    ASSERT_FALSE(dy_is_numeric_arr_type(dy_type_i));
+}
+
+TEST(NarrowArrayTest, Widening)
+{
+    // long enough to cover the vectorized loops and their tails
+    vector<int16_t> samples;
+    for (int i = 0; i < 1000; ++i) samples.push_back(i * 61 - 30000);
+
+    dy_t i16  = dy_make_i16arr(samples.data(), samples.size());
+    dy_t iarr = dy_convert_arr(i16, dy_type_iarr);
+    dy_t farr = dy_convert_arr(i16, dy_type_farr);
+    dy_t f32  = dy_convert_arr(i16, dy_type_f32arr);
+
+    ASSERT_EQ(dy_get_type(iarr), dy_type_iarr);
+    ASSERT_EQ(dy_get_iarr_len(iarr), samples.size());
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        ASSERT_EQ(dy_get_iarr_idx(iarr, i), samples[i]);
+        ASSERT_EQ(dy_get_farr_idx(farr, i), samples[i]);
+        ASSERT_EQ(dy_get_f32arr_idx(f32, i), samples[i]);
+    }
+
+    // the same type makes a copy
+    dy_t same = dy_convert_arr(i16, dy_type_i16arr);
+    ASSERT_EQ(dy_get_type(same), dy_type_i16arr);
+    ASSERT_EQ(dy_get_i16arr_idx(same, 999), samples[999]);
+
+    dy_dispose(same);
+    dy_dispose(f32);
+    dy_dispose(farr);
+    dy_dispose(iarr);
+    dy_dispose(i16);
+}
+
+TEST(NarrowArrayTest, Narrowing)
+{
+    int64_t ints[] = { INT64_MIN, -129, -128, -1, 0, 255, 256, INT64_MAX };
+
+    dy_t iarr = dy_make_iarr(ints, 8);
+    dy_t i8   = dy_convert_arr(iarr, dy_type_i8arr);
+    dy_t u8   = dy_convert_arr(iarr, dy_type_bytes);
+    dy_t u32  = dy_convert_arr(iarr, dy_type_u32arr);
+
+    int8_t   i8s[]  = { -128, -128, -128, -1, 0, 127, 127, 127 };
+    uint8_t  u8s[]  = { 0, 0, 0, 0, 0, 255, 255, 255 };
+    uint32_t u32s[] = { 0, 0, 0, 0, 0, 255, 256, UINT32_MAX };
+    for (size_t i = 0; i < 8; ++i)
+    {
+        ASSERT_EQ(dy_get_i8arr_idx(i8, i), i8s[i]);
+        ASSERT_EQ(dy_get_bytes_idx(u8, i), u8s[i]);
+        ASSERT_EQ(dy_get_u32arr_idx(u32, i), u32s[i]);
+    }
+
+    // unsigned integers above the signed range
+    dy_t i32 = dy_convert_arr(u32, dy_type_i32arr);
+    ASSERT_EQ(dy_get_i32arr_idx(i32, 7), INT32_MAX);
+    ASSERT_EQ(dy_get_i32arr_idx(i32, 6), 256);
+
+    dy_dispose(i32);
+    dy_dispose(u32);
+    dy_dispose(u8);
+    dy_dispose(i8);
+    dy_dispose(iarr);
+}
+
+TEST(NarrowArrayTest, FloatToInteger)
+{
+    double nums[] = {
+        -1e300, -2.9, -0.5, 0.5, 2.9, 40000, 1e300, NAN, 0x1p63, -0x1p63,
+    };
+
+    dy_t farr = dy_make_farr(nums, 10);
+    dy_t i16  = dy_convert_arr(farr, dy_type_i16arr);
+    dy_t iarr = dy_convert_arr(farr, dy_type_iarr);
+    dy_t f32  = dy_convert_arr(farr, dy_type_f32arr);
+
+    int16_t i16s[]  = { INT16_MIN, -2, 0, 0, 2, INT16_MAX, INT16_MAX, 0,
+                        INT16_MAX, INT16_MIN };
+    int64_t iarrs[] = { INT64_MIN, -2, 0, 0, 2, 40000, INT64_MAX, 0,
+                        INT64_MAX, INT64_MIN };
+    for (size_t i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(dy_get_i16arr_idx(i16, i), i16s[i]);
+        ASSERT_EQ(dy_get_iarr_idx(iarr, i), iarrs[i]);
+    }
+
+    ASSERT_EQ(dy_get_f32arr_idx(f32, 4), 2.9f);
+    ASSERT_TRUE(isinf(dy_get_f32arr_idx(f32, 6)));
+    ASSERT_TRUE(isnan(dy_get_f32arr_idx(f32, 7)));
+
+    dy_dispose(f32);
+    dy_dispose(iarr);
+    dy_dispose(i16);
+    dy_dispose(farr);
+}
@@ -0,0 +1,173 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include "sink.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+/// <summary>
+/// collects the values handed out in JSON
+/// </summary>
+struct collector
+{
+    vector<string> vals;
+    dy_arena_t     arena = NULL;
+    size_t         limit = SIZE_MAX;
+
+    static bool receive(void* ctx, dy_t val)
+    {
+        auto   self = static_cast<collector*>(ctx);
+        string json;
+        dy_write_json(val, dy_write_default, append, &json);
+        self->vals.push_back(json);
+
+        if (self->arena != NULL)
+            dy_arena_reset(self->arena);
+        else
+            dy_dispose(val);
+        return self->vals.size() < self->limit;
+    }
+};
+
+/// <summary>
+/// parses the text in chunks of the length
+/// </summary>
+vector<string> parse(char const* path, string const& json, size_t chunk)
+{
+    collector   out;
+    dy_parser_t parser = dy_parser_create(path, NULL, collector::receive, &out);
+    EXPECT_NE(parser, nullptr);
+
+    for (size_t i = 0; i < json.size(); i += chunk)
+    {
+        size_t len = min(chunk, json.size() - i);
+        EXPECT_TRUE(dy_parser_feed(parser, json.data() + i, len));
+    }
+    EXPECT_TRUE(dy_parser_finish(parser));
+    EXPECT_EQ(dy_get_parser_error(parser, NULL), dy_parse_ok);
+    dy_parser_destroy(parser);
+    return out.vals;
+}
+
+/// <summary>
+/// parses the text at once
+/// </summary>
+/// <returns>the error, whose offset is set to <c>offset</c></returns>
+dy_parse_error_t fail(char const* path, string const& json, size_t* offset)
+{
+    collector   out;
+    dy_parser_t parser = dy_parser_create(path, NULL, collector::receive, &out);
+
+    if (dy_parser_feed(parser, json.data(), json.size()))
+        dy_parser_finish(parser);
+
+    dy_parse_error_t error = dy_get_parser_error(parser, offset);
+    dy_parser_destroy(parser);
+    return error;
+}
+
+}
+
+TEST(ParserTest, TopLevel)
+{
+    string         json = "{\"a\":1}\n[1,2]\n\"str\" 3.5 null\ntrue -7";
+    vector<string> vals = { "{\"a\":1}", "[1,2]", "\"str\"", "3.5",
+                            "null",      "true",  "-7" };
+
+    for (size_t chunk = 1; chunk <= json.size(); ++chunk)
+        ASSERT_EQ(parse(NULL, json, chunk), vals);
+    ASSERT_TRUE(parse(NULL, " \n ", 1).empty());
+}
+
+TEST(ParserTest, Path)
+{
+    string json = "{\"skip\": [[1], {\"items\": [0]}], \"da\\/ta\": {\"x\": "
+                  "\"]}\", \"items\": [{\"id\": 1, \"s\": \"a\\\"]\"}, [], 2,"
+                  " \"x\"], \"y\": [3]}, \"items\": [4]}";
+    vector<string> vals = { "{\"id\":1,\"s\":\"a\\\"]\"}", "[]", "2", "\"x\"" };
+
+    for (size_t chunk = 1; chunk <= json.size(); ++chunk)
+        ASSERT_EQ(parse("/da~1ta/items", json, chunk), vals);
+
+    ASSERT_EQ(parse("", "[1, [2]] [3]", 2),
+              (vector<string> { "1", "[2]", "3" }));
+    ASSERT_EQ(parse("/1", "[[0], [1, 2], [3]]", 3),
+              (vector<string> { "1", "2" }));
+    ASSERT_EQ(parse("/1/a~0", "[0, {\"a~\": [5]}]", 4),
+              (vector<string> { "5" }));
+
+    // the values at the path which are not arrays are skipped
+    ASSERT_TRUE(parse("/a", "{\"a\": {\"b\": 1}} {\"a\": 2}", 5).empty());
+    ASSERT_EQ(dy_parser_create("a", NULL, collector::receive, NULL), nullptr);
+}
+
+TEST(ParserTest, Arena)
+{
+    collector out;
+    out.arena = dy_arena_create(0);
+
+    dy_parse_opts_t opts {};
+    opts.arena = out.arena;
+
+    dy_parser_t parser
+        = dy_parser_create("/rows", &opts, collector::receive, &out);
+    ASSERT_TRUE(dy_parser_feed(parser, "{\"rows\": [", 10));
+
+    string row = "{\"name\": \"" + string(1000, 'x') + "\", \"n\": [1, 2]},";
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_TRUE(dy_parser_feed(parser, row.data(), row.size()));
+    ASSERT_TRUE(dy_parser_feed(parser, "0]}", 3));
+    ASSERT_TRUE(dy_parser_finish(parser));
+    dy_parser_destroy(parser);
+
+    // the arena is reused for each row
+    ASSERT_EQ(out.vals.size(), 1001);
+    ASSERT_LE(dy_arena_capacity(out.arena), 64 * 1024);
+    dy_arena_destroy(out.arena);
+}
+
+TEST(ParserTest, Errors)
+{
+    size_t offset;
+    ASSERT_EQ(fail(NULL, "[1, 2] ]", &offset), dy_parse_syntax);
+    ASSERT_EQ(offset, 7);
+    ASSERT_EQ(fail(NULL, "1 [1, x]", &offset), dy_parse_syntax);
+    ASSERT_EQ(offset, 6);
+    ASSERT_EQ(fail(NULL, "[1, 2", &offset), dy_parse_syntax);
+    ASSERT_EQ(offset, 5);
+    ASSERT_EQ(fail(NULL, "\"abc", &offset), dy_parse_syntax);
+    ASSERT_EQ(fail(NULL, "[1e999]", &offset), dy_parse_number);
+    ASSERT_EQ(fail("", "[0, \"\\x\"]", &offset), dy_parse_string);
+    ASSERT_EQ(offset, 5);
+    ASSERT_EQ(fail("/a", "{\"a\" 1}", &offset), dy_parse_syntax);
+    ASSERT_EQ(offset, 5);
+    ASSERT_EQ(fail("/a", "{\"a\": [1}}", &offset), dy_parse_syntax);
+    ASSERT_EQ(offset, 8);
+    ASSERT_EQ(fail("/a", "{\"a\": [1], ]", &offset), dy_parse_syntax);
+    ASSERT_EQ(fail("/a", "{\"b\": \"\t\"}", &offset), dy_parse_string);
+    ASSERT_EQ(offset, 7);
+}
+
+TEST(ParserTest, Stop)
+{
+    collector out;
+    out.limit = 2;
+
+    dy_parser_t parser = dy_parser_create("", NULL, collector::receive, &out);
+    ASSERT_FALSE(dy_parser_feed(parser, "[1, 2, 3]", 9));
+    ASSERT_FALSE(dy_parser_feed(parser, "[4]", 3));
+    ASSERT_FALSE(dy_parser_finish(parser));
+
+    size_t offset;
+    ASSERT_EQ(dy_get_parser_error(parser, &offset), dy_parse_stopped);
+    ASSERT_EQ(offset, 5);
+    ASSERT_EQ(out.vals, (vector<string> { "1", "2" }));
+    dy_parser_destroy(parser);
+}
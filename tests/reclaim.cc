@@ -0,0 +1,163 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+constexpr size_t batch = 4;
+
+void count_free(void* ptr, void* ctx)
+{
+    static_cast<atomic<int>*>(ctx)->fetch_add(1);
+    free(ptr);
+}
+
+/// <summary>
+/// makes an array holding a string whose buffer is counted when freed
+/// </summary>
+dy_t make_counted(atomic<int>* freed)
+{
+    char* str = static_cast<char*>(malloc(8));
+    memcpy(str, "counted", 8);
+
+    dy_t entries[] = { dy_adopt_str(str, 7, count_free, freed),
+                       dy_make_i(INT64_MAX) };
+    return dy_make_arr(entries, 2);
+}
+
+}
+
+// runs first, as the options cannot change once a value is deferred
+TEST(ReclaimTest, Configure)
+{
+    dy_reclaim_opts_t opts {};
+    opts.threads = 2;
+    opts.batch   = batch;
+    ASSERT_TRUE(dy_reclaim_configure(&opts));
+
+    // flushing before any value is deferred starts nothing
+    dy_reclaim_flush();
+    ASSERT_TRUE(dy_reclaim_configure(&opts));
+
+    atomic<int> freed { 0 };
+    dy_dispose_deferred(make_counted(&freed));
+    dy_reclaim_flush();
+    ASSERT_EQ(freed, 1);
+
+    opts.batch = 1;
+    ASSERT_FALSE(dy_reclaim_configure(&opts));
+}
+
+TEST(ReclaimTest, Batches)
+{
+    // fewer values than a batch wait for the flush
+    atomic<int> freed { 0 };
+    for (size_t i = 0; i < batch - 1; ++i)
+        dy_dispose_deferred(make_counted(&freed));
+    dy_reclaim_flush();
+    ASSERT_EQ(freed, batch - 1);
+
+    dy_reclaim_flush();
+    ASSERT_EQ(freed, batch - 1);
+}
+
+TEST(ReclaimTest, Shared)
+{
+    atomic<int> freed { 0 };
+    dy_t        val  = make_counted(&freed);
+    dy_t        copy = dy_copy(val);
+
+    // only the last reference hands the value over
+    dy_dispose_deferred(val);
+    dy_reclaim_flush();
+    ASSERT_EQ(freed, 0);
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(copy, 0)), "counted");
+
+    dy_t entries[] = { copy, dy_make_str("other") };
+    dy_t outer     = dy_make_arr(entries, 2);
+    dy_dispose_deferred(outer);
+    dy_reclaim_flush();
+    ASSERT_EQ(freed, 1);
+}
+
+TEST(ReclaimTest, Values)
+{
+    // values without entries are disposed at once
+    atomic<int> freed { 0 };
+    char*       str = static_cast<char*>(calloc(1, 1));
+    dy_dispose_deferred(dy_adopt_str(str, 0, count_free, &freed));
+    ASSERT_EQ(freed, 1);
+
+    dy_dispose_deferred(dy_make_null());
+    dy_dispose_deferred(dy_make_i(1));
+
+    dy_arena_t arena = dy_arena_create(0);
+    dy_dispose_deferred(dy_arena_make_arr(arena, NULL, 0));
+    dy_arena_destroy(arena);
+
+    string          json = R"({"a": [1, "x", {"b": []}], "c": {}})";
+    dy_parse_opts_t opts {};
+    opts.lazy = true;
+
+    dy_t lazy = dy_parse_json(json.data(), json.size(), &opts);
+    ASSERT_EQ(dy_get_type(dy_get_map_key(lazy, "a").val), dy_type_arr);
+    dy_dispose_deferred(lazy);
+    dy_reclaim_flush();
+}
+
+TEST(ReclaimTest, Threads)
+{
+    constexpr size_t thread_count = 4;
+    constexpr size_t value_count  = 1000;
+
+    atomic<int>    freed { 0 };
+    vector<thread> threads;
+    for (size_t t = 0; t < thread_count; ++t)
+    {
+        threads.emplace_back([&freed] {
+            for (size_t i = 0; i < value_count; ++i)
+                dy_dispose_deferred(make_counted(&freed));
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    dy_reclaim_flush();
+    ASSERT_EQ(freed, thread_count * value_count);
+}
+
+TEST(ReclaimTest, FlushOwn)
+{
+    constexpr size_t thread_count = 4;
+    constexpr size_t round_count  = 2000;
+
+    // a flush covers the values deferred by the thread before it, whatever
+    // the other threads are deferring meanwhile
+    atomic<size_t> failures { 0 };
+    vector<thread> threads;
+    for (size_t t = 0; t < thread_count; ++t)
+    {
+        threads.emplace_back([&failures] {
+            for (size_t i = 0; i < round_count; ++i)
+            {
+                atomic<int> freed { 0 };
+                dy_dispose_deferred(make_counted(&freed));
+                dy_reclaim_flush();
+                if (freed != 1) failures.fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    ASSERT_EQ(failures, 0);
+}
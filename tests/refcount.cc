@@ -0,0 +1,131 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+dy_t make_document()
+{
+    int64_t samples[] = { 1, 2, 3 };
+
+    dy_t items[] = {
+        dy_make_str("item"),
+        dy_make_iarr(samples, 3),
+        dy_make_i(INT64_MAX),
+    };
+
+    dy_keyval_t fields[] = {
+        { "name", dy_make_str("config") },
+        { "items", dy_make_arr(items, 3) },
+    };
+
+    return dy_make_map(fields, 2);
+}
+
+}
+
+TEST(RefcountTest, CopyShares)
+{
+    dy_t doc  = make_document();
+    dy_t copy = dy_copy(doc);
+    ASSERT_EQ(copy, doc);
+
+    // the values stay valid until the last reference is released
+    dy_dispose(doc);
+    dy_t items = dy_get_map_key(copy, "items").val;
+    ASSERT_EQ(dy_get_arr_len(items), 3);
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(items, 0)), "item");
+    ASSERT_EQ(dy_get_i(dy_get_arr_idx(items, 2)), INT64_MAX);
+
+    dy_dispose(copy);
+}
+
+TEST(RefcountTest, RetainRelease)
+{
+    dy_t str = dy_make_str("shared");
+    ASSERT_EQ(dy_retain(str), str);
+    ASSERT_EQ(dy_retain(str), str);
+
+    // a container takes one of the references
+    dy_t arr = dy_make_arr(&str, 1);
+    dy_release(str);
+    dy_release(arr);
+
+    ASSERT_STREQ(dy_get_str_data(str), "shared");
+    dy_release(str);
+
+    // immediates have nothing to count
+    dy_t i = dy_make_i(7);
+    ASSERT_EQ(dy_retain(i), i);
+    dy_release(i);
+    ASSERT_EQ(dy_get_i(i), 7);
+}
+
+TEST(RefcountTest, SharedChildren)
+{
+    // a value may be held by many containers at once
+    dy_t doc    = make_document();
+    dy_t arrs[] = { dy_copy(doc), dy_copy(doc), dy_copy(doc) };
+    dy_t outer  = dy_make_arr(arrs, 3);
+    dy_t other  = dy_make_arr(&doc, 1);
+
+    dy_dispose(outer);
+    ASSERT_STREQ(
+        dy_get_str_data(dy_get_map_key(dy_get_arr_idx(other, 0), "name").val),
+        "config");
+    dy_dispose(other);
+}
+
+TEST(RefcountTest, ArenaCopy)
+{
+    dy_arena_t arena = dy_arena_create(0);
+
+    dy_t items[] = {
+        dy_arena_make_str(arena, "in the arena"),
+        dy_arena_make_i(arena, INT64_MIN),
+    };
+    dy_t arr = dy_arena_make_arr(arena, items, 2);
+
+    // arena values are copied rather than shared
+    ASSERT_EQ(dy_retain(arr), arr);
+    dy_t copy = dy_copy(arr);
+    ASSERT_NE(copy, arr);
+    dy_arena_destroy(arena);
+
+    // the copy is shared from now on
+    dy_t shared = dy_copy(copy);
+    ASSERT_EQ(shared, copy);
+    dy_dispose(copy);
+
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(shared, 0)), "in the arena");
+    ASSERT_EQ(dy_get_i(dy_get_arr_idx(shared, 1)), INT64_MIN);
+    dy_dispose(shared);
+}
+
+TEST(RefcountTest, Threads)
+{
+    constexpr size_t thread_count = 4;
+    constexpr size_t copy_count   = 10000;
+
+    dy_t doc = make_document();
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; ++t)
+    {
+        threads.emplace_back([doc] {
+            std::vector<dy_t> copies;
+            for (size_t i = 0; i < copy_count; ++i)
+                copies.push_back(dy_copy(doc));
+            for (auto copy : copies) dy_dispose(copy);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    ASSERT_STREQ(dy_get_str_data(dy_get_map_key(doc, "name").val), "config");
+    dy_dispose(doc);
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+TEST(ScalarTest, Null)
+{
+    dy_t val = dy_make_null();
+    ASSERT_EQ(dy_get_type(val), dy_type_null);
+    ASSERT_EQ(dy_copy(val), val);
+    dy_dispose(val);
+}
+
+TEST(ScalarTest, Boolean)
+{
+    dy_t t = dy_make_b(true);
+    dy_t f = dy_make_b(false);
+
+    ASSERT_EQ(dy_get_type(t), dy_type_b);
+    ASSERT_EQ(dy_get_type(f), dy_type_b);
+    ASSERT_TRUE(dy_get_b(t));
+    ASSERT_FALSE(dy_get_b(f));
+    ASSERT_NE(t, f);
+
+    dy_dispose(t);
+    dy_dispose(f);
+}
+
+TEST(ScalarTest, Integer)
+{
+    int64_t cmp[] = {
+        0,
+        1,
+        -1,
+        15,
+        (int64_t(1) << 47) - 1,
+        -(int64_t(1) << 47),
+        int64_t(1) << 47,
+        -(int64_t(1) << 47) - 1,
+        numeric_limits<int64_t>::max(),
+        numeric_limits<int64_t>::min(),
+    };
+
+    for (int64_t i : cmp)
+    {
+        dy_t val = dy_make_i(i);
+        ASSERT_EQ(dy_get_type(val), dy_type_i);
+        ASSERT_EQ(dy_get_i(val), i);
+
+        dy_t copy = dy_copy(val);
+        ASSERT_EQ(dy_get_type(copy), dy_type_i);
+        ASSERT_EQ(dy_get_i(copy), i);
+
+        dy_dispose(val);
+        dy_dispose(copy);
+    }
+}
+
+TEST(ScalarTest, Float)
+{
+    double cmp[] = {
+        0.0,
+        -0.0,
+        1.5,
+        -2.25,
+        numeric_limits<double>::min(),
+        numeric_limits<double>::denorm_min(),
+        numeric_limits<double>::max(),
+        numeric_limits<double>::infinity(),
+        -numeric_limits<double>::infinity(),
+    };
+
+    for (double f : cmp)
+    {
+        dy_t val = dy_make_f(f);
+        ASSERT_EQ(dy_get_type(val), dy_type_f);
+        ASSERT_EQ(dy_get_f(val), f);
+        ASSERT_EQ(signbit(dy_get_f(val)), signbit(f));
+        dy_dispose(val);
+    }
+
+    dy_t nan = dy_make_f(-numeric_limits<double>::quiet_NaN());
+    ASSERT_EQ(dy_get_type(nan), dy_type_f);
+    ASSERT_TRUE(isnan(dy_get_f(nan)));
+    dy_dispose(nan);
+}
+
+TEST(ScalarTest, ArenaScalars)
+{
+    dy_arena_t arena = dy_arena_create(0);
+
+    ASSERT_EQ(dy_get_type(dy_arena_make_null(arena)), dy_type_null);
+    ASSERT_TRUE(dy_get_b(dy_arena_make_b(arena, true)));
+    ASSERT_EQ(dy_get_i(dy_arena_make_i(arena, -7)), -7);
+    ASSERT_EQ(dy_get_i(dy_arena_make_i(arena, numeric_limits<int64_t>::min())),
+              numeric_limits<int64_t>::min());
+    ASSERT_DOUBLE_EQ(dy_get_f(dy_arena_make_f(arena, 0.125)), 0.125);
+
+    dy_arena_destroy(arena);
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+dy_t make_record(int64_t id)
+{
+    dy_keyval_t fields[] = {
+        { "id", dy_make_i(id) },
+        { "name", dy_make_str("record") },
+        { "score", dy_make_f(id * 0.5) },
+    };
+    return dy_make_map(fields, 3);
+}
+
+}
+
+TEST(ShapeTest, AutomaticSharing)
+{
+    std::vector<dy_t> records;
+    for (int64_t i = 0; i < 100; ++i) records.push_back(make_record(i));
+
+    dy_shape_t shape = dy_get_map_shape(records[0]);
+    ASSERT_EQ(dy_get_shape_len(shape), 3);
+    ASSERT_STREQ(dy_get_shape_key(shape, 1), "name");
+
+    for (int64_t i = 0; i < 100; ++i)
+    {
+        ASSERT_EQ(dy_get_map_shape(records[i]), shape);
+        ASSERT_EQ(dy_get_i(dy_get_map_key(records[i], "id").val), i);
+        ASSERT_STREQ(dy_get_str_data(dy_get_map_key(records[i], "name").val),
+                     "record");
+    }
+
+    // the keys in another order make another shape
+    dy_keyval_t swapped[] = {
+        { "name", dy_make_null() },
+        { "id", dy_make_i(0) },
+        { "score", dy_make_f(0) },
+    };
+    dy_t other = dy_make_map(swapped, 3);
+    ASSERT_NE(dy_get_map_shape(other), shape);
+    ASSERT_STREQ(dy_get_map_idx(other, 0).key, "name");
+    dy_dispose(other);
+
+    // copies share the shape
+    dy_t copy = dy_copy(records[0]);
+    ASSERT_EQ(dy_get_map_shape(copy), shape);
+
+    for (auto record : records) dy_dispose(record);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(copy, "id").val), 0);
+    dy_dispose(copy);
+}
+
+TEST(ShapeTest, DuplicateKeys)
+{
+    dy_keyval_t pairs[] = {
+        { "a", dy_make_i(1) },
+        { "b", dy_make_i(2) },
+        { "a", dy_make_i(3) },
+    };
+
+    dy_t first  = dy_make_map(pairs, 3);
+    dy_t second = dy_make_map(pairs, 3);
+    ASSERT_EQ(dy_get_map_len(first), 2);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(second, "a").val), 1);
+    ASSERT_EQ(dy_get_i(dy_get_map_idx(second, 1).val), 2);
+
+    dy_dispose(first);
+    dy_dispose(second);
+}
+
+TEST(ShapeTest, ExplicitShape)
+{
+    std::vector<std::string> names;
+    for (size_t i = 0; i < 40; ++i)
+        names.push_back("column_" + std::to_string(i));
+
+    std::vector<char const*> keys;
+    for (auto const& name : names) keys.push_back(name.c_str());
+
+    dy_shape_t shape = dy_make_shape(keys.data(), keys.size());
+    ASSERT_EQ(dy_get_shape_len(shape), keys.size());
+
+    std::vector<dy_t> rows;
+    for (int64_t r = 0; r < 10; ++r)
+    {
+        std::vector<dy_t> vals;
+        for (size_t i = 0; i < keys.size(); ++i) vals.push_back(dy_make_i(r));
+        rows.push_back(dy_make_map_with_shape(shape, vals.data(), vals.size()));
+    }
+
+    // the maps hold the shape after it is released
+    dy_dispose_shape(shape);
+
+    size_t idx = dy_find_shape_key(dy_get_map_shape(rows[0]), "column_7", 8);
+    ASSERT_EQ(idx, 7);
+    ASSERT_EQ(dy_find_shape_key(dy_get_map_shape(rows[0]), "column", 6),
+              SIZE_MAX);
+
+    for (int64_t r = 0; r < 10; ++r)
+    {
+        dy_keyval_t keyval = dy_get_map_idx(rows[r], idx);
+        ASSERT_STREQ(keyval.key, "column_7");
+        ASSERT_EQ(dy_get_i(keyval.val), r);
+        ASSERT_EQ(dy_get_i(dy_get_map_key(rows[r], "column_39").val), r);
+    }
+
+    // maps with the same keys reuse the shape
+    std::vector<dy_keyval_t> pairs;
+    for (auto key : keys) pairs.push_back({ key, dy_make_null() });
+    dy_t map = dy_make_map(pairs.data(), pairs.size());
+    ASSERT_EQ(dy_get_map_shape(map), dy_get_map_shape(rows[0]));
+    dy_dispose(map);
+
+    for (auto row : rows) dy_dispose(row);
+}
+
+TEST(ShapeTest, Arena)
+{
+    char const* keys[] = { "x", "y" };
+    dy_shape_t  shape  = dy_make_shape(keys, 2);
+    dy_arena_t  arena  = dy_arena_create(0);
+
+    dy_t vals[] = { dy_arena_make_i(arena, 1), dy_arena_make_i(arena, 2) };
+    dy_t point  = dy_arena_make_map_with_shape(arena, shape, vals, 2);
+
+    dy_keyval_t pairs[] = {
+        { "x", vals[0] },
+        { "y", vals[1] },
+    };
+    dy_t other = dy_arena_make_map(arena, pairs, 2);
+
+    ASSERT_EQ(dy_get_map_shape(point), shape);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(point, "y").val), 2);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(other, "x").val), 1);
+
+    // copies on the heap do not depend on the arena
+    dy_t copy = dy_copy(other);
+    dy_arena_destroy(arena);
+    dy_dispose_shape(shape);
+
+    ASSERT_EQ(dy_get_i(dy_get_map_key(copy, "y").val), 2);
+    dy_dispose(copy);
+}
+
+TEST(ShapeTest, Threads)
+{
+    std::vector<dy_t> records(1000);
+
+    // the maps outlive the cache of the thread which made them
+    std::thread thread([&] {
+        for (size_t i = 0; i < records.size(); ++i) records[i] = make_record(i);
+    });
+    thread.join();
+
+    dy_t local = make_record(0);
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        ASSERT_EQ(dy_get_map_shape(records[i]), dy_get_map_shape(records[0]));
+        ASSERT_EQ(dy_get_i(dy_get_map_key(records[i], "id").val), i);
+    }
+
+    for (auto record : records) dy_dispose(record);
+    ASSERT_EQ(dy_get_i(dy_get_map_key(local, "id").val), 0);
+    dy_dispose(local);
+}
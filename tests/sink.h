@@ -0,0 +1,29 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#ifndef DY_TEST_SINK_H
+#define DY_TEST_SINK_H
+
+#include <dy.h>
+
+#include <string>
+
+/// <summary>
+/// appends the text written to the string given as the context
+/// </summary>
+inline bool append(void* ctx, char const* data, size_t len)
+{
+    static_cast<std::string*>(ctx)->append(data, len);
+    return true;
+}
+
+/// <summary>
+/// writes the value in JSON to compare the entries
+/// </summary>
+inline std::string to_json(dy_t val)
+{
+    std::string json;
+    dy_write_json(val, dy_write_default, append, &json);
+    return json;
+}
+
+#endif
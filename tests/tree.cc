@@ -0,0 +1,207 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include "sink.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+/// <summary>
+/// deep enough to overflow the stack if the levels were visited recursively
+/// </summary>
+constexpr size_t deep = 1000000;
+
+/// <summary>
+/// builds arrays nested to the depth, with a string in the innermost one
+/// </summary>
+dy_t make_deep(dy_arena_t arena, size_t depth)
+{
+    dy_builder_t builder = dy_builder_create(arena);
+    for (size_t i = 0; i < depth; ++i) dy_builder_begin_arr(builder, 1);
+    dy_builder_push_str(builder, "innermost");
+    for (size_t i = 0; i < depth; ++i) dy_builder_end(builder);
+
+    dy_t val = dy_builder_finish(builder);
+    dy_builder_destroy(builder);
+    return val;
+}
+
+/// <summary>
+/// returns the string in the innermost array
+/// </summary>
+char const* innermost(dy_t val)
+{
+    while (dy_get_type(val) == dy_type_arr) val = dy_get_arr_idx(val, 0);
+    return dy_get_str_data(val);
+}
+
+/// <summary>
+/// makes a tree of maps with the fanout at each level, and strings and
+/// integers as the leaves
+/// </summary>
+dy_t make_tree(dy_arena_t arena, size_t fanout, size_t depth, size_t* seq)
+{
+    if (depth == 0)
+    {
+        string str = "leaf " + to_string(*seq);
+        return ++*seq % 2 == 0 ? dy_arena_make_str(arena, str.c_str())
+                               : dy_arena_make_i(arena, *seq << 32);
+    }
+
+    vector<string>      keys;
+    vector<dy_keyval_t> pairs;
+    for (size_t i = 0; i < fanout; ++i) keys.push_back("k" + to_string(i));
+    for (size_t i = 0; i < fanout; ++i)
+        pairs.push_back({ keys[i].c_str(),
+                          make_tree(arena, fanout, depth - 1, seq) });
+    return dy_arena_make_map(arena, pairs.data(), fanout);
+}
+
+}
+
+TEST(TreeTest, Deep)
+{
+    dy_t val = make_deep(NULL, deep);
+    ASSERT_STREQ(innermost(val), "innermost");
+
+    dy_t copy = dy_copy(val);
+    ASSERT_EQ(copy, val);
+    dy_dispose(copy);
+    dy_dispose(val);
+
+    val = make_deep(NULL, deep);
+    dy_dispose_parallel(val);
+}
+
+TEST(TreeTest, DeepArena)
+{
+    dy_arena_t arena = dy_arena_create(0);
+    dy_t       val   = make_deep(arena, deep);
+
+    dy_t copy     = dy_copy(val);
+    dy_t parallel = dy_copy_parallel(val);
+    dy_arena_destroy(arena);
+
+    ASSERT_STREQ(innermost(copy), "innermost");
+    ASSERT_STREQ(innermost(parallel), "innermost");
+    dy_dispose(copy);
+    dy_dispose_parallel(parallel);
+}
+
+TEST(TreeTest, DeepWrite)
+{
+    dy_t val = make_deep(NULL, deep);
+
+    string json = string(deep, '[') + "\"innermost\"" + string(deep, ']');
+    ASSERT_EQ(to_json(val), json);
+
+    string bytes;
+    ASSERT_TRUE(dy_encode_msgpack(val, append, &bytes));
+    ASSERT_EQ(bytes, string(deep, '\x91') + "\xa9innermost");
+
+    size_t           len = dy_write_mapped_buffer(val, NULL, 0);
+    vector<uint64_t> words((len + 7) / 8);
+    ASSERT_EQ(dy_write_mapped_buffer(val, words.data(), len), len);
+    dy_dispose(val);
+
+    dy_mapped_t mapped = dy_open_mapped_buffer(words.data(), len);
+    ASSERT_STREQ(innermost(dy_get_mapped_root(mapped)), "innermost");
+    dy_close_mapped(mapped);
+}
+
+TEST(TreeTest, DeepCompact)
+{
+    // integers which do not fit in the handles take a node each
+    dy_t ints[] = { dy_make_i(INT64_C(1) << 60), dy_make_i(2) };
+    dy_t val    = dy_make_arr(ints, 2);
+    for (size_t i = 0; i < deep; ++i) val = dy_make_arr(&val, 1);
+
+    size_t saved = 0;
+    val          = dy_compact(val, dy_compact_default, &saved);
+    ASSERT_GT(saved, 0);
+
+    dy_t inner = val;
+    for (size_t i = 0; i < deep; ++i) inner = dy_get_arr_idx(inner, 0);
+    ASSERT_EQ(dy_get_type(inner), dy_type_iarr);
+    ASSERT_EQ(dy_get_iarr_idx(inner, 1), 2);
+    dy_dispose(val);
+}
+
+TEST(TreeTest, DeepLazy)
+{
+    constexpr size_t depth = 100000;
+
+    string json(depth, '[');
+    json += "\"innermost\"";
+    json.append(depth, ']');
+
+    dy_parse_opts_t opts {};
+    opts.lazy      = true;
+    opts.max_depth = depth;
+
+    // every level is parsed, holding the next lazy array
+    dy_t val = dy_parse_json(json.data(), json.size(), &opts);
+    ASSERT_NE(val, nullptr);
+    ASSERT_STREQ(innermost(val), "innermost");
+    dy_dispose(val);
+}
+
+TEST(TreeTest, Parallel)
+{
+    dy_arena_t arena = dy_arena_create(0);
+
+    size_t seq  = 0;
+    dy_t   tree = make_tree(arena, 6, 5, &seq);
+    string json = to_json(tree);
+
+    dy_t copy    = dy_copy_parallel(tree);
+    dy_t shared  = dy_copy_parallel(copy);
+    dy_t leaf    = dy_copy_parallel(dy_arena_make_str(arena, "leaf"));
+    dy_t inlined = dy_copy_parallel(dy_make_i(1));
+
+    seq         = 1;
+    dy_t narrow = dy_copy_parallel(make_tree(arena, 1, 3, &seq));
+    dy_arena_destroy(arena);
+
+    ASSERT_EQ(to_json(copy), json);
+    ASSERT_EQ(shared, copy);
+    ASSERT_STREQ(dy_get_str_data(leaf), "leaf");
+    ASSERT_EQ(to_json(narrow), R"({"k0":{"k0":{"k0":"leaf 1"}}})");
+    ASSERT_EQ(dy_get_i(inlined), 1);
+
+    dy_dispose_parallel(shared);
+    ASSERT_EQ(to_json(copy), json);
+    dy_dispose_parallel(copy);
+    dy_dispose_parallel(leaf);
+    dy_dispose_parallel(narrow);
+    dy_dispose_parallel(inlined);
+}
+
+TEST(TreeTest, SharedSubtrees)
+{
+    dy_t inner[] = { dy_make_str("shared"), dy_make_i(INT64_MAX) };
+    dy_t sub     = dy_make_arr(inner, 2);
+
+    // the subtree is held by every parent and by the test
+    vector<dy_t> parents;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        dy_t entries[] = { dy_retain(sub), dy_make_str("own") };
+        parents.push_back(dy_make_arr(entries, 2));
+    }
+    dy_t root = dy_make_arr(parents.data(), parents.size());
+
+    dy_t copy = dy_copy_parallel(root);
+    ASSERT_EQ(copy, root);
+    dy_dispose_parallel(copy);
+    dy_dispose_parallel(root);
+
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(sub, 0)), "shared");
+    dy_dispose_parallel(sub);
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2020 Stella Authors. All rights reserved.
+
+#include <gtest/gtest.h>
+
+#include "dll.h"
+#include <cstring>
+#include <string>
+
+TEST(ViewTest, ReferencesMemory)
+{
+    // not terminated after the first five characters
+    char    buf[]     = "hello, world";
+    int64_t samples[] = { 3, 1, 4 };
+
+    dy_t str  = dy_make_str_view(buf, 5);
+    dy_t iarr = dy_make_iarr_view(samples, 3);
+
+    ASSERT_TRUE(dy_is_view(str));
+    ASSERT_EQ(dy_get_type(str), dy_type_str);
+    ASSERT_EQ(dy_get_str_len(str), 5);
+    ASSERT_EQ(dy_get_str_data(str), buf);
+    ASSERT_EQ(dy_get_iarr_data(iarr), samples);
+
+    // the value sees changes to the memory
+    samples[1] = 5;
+    ASSERT_EQ(dy_get_iarr_idx(iarr, 1), 5);
+
+    // copies share the view, and disposing them leaves the memory alone
+    dy_t copy = dy_copy(iarr);
+    ASSERT_TRUE(dy_is_view(copy));
+    dy_dispose(copy);
+    dy_dispose(iarr);
+    dy_dispose(str);
+
+    ASSERT_STREQ(buf, "hello, world");
+    ASSERT_EQ(samples[2], 4);
+}
+
+TEST(ViewTest, IsView)
+{
+    uint8_t bytes[] = { 1, 2 };
+
+    dy_t owned = dy_make_bytes(bytes, 2);
+    dy_t view  = dy_make_bytes_view(bytes, 2);
+
+    ASSERT_FALSE(dy_is_view(owned));
+    ASSERT_FALSE(dy_is_view(dy_make_i(1)));
+    ASSERT_TRUE(dy_is_view(view));
+
+    dy_dispose(owned);
+    dy_dispose(view);
+}
+
+TEST(ViewTest, Materialize)
+{
+    std::string buf       = "forwarded";
+    double      samples[] = { 0.5, 0.25 };
+
+    dy_t str   = dy_make_str_view(buf.data(), 7);
+    dy_t owned = dy_materialize(str);
+    ASSERT_FALSE(dy_is_view(owned));
+    ASSERT_NE(dy_get_str_data(owned), buf.data());
+    ASSERT_STREQ(dy_get_str_data(owned), "forward");
+
+    dy_dispose(str);
+    buf.assign("overwritten");
+    ASSERT_STREQ(dy_get_str_data(owned), "forward");
+    dy_dispose(owned);
+
+    dy_t farr  = dy_make_farr_view(samples, 2);
+    owned      = dy_materialize(farr);
+    samples[0] = 1;
+    ASSERT_EQ(dy_get_farr_idx(owned, 0), 0.5);
+    dy_dispose(farr);
+    dy_dispose(owned);
+}
+
+TEST(ViewTest, MaterializeNested)
+{
+    char payload[] = "payload";
+
+    dy_t items[] = {
+        dy_make_str_view(payload, 3),
+        dy_make_i(1),
+    };
+
+    dy_keyval_t fields[] = {
+        { "items", dy_make_arr(items, 2) },
+        { "name", dy_make_str("packet") },
+    };
+
+    dy_t doc   = dy_make_map(fields, 2);
+    dy_t owned = dy_materialize(doc);
+    ASSERT_NE(owned, doc);
+
+    dy_t name = dy_get_map_key(doc, "name").val;
+    dy_t copy = dy_get_map_key(owned, "items").val;
+    ASSERT_FALSE(dy_is_view(dy_get_arr_idx(copy, 0)));
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(copy, 0)), "pay");
+
+    // the values without views are shared
+    ASSERT_EQ(dy_get_map_key(owned, "name").val, name);
+
+    dy_dispose(doc);
+    payload[0] = 'd';
+    ASSERT_STREQ(dy_get_str_data(dy_get_arr_idx(copy, 0)), "pay");
+    dy_dispose(owned);
+
+    // nothing is copied from a value without views
+    dy_t plain = dy_make_str("plain");
+    dy_t same  = dy_materialize(plain);
+    ASSERT_EQ(same, plain);
+    dy_dispose(plain);
+    dy_dispose(same);
+}
+
+TEST(ViewTest, Release)
+{
+    int64_t samples[] = { 7, 8 };
+
+    dy_t view = dy_make_iarr_view(samples, 2);
+
+    // the memory is owned elsewhere, so a copy is handed out
+    dy_free_fn_t free_fn;
+    void*        ctx;
+    int64_t*     released = dy_release_iarr_data(view, &free_fn, &ctx);
+    ASSERT_NE(released, samples);
+    ASSERT_EQ(released[1], 8);
+
+    free_fn(released, ctx);
+    dy_dispose(view);
+}